@@ -126,6 +126,74 @@ ssize_t OW_get(const char *path, char **return_buffer, size_t * buffer_length)
 	return ReturnAndErrno(size_or_error);
 }
 
+/*
+  Read several properties at once, grouped by device so each device is locked only once
+  buffers[i] gets a copy of the value of paths[i] (to be free-ed elsewhere) or NULL
+  lengths[i] gets its length or <0 for error
+  return count, or <0 for error
+ */
+
+ssize_t OW_multiget(const char **paths, int count, char **buffers, ssize_t * lengths)
+{
+	ssize_t ret = -EACCES;
+
+	/* Check the parameters */
+	if (paths == NULL || buffers == NULL || lengths == NULL || count < 1) {
+		return ReturnAndErrno(-EINVAL);
+	}
+
+	if (API_access_start() == 0) {
+		struct one_wire_query **owq = owmalloc(count * (2 * sizeof(struct one_wire_query *) + sizeof(SIZE_OR_ERROR) + sizeof(int)));
+		if (owq == NULL) {
+			ret = -ENOMEM;
+		} else {
+			struct one_wire_query **batch_owq = &owq[count];
+			SIZE_OR_ERROR *batch_read_or_error = (SIZE_OR_ERROR *) & batch_owq[count];
+			int *batch_slot = (int *) &batch_read_or_error[count];
+			int batch_count = 0;
+			int index;
+
+			for (index = 0; index < count; ++index) {
+				buffers[index] = NULL;
+				owq[index] = OWQ_create_from_path((paths[index] == NULL) ? "/" : paths[index]);
+				if (owq[index] == NO_ONE_WIRE_QUERY) {
+					lengths[index] = -ENOENT;
+				} else if (BAD(OWQ_allocate_read_buffer(owq[index]))) {
+					lengths[index] = -ENOMEM;
+				} else {
+					batch_owq[batch_count] = owq[index];
+					batch_slot[batch_count] = index;
+					++batch_count;
+				}
+			}
+
+			FS_read_batch(batch_owq, batch_read_or_error, batch_count);
+
+			for (index = 0; index < batch_count; ++index) {
+				int slot = batch_slot[index];
+				lengths[slot] = batch_read_or_error[index];
+				if (lengths[slot] >= 0) {
+					buffers[slot] = malloc(lengths[slot] + 1);
+					if (buffers[slot] == NULL) {
+						lengths[slot] = -ENOMEM;
+					} else {
+						memcpy(buffers[slot], OWQ_buffer(batch_owq[index]), lengths[slot]);
+						buffers[slot][lengths[slot]] = '\0';
+					}
+				}
+			}
+
+			for (index = 0; index < count; ++index) {
+				OWQ_destroy(owq[index]);
+			}
+			owfree(owq);
+			ret = count;
+		}
+		API_access_end();
+	}
+	return ReturnAndErrno(ret);
+}
+
 int OW_present(const char *path)
 {
 	ssize_t ret = -ENOENT;		/* current buffer string length */
@@ -62,6 +62,19 @@ extern "C" {
 	 */
 	ssize_t OW_get(const char *path, char **buffer, size_t * buffer_length);
 
+	/* OW_multiget -- read several device properties at once
+	   paths is an array of count OWFS style names (NULL entries mean "/")
+	   Properties of the same device are read together, locking the device once.
+
+	   buffers[i] is allocated by OW_multiget for the value of paths[i] (NULL on error)
+	   each buffer MUST BE "free"ed after use.
+	   lengths[i] is the length of that value, or <0 error for that path
+
+	   return value >=0 ok, count
+	   <0 error
+	 */
+	ssize_t OW_multiget(const char **paths, int count, char **buffers, ssize_t * lengths);
+
 	/* OW_present -- check if path is present
 	   path is OWFS style name,
 	   "" or "/" for root directory
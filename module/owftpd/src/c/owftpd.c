@@ -83,7 +83,9 @@ int main(int argc, char *argv[])
 	while (!StateInfo.shutting_down) {
 		if ((err = sigwait(&myset, &signo)) == 0) {
 			if (signo == SIGHUP) {
-				LEVEL_DEBUG("owftpd: ignore signo=%d", signo);
+				// blocked everywhere, so the library handler never sees it
+				LEVEL_DEBUG("owftpd: reread alias files signo=%d", signo);
+				AliasReload();
 				continue;
 			}
 			LEVEL_DEBUG("owftpd: break signo=%d", signo);
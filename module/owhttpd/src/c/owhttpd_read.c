@@ -18,74 +18,280 @@ $Id$
 //static void Show(FILE * out, const char *const path, const char *const file);
 //static void ShowText(FILE * out, const char *path, const char *file);
 
-static void Show(FILE * out, const struct parsedname *pn_entry);
+struct show_row ;
+struct show_page ;
+
+static void ShowPageAdd(struct show_page *page, const struct parsedname *pn_entry);
+static void ShowPageRun(FILE * out, struct show_page *page, void (*show_row) (FILE *, struct show_row *));
+static void ShowPageClear(struct show_page *page);
+static int ShowRowNeedsRead(struct one_wire_query *owq);
+static void ShowRowRead(struct show_row *row);
+static void ShowRowWait(FILE * out, struct show_page *page, int index);
+static int ShowPageClaim(struct show_page *page);
+#if OW_MT
+static void *ShowPageReader(void *v);
+#endif							/* OW_MT */
+
+static void Show(FILE * out, struct show_row *row);
 static void ShowDirectory(FILE * out, const struct parsedname *pn_entry);
-static void ShowReadWrite(FILE * out, struct one_wire_query *owq);
-static void ShowReadonly(FILE * out, struct one_wire_query *owq);
+static void ShowReadWrite(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
+static void ShowReadonly(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
 static void ShowWriteonly(FILE * out, struct one_wire_query *owq);
-static void ShowStructure(FILE * out, struct one_wire_query *owq);
+static void ShowStructure(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
 static void StructureDetail(FILE * out, const char * structure_details );
 static void Upload( FILE * out, const struct parsedname * pn ) ;
 
-static void ShowText(FILE * out, const struct parsedname *pn_entry);
+static void ShowText(FILE * out, struct show_row *row);
 static void ShowTextDirectory(FILE * out, const struct parsedname *pn_entry);
-static void ShowTextReadWrite(FILE * out, struct one_wire_query *owq);
-static void ShowTextReadonly(FILE * out, struct one_wire_query *owq);
+static void ShowTextReadWrite(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
+static void ShowTextReadonly(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
 static void ShowTextWriteonly(FILE * out, struct one_wire_query *owq);
-static void ShowTextStructure(FILE * out, struct one_wire_query *owq);
+static void ShowTextStructure(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
 
-static void ShowJson(FILE * out, const struct parsedname *pn_entry);
+static void ShowJson(FILE * out, struct show_row *row);
 static void ShowJsonDirectory(FILE * out, const struct parsedname *pn_entry);
-static void ShowJsonReadWrite(FILE * out, struct one_wire_query *owq);
-static void ShowJsonReadonly(FILE * out, struct one_wire_query *owq);
+static void ShowJsonReadWrite(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
+static void ShowJsonReadonly(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
 static void ShowJsonWriteonly(FILE * out, struct one_wire_query *owq);
-static void ShowJsonStructure(FILE * out, struct one_wire_query *owq);
+static void ShowJsonStructure(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
 static void StructureDetailJson(FILE * out, const char * structure_details );
 
 /* --------------- Functions ---------------- */
 
+/* A device page reads its property rows in parallel -- most of a page's time is
+ * spent waiting for the bus (or a remote owserver), one property after another.
+ * The directory listing (FS_dir) just collects the rows, then up to
+ * HTTP_PAGE_READERS threads read them, and each row is written out as soon as
+ * it and every row above it have been read. The page thread reads rows too
+ * while it waits, so without threads the page is read in order as before.
+ */
+#define HTTP_PAGE_READERS	4
+
+struct show_row {
+	struct one_wire_query *owq;	// NO_ONE_WIRE_QUERY if it couldn't be made
+	char *name;					// left column (FS_DirName of the listing entry)
+	SIZE_OR_ERROR read_return;	// value size, or error
+	int done;					// read_return is set
+};
+
+struct show_page {
+	struct show_row *row;
+	int rows;
+	int allocated;
+	int next;					// next row to claim for reading
+#if OW_MT
+	pthread_mutex_t lock;
+	pthread_cond_t row_done;
+#endif							/* OW_MT */
+};
+
+#if OW_MT
+#define PAGELOCK(page)		_MUTEX_LOCK(  (page)->lock )
+#define PAGEUNLOCK(page)	_MUTEX_UNLOCK((page)->lock )
+#else							/* OW_MT */
+#define PAGELOCK(page)		return_ok()
+#define PAGEUNLOCK(page)	return_ok()
+#endif							/* OW_MT */
+
+/* Add a row for this directory entry -- called from the FS_dir callback */
+static void ShowPageAdd(struct show_page *page, const struct parsedname *pn_entry)
+{
+	struct show_row *row;
+
+	if (page->rows == page->allocated) {
+		int allocated = page->allocated ? 2 * page->allocated : 32;
+		struct show_row *more = owrealloc(page->row, allocated * sizeof(struct show_row));
+		if (more == NULL) {
+			return;
+		}
+		page->row = more;
+		page->allocated = allocated;
+	}
+	row = &(page->row[page->rows]);
+	row->name = owstrdup(FS_DirName(pn_entry));
+	if (row->name == NULL) {
+		return;
+	}
+	row->owq = OWQ_create_from_path(pn_entry->path);	// for read or dir
+	if (row->owq != NO_ONE_WIRE_QUERY && BAD(OWQ_allocate_read_buffer(row->owq))) {
+		OWQ_destroy(row->owq);
+		row->owq = NO_ONE_WIRE_QUERY;
+	}
+	row->read_return = -ENOTSUP;
+	row->done = (row->owq == NO_ONE_WIRE_QUERY) || !ShowRowNeedsRead(row->owq);
+	++page->rows;
+}
+
+/* Does showing this row need its value? */
+static int ShowRowNeedsRead(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+
+	if (pn->selected_filetype == NO_FILETYPE) {
+		return 0;
+	}
+	if (IsStructureDir(pn)) {
+		return 1;
+	}
+	if (pn->selected_filetype->format == ft_directory || pn->selected_filetype->format == ft_subdir) {
+		return 0;
+	}
+	return pn->selected_filetype->read != NO_READ_FUNCTION;
+}
+
+static void ShowRowRead(struct show_row *row)
+{
+	row->read_return = FS_read_postparse(row->owq);
+	STAT_ADD1(http_page_reads);
+}
+
+/* Next unread row, or -1 */
+/* called with PAGELOCK */
+static int ShowPageClaim(struct show_page *page)
+{
+	while (page->next < page->rows) {
+		int index = page->next++;
+		if (!page->row[index].done) {
+			return index;
+		}
+	}
+	return -1;
+}
+
+/* Wait for row index to be read -- reading unclaimed rows meanwhile */
+static void ShowRowWait(FILE * out, struct show_page *page, int index)
+{
+	PAGELOCK(page);
+	while (!page->row[index].done) {
+		int claim = ShowPageClaim(page);
+		if (claim < 0) {
+			// others are reading the rest -- send what's ready while waiting
+			PAGEUNLOCK(page);
+			fflush(out);
+			PAGELOCK(page);
+			if (!page->row[index].done) {
+				my_pthread_cond_wait(&(page->row_done), &(page->lock));
+			}
+			continue;
+		}
+		PAGEUNLOCK(page);
+		ShowRowRead(&(page->row[claim]));
+		PAGELOCK(page);
+		page->row[claim].done = 1;
+	}
+	PAGEUNLOCK(page);
+}
+
+#if OW_MT
+static void *ShowPageReader(void *v)
+{
+	struct show_page *page = v;
+
+	PAGELOCK(page);
+	while (1) {
+		int claim = ShowPageClaim(page);
+		if (claim < 0) {
+			break;
+		}
+		PAGEUNLOCK(page);
+		ShowRowRead(&(page->row[claim]));
+		PAGELOCK(page);
+		page->row[claim].done = 1;
+		my_pthread_cond_signal(&(page->row_done));
+	}
+	PAGEUNLOCK(page);
+	return VOID_RETURN;
+}
+#endif							/* OW_MT */
+
+/* Read the rows (in parallel) and show each in order */
+static void ShowPageRun(FILE * out, struct show_page *page, void (*show_row) (FILE *, struct show_row *))
+{
+	int index;
+#if OW_MT
+	pthread_t reader[HTTP_PAGE_READERS];
+	int readers = 0;
+	int unread = 0;
+
+	for (index = 0; index < page->rows; ++index) {
+		unread += !page->row[index].done;
+	}
+	_MUTEX_INIT(page->lock);
+	my_pthread_cond_init(&(page->row_done), NULL);
+	// the page thread is a reader too
+	while (readers < HTTP_PAGE_READERS - 1 && readers < unread - 1) {
+		if (pthread_create(&reader[readers], DEFAULT_THREAD_ATTR, ShowPageReader, (void *) page) != 0) {
+			break;
+		}
+		++readers;
+	}
+#endif							/* OW_MT */
+
+	for (index = 0; index < page->rows; ++index) {
+		ShowRowWait(out, page, index);
+		show_row(out, &(page->row[index]));
+	}
+
+#if OW_MT
+	while (readers > 0) {
+		pthread_join(reader[--readers], NULL);
+	}
+	my_pthread_cond_destroy(&(page->row_done));
+	_MUTEX_DESTROY(page->lock);
+#endif							/* OW_MT */
+}
+
+static void ShowPageClear(struct show_page *page)
+{
+	int index;
+
+	for (index = 0; index < page->rows; ++index) {
+		OWQ_destroy(page->row[index].owq);
+		owfree(page->row[index].name);
+	}
+	SAFEFREE(page->row);
+	page->rows = page->allocated = page->next = 0;
+}
+
 /* Device entry -- table line for a filetype */
-static void Show(FILE * out, const struct parsedname *pn_entry)
+static void Show(FILE * out, struct show_row *row)
 {
-	struct one_wire_query *owq = OWQ_create_from_path(pn_entry->path); // for read or dir
-	
+	struct one_wire_query *owq = row->owq;
+	struct parsedname *pn_entry = (owq == NO_ONE_WIRE_QUERY) ? NULL : PN(owq);
+
 	/* Left column */
-	fprintf(out, "<TR><TD><B>%s</B></TD><TD>", FS_DirName(pn_entry));
+	fprintf(out, "<TR><TD><B>%s</B></TD><TD>", row->name);
 
 	if (owq == NO_ONE_WIRE_QUERY) {
 		fprintf(out, "<B>Memory exhausted</B>");
-	} else if ( BAD( OWQ_allocate_read_buffer(owq)) ) {
-		fprintf(out, "<B>Memory exhausted</B>");
 	} else if (pn_entry->selected_filetype == NO_FILETYPE) {
 		ShowDirectory(out, pn_entry);
 	} else if (IsStructureDir(pn_entry)) {
-		ShowStructure(out, owq);
+		ShowStructure(out, owq, row->read_return);
 	} else if (pn_entry->selected_filetype->format == ft_directory || pn_entry->selected_filetype->format == ft_subdir) {
 		// Directory
 		ShowDirectory(out, pn_entry);
 	} else if (pn_entry->selected_filetype->write == NO_WRITE_FUNCTION || Globals.readonly) {
 		// Unwritable
 		if (pn_entry->selected_filetype->read != NO_READ_FUNCTION) {
-			ShowReadonly(out, owq);
+			ShowReadonly(out, owq, row->read_return);
 		}
 	} else {					// Writeable
 		if (pn_entry->selected_filetype->read == NO_READ_FUNCTION) {
 			ShowWriteonly(out, owq);
 		} else {
-			ShowReadWrite(out, owq);
+			ShowReadWrite(out, owq, row->read_return);
 		}
 	}
 	fprintf(out, "</TD></TR>\r\n");
-	OWQ_destroy(owq);
 }
 
 
 /* Device entry -- table line for a filetype */
-static void ShowReadWrite(FILE * out, struct one_wire_query *owq)
+static void ShowReadWrite(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
 	struct parsedname * pn = PN(owq) ;
 	const char *file = FS_DirName(pn);
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
 	if (read_return < 0) {
 		fprintf(out, "Error: %s", strerror(-read_return));
 		return;
@@ -128,9 +334,8 @@ static void Upload( FILE * out, const struct parsedname * pn )
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowReadonly(FILE * out, struct one_wire_query *owq)
+static void ShowReadonly(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
 	if (read_return < 0) {
 		fprintf(out, "Error: %s", strerror(-read_return));
 		return;
@@ -171,9 +376,8 @@ static void ShowReadonly(FILE * out, struct one_wire_query *owq)
 }
 
 /* Structure entry */
-static void ShowStructure(FILE * out, struct one_wire_query *owq)
+static void ShowStructure(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
 	if (read_return < 0) {
 		fprintf(out, "Error: %s", strerror(-read_return));
 		return;
@@ -304,42 +508,40 @@ static void ShowDirectory(FILE * out, const struct parsedname *pn_entry)
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowText(FILE * out, const struct parsedname *pn_entry)
+static void ShowText(FILE * out, struct show_row *row)
 {
-	struct one_wire_query *owq = OWQ_create_from_path(pn_entry->path); // for read or dir
+	struct one_wire_query *owq = row->owq;
+	struct parsedname *pn_entry = (owq == NO_ONE_WIRE_QUERY) ? NULL : PN(owq);
 
 	/* Left column */
-	fprintf(out, "%s ", FS_DirName(pn_entry));
+	fprintf(out, "%s ", row->name);
 
 	if (owq == NO_ONE_WIRE_QUERY) {
-	} else if ( BAD( OWQ_allocate_read_buffer(owq)) ) {
 		//fprintf(out, "(memory exhausted)");
 	} else if (pn_entry->selected_filetype == NO_FILETYPE) {
 		ShowTextDirectory(out, pn_entry);
 	} else if (pn_entry->selected_filetype->format == ft_directory || pn_entry->selected_filetype->format == ft_subdir) {
 		ShowTextDirectory(out, pn_entry);
 	} else if (IsStructureDir(pn_entry)) {
-		ShowTextStructure(out, owq);
+		ShowTextStructure(out, owq, row->read_return);
 	} else if (pn_entry->selected_filetype->write == NO_WRITE_FUNCTION || Globals.readonly) {
 		// Unwritable
 		if (pn_entry->selected_filetype->read != NO_READ_FUNCTION) {
-			ShowTextReadonly(out, owq);
+			ShowTextReadonly(out, owq, row->read_return);
 		}
 	} else {					// Writeable
 		if (pn_entry->selected_filetype->write == NO_READ_FUNCTION) {
 			ShowTextWriteonly(out, owq);
 		} else {
-			ShowTextReadWrite(out, owq);
+			ShowTextReadWrite(out, owq, row->read_return);
 		}
 	}
 	fprintf(out, "\r\n");
-	OWQ_destroy(owq);
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowTextStructure(FILE * out, struct one_wire_query *owq)
+static void ShowTextStructure(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
 	if (read_return < 0) {
 		//fprintf(out, "error: %s", strerror(-read_return));
 		return;
@@ -349,9 +551,8 @@ static void ShowTextStructure(FILE * out, struct one_wire_query *owq)
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowTextReadWrite(FILE * out, struct one_wire_query *owq)
+static void ShowTextReadWrite(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
 	if (read_return < 0) {
 		//fprintf(out, "error: %s", strerror(-read_return));
 		return;
@@ -380,9 +581,9 @@ static void ShowTextReadWrite(FILE * out, struct one_wire_query *owq)
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowTextReadonly(FILE * out, struct one_wire_query *owq)
+static void ShowTextReadonly(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
-	ShowTextReadWrite(out, owq);
+	ShowTextReadWrite(out, owq, read_return);
 }
 
 /* Device entry -- table line for a filetype */
@@ -398,67 +599,58 @@ static void ShowTextDirectory(FILE * out, const struct parsedname *pn_entry)
 	(void) pn_entry;
 }
 
-/* Now show the device */
-static void ShowDeviceTextCallback(void *v, const struct parsedname * pn_entry)
+/* Now show the device -- collect the rows, then read and show them */
+static void ShowDevicePageCallback(void *v, const struct parsedname * pn_entry)
 {
-	FILE *out = v;
-	ShowText(out, pn_entry);
+	struct show_page *page = v;
+	ShowPageAdd(page, pn_entry);
 }
 
-static void ShowDeviceCallback(void *v, const struct parsedname * pn_entry)
-{
-	FILE *out = v;
-//    Show(sds->out, sds->path, FS_DirName(pn_entry));
-	Show(out, pn_entry);
-}
-
-static void ShowDeviceText(FILE * out, struct parsedname *pn)
+static void ShowDeviceText(FILE * out, struct parsedname *pn, struct show_page *page)
 {
 	HTTPstart(out, "200 OK", ct_text);
 
 	if (pn->selected_filetype == NO_DEVICE) {	/* whole device */
 		//printf("whole directory path=%s \n", pn->path);
-		FS_dir(ShowDeviceTextCallback, out, pn);
+		FS_dir(ShowDevicePageCallback, page, pn);
 	} else {					/* Single item */
 		//printf("single item path=%s\n", pn->path);
-		ShowText(out, pn);
+		ShowPageAdd(page, pn);
 	}
+	ShowPageRun(out, page, ShowText);
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowJson(FILE * out, const struct parsedname *pn_entry)
+static void ShowJson(FILE * out, struct show_row *row)
 {
-	struct one_wire_query *owq = OWQ_create_from_path(pn_entry->path); // for read or dir
+	struct one_wire_query *owq = row->owq;
+	struct parsedname *pn_entry = (owq == NO_ONE_WIRE_QUERY) ? NULL : PN(owq);
 
 	if (owq == NO_ONE_WIRE_QUERY) {
 		fprintf(out, "null");
-	} else if ( BAD( OWQ_allocate_read_buffer(owq)) ) {
-		fprintf(out, "null");
 	} else if (pn_entry->selected_filetype == NO_FILETYPE) {
 		ShowJsonDirectory(out, pn_entry);
 	} else if (IsStructureDir(pn_entry)) {
-		ShowJsonStructure(out, owq);
+		ShowJsonStructure(out, owq, row->read_return);
 	} else if (pn_entry->selected_filetype->format == ft_directory || pn_entry->selected_filetype->format == ft_subdir) {
 		ShowJsonDirectory(out, pn_entry);
 	} else if (pn_entry->selected_filetype->write == NO_WRITE_FUNCTION || Globals.readonly) {
 		// Unwritable
 		if (pn_entry->selected_filetype->read != NO_READ_FUNCTION) {
-			ShowJsonReadonly(out, owq);
+			ShowJsonReadonly(out, owq, row->read_return);
 		}
 	} else {					// Writeable
 		if (pn_entry->selected_filetype->write == NO_READ_FUNCTION) {
 			ShowJsonWriteonly(out, owq);
 		} else {
-			ShowJsonReadWrite(out, owq);
+			ShowJsonReadWrite(out, owq, row->read_return);
 		}
 	}
-	OWQ_destroy(owq);
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowJsonStructure(FILE * out, struct one_wire_query *owq)
+static void ShowJsonStructure(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
 	if (read_return < 0) {
 		fprintf(out, "null");
 		return;
@@ -557,10 +749,9 @@ static void StructureDetailJson(FILE * out, const char * structure_details )
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowJsonReadWrite(FILE * out, struct one_wire_query *owq)
+static void ShowJsonReadWrite(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
 	struct parsedname * pn = PN(owq) ;
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
 
 	if (read_return < 0) {
 		fprintf(out, "null");
@@ -592,9 +783,9 @@ static void ShowJsonReadWrite(FILE * out, struct one_wire_query *owq)
 }
 
 /* Device entry -- table line for a filetype */
-static void ShowJsonReadonly(FILE * out, struct one_wire_query *owq)
+static void ShowJsonReadonly(FILE * out, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
-	ShowJsonReadWrite(out, owq);
+	ShowJsonReadWrite(out, owq, read_return);
 }
 
 /* Device entry -- table line for a filetype */
@@ -609,57 +800,80 @@ static void ShowJsonDirectory(FILE * out, const struct parsedname *pn_entry)
 	fprintf(out,"[]") ;
 }
 
-/* Now show the device */
-static void ShowDeviceJsonCallback(void *v, const struct parsedname * pn_entry)
+/* Object member for a device page row */
+static void ShowJsonMember(FILE * out, struct show_row *row)
 {
-	FILE *out = v;
-	fprintf(out, "\"%s\":",FS_DirName(pn_entry) ) ;
-	ShowJson(out, pn_entry);
+	fprintf(out, "\"%s\":", row->name ) ;
+	ShowJson(out, row);
 	fprintf(out, ",\n" ) ;
 }
 
-static void ShowDeviceJson(FILE * out, struct parsedname *pn)
+static void ShowDeviceJson(FILE * out, struct parsedname *pn, struct show_page *page)
 {
 	HTTPstart(out, "200 OK", ct_text);
 
 	if (pn->selected_filetype == NO_DEVICE) {	/* whole device */
 		fprintf(out, "{\n" ) ;
-		FS_dir(ShowDeviceJsonCallback, out, pn);
+		FS_dir(ShowDevicePageCallback, page, pn);
+		ShowPageRun(out, page, ShowJsonMember);
 		fprintf(out, "}" );
 	} else {					/* Single item */
 		//printf("single item path=%s\n", pn->path);
-		ShowJson(out, pn);
+		ShowPageAdd(page, pn);
+		ShowPageRun(out, page, ShowJson);
 	}
 }
 
 
+/* Page timing (msec) for /statistics/http */
+static void ShowDeviceStatistics(const struct timeval *start)
+{
+	struct timeval now;
+	UINT msec;
+
+	gettimeofday(&now, NULL);
+	timersub(&now, start, &now);
+	msec = now.tv_sec * 1000 + now.tv_usec / 1000;
+	STAT_ADD1(http_pages);
+	STAT_ADD(http_page_msec_total, msec);
+	http_page_msec_last = msec;
+	STAT_MAX(http_page_msec_max, msec);
+}
+
 void ShowDevice(FILE * out, struct parsedname *pn)
 {
+	struct show_page page;
+	struct timeval start;
+
+	memset(&page, 0, sizeof(struct show_page));
+	gettimeofday(&start, NULL);
+
 	if (pn->state & ePS_text) {
-		ShowDeviceText(out, pn);
-		return;
+		ShowDeviceText(out, pn, &page);
 	} else if (pn->state & ePS_json) {
-		ShowDeviceJson(out, pn);
-		return;
-	}
+		ShowDeviceJson(out, pn, &page);
+	} else {
+		HTTPstart(out, "200 OK", ct_html);
 
-	HTTPstart(out, "200 OK", ct_html);
+		HTTPtitle(out, &pn->path[1]);
+		HTTPheader(out, &pn->path[1]);
 
-	HTTPtitle(out, &pn->path[1]);
-	HTTPheader(out, &pn->path[1]);
+		if (NotUncachedDir(pn) && IsRealDir(pn)) {
+			fprintf(out, "<BR><small><A href='/uncached%s'>uncached version</A></small>", pn->path);
+		}
+		fprintf(out, "<TABLE BGCOLOR=\"#DDDDDD\" BORDER=1>");
+		fprintf(out, "<TR><TD><A HREF='%.*s'><CODE><B><BIG>up</BIG></B></CODE></A></TD><TD>directory</TD></TR>", Backup(pn->path), pn->path);
 
-	if (NotUncachedDir(pn) && IsRealDir(pn)) {
-		fprintf(out, "<BR><small><A href='/uncached%s'>uncached version</A></small>", pn->path);
+		if (pn->selected_filetype == NO_FILETYPE) {	/* whole device */
+			FS_dir(ShowDevicePageCallback, &page, pn);
+		} else {					/* single item */
+			ShowPageAdd(&page, pn);
+		}
+		ShowPageRun(out, &page, Show);
+		fprintf(out, "</TABLE>");
+		HTTPfoot(out);
 	}
-	fprintf(out, "<TABLE BGCOLOR=\"#DDDDDD\" BORDER=1>");
-	fprintf(out, "<TR><TD><A HREF='%.*s'><CODE><B><BIG>up</BIG></B></CODE></A></TD><TD>directory</TD></TR>", Backup(pn->path), pn->path);
 
-
-	if (pn->selected_filetype == NO_FILETYPE) {	/* whole device */
-		FS_dir(ShowDeviceCallback, out, pn);
-	} else {					/* single item */
-		Show(out, pn);
-	}
-	fprintf(out, "</TABLE>");
-	HTTPfoot(out);
+	ShowPageClear(&page);
+	ShowDeviceStatistics(&start);
 }
@@ -41,6 +41,9 @@ const char mutexattr_settype_failed[] = "mutexattr_settype failed rc=%d [%s]\n";
 const char rwlock_init_failed[] = "rwlock_init failed rc=%d [%s]\n";
 const char rwlock_read_lock_failed[] = "rwlock_read_lock failed rc=%d [%s]\n";
 const char rwlock_read_unlock_failed[] = "rwlock_read_unlock failed rc=%d [%s]\n";
+const char rwlock_destroy_failed[] = "rwlock_destroy failed rc=%d [%s]\n";
+const char rwlock_write_lock_failed[] = "rwlock_write_lock failed rc=%d [%s]\n";
+const char rwlock_unlock_failed[] = "rwlock_unlock failed rc=%d [%s]\n";
 const char cond_timedwait_failed[] = "cond_timedwait failed rc=%d [%s]\n";
 const char cond_signal_failed[] = "cond_signal failed rc=%d [%s]\n";
 const char cond_wait_failed[] = "cond_wait failed rc=%d [%s]\n";
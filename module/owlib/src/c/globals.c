@@ -63,6 +63,7 @@ struct global Globals = {
 
 	.altUSB = 0,
 	.usb_flextime = 1,
+	.usb_pipeline = 0,
 	.serial_flextime = 1,
 	.serial_reverse = 0,  // 1 is "reverse" polarity
 	.serial_hardflow = 0, // hardware flow control
@@ -82,6 +83,11 @@ struct global Globals = {
 	.timeout_persistent_high = 3600,
 	.clients_persistent_low = 10,
 	.clients_persistent_high = 20,
+	.timeout_pool = 60,
+	.timeout_pool_check = 2,
+	.connections_pool = 4,
+	.stale_volatile = 0,
+	.stale_stable = 0,
 
 	.usb_scan_interval = DEFAULT_USB_SCAN_INTERVAL,
 	.enet_scan_interval = DEFAULT_ENET_SCAN_INTERVAL,
@@ -90,6 +96,7 @@ struct global Globals = {
 	.no_dirall = 0,
 	.no_get = 0,
 	.no_persistence = 0,
+	.no_pipeline = 0,
 	.eightbit_serial = 0,
 	.zero = zero_unknown ,
 	.i2c_APU = 1 ,
@@ -19,7 +19,156 @@ $Id$
 #include "owfs_config.h"
 #include "ow.h"
 
+/* Alias files named on the command line, kept (as absolute paths) for AliasReload */
+struct alias_file {
+	struct alias_file * next ;
+	ASCII * name ;
+} ;
+static struct alias_file * alias_file_list = NULL ;
+
+/* set by SIGHUP, acted on by AliasReloadCheck */
+static volatile sig_atomic_t alias_reload_requested = 0 ;
+
+static GOOD_OR_BAD ReadAliasFile_records(const ASCII * file, struct memblob * mb) ;
+static void AliasFileRemember(const ASCII * file) ;
+static ASCII * Test_Alias( ASCII * name, const BYTE * sn ) ;
+#if OW_MT
+static void * AliasReload_thread(void * v) ;
+#endif /* OW_MT */
+
+/* Read an alias file (command line option) and add its aliases */
 GOOD_OR_BAD ReadAliasFile(const ASCII * file)
+{
+	struct memblob mb ;
+
+	MemblobInit( &mb, PATH_MAX ) ;
+	if ( BAD( ReadAliasFile_records( file, &mb ) ) ) {
+		MemblobClear( &mb ) ;
+		return gbBAD ;
+	}
+	AliasFileRemember( file ) ;
+	if ( BAD( Cache_Load_Aliases( &mb, 0 ) ) ) {
+		LEVEL_DEFAULT("Cannot load the aliases from %s", file);
+	}
+	MemblobClear( &mb ) ;
+	return gbGOOD;
+}
+
+/* Read the alias files again -- their contents replace all current aliases */
+/* readers keep using the old aliases until the new ones are complete */
+/* a file that can't be read leaves the aliases unchanged */
+GOOD_OR_BAD AliasReload(void)
+{
+	struct memblob mb ;
+	struct alias_file * af ;
+	GOOD_OR_BAD ret ;
+
+	if ( alias_file_list == NULL ) {
+		LEVEL_DEBUG("No alias files to reload");
+		return gbBAD ;
+	}
+
+	MemblobInit( &mb, PATH_MAX ) ;
+	for ( af = alias_file_list ; af != NULL ; af = af->next ) {
+		if ( BAD( ReadAliasFile_records( af->name, &mb ) ) ) {
+			MemblobClear( &mb ) ;
+			return gbBAD ;
+		}
+	}
+	ret = Cache_Load_Aliases( &mb, 1 ) ;
+	MemblobClear( &mb ) ;
+	LEVEL_CALL("Alias files reloaded%s", GOOD(ret) ? "" : " -- failed" ) ;
+	return ret ;
+}
+
+/* From the SIGHUP handler -- only sets a flag */
+void AliasReloadRequest(void)
+{
+	alias_reload_requested = 1 ;
+}
+
+/* Called as each request is parsed: start a reload if SIGHUP asked for one */
+void AliasReloadCheck(void)
+{
+#if OW_MT
+	pthread_t thread ;
+#endif /* OW_MT */
+
+	if ( alias_reload_requested == 0 ) {
+		return ;
+	}
+	alias_reload_requested = 0 ;
+#if OW_MT
+	// in the background, so this request isn't held up by the file reads
+	if ( pthread_create( &thread, DEFAULT_THREAD_ATTR, AliasReload_thread, NULL ) == 0 ) {
+		pthread_detach( thread ) ;
+		return ;
+	}
+	ERROR_DEBUG("Cannot start the alias reload thread") ;
+#endif /* OW_MT */
+	AliasReload() ;
+}
+
+#if OW_MT
+static void * AliasReload_thread(void * v)
+{
+	(void) v ;
+	AliasReload() ;
+	return VOID_RETURN ;
+}
+#endif /* OW_MT */
+
+/* Forget the alias file names -- at library close, single threaded */
+void AliasClose(void)
+{
+	while ( alias_file_list != NULL ) {
+		struct alias_file * af = alias_file_list ;
+		alias_file_list = af->next ;
+		owfree( af->name ) ;
+		owfree( af ) ;
+	}
+}
+
+static void AliasFileRemember(const ASCII * file)
+{
+	char resolved[PATH_MAX+1] ;
+	struct alias_file * af ;
+	const ASCII * name = file ;
+
+	// the daemon changes directory, so keep the full path
+	if ( realpath( file, resolved ) != NULL ) {
+		name = resolved ;
+	}
+	for ( af = alias_file_list ; af != NULL ; af = af->next ) {
+		if ( strcmp( af->name, name ) == 0 ) {
+			return ;
+		}
+	}
+
+	af = owmalloc( sizeof(struct alias_file) ) ;
+	if ( af == NULL ) {
+		return ;
+	}
+	af->name = owstrdup( name ) ;
+	if ( af->name == NULL ) {
+		owfree( af ) ;
+		return ;
+	}
+	// keep command line order, later files win
+	af->next = NULL ;
+	if ( alias_file_list == NULL ) {
+		alias_file_list = af ;
+	} else {
+		struct alias_file * last = alias_file_list ;
+		while ( last->next != NULL ) {
+			last = last->next ;
+		}
+		last->next = af ;
+	}
+}
+
+/* Add each good line of the alias file to mb -- 8 byte serial number then null-terminated name */
+static GOOD_OR_BAD ReadAliasFile_records(const ASCII * file, struct memblob * mb)
 {
 	FILE *alias_file_pointer ;
 
@@ -69,7 +218,11 @@ GOOD_OR_BAD ReadAliasFile(const ASCII * file)
 					}
 					name_char[--len] = '\0'  ;
 				}
-				Test_and_Add_Alias( name_char, sn) ;
+				name_char = Test_Alias( name_char, sn ) ;
+				if ( name_char != NULL ) {
+					MemblobAdd( sn, SERIAL_NUMBER_SIZE, mb ) ;
+					MemblobAdd( (BYTE *) name_char, strlen(name_char)+1, mb ) ;
+				}
 				break ;
 			}
 		}
@@ -78,7 +231,7 @@ GOOD_OR_BAD ReadAliasFile(const ASCII * file)
 		free(alias_line) ; // not owfree since allocated by getline
 	}
 	fclose(alias_file_pointer);
-	return gbGOOD;
+	return MemblobPure( mb ) ? gbGOOD : gbBAD ;
 }
 
 /* Name is a null-terminated string */
@@ -87,12 +240,10 @@ GOOD_OR_BAD ReadAliasFile(const ASCII * file)
  * 2. Checks name length
  * 3. Refuses reserved words
  * 4. Refuses path separator (/)
- * 5. Removes any old assignments to name or serial number
- * 6. Add new alias
+ * Returns the trimmed name, or NULL if refused
  * */
-GOOD_OR_BAD Test_and_Add_Alias( char * name, BYTE * sn )
+static ASCII * Test_Alias( ASCII * name, const BYTE * sn )
 {
-	BYTE sn_stored[SERIAL_NUMBER_SIZE] ;
 	size_t len ;
 
 	// Parse off initial spaces
@@ -111,7 +262,7 @@ GOOD_OR_BAD Test_and_Add_Alias( char * name, BYTE * sn )
 	// Check length
 	if ( len > PROPERTY_LENGTH_ALIAS ) {
 		LEVEL_CALL("Alias too long: sn=" SNformat ", Alias=%s, Length=%d, Max length=%d", SNvar(sn), name,  (int) len, PROPERTY_LENGTH_ALIAS ) ;
-		return gbBAD ;
+		return NULL ;
 	}
 
 	// Reserved word?
@@ -127,30 +278,27 @@ GOOD_OR_BAD Test_and_Add_Alias( char * name, BYTE * sn )
 	|| strncmp( name, "bus.", 4 )==0
 	) {
 		LEVEL_CALL("Alias attempts to redefine reserved filename: %s",name ) ;
-		return gbBAD ;
+		return NULL ;
 	}
 
 	// No path separator allowed in name
 	if ( strchr( name, '/' ) ) {
 		LEVEL_CALL("Alias contains confusing path separator \'/\': %s",name ) ;
-		return gbBAD ;
-	}
-
-	// Is there another assignment for this alias name already?
-	if ( GOOD( Cache_Get_Alias_SN( name, sn_stored ) ) ) {
-		if ( memcmp( sn, sn_stored, SERIAL_NUMBER_SIZE ) == 0 ) {
-			// repeat assignment
-			return gbGOOD ;
-		}
-		// delete old serial number
-		LEVEL_CALL("Alias %s reassigned from "SNformat" to "SNformat,name,SNvar(sn_stored),SNvar(sn)) ;
-		Cache_Del_Alias(sn_stored) ;
+		return NULL ;
 	}
 
-	// Delete any prior assignments for this serial number
-	Cache_Del_Alias(sn) ;
+	return name ;
+}
 
-	// Now add
+/* Check the name (Test_Alias) then assign it to sn
+ * Any other serial number using this name, and any old name for sn, are dropped
+ * */
+GOOD_OR_BAD Test_and_Add_Alias( char * name, BYTE * sn )
+{
+	name = Test_Alias( name, sn ) ;
+	if ( name == NULL ) {
+		return gbBAD ;
+	}
 	return Cache_Add_Alias( name, sn) ;
 }
 
@@ -163,9 +311,11 @@ void FS_dir_entry_aliased(void (*dirfunc) (void *, const struct parsedname *), v
 
 		ASCII path[PATH_MAX+3] ;
 		ASCII * path_pointer = path ; // current location in original path
+		ASCII alias_path[PATH_MAX+3] ; // new path for the copy (shallow copy shares the original's)
 
 		// Shallow copy
 		memcpy( pn_copy, pn, sizeof(struct parsedname) ) ;
+		pn_copy->path = alias_path ;
 		pn_copy->path[0] = '\0' ;
 
 		// path copy to use for separation
@@ -186,19 +336,17 @@ void FS_dir_entry_aliased(void (*dirfunc) (void *, const struct parsedname *), v
 			if ( Parse_SerialNumber(path_segment,sn) == sn_valid ) {
 				//printf("We see serial number in path "SNformat"\n",SNvar(sn)) ;
 				// now test for alias
-				ASCII * name = Cache_Get_Alias( sn ) ;
-				if ( name != NULL ) {
+				ASCII name[PROPERTY_LENGTH_ALIAS+1] ;
+				if ( GOOD( Cache_Get_Alias( name, PROPERTY_LENGTH_ALIAS+1, sn ) ) ) {
 					//printf("It's aliased to %s\n",name);
 					// now test for room
 					if ( PATH_MAX < strlen(pn_copy->path) + strlen(name) ) {
 						// too long, just use initial copy
 						strcpy( pn_copy->path, pn->path ) ;
-						owfree(name) ;
 						break ;
 					}
 					// overwrite serial number with alias name
 					strcat( pn_copy->path, name ) ;
-					owfree( name ) ;
 				} else {
 					strcat( pn_copy->path, path_segment ) ;
 				}
@@ -0,0 +1,423 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: palfille@earthlink.net
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Alias table -- serial number <-> alias name
+ * Aliases come from the alias files (--alias), writes to a device's alias property
+ * and aliases found on remote owservers.
+ * Every parse of an aliased path and every entry of a directory listing looks here,
+ * so readers see an immutable snapshot, hashed both ways, and take no lock and
+ * allocate nothing.
+ * A change builds a whole new snapshot and swaps it in. Writers are serialized by
+ * ALIASTABLELOCK, and free the old snapshot once no reader can still be using it:
+ * readers count themselves in one of two counters (alias_readers) picked by
+ * alias_epoch, and after the swap the writer flips the epoch and waits for the
+ * old counter to drain -- twice, so both counters have been empty since the swap.
+ * Without atomics, readers take ALIASTABLELOCK instead.
+ */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+
+#if OW_CACHE
+
+struct alias_entry {
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+	UINT name_hash ;
+	const ASCII * name ;
+} ;
+
+struct alias_snapshot {
+	UINT count ;
+	UINT mask ;						// hash slots - 1
+	struct alias_entry * entry ;	// sorted by serial number (alias list order)
+	UINT * by_sn ;					// slot -> entry index + 1, 0 for empty
+	UINT * by_name ;
+} ;
+
+#define ALIAS_SLOTS_MIN	16
+
+static struct alias_snapshot * volatile alias_current = NULL ;
+
+#if OW_MT && defined(HAVE_SYNC_FETCH_AND_ADD)
+static UINT alias_readers[2] ;
+static volatile UINT alias_epoch = 0 ;
+#endif /* OW_MT && HAVE_SYNC_FETCH_AND_ADD */
+
+static const struct alias_snapshot * AliasSnapshotEnter( UINT * epoch ) ;
+static void AliasSnapshotLeave( UINT epoch ) ;
+static void AliasSnapshotPublish( struct alias_snapshot * snap ) ;
+static struct alias_snapshot * AliasSnapshotBuild( struct alias_entry * candidate, UINT count ) ;
+static GOOD_OR_BAD AliasSnapshotReplace( const struct alias_entry * first, const struct alias_entry * more, UINT more_count, int keep_current ) ;
+static int AliasFindSN( const UINT * by_sn, UINT mask, const struct alias_entry * entry, const BYTE * sn ) ;
+static int AliasFindName( const UINT * by_name, UINT mask, const struct alias_entry * entry, const ASCII * name, UINT name_hash ) ;
+static int alias_sn_compare( const void * a, const void * b ) ;
+
+/* Both indexes hash with FNV-1a (ow_crc.c) */
+#define AliasNameHash( name )	FNV1a_string( name, 0 )
+#define AliasSNHash( sn )		FNV1a( sn, SERIAL_NUMBER_SIZE, 0 )
+
+/* entry index, or -1 */
+static int AliasFindSN( const UINT * by_sn, UINT mask, const struct alias_entry * entry, const BYTE * sn )
+{
+	UINT slot ;
+
+	for ( slot = AliasSNHash( sn ) ; by_sn[slot & mask] != 0 ; ++slot ) {
+		int index = by_sn[slot & mask] - 1 ;
+		if ( memcmp( entry[index].sn, sn, SERIAL_NUMBER_SIZE ) == 0 ) {
+			return index ;
+		}
+	}
+	return -1 ;
+}
+
+/* entry index, or -1 */
+static int AliasFindName( const UINT * by_name, UINT mask, const struct alias_entry * entry, const ASCII * name, UINT name_hash )
+{
+	UINT slot ;
+
+	for ( slot = name_hash ; by_name[slot & mask] != 0 ; ++slot ) {
+		int index = by_name[slot & mask] - 1 ;
+		if ( entry[index].name_hash == name_hash && strcmp( entry[index].name, name ) == 0 ) {
+			return index ;
+		}
+	}
+	return -1 ;
+}
+
+static int alias_sn_compare( const void * a, const void * b )
+{
+	return memcmp( ((const struct alias_entry *) a)->sn, ((const struct alias_entry *) b)->sn, SERIAL_NUMBER_SIZE ) ;
+}
+
+#if OW_MT && defined(HAVE_SYNC_FETCH_AND_ADD)
+
+static const struct alias_snapshot * AliasSnapshotEnter( UINT * epoch )
+{
+	epoch[0] = alias_epoch & 1 ;
+	(void) __sync_fetch_and_add( &alias_readers[epoch[0]], 1 ) ;	// full barrier -- snapshot is read after we're counted
+	return alias_current ;
+}
+
+static void AliasSnapshotLeave( UINT epoch )
+{
+	(void) __sync_fetch_and_sub( &alias_readers[epoch], 1 ) ;
+}
+
+/* Called with ALIASTABLELOCK */
+static void AliasSnapshotPublish( struct alias_snapshot * snap )
+{
+	struct alias_snapshot * old = alias_current ;
+	int round ;
+
+	__sync_synchronize() ;	// snapshot contents before the pointer
+	alias_current = snap ;
+	__sync_synchronize() ;
+
+	// new readers go to the other counter, so this one only drains
+	for ( round = 0 ; round < 2 ; ++round ) {
+		UINT epoch = alias_epoch & 1 ;
+		alias_epoch = epoch ^ 1 ;
+		__sync_synchronize() ;
+		while ( __sync_fetch_and_add( &alias_readers[epoch], 0 ) != 0 ) {
+			UT_delay_us( 10 ) ;
+		}
+	}
+	SAFEFREE( old ) ;
+}
+
+#else /* OW_MT && HAVE_SYNC_FETCH_AND_ADD */
+
+static const struct alias_snapshot * AliasSnapshotEnter( UINT * epoch )
+{
+	epoch[0] = 0 ;
+	ALIASTABLELOCK ;
+	return alias_current ;
+}
+
+static void AliasSnapshotLeave( UINT epoch )
+{
+	(void) epoch ;
+	ALIASTABLEUNLOCK ;
+}
+
+/* Called with ALIASTABLELOCK -- so no readers */
+static void AliasSnapshotPublish( struct alias_snapshot * snap )
+{
+	struct alias_snapshot * old = alias_current ;
+
+	alias_current = snap ;
+	SAFEFREE( old ) ;
+}
+
+#endif /* OW_MT && HAVE_SYNC_FETCH_AND_ADD */
+
+/* One allocation holding the snapshot, its entries, both hash tables and the names */
+/* Candidates are in priority order: a serial number or name already taken by an earlier candidate is dropped */
+/* A candidate with an empty name just takes its serial number (removes its alias) */
+static struct alias_snapshot * AliasSnapshotBuild( struct alias_entry * candidate, UINT count )
+{
+	UINT slots = ALIAS_SLOTS_MIN ;
+	size_t name_bytes = 0 ;
+	struct alias_snapshot * snap ;
+	ASCII * name_store ;
+	UINT kept = 0 ;
+	UINT i ;
+
+	while ( slots < 2 * count ) {
+		slots <<= 1 ;
+	}
+	for ( i = 0 ; i < count ; ++i ) {
+		name_bytes += strlen( candidate[i].name ) + 1 ;
+	}
+
+	snap = owcalloc( 1, sizeof(struct alias_snapshot) + count * sizeof(struct alias_entry) + 2 * slots * sizeof(UINT) + name_bytes ) ;
+	if ( snap == NULL ) {
+		return NULL ;
+	}
+	snap->mask = slots - 1 ;
+	snap->entry = (struct alias_entry *) &snap[1] ;
+	snap->by_sn = (UINT *) &(snap->entry[count]) ;
+	snap->by_name = &(snap->by_sn[slots]) ;
+	name_store = (ASCII *) &(snap->by_name[slots]) ;
+
+	// first pass -- claim serial numbers and names in priority order (tables index the candidates)
+	for ( i = 0 ; i < count ; ++i ) {
+		UINT slot ;
+
+		candidate[i].name_hash = AliasNameHash( candidate[i].name ) ;
+		if ( AliasFindSN( snap->by_sn, snap->mask, candidate, candidate[i].sn ) >= 0 ) {
+			continue ;
+		}
+		if ( candidate[i].name[0] != '\0' && AliasFindName( snap->by_name, snap->mask, candidate, candidate[i].name, candidate[i].name_hash ) >= 0 ) {
+			continue ;
+		}
+		for ( slot = AliasSNHash( candidate[i].sn ) ; snap->by_sn[slot & snap->mask] != 0 ; ++slot ) {
+		}
+		snap->by_sn[slot & snap->mask] = i + 1 ;
+		if ( candidate[i].name[0] == '\0' ) {
+			continue ;
+		}
+		for ( slot = candidate[i].name_hash ; snap->by_name[slot & snap->mask] != 0 ; ++slot ) {
+		}
+		snap->by_name[slot & snap->mask] = i + 1 ;
+		memcpy( &(snap->entry[kept]), &candidate[i], sizeof(struct alias_entry) ) ;
+		++kept ;
+	}
+
+	// second pass -- sort the survivors and index them
+	qsort( snap->entry, kept, sizeof(struct alias_entry), alias_sn_compare ) ;
+	memset( snap->by_sn, 0, 2 * slots * sizeof(UINT) ) ;
+	for ( i = 0 ; i < kept ; ++i ) {
+		struct alias_entry * ae = &(snap->entry[i]) ;
+		size_t length = strlen( ae->name ) + 1 ;
+		UINT slot ;
+
+		memcpy( name_store, ae->name, length ) ;
+		ae->name = name_store ;
+		name_store += length ;
+		for ( slot = AliasSNHash( ae->sn ) ; snap->by_sn[slot & snap->mask] != 0 ; ++slot ) {
+		}
+		snap->by_sn[slot & snap->mask] = i + 1 ;
+		for ( slot = ae->name_hash ; snap->by_name[slot & snap->mask] != 0 ; ++slot ) {
+		}
+		snap->by_name[slot & snap->mask] = i + 1 ;
+	}
+	snap->count = kept ;
+	return snap ;
+}
+
+/* New snapshot from: first (if any), then more[], then the current aliases (if keep_current) */
+/* earlier ones win any serial number or name conflict */
+static GOOD_OR_BAD AliasSnapshotReplace( const struct alias_entry * first, const struct alias_entry * more, UINT more_count, int keep_current )
+{
+	const struct alias_snapshot * current ;
+	struct alias_entry * candidate ;
+	struct alias_snapshot * snap ;
+	UINT count = 0 ;
+
+	ALIASTABLELOCK ;
+	current = alias_current ;	// only writers change it, and we're the writer
+	candidate = owmalloc( ( 1 + more_count + ( ( keep_current && current != NULL ) ? current->count : 0 ) ) * sizeof(struct alias_entry) ) ;
+	if ( candidate == NULL ) {
+		ALIASTABLEUNLOCK ;
+		return gbBAD ;
+	}
+	if ( first != NULL ) {
+		memcpy( &candidate[count++], first, sizeof(struct alias_entry) ) ;
+	}
+	if ( more_count > 0 ) {
+		memcpy( &candidate[count], more, more_count * sizeof(struct alias_entry) ) ;
+		count += more_count ;
+	}
+	if ( keep_current && current != NULL ) {
+		memcpy( &candidate[count], current->entry, current->count * sizeof(struct alias_entry) ) ;
+		count += current->count ;
+	}
+
+	snap = AliasSnapshotBuild( candidate, count ) ;
+	owfree( candidate ) ;
+	if ( snap == NULL ) {
+		ALIASTABLEUNLOCK ;
+		return gbBAD ;
+	}
+	AliasSnapshotPublish( snap ) ;
+	ALIASTABLEUNLOCK ;
+
+	ParseCache_Flush() ; // paths using these aliases now parse differently
+	return gbGOOD ;
+}
+
+/* Assign name to sn, taking it from any other serial number and replacing sn's old alias */
+/* An empty name just removes sn's alias */
+GOOD_OR_BAD Cache_Add_Alias(const ASCII *name, const BYTE * sn)
+{
+	struct alias_entry ae ;
+	ASCII stored[PROPERTY_LENGTH_ALIAS+1] ;
+
+	if ( strlen( name ) > PROPERTY_LENGTH_ALIAS ) {
+		LEVEL_DEBUG("Alias too long for " SNformat, SNvar(sn));
+		return gbBAD ;
+	}
+	if ( GOOD( Cache_Get_Alias( stored, PROPERTY_LENGTH_ALIAS+1, sn ) ) ) {
+		if ( strcmp( stored, name ) == 0 ) {
+			// repeat assignment
+			return gbGOOD ;
+		}
+	} else if ( name[0] == '\0' ) {
+		// nothing to remove
+		return gbGOOD ;
+	}
+
+	LEVEL_DEBUG("Adding alias for " SNformat " = %s", SNvar(sn), name);
+	memcpy( ae.sn, sn, SERIAL_NUMBER_SIZE ) ;
+	ae.name = name ;
+	return AliasSnapshotReplace( &ae, NULL, 0, 1 ) ;
+}
+
+// Delete a serial number's alias
+// Safe to call if no alias exists
+void Cache_Del_Alias(const BYTE * sn)
+{
+	Cache_Add_Alias( "", sn ) ;
+}
+
+/* Load aliases collected from alias files */
+/* mb holds records of an 8-byte serial number followed by a null-terminated name, later records win */
+/* replace: the records become the whole table, otherwise they are added to it */
+GOOD_OR_BAD Cache_Load_Aliases(struct memblob * mb, int replace)
+{
+	const BYTE * data = MemblobData( mb ) ;
+	size_t length = MemblobLength( mb ) ;
+	size_t offset ;
+	struct alias_entry * record ;
+	UINT count = 0 ;
+	UINT i ;
+	GOOD_OR_BAD ret ;
+
+	for ( offset = 0 ; offset + SERIAL_NUMBER_SIZE < length ; ++count ) {
+		offset += SERIAL_NUMBER_SIZE ;
+		offset += strlen( (const ASCII *) &data[offset] ) + 1 ;
+	}
+
+	record = owmalloc( ( count + 1 ) * sizeof(struct alias_entry) ) ;
+	if ( record == NULL ) {
+		return gbBAD ;
+	}
+	// last record first, so it wins
+	for ( offset = 0, i = count ; i > 0 ; --i ) {
+		memcpy( record[i-1].sn, &data[offset], SERIAL_NUMBER_SIZE ) ;
+		offset += SERIAL_NUMBER_SIZE ;
+		record[i-1].name = (const ASCII *) &data[offset] ;
+		offset += strlen( record[i-1].name ) + 1 ;
+	}
+
+	ret = AliasSnapshotReplace( NULL, record, count, ! replace ) ;
+	owfree( record ) ;
+	return ret ;
+}
+
+/* Copy sn's alias into alias_name (length bytes, including the null) */
+/* no allocation -- gbBAD if no alias (or it doesn't fit) */
+GOOD_OR_BAD Cache_Get_Alias(ASCII * alias_name, size_t length, const BYTE * sn)
+{
+	GOOD_OR_BAD ret = gbBAD ;
+	UINT epoch ;
+	const struct alias_snapshot * snap = AliasSnapshotEnter( &epoch ) ;
+
+	if ( snap != NULL ) {
+		int index = AliasFindSN( snap->by_sn, snap->mask, snap->entry, sn ) ;
+		if ( index >= 0 && strlen( snap->entry[index].name ) < length ) {
+			strcpy( alias_name, snap->entry[index].name ) ;
+			ret = gbGOOD ;
+		}
+	}
+	AliasSnapshotLeave( epoch ) ;
+	return ret ;
+}
+
+/* sn must point to an 8 byte buffer */
+/* Alias name must be a null-terminated string */
+GOOD_OR_BAD Cache_Get_Alias_SN(const ASCII * alias_name, BYTE * sn )
+{
+	GOOD_OR_BAD ret = gbBAD ;
+	UINT epoch ;
+	const struct alias_snapshot * snap ;
+
+	if ( alias_name[0] == '\0' ) {
+		return gbBAD ;
+	}
+
+	snap = AliasSnapshotEnter( &epoch ) ;
+	if ( snap != NULL ) {
+		int index = AliasFindName( snap->by_name, snap->mask, snap->entry, alias_name, AliasNameHash( alias_name ) ) ;
+		if ( index >= 0 ) {
+			memcpy( sn, snap->entry[index].sn, SERIAL_NUMBER_SIZE ) ;
+			ret = gbGOOD ;
+		}
+	}
+	AliasSnapshotLeave( epoch ) ;
+	return ret ;
+}
+
+// Alias list
+// formatted as an alias file:
+// NNNNNNNNNNNN=alias_name\n
+void Aliaslist( struct memblob * mb  )
+{
+	UINT epoch ;
+	const struct alias_snapshot * snap = AliasSnapshotEnter( &epoch ) ;
+	UINT i ;
+
+	for ( i = 0 ; snap != NULL && i < snap->count ; ++i ) {
+		char SN_address[SERIAL_NUMBER_SIZE*2] ;
+		const struct alias_entry * ae = &(snap->entry[i]) ;
+
+		// Add sn address
+		bytes2string(SN_address, ae->sn, SERIAL_NUMBER_SIZE);
+		MemblobAdd( (BYTE *) SN_address, SERIAL_NUMBER_SIZE*2, mb ) ;
+		// Add '='
+		MemblobAdd( (BYTE *) "=", 1, mb ) ;
+		// Add alias name
+		MemblobAdd( (const BYTE *) ae->name, strlen( ae->name ), mb ) ;
+		// Add <CR>
+		MemblobAdd( (BYTE *) "\x0D\x0A", 2, mb ) ;
+	}
+	AliasSnapshotLeave( epoch ) ;
+}
+
+/* Note: done in single-threaded mode so no readers are left */
+void Cache_Close_Aliases(void)
+{
+	SAFEFREE( alias_current ) ;
+}
+
+#endif							/* OW_CACHE */
@@ -67,10 +67,9 @@ void BUS_unlock_in(struct connection_in *in)
 	}
 	timersub( &tv, &(in->last_lock), &tv ) ;
 
-	STATLOCK;
+	// bus_time is only changed here, under bus_mutex
 	timeradd( &tv, &(in->bus_time), &(in->bus_time) ) ;
-	++in->bus_stat[e_bus_unlocks];
-	STATUNLOCK;
+	STAT_ADD1_BUS(e_bus_unlocks, in);
 
 	if (get_busmode(in) == bus_i2c && in->master.i2c.channels > 1) {
 		_MUTEX_UNLOCK(in->master.i2c.head->master.i2c.all_channel_lock);
@@ -0,0 +1,202 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+	email: palfille@earthlink.net
+	Released under the GPL
+	See the header file: ow.h for full attribution
+	1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Bus workers
+ * Fan-outs over all buses (directory listing, presence search) hand each bus its job
+ * instead of creating a thread per bus per request.
+ * Each bus master (connection_in) gets one persistent worker thread with a FIFO queue,
+ * started on first use and stopped when the connection is removed.
+ * A bus is serialized by its bus lock anyway, so one worker per bus bounds concurrency
+ * without losing parallelism between buses.
+ * Jobs are run inline if the worker can't be started, or if the caller is itself
+ * a bus worker (a nested fan-out must not wait on a queue it is blocking).
+ */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_connection.h"
+
+#if OW_MT
+
+struct bus_worker {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;		// a job was queued or the worker should stop
+	struct bus_job *head;		// FIFO of queued jobs
+	struct bus_job *tail;
+	int stop;
+};
+
+static pthread_key_t bus_worker_key;	// set in worker threads only
+static pthread_once_t bus_worker_key_once = PTHREAD_ONCE_INIT;
+
+static void BusWorker_key_create(void);
+static void *BusWorker_loop(void *v);
+static struct bus_worker *BusWorker_get(struct connection_in *in);
+static void BusJob_done(struct bus_job *job);
+
+static void BusWorker_key_create(void)
+{
+	pthread_key_create(&bus_worker_key, NULL);
+}
+
+void BusJobGroupInit(struct bus_job_group *group)
+{
+	_MUTEX_INIT(group->mutex);
+	my_pthread_cond_init(&(group->cond), NULL);
+	group->pending = 0;
+}
+
+/* Queue job->run(job->arg) for the bus, or run it now */
+void BusJobSubmit(struct bus_job_group *group, struct bus_job *job, struct connection_in *in)
+{
+	struct bus_worker *bw;
+
+	job->group = group;
+	job->next = NULL;
+
+	pthread_once(&bus_worker_key_once, BusWorker_key_create);
+	if (pthread_getspecific(bus_worker_key) != NULL || (bw = BusWorker_get(in)) == NULL) {
+		job->run(job->arg);
+		return;
+	}
+
+	_MUTEX_LOCK(group->mutex);
+	++group->pending;
+	_MUTEX_UNLOCK(group->mutex);
+
+	_MUTEX_LOCK(bw->mutex);
+	if (bw->tail == NULL) {
+		bw->head = job;
+	} else {
+		bw->tail->next = job;
+	}
+	bw->tail = job;
+	my_pthread_cond_signal(&(bw->cond));
+	_MUTEX_UNLOCK(bw->mutex);
+}
+
+/* Wait for every queued job of the group, then release the group */
+void BusJobGroupWait(struct bus_job_group *group)
+{
+	_MUTEX_LOCK(group->mutex);
+	while (group->pending > 0) {
+		my_pthread_cond_wait(&(group->cond), &(group->mutex));
+	}
+	_MUTEX_UNLOCK(group->mutex);
+	my_pthread_cond_destroy(&(group->cond));
+	_MUTEX_DESTROY(group->mutex);
+}
+
+static void BusJob_done(struct bus_job *job)
+{
+	struct bus_job_group *group = job->group;
+
+	_MUTEX_LOCK(group->mutex);
+	if (--group->pending == 0) {
+		my_pthread_cond_signal(&(group->cond));
+	}
+	_MUTEX_UNLOCK(group->mutex);
+}
+
+/* The connection's worker, started on first use */
+/* NULL if it can't be started */
+static struct bus_worker *BusWorker_get(struct connection_in *in)
+{
+	struct bus_worker *bw;
+
+	BUSWORKERLOCK;
+	bw = in->worker;
+	if (bw == NULL) {
+		bw = owmalloc(sizeof(struct bus_worker));
+		if (bw != NULL) {
+			memset(bw, 0, sizeof(struct bus_worker));
+			_MUTEX_INIT(bw->mutex);
+			my_pthread_cond_init(&(bw->cond), NULL);
+			if (pthread_create(&(bw->thread), DEFAULT_THREAD_ATTR, BusWorker_loop, (void *) bw) == 0) {
+				LEVEL_DEBUG("Started bus worker for bus %d", in->index);
+				in->worker = bw;
+			} else {
+				LEVEL_DEBUG("Cannot start bus worker for bus %d -- run jobs inline", in->index);
+				my_pthread_cond_destroy(&(bw->cond));
+				_MUTEX_DESTROY(bw->mutex);
+				owfree(bw);
+				bw = NULL;
+			}
+		}
+	}
+	BUSWORKERUNLOCK;
+	return bw;
+}
+
+static void *BusWorker_loop(void *v)
+{
+	struct bus_worker *bw = v;
+
+	pthread_setspecific(bus_worker_key, bw);
+
+	_MUTEX_LOCK(bw->mutex);
+	for (;;) {
+		struct bus_job *job = bw->head;
+
+		if (job == NULL) {
+			if (bw->stop) {
+				break;
+			}
+			my_pthread_cond_wait(&(bw->cond), &(bw->mutex));
+			continue;
+		}
+		bw->head = job->next;
+		if (bw->head == NULL) {
+			bw->tail = NULL;
+		}
+		_MUTEX_UNLOCK(bw->mutex);
+
+		job->run(job->arg);
+		BusJob_done(job);
+
+		_MUTEX_LOCK(bw->mutex);
+	}
+	_MUTEX_UNLOCK(bw->mutex);
+	return VOID_RETURN;
+}
+
+/* Stop and free the connection's worker (connection being removed) */
+/* Called with CONNIN_WLOCK, so no fan-out is in progress */
+void BusWorkerStop(struct connection_in *in)
+{
+	struct bus_worker *bw = in->worker;
+
+	if (bw == NULL) {
+		return;
+	}
+	in->worker = NULL;
+
+	_MUTEX_LOCK(bw->mutex);
+	bw->stop = 1;
+	my_pthread_cond_signal(&(bw->cond));
+	_MUTEX_UNLOCK(bw->mutex);
+
+	pthread_join(bw->thread, NULL);
+	my_pthread_cond_destroy(&(bw->cond));
+	_MUTEX_DESTROY(bw->mutex);
+	owfree(bw);
+}
+
+#else							/* OW_MT */
+
+void BusWorkerStop(struct connection_in *in)
+{
+	(void) in;					// suppress compiler warning in the trivial case.
+}
+
+#endif							/* OW_MT */
@@ -39,29 +39,36 @@ void * MainDirectory_Marker = &MainDirMarkerLoc ;
 int DevMarkerLoc ;
 void * Device_Marker = &DevMarkerLoc ;
 
-// Aliases are sn-based
-// generic unique address for devices.
-int AliasMarkerLoc ;
-void * Alias_Marker = &AliasMarkerLoc ;
-
 // Simultaneous Dir are bus-based
 // generic unique address for Simultaneous.
 int SimulMarkerLoc[simul_end] ;
 void * Simul_Marker[] = { &SimulMarkerLoc[simul_temp], &SimulMarkerLoc[simul_volt], } ;
 
+/* Volatile entries are hashed on their key into CACHE_SHARDS trees.
+   Each shard has its own lock (Mutex.cache_shard) so lookups of different
+   sensors don't contend, and expired entries are purged a shard at a time */
+struct cache_shard {
+	void *temporary_tree;				// cache database for this shard
+	size_t ram_size;					// bytes held (nodes, data and tree overhead)
+	struct tree_node *clock_hand;		// next eviction candidate on the ring of entries (NULL if empty)
+	UINT entries;						// entries on the ring
+	time_t next_sweep;					// time to purge expired entries
+};
+
+/* Most expired entries removed from a shard in one pass (bounds lock hold time) */
+#define CACHE_SWEEP_BATCH	64
+
 /* Put the globals into a struct to declutter the namespace */
 struct cache_data {
-	void *temporary_tree_new;			// current cache database
-	void *temporary_tree_old;			// older cache database
+	struct cache_shard shard[CACHE_SHARDS];	// volatile property cache
 	void *persistent_tree;				// persistent database
 	void *temporary_alias_tree_new;		// current cache database
 	void *temporary_alias_tree_old;		// older cache database
-	void *persistent_alias_tree;		// persistent database
-	size_t old_ram_size;				// cache size
-	size_t new_ram_size;				// cache size
+	size_t old_ram_size;				// alias cache size
+	size_t new_ram_size;				// alias cache size
 	time_t time_retired;				// start time of older
 	time_t time_to_kill;				// deathtime of older
-	time_t retired_lifespan;			// lifetime of older
+	time_t retired_lifespan;			// lifetime of older, also shard sweep interval
 	UINT added;					// items added
 };
 static struct cache_data cache;
@@ -84,6 +91,12 @@ static struct cache_data cache;
 	freed when cache node is freed
   Note: This means that cache data must be a copy of program data
         both on creation and retrieval
+  Memory budget (Globals.cache_size, split evenly over the shards)
+	every entry is charged its node, data and search tree node (CACHE_NODE_BYTES)
+	a full shard evicts with the CLOCK algorithm:
+	each shard keeps its entries on a ring, new entries just behind the hand
+	readers set "referenced", the hand clears it and evicts the first entry
+	that is unreferenced (or expired)
 */
 
 /* Key used for sorting/retrieving cache data
@@ -107,6 +120,10 @@ struct tree_node {
 	struct tree_key tk;
 	time_t expires;
 	size_t dsize;
+	struct tree_node *clock_next;	// ring of the shard's entries (volatile cache only)
+	struct tree_node *clock_prev;
+	enum fc_change change;			// for occupancy statistics
+	int referenced;					// read since the clock hand last passed
 };
 
 struct alias_tree_node {
@@ -127,14 +144,28 @@ struct tree_opaque {
 };
 
 #define TREE_DATA(tn)    ( (BYTE *)(tn) + sizeof(struct tree_node) )
+
+/* Memory charged for a cached entry: node, data and the tsearch node (key, left, right) */
+#define CACHE_TREE_OVERHEAD	( 3 * sizeof(void *) )
+#define CACHE_NODE_BYTES(tn)	( sizeof(struct tree_node) + (tn)->dsize + CACHE_TREE_OVERHEAD )
+
+/* Memory charged for an alias entry: node, name and the tsearch node */
+#define ALIAS_NODE_BYTES(atn)	( sizeof(struct alias_tree_node) + (atn)->size + 1 + CACHE_TREE_OVERHEAD )
 #define CONST_TREE_DATA(tn)    ( (const BYTE *)(tn) + sizeof(struct tree_node) )
 
 #define ALIAS_TREE_DATA(atn)    ( (ASCII *)(atn) + sizeof(struct alias_tree_node) )
 #define CONST_ALIAS_TREE_DATA(atn)    ( (const ASCII *)(atn) + sizeof(struct alias_tree_node) )
 
-enum cache_task_return { ctr_ok, ctr_not_found, ctr_expired, ctr_size_mismatch, } ;
+enum cache_task_return { ctr_ok, ctr_stale, ctr_not_found, ctr_expired, ctr_size_mismatch, } ;
 
-static void FlipTree( void ) ;
+static void FlipAliasTree( void ) ;
+static int CacheShard( const struct tree_node * tn ) ;
+static int Cache_Sweep_Shard( int shard, time_t now ) ;
+static void Cache_Ring_Insert( struct cache_shard * cs, struct tree_node * tn ) ;
+static void Cache_Ring_Remove( struct cache_shard * cs, struct tree_node * tn ) ;
+static void Cache_Ring_Replace( struct cache_shard * cs, struct tree_node * tn_old, struct tree_node * tn_new ) ;
+static void Cache_Forget( struct cache_shard * cs, struct tree_node * tn ) ;
+static void Cache_Evict_One( struct cache_shard * cs, time_t now ) ;
 
 static int IsThisPersistent( const struct parsedname * pn ) ;
 
@@ -142,7 +173,7 @@ static GOOD_OR_BAD Cache_Add(const void *data, const size_t datasize, const stru
 static GOOD_OR_BAD Cache_Add_Common(struct tree_node *tn);
 static GOOD_OR_BAD Cache_Add_Persistent(struct tree_node *tn);
 
-static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_t * duration, const struct tree_node *tn);
+static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_t * duration, const struct tree_node *tn, time_t grace);
 static enum cache_task_return Cache_Get_Common_Dir(struct dirblob *db, time_t * duration, const struct tree_node *tn);
 static enum cache_task_return Cache_Get_Persistent(void *data, size_t * dsize, time_t * duration, const struct tree_node *tn);
 
@@ -157,20 +188,13 @@ static GOOD_OR_BAD Cache_Del_Persistent(const struct tree_node *tn);
 static void Cache_Add_Alias_Common(struct alias_tree_node *atn);
 static INDEX_OR_ERROR Cache_Get_Alias_Common( struct alias_tree_node * atn) ;
 
-static void Cache_Add_Alias_SN(const ASCII * alias_name, const BYTE * sn) ;
-static void Cache_Del_Alias_SN(const ASCII * alias_name) ;
-
-static void Cache_Add_Alias_Persistent(struct alias_tree_node *atn);
-static enum cache_task_return Cache_Get_Alias_Persistent( BYTE * sn, struct alias_tree_node * atn);
-static void Cache_Del_Alias_Persistent( struct alias_tree_node * atn) ;
-
 static GOOD_OR_BAD Add_Stat(struct cache_stats *scache, GOOD_OR_BAD result);
 static GOOD_OR_BAD Get_Stat(struct cache_stats *scache, const enum cache_task_return result);
 static void Del_Stat(struct cache_stats *scache, const int result);
 
 static int tree_compare(const void *a, const void *b);
 static time_t TimeOut(const enum fc_change change);
-static void Aliaslistaction(const void *node, const VISIT which, const int depth) ;
+static time_t StaleGrace(const enum fc_change change);
 static void LoadTK( const BYTE * sn, void * p, int extension, struct tree_node * tn ) ;
 
 /* used for the sort/search b-tree routines */
@@ -220,6 +244,35 @@ static time_t TimeOut(const enum fc_change change)
 	}
 }
 
+/* Extra life of an expired property value (seconds), during which it is still
+   answered -- flagged stale -- while a background read refreshes it.
+   0 (the default) keeps the old behavior of reading the bus at expiry */
+static time_t StaleGrace(const enum fc_change change)
+{
+#if OW_MT
+	switch (change) {
+	case fc_volatile:
+	case fc_simultaneous_temperature:
+	case fc_simultaneous_voltage:
+		return Globals.stale_volatile;
+	case fc_stable:
+	case fc_read_stable:
+		return Globals.stale_stable;
+	default:
+		return 0;
+	}
+#else							/* OW_MT */
+	(void) change;
+	return 0;					// no background refresher (ow_refresh.c)
+#endif							/* OW_MT */
+}
+
+/* Cache lifetime (seconds) of a property type, 0 if not cached */
+time_t Cache_Timeout(const enum fc_change change)
+{
+	return TimeOut(change);
+}
+
 #ifdef CACHE_DEBUG
 /* debug routine -- shows a table */
 /* Run it as twalk(dababase, tree_show ) */
@@ -255,8 +308,11 @@ static void tree_show(const void *node, const VISIT which, const int depth)
 }
 static void new_tree(void)
 {
-	fprintf(stderr,"Walk the new tree:\n");
-	twalk(cache.temporary_tree_new, tree_show);
+	int shard ;
+	for ( shard = 0 ; shard < CACHE_SHARDS ; ++shard ) {
+		fprintf(stderr,"Walk shard %d:\n",shard);
+		twalk(cache.shard[shard].temporary_tree, tree_show);
+	}
 }
 #else							/* CACHE_DEBUG */
 #define new_tree()
@@ -272,6 +328,8 @@ static int IsThisPersistent( const struct parsedname * pn )
 /* Note: done in single-threaded mode so locking not yet needed */
 void Cache_Open(void)
 {
+	int shard ;
+
 	memset(&cache, 0, sizeof(struct cache_data));
 
 	cache.retired_lifespan = TimeOut(fc_stable);
@@ -279,8 +337,12 @@ void Cache_Open(void)
 		cache.retired_lifespan = 3600;	/* 1 hour tops */
 	}
 
-	// Flip once (at start) to set up old tree.
-	FlipTree() ;
+	for ( shard = 0 ; shard < CACHE_SHARDS ; ++shard ) {
+		cache.shard[shard].next_sweep = NOW_TIME + cache.retired_lifespan ;
+	}
+
+	// Flip once (at start) to set up old alias tree.
+	FlipAliasTree() ;
 }
 
 /* Note: done in a simgle single thread mode so locking not needed */
@@ -288,25 +350,29 @@ void Cache_Close(void)
 {
 	Cache_Clear() ;
 	SAFETDESTROY( cache.persistent_tree, owfree_func);
-	SAFETDESTROY( cache.persistent_alias_tree, owfree_func);
+	Cache_Close_Aliases() ;
 }
 
-/* Moves new to old tree, initializes new tree, and clears former old tree location */
-static void FlipTree( void )
+/* Pick the shard for a key -- FNV-1a hash over the whole tree_key */
+/* LoadTK clears the key first, so padding bytes are stable */
+static int CacheShard( const struct tree_node * tn )
+{
+	return FNV1a( (const BYTE *) &(tn->tk), sizeof(struct tree_key), 0 ) % CACHE_SHARDS ;
+}
+
+/* Moves new alias tree to old, initializes new tree, and clears former old tree location */
+/* Called with CACHE_WLOCK */
+static void FlipAliasTree( void )
 {
-	void * flip = cache.temporary_tree_old; // old old saved for later clearing
 	void * flip_alias = cache.temporary_alias_tree_old; // old old saved for later clearing
 
-	/* Flip caches! old = new. New truncated, reset time and counters and flag */
-	LEVEL_DEBUG("Flipping cache tree (purging timed-out data)");
+	LEVEL_DEBUG("Flipping alias cache tree (purging timed-out data)");
 
 	// move "new" pointers to "old"
-	cache.temporary_tree_old = cache.temporary_tree_new;
 	cache.old_ram_size = cache.new_ram_size;
 	cache.temporary_alias_tree_old = cache.temporary_alias_tree_new;
 
 	// New cache setup
-	cache.temporary_tree_new = NULL;
 	cache.temporary_alias_tree_new = NULL;
 	cache.new_ram_size = 0;
 	cache.added = 0;
@@ -316,23 +382,166 @@ static void FlipTree( void )
 	cache.time_to_kill = cache.time_retired + cache.retired_lifespan;
 
 	// delete really old tree
-	LEVEL_DEBUG("flip cache. tdestroy() will be called.");
-	SAFETDESTROY( flip, owfree_func);
 	SAFETDESTROY( flip_alias, owfree_func);
-	STATLOCK;
-	++cache_flips;			/* statistics */
-	memcpy(&old_avg, &new_avg, sizeof(struct average));
-	AVERAGE_CLEAR(&new_avg);
-	STATUNLOCK;
+}
+
+/* Link a new entry into the shard's ring, just behind the clock hand (last to be considered) */
+/* Called with SHARD_WLOCK */
+static void Cache_Ring_Insert( struct cache_shard * cs, struct tree_node * tn )
+{
+	struct tree_node * hand = cs->clock_hand ;
+
+	tn->referenced = 0 ;
+	if ( hand == NULL ) {
+		tn->clock_next = tn->clock_prev = tn ;
+		cs->clock_hand = tn ;
+	} else {
+		tn->clock_next = hand ;
+		tn->clock_prev = hand->clock_prev ;
+		hand->clock_prev->clock_next = tn ;
+		hand->clock_prev = tn ;
+	}
+	++cs->entries ;
+}
+
+/* CLOCK hint from a reader -- under SHARD_RLOCK, so other readers may store at the same time */
+static void Cache_Referenced( struct tree_node * tn )
+{
+#if OW_MT && defined(HAVE_SYNC_FETCH_AND_ADD)
+	(void) __sync_lock_test_and_set( &(tn->referenced), 1 ) ;
+#else /* OW_MT && HAVE_SYNC_FETCH_AND_ADD */
+	tn->referenced = 1 ;
+#endif /* OW_MT && HAVE_SYNC_FETCH_AND_ADD */
+}
+
+/* Unlink an entry from the shard's ring */
+/* Called with SHARD_WLOCK */
+static void Cache_Ring_Remove( struct cache_shard * cs, struct tree_node * tn )
+{
+	if ( tn->clock_next == tn ) {
+		cs->clock_hand = NULL ;
+	} else {
+		tn->clock_prev->clock_next = tn->clock_next ;
+		tn->clock_next->clock_prev = tn->clock_prev ;
+		if ( cs->clock_hand == tn ) {
+			cs->clock_hand = tn->clock_next ;
+		}
+	}
+	--cs->entries ;
+}
+
+/* An updated value takes over the ring position of the old one */
+/* Called with SHARD_WLOCK */
+static void Cache_Ring_Replace( struct cache_shard * cs, struct tree_node * tn_old, struct tree_node * tn_new )
+{
+	tn_new->referenced = 1 ; // just written, so in use
+	if ( tn_old->clock_next == tn_old ) {
+		tn_new->clock_next = tn_new->clock_prev = tn_new ;
+	} else {
+		tn_new->clock_next = tn_old->clock_next ;
+		tn_new->clock_prev = tn_old->clock_prev ;
+		tn_old->clock_prev->clock_next = tn_new ;
+		tn_old->clock_next->clock_prev = tn_new ;
+	}
+	if ( cs->clock_hand == tn_old ) {
+		cs->clock_hand = tn_new ;
+	}
+}
+
+/* Remove an entry from a shard (tree, ring and accounting) and free it */
+/* Called with SHARD_WLOCK */
+static void Cache_Forget( struct cache_shard * cs, struct tree_node * tn )
+{
+	tdelete(tn, &cs->temporary_tree, tree_compare);
+	Cache_Ring_Remove( cs, tn ) ;
+	cs->ram_size -= CACHE_NODE_BYTES(tn) ;
+	STAT_SUB(cache_bytes, CACHE_NODE_BYTES(tn));
+	STAT_SUB(cache_occupancy[tn->change], 1);
+	STAT_AVERAGE_OUT(&new_avg);
+	owfree(tn);
+}
+
+/* Make room in a full shard -- CLOCK (second chance) replacement */
+/* Called with SHARD_WLOCK and a non-empty ring */
+static void Cache_Evict_One( struct cache_shard * cs, time_t now )
+{
+	struct tree_node * tn = cs->clock_hand ;
+
+	// clears at most one lap of reference bits, so always finds a victim
+	while ( tn->referenced && tn->expires + StaleGrace(tn->change) >= now ) {
+		tn->referenced = 0 ;
+		tn = cs->clock_hand = tn->clock_next ;
+	}
+	cs->clock_hand = tn->clock_next ;
+	LEVEL_DEBUG("Evict from cache sn " SNformat " pointer=%p index=%d size=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension, (int) tn->dsize);
+	Cache_Forget( cs, tn ) ;
+	STAT_ADD1(cache_evictions);
+}
+
+/* Remove expired entries from one shard */
+/* Called with SHARD_WLOCK(shard), only this shard's readers wait */
+/* returns number of entries removed */
+static int Cache_Sweep_Shard( int shard, time_t now )
+{
+	struct cache_shard * cs = &cache.shard[shard] ;
+	struct tree_node * tn = cs->clock_hand ;
+	UINT visit = cs->entries ;
+	int swept = 0 ;
+
+	// one lap of the ring, at most CACHE_SWEEP_BATCH removed
+	while ( visit-- > 0 && swept < CACHE_SWEEP_BATCH ) {
+		struct tree_node * tn_next = tn->clock_next ;
+		if ( tn->expires + StaleGrace(tn->change) < now ) {
+			Cache_Forget( cs, tn ) ;
+			++swept ;
+		}
+		tn = tn_next ;
+	}
+
+	// a full batch means there may be more -- try again on next add
+	cs->next_sweep = ( swept < CACHE_SWEEP_BATCH ) ? now + cache.retired_lifespan : now ;
+	LEVEL_DEBUG("Swept %d expired entries from cache shard %d", swept, shard);
+	return swept ;
 }
 
 /* Clear the cache (a change was made that might give stale information) */
 void Cache_Clear(void)
 {
+	int shard ;
+
+	for ( shard = 0 ; shard < CACHE_SHARDS ; ++shard ) {
+		void * flip ;
+		struct tree_node * tn ;
+		UINT entries ;
+
+		SHARD_WLOCK(shard);
+		flip = cache.shard[shard].temporary_tree ;
+		tn = cache.shard[shard].clock_hand ;
+		entries = cache.shard[shard].entries ;
+		cache.shard[shard].temporary_tree = NULL ;
+		cache.shard[shard].clock_hand = NULL ;
+		cache.shard[shard].entries = 0 ;
+		cache.shard[shard].ram_size = 0 ;
+		SHARD_WUNLOCK(shard);
+
+		// accounting and tdestroy outside the lock
+		for ( ; entries > 0 ; --entries, tn = tn->clock_next ) {
+			STAT_SUB(cache_bytes, CACHE_NODE_BYTES(tn));
+			STAT_SUB(cache_occupancy[tn->change], 1);
+		}
+		SAFETDESTROY( flip, owfree_func);
+	}
+
 	CACHE_WLOCK;
-	FlipTree() ;
-	FlipTree() ;
+	FlipAliasTree() ;
+	FlipAliasTree() ;
 	CACHE_WUNLOCK;
+
+	STATLOCK;
+	++cache_flips;			/* statistics */
+	memcpy(&old_avg, &new_avg, sizeof(struct average));
+	AVERAGE_CLEAR(&new_avg);
+	STATUNLOCK;
 }
 
 /* Wrapper to perform a cache function and add statistics */
@@ -348,6 +557,9 @@ static GOOD_OR_BAD Add_Stat(struct cache_stats *scache, GOOD_OR_BAD result)
 GOOD_OR_BAD OWQ_Cache_Add(const struct one_wire_query *owq)
 {
 	const struct parsedname *pn = PN(owq);
+	if (pn->control_flags & STALE_VALUE) {
+		return gbBAD;			// already expired where it came from -- don't store it as fresh
+	}
 	if (pn->extension == EXTENSION_ALL) {
 		switch (pn->selected_filetype->format) {
 		case ft_ascii:
@@ -430,6 +642,7 @@ static GOOD_OR_BAD Cache_Add(const void *data, const size_t datasize, const stru
 	LoadTK( pn->sn, pn->selected_filetype, pn->extension, tn );
 	tn->expires = duration + NOW_TIME;
 	tn->dsize = datasize;
+	tn->change = pn->selected_filetype->change;
 	if (datasize) {
 		memcpy(TREE_DATA(tn), data, datasize);
 	}
@@ -488,6 +701,7 @@ GOOD_OR_BAD Cache_Add_Dir(const struct dirblob *db, const struct parsedname *pn)
 	LoadTK( pn_directory.sn, Directory_Marker, pn->selected_connection->index, tn );
 	tn->expires = duration + NOW_TIME;
 	tn->dsize = size;
+	tn->change = fc_directory;
 	if (size) {
 		memcpy(TREE_DATA(tn), db->snlist, size);
 	}
@@ -535,6 +749,7 @@ GOOD_OR_BAD Cache_Add_Simul(const enum simul_type type, const struct parsedname
 	LEVEL_DEBUG("Simultaneous add type=%d",type);
 	tn->expires = duration + NOW_TIME;
 	tn->dsize = 0;
+	tn->change = fc_volatile;
 	return Add_Stat(&cache_dir, Cache_Add_Common(tn));
 }
 
@@ -562,6 +777,7 @@ GOOD_OR_BAD Cache_Add_Device(const int bus_nr, const BYTE * sn)
 	LoadTK(sn, Device_Marker, 0, tn );
 	tn->expires = duration + NOW_TIME;
 	tn->dsize = sizeof(int);
+	tn->change = fc_presence;
 	memcpy(TREE_DATA(tn), &bus_nr, sizeof(int));
 	return Add_Stat(&cache_dev, Cache_Add_Common(tn));
 }
@@ -600,6 +816,7 @@ GOOD_OR_BAD Cache_Add_SlaveSpecific(const void *data, const size_t datasize, con
 	LoadTK( pn->sn, ip->name, EXTENSION_INTERNAL, tn );
 	tn->expires = duration + NOW_TIME;
 	tn->dsize = datasize;
+	tn->change = ip->change;
 	if (datasize) {
 		memcpy(TREE_DATA(tn), data, datasize);
 	}
@@ -614,75 +831,72 @@ GOOD_OR_BAD Cache_Add_SlaveSpecific(const void *data, const size_t datasize, con
 }
 
 /* Add an item to the cache */
-/* return 0 if good, 1 if not */
-GOOD_OR_BAD Cache_Add_Alias(const ASCII *name, const BYTE * sn)
-{
-	struct tree_node *tn;
-	size_t size = strlen(name) ;
-
-	if ( size == 0 ) {
-		return gbGOOD ;
-	}
-
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node) + size + 1 );
-	if (!tn) {
-		return gbBAD;
-	}
-
-	LEVEL_DEBUG("Adding alias for " SNformat " = %s", SNvar(sn), name);
-	LoadTK( sn, Alias_Marker, 0, tn );
-	tn->expires = NOW_TIME;
-	tn->dsize = size;
-	memcpy((ASCII *)TREE_DATA(tn), name, size+1 ); // includes NULL
-	Cache_Add_Alias_SN( name, sn ) ;
-	return Add_Stat(&cache_pst, Cache_Add_Persistent(tn));
-}
-
-/* Add an item to the cache */
-/* retire the cache (flip) if too old, and start a new one (keep the old one for a while) */
+/* purge expired entries from this shard if it's time, other shards are untouched */
+/* a new entry evicts cold ones if the shard is over its share of the memory budget (an update replaces in place) */
 /* return 0 if good, 1 if not */
 static GOOD_OR_BAD Cache_Add_Common(struct tree_node *tn)
 {
 	struct tree_opaque *opaque;
 	enum { no_add, yes_add, just_update } state = no_add;
+	int shard = CacheShard(tn) ;
+	struct cache_shard * cs = &cache.shard[shard] ;
+	size_t budget = Globals.cache_size / CACHE_SHARDS ; // each shard gets an equal part
+	size_t needed = CACHE_NODE_BYTES(tn) ;
+	time_t now = NOW_TIME ;
+	int swept = 0 ;
 
 	node_show(tn);
 	LEVEL_DEBUG("Add to cache sn " SNformat " pointer=%p index=%d size=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension, tn->dsize);
-	CACHE_WLOCK;
-	if (cache.time_to_kill < NOW_TIME) {	// old database has timed out
-		FlipTree() ;
+	SHARD_WLOCK(shard);
+	if (cs->next_sweep <= now) {	// time to purge expired entries
+		swept = Cache_Sweep_Shard(shard, now) ;
 	}
-	if (Globals.cache_size && (cache.old_ram_size + cache.new_ram_size > Globals.cache_size)) {
-		// failed size test
+	if (Globals.cache_size && (needed > budget)) {
+		// larger than the shard's whole share
 		owfree(tn);
-	} else if ((opaque = tsearch(tn, &cache.temporary_tree_new, tree_compare))) {
-		//printf("Cache_Add_Common to %p\n",opaque);
-		if (tn != opaque->key) {
-			cache.new_ram_size += sizeof(tn) - sizeof(opaque->key);
-			owfree(opaque->key);
+	} else {
+		opaque = tsearch(tn, &cs->temporary_tree, tree_compare) ;
+		if ( opaque == NULL ) {
+			// nothing found or added?!? free our memory segment
+			owfree(tn);
+		} else if (tn != opaque->key) {
+			struct tree_node * tn_old = opaque->key ;
+			Cache_Ring_Replace( cs, tn_old, tn ) ;
+			cs->ram_size += needed - CACHE_NODE_BYTES(tn_old) ;
+			STAT_ADD(cache_bytes, needed);
+			STAT_SUB(cache_bytes, CACHE_NODE_BYTES(tn_old));
+			STAT_SUB(cache_occupancy[tn_old->change], 1);
+			STAT_ADD1(cache_occupancy[tn->change]);
+			owfree(tn_old);
 			opaque->key = tn;
 			state = just_update;
 		} else {
+			// new entry -- not on the ring yet, so the clock can't pick it
+			while ( Globals.cache_size && cs->clock_hand != NULL && cs->ram_size + needed > budget ) {
+				Cache_Evict_One( cs, now ) ;
+			}
+			Cache_Ring_Insert( cs, tn ) ;
+			cs->ram_size += needed ;
+			STAT_ADD(cache_bytes, needed);
+			STAT_ADD1(cache_occupancy[tn->change]);
 			state = yes_add;
-			cache.new_ram_size += sizeof(tn);
 		}
-	} else {					// nothing found or added?!? free our memory segment
-		owfree(tn);
 	}
-	CACHE_WUNLOCK;
+	SHARD_WUNLOCK(shard);
+
+	if ( swept > 0 ) {
+		STAT_ADD1(cache_flips);		/* statistics */
+	}
+
 	/* Added or updated, update statistics */
 	switch (state) {
 		case yes_add: // add new entry
-			STATLOCK;
-			AVERAGE_IN(&new_avg);
-			++cache_adds;			/* statistics */
-			STATUNLOCK;
+			STAT_AVERAGE_IN(&new_avg);
+			STAT_ADD1(cache_adds);		/* statistics */
 			return gbGOOD;
 		case just_update: // update the time mark and data
-			STATLOCK;
-			AVERAGE_MARK(&new_avg);
-			++cache_adds;			/* statistics */
-			STATUNLOCK;
+			STAT_AVERAGE_MARK(&new_avg);
+			STAT_ADD1(cache_adds);		/* statistics */
 			return gbGOOD;
 		default: // unable to add
 			return gbBAD;
@@ -716,14 +930,10 @@ static GOOD_OR_BAD Cache_Add_Persistent(struct tree_node *tn)
 
 	switch (state) {
 	case yes_add:
-		STATLOCK;
-		AVERAGE_IN(&store_avg);
-		STATUNLOCK;
+		STAT_AVERAGE_IN(&store_avg);
 		return gbGOOD;
 	case just_update:
-		STATLOCK;
-		AVERAGE_MARK(&store_avg);
-		STATUNLOCK;
+		STAT_AVERAGE_MARK(&store_avg);
 		return gbGOOD;
 	default:
 		return gbBAD;
@@ -734,20 +944,23 @@ static GOOD_OR_BAD Get_Stat(struct cache_stats *scache, const enum cache_task_re
 {
 	GOOD_OR_BAD gbret = gbBAD ; // default
 	
-	STATLOCK;
-	++scache->tries;
+	STAT_ADD1(scache->tries);
 	switch ( result ) {
 		case ctr_expired:
-			++scache->expires;
+			STAT_ADD1(scache->expires);
 			break ;
 		case ctr_ok:
-			++scache->hits;
+			STAT_ADD1(scache->hits);
+			gbret = gbGOOD ;
+			break ;
+		case ctr_stale:
+			// expired, but answered within its stale grace
+			STAT_ADD1(cache_stale_hits);
 			gbret = gbGOOD ;
 			break ;
 		default:
 			break ;
 	}	
-	STATUNLOCK;
 	return gbret ;
 }
 
@@ -823,6 +1036,72 @@ GOOD_OR_BAD OWQ_Cache_Get(struct one_wire_query *owq)
 	}
 }
 
+/* Stale-while-revalidate lookup of a single (non-aggregate) value
+   gbGOOD only for an expired value still within its stale grace, loaded into owq.
+   A fresh value is left to OWQ_Cache_Get on the normal path (simultaneous checks apply there).
+   Counts stale hits, and the misses that will have to wait for the bus */
+GOOD_OR_BAD OWQ_Cache_Get_Stale(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	time_t grace = StaleGrace(pn->selected_filetype->change);
+	time_t duration = TimeOut(pn->selected_filetype->change);
+	struct tree_node tn;
+	void *data;
+	size_t dsize;
+	int text = 0;
+
+	// do check here to avoid needless processing
+	if (grace <= 0 || duration <= 0 || pn->selected_filetype->ag != NON_AGGREGATE) {
+		return gbBAD;
+	}
+	if (IsUncachedDir(pn) || IsAlarmDir(pn) || IsThisPersistent(pn)) {
+		return gbBAD;
+	}
+
+	switch (pn->selected_filetype->format) {
+	case ft_ascii:
+	case ft_vascii:
+	case ft_binary:
+		if (OWQ_offset(owq) > 0) {
+			return gbBAD;
+		}
+		data = OWQ_buffer(owq);
+		dsize = OWQ_size(owq);
+		text = 1;
+		break;
+	case ft_integer:
+	case ft_unsigned:
+	case ft_yesno:
+	case ft_date:
+	case ft_float:
+	case ft_pressure:
+	case ft_temperature:
+	case ft_tempgap:
+		data = &OWQ_val(owq);
+		dsize = sizeof(union value_object);
+		break;
+	default:
+		return gbBAD;
+	}
+
+	LoadTK( pn->sn, pn->selected_filetype, pn->extension, &tn );
+	switch ( Cache_Get_Common(data, &dsize, &duration, &tn, grace) ) {
+	case ctr_ok:
+		return gbBAD;			// fresh -- the normal path will find it
+	case ctr_stale:
+		if (text) {
+			OWQ_length(owq) = dsize;
+		} else if (dsize != sizeof(union value_object)) {
+			break;
+		}
+		return Get_Stat(&cache_ext, ctr_stale);
+	default:
+		break;
+	}
+	STAT_ADD1(cache_stale_misses);
+	return gbBAD;
+}
+
 /* Look in caches, 0=found and valid, 1=not or uncachable in the first place */
 GOOD_OR_BAD Cache_Get(void *data, size_t * dsize, const struct parsedname *pn)
 {
@@ -851,7 +1130,7 @@ GOOD_OR_BAD Cache_Get(void *data, size_t * dsize, const struct parsedname *pn)
 	LoadTK( pn->sn, pn->selected_filetype, pn->extension, &tn );
 	return persistent ?
 		Get_Stat(&cache_pst, Cache_Get_Persistent(data, dsize, &duration, &tn)) :
-		Get_Stat(&cache_ext, Cache_Get_Common(data, dsize, &duration, &tn));
+		Get_Stat(&cache_ext, Cache_Get_Common(data, dsize, &duration, &tn, 0));
 }
 
 /* Look in caches, 0=found and valid, 1=not or uncachable in the first place */
@@ -878,20 +1157,15 @@ static enum cache_task_return Cache_Get_Common_Dir(struct dirblob *db, time_t *
 	time_t now = NOW_TIME;
 	size_t size;
 	struct tree_opaque *opaque;
+	int shard = CacheShard(tn) ;
 	LEVEL_DEBUG("Get from cache sn " SNformat " pointer=%p extension=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension);
-	CACHE_RLOCK;
-	opaque = tfind(tn, &cache.temporary_tree_new, tree_compare) ;
-	if ( opaque == NULL ) {
-		// not found in new tree
-		if ( cache.time_retired + duration[0] > now ) {
-			// old tree could be new enough
-			opaque = tfind(tn, &cache.temporary_tree_old, tree_compare) ;
-		}
-	}
+	SHARD_RLOCK(shard);
+	opaque = tfind(tn, &cache.shard[shard].temporary_tree, tree_compare) ;
 	if ( opaque != NULL ) {
 		duration[0] = opaque->key->expires - now ;
 		if (duration[0] >= 0) {
 			LEVEL_DEBUG("Dir found in cache");
+			Cache_Referenced( opaque->key ) ;
 			size = opaque->key->dsize;
 			if (DirblobRecreate(TREE_DATA(opaque->key), size, db) == 0) {
 				//printf("Cache: snlist=%p, devices=%lu, size=%lu\n",*snlist,devices[0],size) ;
@@ -910,7 +1184,7 @@ static enum cache_task_return Cache_Get_Common_Dir(struct dirblob *db, time_t *
 		LEVEL_DEBUG("Dir not found in cache");
 		ctr_ret = ctr_not_found;
 	}
-	CACHE_RUNLOCK;
+	SHARD_RUNLOCK(shard);
 	return ctr_ret;
 }
 
@@ -926,7 +1200,7 @@ GOOD_OR_BAD Cache_Get_Device(void *bus_nr, const struct parsedname *pn)
 
 	LEVEL_DEBUG("Looking for device "SNformat, SNvar(pn->sn));
 	LoadTK( pn->sn, Device_Marker, 0, &tn ) ;
-	return Get_Stat(&cache_dev, Cache_Get_Common(bus_nr, &size, &duration, &tn));
+	return Get_Stat(&cache_dev, Cache_Get_Common(bus_nr, &size, &duration, &tn, 0));
 }
 
 /* Does cache get, but doesn't allow play in data size */
@@ -959,7 +1233,7 @@ static GOOD_OR_BAD Cache_Get_Internal(void *data, size_t * dsize, const struct i
 		case fc_persistent:
 			return Get_Stat(&cache_pst, Cache_Get_Persistent(data, dsize, &duration, &tn));
 		default:
-			return Get_Stat(&cache_int, Cache_Get_Common(data, dsize, &duration, &tn));
+			return Get_Stat(&cache_int, Cache_Get_Common(data, dsize, &duration, &tn, 0));
 	}
 }
 
@@ -987,7 +1261,7 @@ GOOD_OR_BAD Cache_Get_Simul_Time(enum simul_type type, time_t * dwell_time, cons
 	
 	FS_LoadDirectoryOnly(&pn_directory, pn);
 	LoadTK(pn_directory.sn, Simul_Marker[type], pn->selected_connection->index, &tn ) ;
-	if ( Get_Stat(&cache_int, Cache_Get_Common(NULL, &dsize_simul, &time_left, &tn)) ) {
+	if ( Get_Stat(&cache_int, Cache_Get_Common(NULL, &dsize_simul, &time_left, &tn, 0)) ) {
 		return gbBAD ;
 	}
 	// duration_simul is time left
@@ -1018,7 +1292,7 @@ static GOOD_OR_BAD Cache_Get_Simultaneous(enum simul_type type, struct one_wire_
 	
 	LoadTK( pn->sn, pn->selected_filetype, pn->extension, &tn ) ;
 	
-	if ( Get_Stat(&cache_ext, Cache_Get_Common( &OWQ_val(owq), &dsize, &time_left, &tn)) == 0 ) {
+	if ( Get_Stat(&cache_ext, Cache_Get_Common( &OWQ_val(owq), &dsize, &time_left, &tn, 0)) == 0 ) {
 		// valid cached primary data -- see if a simultaneous conversion should be used instead
 		time_t dwell_time_data = duration - time_left ;
 		
@@ -1047,58 +1321,33 @@ static GOOD_OR_BAD Cache_Get_Simultaneous(enum simul_type type, struct one_wire_
 	return gbBAD ; // Simul is newer
 }
 
-/* Look in caches, 0=found and valid, 1=not or uncachable in the first place */
-/* space allocated, needs to be owfree-d */
-/* returns null-terminated string */
-ASCII * Cache_Get_Alias(const BYTE * sn)
-{
-	struct tree_node tn;
-	struct tree_opaque *opaque;
-	ASCII * alias_name = NULL ;
-	
-
-	LoadTK(sn, Alias_Marker, 0, &tn ) ;
-
-	PERSISTENT_RLOCK;
-	opaque = tfind(&tn, &cache.persistent_tree, tree_compare) ;
-	if ( opaque != NULL ) {
-		alias_name = owmalloc( opaque->key->dsize + 1 ) ;
-		if ( alias_name != NULL ) {
-			memcpy( alias_name, (ASCII *)TREE_DATA(opaque->key), opaque->key->dsize+1 ) ;
-			LEVEL_DEBUG("Retrieving " SNformat " alias=%s", SNvar(sn), alias_name );
-		}
-	}
-	PERSISTENT_RUNLOCK;
-	return alias_name ;
-}
-
 /* Look in caches, 0=found and valid, 1=not or uncachable in the first place */
 /* duration is time left */
-static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_t * duration, const struct tree_node *tn)
+/* grace: seconds past expiry that the value is still returned (as ctr_stale) */
+static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_t * duration, const struct tree_node *tn, time_t grace)
 {
 	enum cache_task_return ctr_ret;
 	time_t now = NOW_TIME;
 	struct tree_opaque *opaque;
+	int shard = CacheShard(tn) ;
 	
 	LEVEL_DEBUG("Search in cache sn " SNformat " pointer=%p index=%d size=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension, (int) dsize[0]);
 	//node_show(tn);
 	//new_tree();
-	CACHE_RLOCK;
-	opaque = tfind(tn, &cache.temporary_tree_new, tree_compare) ;
-	if ( opaque == NULL ) {
-		// not found in new tree
-		if ( cache.time_retired + duration[0] > now ) {
-			// retired time isn't too old for this data item
-			opaque = tfind(tn, &cache.temporary_tree_old, tree_compare) ;
-		}
-	}
+	SHARD_RLOCK(shard);
+	opaque = tfind(tn, &cache.shard[shard].temporary_tree, tree_compare) ;
 	if ( opaque != NULL ) {
 		// modify duration to time left (can be negative if expired)
 		duration[0] = opaque->key->expires - now ;
-		if (duration[0] > 0) {
-			LEVEL_DEBUG("Value found in cache. Remaining life: %d seconds.",duration[0]);
+		if (duration[0] + grace > 0) {
+			if (duration[0] > 0) {
+				LEVEL_DEBUG("Value found in cache. Remaining life: %d seconds.",duration[0]);
+			} else {
+				LEVEL_DEBUG("Value found in cache, expired by %d seconds but still within its stale grace.",-duration[0]);
+			}
 			// Compared with >= before, but fc_second(1) always cache for 2 seconds in that case.
 			// Very noticable when reading time-data like "/26.80A742000000/date" for example.
+			Cache_Referenced( opaque->key ) ;
 			if ( dsize[0] >= opaque->key->dsize) {
 				// lower data size if stored value is shorter
 				dsize[0] = opaque->key->dsize;
@@ -1106,8 +1355,8 @@ static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_
 				if (dsize[0] > 0) {
 					memcpy(data, TREE_DATA(opaque->key), dsize[0]);
 				}
-				ctr_ret = ctr_ok;
-				//twalk(cache.temporary_tree_new,tree_show) ;
+				ctr_ret = (duration[0] > 0) ? ctr_ok : ctr_stale;
+				//new_tree() ;
 			} else {
 				ctr_ret = ctr_size_mismatch;
 			}
@@ -1119,7 +1368,7 @@ static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_
 		LEVEL_DEBUG("Value not found in cache");
 		ctr_ret = ctr_not_found;
 	}
-	CACHE_RUNLOCK;
+	SHARD_RUNLOCK(shard);
 	return ctr_ret;
 }
 
@@ -1197,36 +1446,6 @@ void OWQ_Cache_Del_parts(struct one_wire_query *owq)
 	}
 }
 
-// Delete a serial number's alias
-// Safe to call if no alias exists
-// Also deletes from linked alias_sn file
-void Cache_Del_Alias(const BYTE * sn)
-{
-	ASCII * alias_name ;
-	struct tree_node *tn;
-	size_t size ;
-
-	alias_name = Cache_Get_Alias( sn ) ;
-	if ( alias_name == NULL ) {
-		// doesn't exist
-		// (or a memory error -- unlikely)
-		return ;
-	}
-
-	LEVEL_DEBUG("Deleting alias %s from "SNformat, alias_name, SNvar(sn)) ;
-	size = strlen( alias_name ) ;
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node) + size + 1 );
-	if ( tn != NULL ) {
-		tn->expires = NOW_TIME;
-		tn->dsize = size;
-		memcpy((ASCII *)TREE_DATA(tn), alias_name, size+1); // includes NULL
-		LoadTK( sn, Alias_Marker, 0, tn ) ;
-		Del_Stat(&cache_pst, Cache_Del_Persistent(tn));
-		Cache_Del_Alias_SN( alias_name ) ;
-	}
-	owfree( alias_name ) ;
-}
-
 static void Cache_Del(const struct parsedname *pn)
 {
 	struct tree_node tn;
@@ -1372,22 +1591,17 @@ static GOOD_OR_BAD Cache_Del_Common(const struct tree_node *tn)
 	struct tree_opaque *opaque;
 	time_t now = NOW_TIME;
 	GOOD_OR_BAD ret = gbBAD;
+	int shard = CacheShard(tn) ;
 	LEVEL_DEBUG("Delete from cache sn " SNformat " in=%p index=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension);
 
-	CACHE_WLOCK;
-	opaque = tfind(tn, &cache.temporary_tree_new, tree_compare) ;
-	if ( opaque == NULL ) {
-		// not in new tree
-		if ( cache.time_to_kill > now ) {
-			// old tree still alive
-			opaque = tfind(tn, &cache.temporary_tree_old, tree_compare) ;
-		}
-	}
+	// just mark as expired, the next sweep of this shard frees it
+	SHARD_WLOCK(shard);
+	opaque = tfind(tn, &cache.shard[shard].temporary_tree, tree_compare) ;
 	if ( opaque != NULL ) {
 		opaque->key->expires = now - 1;
 		ret = gbGOOD;
 	}
-	CACHE_WUNLOCK;
+	SHARD_WUNLOCK(shard);
 
 	return ret;
 }
@@ -1410,9 +1624,7 @@ static GOOD_OR_BAD Cache_Del_Persistent(const struct tree_node *tn)
 	}
 
 	owfree(tn_found);
-	STATLOCK;
-	AVERAGE_OUT(&store_avg);
-	STATUNLOCK;
+	STAT_AVERAGE_OUT(&store_avg);
 	return gbGOOD;
 }
 
@@ -1424,52 +1636,6 @@ static void LoadTK( const BYTE * sn, void * p, int extension, struct tree_node *
 	tn->tk.extension = extension;
 }
 
-// Alias list from persistent cache
-// formatted as an alias file:
-// NNNNNNNNNNNN=alias_name\n
-//
-// Need to protect a global variable (aliaslist_cb) since twalk has no way of sending user data.
-
-struct memblob * aliaslist_mb ;
-
-static void Aliaslistaction(const void *node, const VISIT which, const int depth)
-{
-	const struct tree_node *p = *(struct tree_node * const *) node;
-	(void) depth;
-	char SN_address[SERIAL_NUMBER_SIZE*2] ;
-	
-	switch (which) {
-	case leaf:
-	case postorder:
-		if ( p->tk.p != Alias_Marker ) {
-			return ;
-		}
-		// Add sn address
-		bytes2string(SN_address, p->tk.sn, SERIAL_NUMBER_SIZE);
-		MemblobAdd( (BYTE *) SN_address, SERIAL_NUMBER_SIZE*2, aliaslist_mb ) ;
-		// Add '='
-		MemblobAdd( (BYTE *) "=", 1, aliaslist_mb ) ;
-		// Add alias name
-		MemblobAdd( (const BYTE *)CONST_TREE_DATA(p), p->dsize, aliaslist_mb ) ;
-		// Add <CR>
-		MemblobAdd( (BYTE *) "\x0D\x0A", 2, aliaslist_mb ) ;
-		return ;
-	case preorder:
-	case endorder:
-		break;
-	}
-}
-
-void Aliaslist( struct memblob * mb  )
-{
-	PERSISTENT_RLOCK ;
-	ALIASLISTLOCK ;
-	aliaslist_mb = mb ;
-	twalk(cache.persistent_tree, Aliaslistaction);
-	ALIASLISTUNLOCK ;
-	PERSISTENT_RUNLOCK ;
-}
-
 /* Add an alias to the temporary database of name->bus */
 /* alias_name is a null-terminated string */
 void Cache_Add_Alias_Bus(const ASCII * alias_name, INDEX_OR_ERROR bus)
@@ -1505,18 +1671,18 @@ static void Cache_Add_Alias_Common(struct alias_tree_node *atn)
 
 	CACHE_WLOCK;
 	if (cache.time_to_kill < NOW_TIME) {	// old database has timed out
-		FlipTree() ;
+		FlipAliasTree() ;
 	}
 	if (Globals.cache_size && (cache.old_ram_size + cache.new_ram_size > Globals.cache_size)) {
 		// failed size test
 		owfree(atn);
 	} else if ((opaque = tsearch(atn, &cache.temporary_alias_tree_new, alias_tree_compare))) {
 		if ( (void *)atn != (void *) (opaque->key) ) {
-			cache.new_ram_size += sizeof(atn) - sizeof(opaque->key);
+			cache.new_ram_size += ALIAS_NODE_BYTES(atn) - ALIAS_NODE_BYTES((struct alias_tree_node *) opaque->key);
 			owfree(opaque->key);
 			opaque->key = (void *) atn;
 		} else {
-			cache.new_ram_size += sizeof(atn);
+			cache.new_ram_size += ALIAS_NODE_BYTES(atn);
 		}
 	} else {					// nothing found or added?!? free our memory segment
 		owfree(atn);
@@ -1524,49 +1690,6 @@ static void Cache_Add_Alias_Common(struct alias_tree_node *atn)
 	CACHE_WUNLOCK;
 }
 
-/* Add an alias/sn to the persistent database of name->sn */
-/* Alias name must be a null-terminated string */
-static void Cache_Add_Alias_SN(const ASCII * alias_name, const BYTE * sn)
-{
-	// allocate space for the node and data
-	size_t datasize = strlen(alias_name) ;
-	struct alias_tree_node *atn = (struct alias_tree_node *) owmalloc(sizeof(struct alias_tree_node) + datasize + 1);
-
-	if (atn==NULL) {
-		return ;
-	}
-
-	if (datasize==0) {
-		owfree(atn) ;
-		return ;
-	}
-
-	// populate the node structure with data
-	atn->expires = NOW_TIME;
-	atn->size = datasize;
-	memcpy( atn->sn, sn, SERIAL_NUMBER_SIZE ) ;
-	memcpy( ALIAS_TREE_DATA(atn), alias_name, datasize+1 ) ;
-	
-	Cache_Add_Alias_Persistent( atn ) ;
-}
-
-static void Cache_Add_Alias_Persistent(struct alias_tree_node *atn)
-{
-	struct tree_opaque *opaque;
-
-	PERSISTENT_WLOCK;
-	opaque = tsearch(atn, &cache.persistent_alias_tree, alias_tree_compare) ;
-	if ( opaque != NULL ) {
-		if ( (void *) atn != (void *) (opaque->key) ) {
-			owfree(opaque->key);
-			opaque->key = (void *) atn;
-		}
-	} else {					// nothing found or added?!? free our memory segment
-		owfree(atn);
-	}
-	PERSISTENT_WUNLOCK;
-}
-
 /* Find bus from alias name */
 /* Alias name must be a null-terminated string */
 INDEX_OR_ERROR Cache_Get_Alias_Bus(const ASCII * alias_name)
@@ -1616,84 +1739,6 @@ static INDEX_OR_ERROR Cache_Get_Alias_Common( struct alias_tree_node * atn)
 	return bus;
 }
 
-/* sn must point to an 8 byte buffer */
-/* Alias name must be a null-terminated string */
-GOOD_OR_BAD Cache_Get_Alias_SN(const ASCII * alias_name, BYTE * sn )
-{
-	// allocate space for the node and data
-	size_t datasize = strlen(alias_name) ;
-	struct alias_tree_node *atn ;
-
-	if (datasize==0) {
-		return gbBAD ;
-	}
-
-	atn = (struct alias_tree_node *) owmalloc(sizeof(struct alias_tree_node) + datasize+1);
-	if (atn==NULL) {
-		return gbBAD ;
-	}
-
-	// populate the node structure with data
-	atn->size = datasize;
-	memcpy( ALIAS_TREE_DATA(atn), alias_name, datasize+1 ) ;
-	
-	return Cache_Get_Alias_Persistent( sn, atn )==ctr_ok ? gbGOOD : gbBAD  ;
-}
-
-/* look in persistent alias->sn tree */
-static enum cache_task_return Cache_Get_Alias_Persistent( BYTE * sn, struct alias_tree_node * atn)
-{
-	struct tree_opaque *opaque;
-	GOOD_OR_BAD ret = gbBAD ;
-
-	PERSISTENT_RLOCK;
-	opaque = tfind(atn, &cache.persistent_alias_tree, alias_tree_compare) ;
-	if ( opaque != NULL ) {
-		memcpy( sn, ((struct alias_tree_node *)(opaque->key))->sn, SERIAL_NUMBER_SIZE ) ;
-		LEVEL_DEBUG("Lookup of %s gives "SNformat, CONST_ALIAS_TREE_DATA(atn), SNvar(sn) ) ;
-		ret = gbGOOD ;
-	} else {
-		LEVEL_DEBUG("Lookup of %s unsuccessful",CONST_ALIAS_TREE_DATA(atn)) ;
-	}
-	PERSISTENT_RUNLOCK;
-	owfree(atn) ;
-	return ret;
-}
-
-/* Alias name must be a null-terminated string */
-static void Cache_Del_Alias_SN(const ASCII * alias_name)
-{
-	// allocate space for the node and data
-	size_t datasize = strlen(alias_name) ;
-	struct alias_tree_node *atn = (struct alias_tree_node *) owmalloc(sizeof(struct alias_tree_node) + datasize + 1);
-
-	if (atn==NULL) {
-		return ;
-	}
-
-	// populate the node structure with data
-	atn->expires = NOW_TIME;
-	atn->size = datasize;
-	memcpy( ALIAS_TREE_DATA(atn), alias_name, datasize+1 ) ;
-	
-	Cache_Del_Alias_Persistent( atn ) ;
-}
-
-/* look in persistent alias->sn tree */
-static void Cache_Del_Alias_Persistent( struct alias_tree_node * atn)
-{
-	struct tree_opaque *opaque;
-	struct alias_tree_node *atn_found = NULL;
-
-	PERSISTENT_RLOCK;
-	opaque = tfind(atn, &cache.persistent_alias_tree, alias_tree_compare) ;
-	if ( opaque != NULL ) {
-		atn_found = (struct alias_tree_node *) (opaque->key);
-	}
-	PERSISTENT_RUNLOCK;
-	owfree(atn_found) ;
-}
-
 /* Delete bus from alias name */
 /* Alias name must be a null-terminated string */
 void Cache_Del_Alias_Bus(const ASCII * alias_name)
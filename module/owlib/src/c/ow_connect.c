@@ -106,6 +106,9 @@ static struct connection_in *AllocIn(const struct connection_in *old_in)
 		
 		/* not yet linked */
 		new_in->next = NO_CONNECTION ;
+		/* fan-out worker is started on first use, never shared with the prior bus */
+		new_in->worker = NULL ;
+		new_in->read_flights = NULL ;
 
 		/* Support DS1994/DS2404 which require longer delays, and is automatically
 		 * turned on in *_next_both().
@@ -122,7 +125,9 @@ static struct connection_in *AllocIn(const struct connection_in *old_in)
 		new_in->index = Inbound_Control.next_index++;
 		_MUTEX_INIT(new_in->bus_mutex);
 		_MUTEX_INIT(new_in->dev_mutex);
-		new_in->dev_db = NULL;
+		if ( BAD( DeviceLockTableCreate(new_in) ) ) {
+			LEVEL_DEFAULT("Cannot allocate device lock table for bus master structure");
+		}
 	} else {
 		LEVEL_DEFAULT("Cannot allocate memory for bus master structure");
 	}
@@ -182,6 +187,9 @@ struct port_in *LinkPort(struct port_in *pin)
 		Inbound_Control.head_port = pin ;
 
 		_MUTEX_INIT(pin->port_mutex);
+
+		/* bus.n paths may mean something new */
+		ParseCache_Flush();
 	}
 	return pin;
 }
@@ -237,10 +245,16 @@ void RemoveIn( struct connection_in * conn )
 		Inbound_Control.next_index-- ;
 	}
 
+	/* Cached parses may point to this connection */
+	ParseCache_Flush();
+
+	/* Stop the fan-out worker before its bus goes away */
+	BusWorkerStop(conn);
+
 	/* Now free up thread-sync resources */
 	_MUTEX_DESTROY(conn->bus_mutex);
 	_MUTEX_DESTROY(conn->dev_mutex);
-	SAFETDESTROY( conn->dev_db, owfree_func);
+	DeviceLockTableDestroy(conn);
 
 	/* Close master-specific resources */
 	BUS_close(conn) ;
@@ -310,5 +324,8 @@ struct connection_in * AddtoPort( struct port_in * pin )
 	add_in->channel = pin->connections ;
 	++pin->connections ;
 
+	/* bus.n paths may mean something new */
+	ParseCache_Flush();
+
 	return add_in ;
 }
@@ -0,0 +1,730 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: palfille@earthlink.net
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_external.h"
+#include <sys/wait.h>
+#include <poll.h>
+
+/* strategy for co-process external properties:
+   A property given on a "coprocess:" line instead of a "script:" line has its program started once
+   and kept running. Requests are written to its stdin, answers read from its stdout,
+   so a read or write costs a pipe round trip instead of a shell and a process.
+   One co-process per distinct command line, shared by every property naming it.
+
+   Request: a line of tab separated fields, then the payload
+     id mode sensor property extension size offset length sensor_data property_data
+     <length bytes> -- the value for "write", none for "read"
+   Answer: a line, then the payload
+     id status length
+     <length bytes> -- the value for "read"; status is 0 or a negative errno
+
+   Requests carry an id so several can be outstanding (threaded builds);
+   answers may come back in any order.
+   The property's "other" field takes options: timeout=seconds concurrency=requests
+   A co-process that misses a deadline or closes its output is stopped, and started
+   again by the next request.
+*/
+
+#define COPROCESS_CONCURRENCY_DEFAULT	4
+#define COPROCESS_LINE_LENGTH	256
+#define COPROCESS_MAX_PAYLOAD	65536
+
+struct coprocess_request {
+	struct coprocess_request * next ;
+	unsigned int id ;
+	BYTE * answer ;				// where the answer payload goes
+	size_t answer_size ;
+	size_t answer_length ;		// bytes received
+	int status ;				// from the answer line
+	int done ;
+} ;
+
+struct coprocess {
+	struct coprocess * next ;
+	char * command ;
+	pid_t pid ;					// 0 when not running
+	FILE_DESCRIPTOR_OR_ERROR to_child ;
+	FILE_DESCRIPTOR_OR_ERROR from_child ;
+	int timeout ;				// seconds
+	int concurrency ;			// most requests outstanding at once
+	int outstanding ;
+	unsigned int next_id ;
+	struct coprocess_request * pending ;
+	char in_buffer[COPROCESS_LINE_LENGTH] ;	// answer stream read-ahead
+	size_t in_start ;
+	size_t in_end ;
+	pthread_mutex_t mutex ;
+#if OW_MT
+	pthread_cond_t cond ;		// an answer arrived, a slot freed, the child or the reader stopped
+#endif /* OW_MT */
+} ;
+
+static struct coprocess * coprocess_list = NULL ;
+
+static struct coprocess * Coprocess_find( struct property_node * property_n ) ;
+static void Coprocess_options( struct coprocess * cp, const char * options ) ;
+static GOOD_OR_BAD Coprocess_start( struct coprocess * cp ) ;
+static void Coprocess_stop( struct coprocess * cp ) ;
+static ZERO_OR_ERROR Coprocess_transact( struct coprocess * cp, const char * header, const BYTE * payload, size_t payload_length, BYTE * answer, size_t answer_size, size_t * answer_length ) ;
+static ZERO_OR_ERROR Coprocess_send( struct coprocess * cp, unsigned int id, const char * header, const BYTE * payload, size_t payload_length ) ;
+static ZERO_OR_ERROR Coprocess_receive( struct coprocess * cp, int timeout_ms ) ;
+static ZERO_OR_ERROR Coprocess_getbytes( struct coprocess * cp, BYTE * data, size_t length, int timeout_ms ) ;
+static ZERO_OR_ERROR Coprocess_getline( struct coprocess * cp, char * line, size_t size, int timeout_ms ) ;
+static ZERO_OR_ERROR Coprocess_fill( struct coprocess * cp, int timeout_ms ) ;
+static void Coprocess_dispatch( struct coprocess * cp, unsigned int id, int status, const BYTE * payload, size_t length ) ;
+static void Coprocess_fail_pending( struct coprocess * cp ) ;
+static void Coprocess_reap( pid_t pid ) ;
+static int Coprocess_header( char * header, size_t size, const char * mode, size_t length, struct sensor_node * sensor_n, struct property_node * property_n, struct one_wire_query * owq ) ;
+#if OW_MT
+static void * Coprocess_reader( void * v ) ;
+#endif /* OW_MT */
+
+// ------------------------
+
+ZERO_OR_ERROR OW_read_external_coprocess( struct sensor_node * sensor_n, struct property_node * property_n, struct one_wire_query * owq )
+{
+	char header[PATH_MAX+1] ;
+	struct coprocess * cp = Coprocess_find( property_n ) ;
+	size_t answer_length ;
+	ZERO_OR_ERROR zoe ;
+
+	if ( cp == NULL ) {
+		return -ENOMEM ;
+	}
+
+	if ( Coprocess_header( header, PATH_MAX+1, "read", 0, sensor_n, property_n, owq ) < 0 ) {
+		LEVEL_DEBUG("Problem creating co-process request for %s/%s",sensor_n->name,property_n->property) ;
+		return -EINVAL ;
+	}
+
+	memset( OWQ_buffer(owq), 0, OWQ_size(owq) ) ;
+	zoe = Coprocess_transact( cp, header, NULL, 0, (BYTE *) OWQ_buffer(owq), OWQ_size(owq), &answer_length ) ;
+	if ( zoe < 0 ) {
+		return zoe ;
+	}
+
+	return OWQ_parse_input( owq ) ;
+}
+
+ZERO_OR_ERROR OW_write_external_coprocess( struct sensor_node * sensor_n, struct property_node * property_n, struct one_wire_query * owq )
+{
+	char header[PATH_MAX+1] ;
+	struct coprocess * cp = Coprocess_find( property_n ) ;
+	size_t answer_length ;
+	int po_return ;
+
+	if ( cp == NULL ) {
+		return -ENOMEM ;
+	}
+
+	po_return = OWQ_parse_output(owq) ; // load data in buffer
+	if ( po_return < 0 ) {
+		return -EINVAL ;
+	}
+
+	if ( Coprocess_header( header, PATH_MAX+1, "write", po_return, sensor_n, property_n, owq ) < 0 ) {
+		LEVEL_DEBUG("Problem creating co-process request for %s/%s",sensor_n->name,property_n->property) ;
+		return -EINVAL ;
+	}
+
+	return Coprocess_transact( cp, header, (BYTE *) OWQ_buffer(owq), po_return, NULL, 0, &answer_length ) ;
+}
+
+/* Stop all co-processes -- library shutdown */
+void Coprocess_close_all( void )
+{
+	COPROCESSLOCK ;
+	while ( coprocess_list != NULL ) {
+		struct coprocess * cp = coprocess_list ;
+		coprocess_list = cp->next ;
+
+		_MUTEX_LOCK( cp->mutex ) ;
+		Coprocess_stop( cp ) ;
+#if OW_MT
+		while ( FILE_DESCRIPTOR_VALID( cp->from_child ) ) {
+			// reader still draining
+			my_pthread_cond_wait( &(cp->cond), &(cp->mutex) ) ;
+		}
+#endif /* OW_MT */
+		_MUTEX_UNLOCK( cp->mutex ) ;
+#if OW_MT
+		my_pthread_cond_destroy( &(cp->cond) ) ;
+#endif /* OW_MT */
+		_MUTEX_DESTROY( cp->mutex ) ;
+		owfree( cp->command ) ;
+		owfree( cp ) ;
+	}
+	COPROCESSUNLOCK ;
+}
+
+// ------------------------
+
+/* Co-process for this property's command, created (not started) on first use */
+static struct coprocess * Coprocess_find( struct property_node * property_n )
+{
+	struct coprocess * cp ;
+
+	COPROCESSLOCK ;
+	for ( cp = coprocess_list ; cp != NULL ; cp = cp->next ) {
+		if ( strcmp( cp->command, property_n->read ) == 0 ) {
+			COPROCESSUNLOCK ;
+			return cp ;
+		}
+	}
+
+	cp = owcalloc( 1, sizeof(struct coprocess) ) ;
+	if ( cp != NULL ) {
+		cp->command = owstrdup( property_n->read ) ;
+		if ( cp->command == NULL ) {
+			owfree( cp ) ;
+			cp = NULL ;
+		} else {
+			cp->to_child = FILE_DESCRIPTOR_BAD ;
+			cp->from_child = FILE_DESCRIPTOR_BAD ;
+			Coprocess_options( cp, property_n->other ) ;
+			_MUTEX_INIT( cp->mutex ) ;
+#if OW_MT
+			my_pthread_cond_init( &(cp->cond), NULL ) ;
+#endif /* OW_MT */
+			cp->next = coprocess_list ;
+			coprocess_list = cp ;
+		}
+	}
+	COPROCESSUNLOCK ;
+	return cp ;
+}
+
+/* timeout=seconds concurrency=requests */
+static void Coprocess_options( struct coprocess * cp, const char * options )
+{
+	const char * option ;
+
+	cp->timeout = Globals.timeout_network ;
+	cp->concurrency = COPROCESS_CONCURRENCY_DEFAULT ;
+
+	if ( options == NULL ) {
+		return ;
+	}
+	option = strstr( options, "timeout=" ) ;
+	if ( option != NULL ) {
+		cp->timeout = atoi( option + strlen("timeout=") ) ;
+	}
+	option = strstr( options, "concurrency=" ) ;
+	if ( option != NULL ) {
+		cp->concurrency = atoi( option + strlen("concurrency=") ) ;
+	}
+
+	if ( cp->timeout < 1 ) {
+		cp->timeout = 1 ;
+	}
+#if OW_MT
+	if ( cp->concurrency < 1 ) {
+		cp->concurrency = 1 ;
+	}
+#else /* OW_MT */
+	cp->concurrency = 1 ;
+#endif /* OW_MT */
+	LEVEL_DEBUG("Co-process <%s> timeout=%d concurrency=%d",cp->command,cp->timeout,cp->concurrency) ;
+}
+
+/* Start the child (and answer reader) -- cp locked */
+static GOOD_OR_BAD Coprocess_start( struct coprocess * cp )
+{
+	int to_pipe[2] ;
+	int from_pipe[2] ;
+#if OW_MT
+	pthread_t reader ;
+
+	while ( FILE_DESCRIPTOR_VALID( cp->from_child ) ) {
+		// the previous child's reader hasn't finished yet
+		my_pthread_cond_wait( &(cp->cond), &(cp->mutex) ) ;
+	}
+	if ( cp->pid != 0 ) {
+		return gbGOOD ;			// started by another request meanwhile
+	}
+#endif /* OW_MT */
+
+	if ( pipe( to_pipe ) != 0 ) {
+		ERROR_DEBUG("Cannot create pipe for co-process <%s>",cp->command) ;
+		return gbBAD ;
+	}
+	if ( pipe( from_pipe ) != 0 ) {
+		ERROR_DEBUG("Cannot create pipe for co-process <%s>",cp->command) ;
+		close( to_pipe[0] ) ;
+		close( to_pipe[1] ) ;
+		return gbBAD ;
+	}
+
+	cp->pid = fork() ;
+	if ( cp->pid == 0 ) {
+		// child -- own process group so the whole command line can be signalled
+		setpgid( 0, 0 ) ;
+		dup2( to_pipe[0], STDIN_FILENO ) ;
+		dup2( from_pipe[1], STDOUT_FILENO ) ;
+		close( to_pipe[0] ) ;
+		close( to_pipe[1] ) ;
+		close( from_pipe[0] ) ;
+		close( from_pipe[1] ) ;
+		execl( "/bin/sh", "sh", "-c", cp->command, (char *) NULL ) ;
+		_exit( 127 ) ;
+	}
+
+	close( to_pipe[0] ) ;
+	close( from_pipe[1] ) ;
+	if ( cp->pid < 0 ) {
+		ERROR_DEBUG("Cannot start co-process <%s>",cp->command) ;
+		cp->pid = 0 ;
+		close( to_pipe[1] ) ;
+		close( from_pipe[0] ) ;
+		return gbBAD ;
+	}
+	fcntl( to_pipe[1], F_SETFD, FD_CLOEXEC ) ;
+	fcntl( from_pipe[0], F_SETFD, FD_CLOEXEC ) ;
+	cp->to_child = to_pipe[1] ;
+	cp->from_child = from_pipe[0] ;
+	cp->in_start = cp->in_end = 0 ;
+	LEVEL_DEBUG("Started co-process <%s> pid=%d",cp->command,(int) cp->pid) ;
+
+#if OW_MT
+	if ( pthread_create( &reader, DEFAULT_THREAD_ATTR, Coprocess_reader, (void *) cp ) != 0 ) {
+		ERROR_DEBUG("Cannot start the answer reader for co-process <%s>",cp->command) ;
+		Coprocess_stop( cp ) ;
+		close( cp->from_child ) ;
+		cp->from_child = FILE_DESCRIPTOR_BAD ;
+		return gbBAD ;
+	}
+	pthread_detach( reader ) ;
+#endif /* OW_MT */
+	return gbGOOD ;
+}
+
+/* End the child and fail anything outstanding -- cp locked */
+static void Coprocess_stop( struct coprocess * cp )
+{
+	if ( cp->pid == 0 ) {
+		return ;
+	}
+	LEVEL_DEBUG("Stopping co-process <%s> pid=%d",cp->command,(int) cp->pid) ;
+	close( cp->to_child ) ;
+	cp->to_child = FILE_DESCRIPTOR_BAD ;
+	Coprocess_reap( cp->pid ) ;
+	cp->pid = 0 ;
+	Coprocess_fail_pending( cp ) ;
+#if ! OW_MT
+	// (threaded: the reader owns from_child and closes it at the end of the stream)
+	close( cp->from_child ) ;
+	cp->from_child = FILE_DESCRIPTOR_BAD ;
+#endif /* OW_MT */
+}
+
+/* Ask the child (and anything the shell started) to end, then insist */
+static void Coprocess_reap( pid_t pid )
+{
+	int tries ;
+
+	kill( -pid, SIGTERM ) ;
+	for ( tries = 0 ; tries < 10 ; ++tries ) {
+		if ( waitpid( pid, NULL, WNOHANG ) != 0 ) {
+			return ;
+		}
+		UT_delay( 10 ) ;
+	}
+	kill( -pid, SIGKILL ) ;
+	waitpid( pid, NULL, 0 ) ;
+}
+
+static void Coprocess_fail_pending( struct coprocess * cp )
+{
+	struct coprocess_request * request ;
+
+	for ( request = cp->pending ; request != NULL ; request = request->next ) {
+		if ( ! request->done ) {
+			request->status = -EIO ;
+			request->done = 1 ;
+		}
+	}
+#if OW_MT
+	pthread_cond_broadcast( &(cp->cond) ) ;
+#endif /* OW_MT */
+}
+
+#if OW_MT
+static ZERO_OR_ERROR Coprocess_transact( struct coprocess * cp, const char * header, const BYTE * payload, size_t payload_length, BYTE * answer, size_t answer_size, size_t * answer_length )
+{
+	struct coprocess_request request = { NULL, 0, answer, answer_size, 0, 0, 0, } ;
+	struct coprocess_request ** link ;
+	struct timespec deadline ;
+	struct timeval now ;
+	int timed_out = 0 ;
+
+	gettimeofday( &now, NULL ) ;
+	deadline.tv_sec = now.tv_sec + cp->timeout ;
+	deadline.tv_nsec = now.tv_usec * 1000 ;
+
+	_MUTEX_LOCK( cp->mutex ) ;
+
+	// wait for a free slot
+	while ( cp->outstanding >= cp->concurrency ) {
+		if ( pthread_cond_timedwait( &(cp->cond), &(cp->mutex), &deadline ) == ETIMEDOUT ) {
+			_MUTEX_UNLOCK( cp->mutex ) ;
+			LEVEL_DEBUG("No free slot for co-process <%s>",cp->command) ;
+			return -ETIMEDOUT ;
+		}
+	}
+
+	if ( cp->pid == 0 && BAD( Coprocess_start( cp ) ) ) {
+		_MUTEX_UNLOCK( cp->mutex ) ;
+		return -EIO ;
+	}
+
+	request.id = ++cp->next_id ;
+	request.next = cp->pending ;
+	cp->pending = &request ;
+	++cp->outstanding ;
+
+	if ( Coprocess_send( cp, request.id, header, payload, payload_length ) != 0 ) {
+		Coprocess_stop( cp ) ;
+	}
+
+	while ( ! request.done ) {
+		if ( pthread_cond_timedwait( &(cp->cond), &(cp->mutex), &deadline ) == ETIMEDOUT ) {
+			timed_out = 1 ;
+			break ;
+		}
+	}
+
+	// unlink
+	for ( link = &(cp->pending) ; *link != NULL ; link = &((*link)->next) ) {
+		if ( *link == &request ) {
+			*link = request.next ;
+			break ;
+		}
+	}
+	--cp->outstanding ;
+
+	if ( timed_out ) {
+		LEVEL_DEBUG("Co-process <%s> missed its deadline",cp->command) ;
+		Coprocess_stop( cp ) ;
+		request.status = -ETIMEDOUT ;
+	}
+	pthread_cond_broadcast( &(cp->cond) ) ;
+	_MUTEX_UNLOCK( cp->mutex ) ;
+
+	answer_length[0] = request.answer_length ;
+	return request.status ;
+}
+
+/* Answers are read and handed to their waiting requests until the stream ends */
+static void * Coprocess_reader( void * v )
+{
+	struct coprocess * cp = v ;
+	FILE_DESCRIPTOR_OR_ERROR from_child = cp->from_child ;
+
+	while ( Coprocess_receive( cp, -1 ) == 0 ) {
+	}
+
+	_MUTEX_LOCK( cp->mutex ) ;
+	// ended on its own or sent garbage (no-op if already stopped)
+	Coprocess_stop( cp ) ;
+	close( from_child ) ;
+	cp->from_child = FILE_DESCRIPTOR_BAD ;
+	pthread_cond_broadcast( &(cp->cond) ) ;
+	_MUTEX_UNLOCK( cp->mutex ) ;
+	return VOID_RETURN ;
+}
+
+#else /* OW_MT */
+
+/* Single threaded: one request at a time, its caller reads the answer */
+static ZERO_OR_ERROR Coprocess_transact( struct coprocess * cp, const char * header, const BYTE * payload, size_t payload_length, BYTE * answer, size_t answer_size, size_t * answer_length )
+{
+	struct coprocess_request request = { NULL, 0, answer, answer_size, 0, 0, 0, } ;
+
+	if ( cp->pid == 0 && BAD( Coprocess_start( cp ) ) ) {
+		return -EIO ;
+	}
+
+	request.id = ++cp->next_id ;
+	cp->pending = &request ;
+
+	if ( Coprocess_send( cp, request.id, header, payload, payload_length ) != 0 ) {
+		Coprocess_stop( cp ) ;
+	}
+	while ( ! request.done ) {
+		if ( Coprocess_receive( cp, 1000 * cp->timeout ) != 0 ) {
+			Coprocess_stop( cp ) ;
+		}
+	}
+	cp->pending = NULL ;
+
+	answer_length[0] = request.answer_length ;
+	return request.status ;
+}
+#endif /* OW_MT */
+
+/* Request line and payload -- cp locked */
+static ZERO_OR_ERROR Coprocess_send( struct coprocess * cp, unsigned int id, const char * header, const BYTE * payload, size_t payload_length )
+{
+	char id_string[16] ;
+	struct iovec iov[3] ;
+	int iov_count = 0 ;
+	int snp_return ;
+
+	UCLIBCLOCK ;
+	snp_return = snprintf( id_string, sizeof(id_string), "%u\t", id ) ;
+	UCLIBCUNLOCK ;
+	if ( snp_return < 0 ) {
+		return -EINVAL ;
+	}
+
+	iov[iov_count].iov_base = id_string ;
+	iov[iov_count++].iov_len = snp_return ;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+	iov[iov_count].iov_base = (char *) header ;
+	iov[iov_count++].iov_len = strlen( header ) ;
+	if ( payload_length > 0 ) {
+		iov[iov_count].iov_base = (BYTE *) payload ;
+		iov[iov_count++].iov_len = payload_length ;
+	}
+#pragma GCC diagnostic pop
+
+	while ( iov_count > 0 ) {
+		ssize_t written = writev( cp->to_child, iov, iov_count ) ;
+		int i ;
+
+		if ( written < 0 ) {
+			if ( errno == EINTR ) {
+				continue ;
+			}
+			ERROR_DEBUG("Cannot send request to co-process <%s>",cp->command) ;
+			return -EIO ;
+		}
+		// skip what went out
+		for ( i = 0 ; i < iov_count && written >= (ssize_t) iov[i].iov_len ; ++i ) {
+			written -= iov[i].iov_len ;
+		}
+		memmove( iov, &iov[i], (iov_count - i) * sizeof(struct iovec) ) ;
+		iov_count -= i ;
+		if ( iov_count > 0 ) {
+			iov[0].iov_base = (char *) iov[0].iov_base + written ;
+			iov[0].iov_len -= written ;
+		}
+	}
+	return 0 ;
+}
+
+/* Read one answer and hand it to its request
+   -ETIMEDOUT, -EIO (end of stream) or -EPROTO (garbage) end the stream */
+static ZERO_OR_ERROR Coprocess_receive( struct coprocess * cp, int timeout_ms )
+{
+	char line[COPROCESS_LINE_LENGTH] ;
+	unsigned int id ;
+	int status ;
+	long length ;
+	BYTE * payload = NULL ;
+	ZERO_OR_ERROR zoe ;
+
+	zoe = Coprocess_getline( cp, line, COPROCESS_LINE_LENGTH, timeout_ms ) ;
+	if ( zoe != 0 ) {
+		return zoe ;
+	}
+	if ( sscanf( line, "%u %d %ld", &id, &status, &length ) != 3 || length < 0 || length > COPROCESS_MAX_PAYLOAD ) {
+		LEVEL_DEBUG("Co-process <%s> bad answer <%s>",cp->command,line) ;
+		return -EPROTO ;
+	}
+
+	if ( length > 0 ) {
+		payload = owmalloc( length ) ;
+		if ( payload == NULL ) {
+			return -ENOMEM ;
+		}
+		zoe = Coprocess_getbytes( cp, payload, length, timeout_ms ) ;
+		if ( zoe != 0 ) {
+			owfree( payload ) ;
+			return zoe ;
+		}
+	}
+
+	_MUTEX_LOCK( cp->mutex ) ;
+	Coprocess_dispatch( cp, id, status, payload, length ) ;
+	_MUTEX_UNLOCK( cp->mutex ) ;
+
+	if ( payload != NULL ) {
+		owfree( payload ) ;
+	}
+	return 0 ;
+}
+
+/* cp locked -- answers to abandoned (timed out) requests are dropped */
+static void Coprocess_dispatch( struct coprocess * cp, unsigned int id, int status, const BYTE * payload, size_t length )
+{
+	struct coprocess_request * request ;
+
+	for ( request = cp->pending ; request != NULL ; request = request->next ) {
+		if ( request->id == id && ! request->done ) {
+			if ( length > request->answer_size ) {
+				length = request->answer_size ;
+			}
+			if ( length > 0 ) {
+				memcpy( request->answer, payload, length ) ;
+			}
+			request->answer_length = length ;
+			request->status = (status > 0) ? 0 : status ;
+			request->done = 1 ;
+#if OW_MT
+			pthread_cond_broadcast( &(cp->cond) ) ;
+#endif /* OW_MT */
+			return ;
+		}
+	}
+	LEVEL_DEBUG("Co-process <%s> answer to unknown request %u",cp->command,id) ;
+}
+
+static ZERO_OR_ERROR Coprocess_getline( struct coprocess * cp, char * line, size_t size, int timeout_ms )
+{
+	size_t used = 0 ;
+
+	while ( used < size - 1 ) {
+		char c ;
+		if ( cp->in_start == cp->in_end ) {
+			ZERO_OR_ERROR zoe = Coprocess_fill( cp, timeout_ms ) ;
+			if ( zoe != 0 ) {
+				return zoe ;
+			}
+		}
+		c = cp->in_buffer[cp->in_start++] ;
+		if ( c == '\n' ) {
+			line[used] = '\0' ;
+			return 0 ;
+		}
+		line[used++] = c ;
+	}
+	return -EPROTO ;			// line too long
+}
+
+static ZERO_OR_ERROR Coprocess_getbytes( struct coprocess * cp, BYTE * data, size_t length, int timeout_ms )
+{
+	while ( length > 0 ) {
+		size_t available ;
+		if ( cp->in_start == cp->in_end ) {
+			ZERO_OR_ERROR zoe = Coprocess_fill( cp, timeout_ms ) ;
+			if ( zoe != 0 ) {
+				return zoe ;
+			}
+		}
+		available = cp->in_end - cp->in_start ;
+		if ( available > length ) {
+			available = length ;
+		}
+		memcpy( data, &(cp->in_buffer[cp->in_start]), available ) ;
+		cp->in_start += available ;
+		data += available ;
+		length -= available ;
+	}
+	return 0 ;
+}
+
+/* Refill the read-ahead buffer (it is empty) */
+static ZERO_OR_ERROR Coprocess_fill( struct coprocess * cp, int timeout_ms )
+{
+	struct pollfd pfd = { cp->from_child, POLLIN, 0, } ;
+	ssize_t got ;
+
+	switch ( poll( &pfd, 1, timeout_ms ) ) {
+		case 0:
+			return -ETIMEDOUT ;
+		case -1:
+			if ( errno == EINTR ) {
+				return Coprocess_fill( cp, timeout_ms ) ;
+			}
+			return -EIO ;
+		default:
+			break ;
+	}
+
+	got = read( cp->from_child, cp->in_buffer, COPROCESS_LINE_LENGTH ) ;
+	if ( got <= 0 ) {
+		if ( got < 0 && errno == EINTR ) {
+			return Coprocess_fill( cp, timeout_ms ) ;
+		}
+		return -EIO ;			// end of stream
+	}
+	cp->in_start = 0 ;
+	cp->in_end = got ;
+	return 0 ;
+}
+
+/* Make a free-form field safe for the tab separated header */
+/* The configuration parser can leave a trailing newline on the data fields */
+static char * Coprocess_field( const char * field )
+{
+	char * scrubbed = owstrdup( (field == NULL) ? "" : field ) ;
+	char * c ;
+	size_t len ;
+
+	if ( scrubbed == NULL ) {
+		return NULL ;
+	}
+	for ( c = scrubbed ; *c != '\0' ; ++c ) {
+		if ( *c == '\t' || *c == '\n' || *c == '\r' ) {
+			*c = ' ' ;
+		}
+	}
+	len = strlen( scrubbed ) ;
+	while ( len > 0 && scrubbed[len-1] == ' ' ) {
+		scrubbed[--len] = '\0' ;
+	}
+	return scrubbed ;
+}
+
+/* Fields after the id, tab separated, newline ended */
+static int Coprocess_header( char * header, size_t size, const char * mode, size_t length, struct sensor_node * sensor_n, struct property_node * property_n, struct one_wire_query * owq )
+{
+	struct parsedname * pn = PN(owq) ;
+	char extension[16] ;
+	char * sensor_data = Coprocess_field( sensor_n->data ) ;
+	char * property_data = Coprocess_field( property_n->data ) ;
+	int snp_return = -1 ;
+
+	if ( sensor_data == NULL || property_data == NULL ) {
+		SAFEFREE( sensor_data ) ;
+		SAFEFREE( property_data ) ;
+		return -1 ;
+	}
+
+	UCLIBCLOCK ;
+	if ( pn->sparse_name == NULL ) {
+		snprintf( extension, sizeof(extension), "%d", pn->extension ) ;
+	}
+	snp_return = snprintf( header, size, "%s\t%s\t%s\t%s\t%d\t%d\t%d\t%s\t%s\n",
+		mode,
+		sensor_n->name, // sensor name
+		property_n->property, // property
+		(pn->sparse_name == NULL) ? extension : pn->sparse_name, // extension
+		(int) OWQ_size(owq), // size
+		(int) OWQ_offset(owq), // offset
+		(int) length, // payload length
+		sensor_data, // sensor-specific data
+		property_data // property-specific data
+	) ;
+	UCLIBCUNLOCK ;
+	owfree( sensor_data ) ;
+	owfree( property_data ) ;
+
+	if ( snp_return < 0 || (size_t) snp_return >= size ) {
+		return -1 ;
+	}
+	return snp_return ;
+}
@@ -75,12 +75,10 @@ BYTE CRC8(const BYTE * bytes, const size_t length)
 BYTE CRC8seeded(const BYTE * bytes, const size_t length, const UINT seed)
 {
 	BYTE r = CRC8compute(bytes, length, seed);
-	STATLOCK;
-	++CRC8_tries;				/* statistics */
+	STAT_ADD1(CRC8_tries);		/* statistics */
 	if (r) {
-		++CRC8_errors;			/* statistics */
+		STAT_ADD1(CRC8_errors);	/* statistics */
 	}
-	STATUNLOCK;
 	return r;
 }
 
@@ -107,14 +105,39 @@ int CRC16seeded(const BYTE * bytes, const size_t length, const UINT seed)
 		sd ^= (c <<= 6);
 		sd ^= (c << 1);
 	}
-	STATLOCK;
-	++CRC16_tries;				/* statistics */
+	STAT_ADD1(CRC16_tries);		/* statistics */
 	if (sd == 0xB001) {
 		ret = 0;				/* good */
 	} else {
 		ret = -1;				/* error */
-		++CRC16_errors;			/* statistics */
+		STAT_ADD1(CRC16_errors);	/* statistics */
 	}
-	STATUNLOCK;
 	return ret;
 }
+
+/* FNV-1a -- not a check code, the hash for the in-memory lookup tables */
+/* (device locks, cache shards, parse cache, property index, aliases) */
+/* seed is mixed into the offset basis, 0 for the standard hash */
+UINT FNV1a(const BYTE * bytes, const size_t length, const UINT seed)
+{
+	UINT hash = 2166136261U ^ seed;
+	size_t i;
+
+	for (i = 0; i < length; ++i) {
+		hash ^= bytes[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/* FNV-1a over a null-terminated string (the null is not hashed) */
+UINT FNV1a_string(const ASCII * string, const UINT seed)
+{
+	UINT hash = 2166136261U ^ seed;
+
+	while (*string != '\0') {
+		hash ^= (BYTE) * string++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
@@ -16,55 +16,122 @@ $Id$
 
 # if OW_MT
 
-// dynamically created access control for a 1-wire device
+// access control for a 1-wire device
 // used to negotiate between different threads (queries)
+// one slot of the per-connection device lock table
 struct devlock {
-	pthread_mutex_t lock;
+	pthread_mutex_t lock;	// created with the table, reused by whichever device holds the slot
 	BYTE sn[SERIAL_NUMBER_SIZE];
-	UINT users;
+	UINT users;				// threads holding or waiting for the device (0 = slot free)
+	UINT probes;			// devices in use whose probe from their home slot reaches here (0 = end of every chain)
 };
 
-
 /*
-We keep all the devlocks, organized in a tree for faster searching.
+Each connection has a fixed, open-addressed (linear probing) table of devlocks,
+keyed by serial number and allocated with the connection.
+A device only needs a slot while some thread holds or waits for it,
+so the table is sized for concurrent queries, not for the number of devices.
+No allocation, mutex creation or tree walk per access.
 */
+#define DEVLOCK_SLOTS	256		// power of 2
+
 #define DEVTREE_LOCK(pn)           _MUTEX_LOCK(   ((pn)->selected_connection)->dev_mutex )
 #define DEVTREE_UNLOCK(pn)         _MUTEX_UNLOCK( ((pn)->selected_connection)->dev_mutex )
 
-/* Bad bad C library */
-/* implementation of tfind, tsearch returns an opaque structure */
-/* you have to know that the first element is a pointer to your data */
+static struct devlock * DevlockFind( struct devlock * table, const BYTE * sn ) ;
+static void DevlockChain( struct devlock * table, struct devlock * slot, int claim ) ;
 
-/* This is a tree element for the devlocks */
-struct dev_opaque {
-	struct devlock *key;
-	void *other;
-};
+/* Create the device lock table for a new connection */
+GOOD_OR_BAD DeviceLockTableCreate(struct connection_in *in)
+{
+	int slot ;
+
+	in->dev_table = owmalloc( DEVLOCK_SLOTS * sizeof(struct devlock) ) ;
+	if ( in->dev_table == NULL ) {
+		return gbBAD ;
+	}
+	memset( in->dev_table, 0, DEVLOCK_SLOTS * sizeof(struct devlock) ) ;
+	for ( slot = 0 ; slot < DEVLOCK_SLOTS ; ++slot ) {
+		_MUTEX_INIT( in->dev_table[slot].lock ) ;
+	}
+	return gbGOOD ;
+}
+
+/* Free the device lock table when the connection is removed */
+void DeviceLockTableDestroy(struct connection_in *in)
+{
+	int slot ;
+
+	if ( in->dev_table == NULL ) {
+		return ;
+	}
+	for ( slot = 0 ; slot < DEVLOCK_SLOTS ; ++slot ) {
+		_MUTEX_DESTROY( in->dev_table[slot].lock ) ;
+	}
+	owfree( in->dev_table ) ;
+	in->dev_table = NULL ;
+}
+
+/* The slot in use by this device, else the first free slot on its probe chain */
+/* NULL only if every slot is in use */
+/* Called with DEVTREE_LOCK */
+static struct devlock * DevlockFind( struct devlock * table, const BYTE * sn )
+{
+	UINT start = FNV1a( sn, SERIAL_NUMBER_SIZE, 0 ) ;
+	struct devlock * free_slot = NULL ;
+	UINT i ;
 
-/* compilation error in gcc version 4.0.0 20050519 if dev_compare
- * is defined as an embedded function
- */
-/* Use the serial numbers to find the right devlock */
-static int dev_compare(const void *a, const void *b)
+	for ( i = 0 ; i < DEVLOCK_SLOTS ; ++i ) {
+		struct devlock * slot = &table[ (start + i) & (DEVLOCK_SLOTS - 1) ] ;
+
+		if ( slot->probes == 0 ) {
+			// end of the chain -- device not present
+			return ( free_slot != NULL ) ? free_slot : slot ;
+		}
+		if ( slot->users == 0 ) {
+			if ( free_slot == NULL ) {
+				free_slot = slot ;
+			}
+		} else if ( memcmp( slot->sn, sn, SERIAL_NUMBER_SIZE ) == 0 ) {
+			return slot ;
+		}
+	}
+	return free_slot ;
+}
+
+/* A device claims (or gives up) a slot -- count it on every slot from its home slot to this one */
+/* so freed slots drop out of the chains exactly, with no tombstones left behind */
+/* Called with DEVTREE_LOCK */
+static void DevlockChain( struct devlock * table, struct devlock * slot, int claim )
 {
-	return memcmp(&((const struct devlock *) a)->sn, &((const struct devlock *) b)->sn, SERIAL_NUMBER_SIZE);
+	UINT index = FNV1a( slot->sn, SERIAL_NUMBER_SIZE, 0 ) ;
+
+	while (1) {
+		struct devlock * step = &table[ index & (DEVLOCK_SLOTS - 1) ] ;
+		if ( claim ) {
+			++(step->probes) ;
+		} else {
+			--(step->probes) ;
+		}
+		if ( step == slot ) {
+			break ;
+		}
+		++index ;
+	}
 }
 
-/* Grabs a device lock, either one already matching, or creates one */
+/* Grabs a device lock, either one already matching, or a free slot */
 /* called per-adapter */
-/* The device locks (devlock) are kept in a tree */
 ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
 {
-	struct devlock *local_devicelock;
-	struct devlock *tree_devicelock;
-	struct dev_opaque *opaque;
+	struct devlock *slot;
 
 	if (pn->selected_device == DeviceSimultaneous) {
 		/* Shouldn't call DeviceLockGet() on DeviceSimultaneous. No sn exists */
 		return 0;
 	}
 
-	/* Cannot lock without knowing which bus since the device trees are bus-specific */
+	/* Cannot lock without knowing which bus since the device tables are bus-specific */
 	if (pn->selected_connection == NO_CONNECTION) {
 		return -EINVAL ;
 	}
@@ -93,53 +160,41 @@ ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
 			break;
 	}
 
-	// Create a devlock block to add to the tree
-	local_devicelock = owmalloc(sizeof(struct devlock)) ;
-	if ( local_devicelock == NULL ) {
+	if ( pn->selected_connection->dev_table == NULL ) {
 		return -ENOMEM;
 	}
-	memcpy(local_devicelock->sn, pn->sn, SERIAL_NUMBER_SIZE);
 
 	DEVTREE_LOCK(pn);
-	/* in->dev_db points to the root of a tree of queries that are using this device */
-	opaque = (struct dev_opaque *)tsearch(local_devicelock, &(pn->selected_connection->dev_db), dev_compare) ;
-	if ( opaque == NULL ) {	// unfound and uncreatable
+	slot = DevlockFind( pn->selected_connection->dev_table, pn->sn ) ;
+	if ( slot == NULL ) {
 		DEVTREE_UNLOCK(pn);
-		owfree(local_devicelock); // kill the allocated devlock
+		LEVEL_DEBUG("Device lock table full for " SNformat, SNvar(pn->sn));
 		return -ENOMEM;
 	}
-	
-	tree_devicelock = opaque->key ;
-	if ( local_devicelock == tree_devicelock) {	// new device slot
-		// No longer "local" -- the local_device lock now belongs to the device_tree
-		// It will need to be freed later, when the user count returns to zero.
-		_MUTEX_INIT(tree_devicelock->lock);	// create a mutex
-		tree_devicelock->users = 0 ;
-	} else {					// existing device slot
-		owfree(local_devicelock); // kill the locally allocated devlock (since there already is a matching devlock)	
+	if ( slot->users == 0 ) {	// claim a free slot for this device
+		memcpy(slot->sn, pn->sn, SERIAL_NUMBER_SIZE);
+		DevlockChain( pn->selected_connection->dev_table, slot, 1 ) ;
 	}
-	++(tree_devicelock->users); // add our claim to the device
+	++(slot->users); // add our claim to the device
 	DEVTREE_UNLOCK(pn);
-	_MUTEX_LOCK(tree_devicelock->lock);	// now grab the device
-	pn->lock = tree_devicelock; // use this new devlock
+	_MUTEX_LOCK(slot->lock);	// now grab the device
+	pn->lock = slot; // use this devlock
 	return 0;
 }
 
 // Unlock the device
 void DeviceLockRelease(struct parsedname *pn)
 {
-	if (pn->lock) { // this is the stored pointer to the device in the appropriate device tree
+	if (pn->lock) { // this is the stored pointer to the device's slot in the connection's table
 		// Free the device
-		_MUTEX_UNLOCK(pn->lock->lock);		/* Serg: This coredump on his 64-bit server */
+		_MUTEX_UNLOCK(pn->lock->lock);
 
-		// Now mark our disinterest in the device tree (and possibly reap the node))
+		// Now mark our disinterest in the device (and possibly free the slot)
 		DEVTREE_LOCK(pn);
 		--pn->lock->users; // remove our interest
 		if (pn->lock->users == 0) {
-			// Nobody's interested!
-			tdelete(pn->lock, &(pn->selected_connection->dev_db), dev_compare); /* Serg: Address 0x5A0D750 is 0 bytes inside a block of size 32 free'd */
-			_MUTEX_DESTROY(pn->lock->lock);
-			owfree(pn->lock);
+			// Nobody's interested! Keep the mutex for the next device
+			DevlockChain( pn->selected_connection->dev_table, pn->lock, 0 ) ;
 		}
 		DEVTREE_UNLOCK(pn);
 		pn->lock = NULL;
@@ -159,4 +214,15 @@ void DeviceLockRelease(struct parsedname *pn)
 	(void) pn;					// suppress compiler warning in the trivial case.
 }
 
+GOOD_OR_BAD DeviceLockTableCreate(struct connection_in *in)
+{
+	in->dev_table = NULL ;
+	return gbGOOD ;
+}
+
+void DeviceLockTableDestroy(struct connection_in *in)
+{
+	(void) in;					// suppress compiler warning in the trivial case.
+}
+
 #endif							/* OW_MT */
@@ -28,6 +28,7 @@ static ZERO_OR_ERROR FS_alarmdir(void (*dirfunc) (void *, const struct parsednam
 static ZERO_OR_ERROR FS_typedir(void (*dirfunc) (void *, const struct parsedname * const), void *v, const struct parsedname *pn_type_directory);
 static ZERO_OR_ERROR FS_realdir(void (*dirfunc) (void *, const struct parsedname * const), void *v, const struct parsedname *pn2, uint32_t * flags);
 static ZERO_OR_ERROR FS_cache2real(void (*dirfunc) (void *, const struct parsedname * const), void *v, const struct parsedname *pn2, uint32_t * flags);
+static GOOD_OR_BAD FS_cachedir(void (*dirfunc) (void *, const struct parsedname * const), void *v, const struct parsedname *pn_real_directory, uint32_t * flags);
 static ZERO_OR_ERROR FS_busdir(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn_directory);
 
 static void FS_stype_dir(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn_root_directory);
@@ -99,10 +100,8 @@ static ZERO_OR_ERROR FS_dir_both(void (*dirfunc) (void *, const struct parsednam
 	
 	LEVEL_CALL("path=%s", SAFESTRING(pn_raw_directory->path));
 
-	STATLOCK;
-	AVERAGE_IN(&dir_avg);
-	AVERAGE_IN(&all_avg);
-	STATUNLOCK;
+	STAT_AVERAGE_IN(&dir_avg);
+	STAT_AVERAGE_IN(&all_avg);
 
 	FSTATLOCK;
 	StateInfo.dir_time = NOW_TIME;	// protected by mutex
@@ -187,10 +186,8 @@ static ZERO_OR_ERROR FS_dir_both(void (*dirfunc) (void *, const struct parsednam
 
 	}
 
-	STATLOCK;
-	AVERAGE_OUT(&dir_avg);
-	AVERAGE_OUT(&all_avg);
-	STATUNLOCK;
+	STAT_AVERAGE_OUT(&dir_avg);
+	STAT_AVERAGE_OUT(&all_avg);
 
 	LEVEL_DEBUG("ret=%d", ret);
 	return ret;
@@ -245,8 +242,7 @@ static void FS_simultaneous_entry(void (*dirfunc) (void *, const struct parsedna
 /* FS_dir_all_connections produces the data that can vary: device lists, etc. */
 
 struct dir_all_connections_struct {
-	struct port_in * pin ;
-	struct connection_in * cin ;
+	struct bus_job job;
 	struct parsedname pn_directory;
 	void (*dirfunc) (void *, const struct parsedname *);
 	void *v;
@@ -254,30 +250,10 @@ struct dir_all_connections_struct {
 	ZERO_OR_ERROR ret;
 };
 
-/* Embedded function */
-static void *FS_dir_all_connections_callback_conn(void *v)
+/* Run by the bus worker for one connection */
+static void FS_dir_all_connections_job(void *v)
 {
 	struct dir_all_connections_struct *dacs = v;
-	struct dir_all_connections_struct dacs_next ;
-	pthread_t thread;
-	int threadbad = 0;
-	
-	// set up structure
-	dacs_next.cin = dacs->cin->next ;
-
-	if ( dacs_next.cin == NO_CONNECTION ) {
-		threadbad = 1 ;
-	} else {
-		dacs_next.pin = dacs->pin ;
-		dacs_next.dirfunc = dacs->dirfunc ;
-		memcpy( &(dacs_next.pn_directory), &(dacs->pn_directory), sizeof(struct parsedname));	// shallow copy
-		dacs_next.v = dacs->v ;
-		dacs_next.flags = dacs->flags ;
-		dacs_next.ret = dacs->ret ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, FS_dir_all_connections_callback_conn, (void *) (&dacs_next));
-	}
-
-	SetKnownBus(dacs->cin->index, &(dacs->pn_directory) );
 
 	if ( BAD(TestConnection( &(dacs->pn_directory) )) ) {	// reconnect ok?
 		dacs->ret = -ECONNABORTED;
@@ -290,84 +266,92 @@ static void *FS_dir_all_connections_callback_conn(void *v)
 	} else {
 		dacs->ret = FS_cache2real(dacs->dirfunc, dacs->v, &(dacs->pn_directory), &(dacs->flags));
 	}
-	//printf("FS_dir_all_connections4 pid=%ld adapter=%d ret=%d\n",pthread_self(), dacs->pn_directory->selected_connection->index,ret);
-	/* See if next bus was also queried */
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)!= 0) {
-			return VOID_RETURN ;			/* cannot join, so return only this result */
-		}
-		if (dacs_next.ret >= 0) {
-			dacs->ret = dacs_next.ret;	/* is it an error return? Then return this one */
-		} else {
-			dacs->flags |= dacs_next.flags ;
-		}		
-	}
-	return VOID_RETURN;
 }
 
-static void *FS_dir_all_connections_callback_port(void *v)
+/* A local bus with a cached listing is answered in the calling thread */
+/* returns 1 if done */
+static int FS_dir_all_connections_cached(struct dir_all_connections_struct *dacs)
 {
-	struct dir_all_connections_struct *dacs = v;
-	struct dir_all_connections_struct dacs_next ;
-	pthread_t thread;
-	int threadbad = 0;
-	
-	if ( dacs->pin == NULL ) {
-		return VOID_RETURN;
+	struct parsedname * pn = &(dacs->pn_directory) ;
+	struct connection_in * in = pn->selected_connection ;
+
+	if ( in->reconnect_state >= reconnect_error ) {
+		return 0 ;	// TestConnection would have to reconnect first
 	}
+	if ( BusIsServer(in) || IsAlarmDir(pn) || get_busmode(in) == bus_external ) {
+		return 0 ;
+	}
+	return GOOD( FS_cachedir(dacs->dirfunc, dacs->v, pn, &(dacs->flags)) ) ;
+}
+
+/* Each connection's listing is queued on that bus's worker thread (ow_busworker.c) */
+/* unless the cache can answer it right away */
+/* Result is 0 if any bus answered, else the first error */
+static ZERO_OR_ERROR
+FS_dir_all_connections(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn_directory, uint32_t * flags)
+{
+	struct port_in * pin ;
+	struct connection_in * cin ;
+	struct dir_all_connections_struct * dacs ;
+	struct bus_job_group group ;
+	int connections = 0 ;
+	int i ;
+	ZERO_OR_ERROR ret = 0 ;
 
-	// set up structure
-	dacs_next.pin = dacs->pin->next ;
+	*flags = 0 ;
 
-	if ( dacs_next.pin == NULL ) {
-		threadbad = 1 ;
-	} else {
-		dacs_next.dirfunc = dacs->dirfunc ;
-		memcpy( &(dacs_next.pn_directory), &(dacs->pn_directory), sizeof(struct parsedname));	// shallow copy
-		dacs_next.v = dacs->v ;
-		dacs_next.flags = dacs->flags ;
-		dacs_next.ret = dacs->ret ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, FS_dir_all_connections_callback_port, (void *) (&dacs_next));
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+			++connections ;
+		}
+	}
+	if ( connections == 0 ) {
+		return 0 ;
 	}
 
-	dacs->cin = dacs->pin->first ;
-	if ( dacs->cin != NO_CONNECTION ) {
-		FS_dir_all_connections_callback_conn( v ) ;
+	dacs = owmalloc( connections * sizeof(struct dir_all_connections_struct) ) ;
+	if ( dacs == NULL ) {
+		return -ENOMEM ;
 	}
-		
-	//printf("FS_dir_all_connections4 pid=%ld adapter=%d ret=%d\n",pthread_self(), dacs->pn_directory->selected_connection->index,ret);
-	/* See if next bus was also queried */
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)!= 0) {
-			return VOID_RETURN ;			/* cannot join, so return only this result */
+
+	BusJobGroupInit( &group ) ;
+	i = 0 ;
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+			struct dir_all_connections_struct * d = &dacs[i++] ;
+
+			memcpy( &(d->pn_directory), pn_directory, sizeof(struct parsedname));	// shallow copy
+			SetKnownBus(cin->index, &(d->pn_directory) );
+			d->dirfunc = dirfunc ;
+			d->v = v ;
+			d->flags = 0 ;
+			d->ret = 0 ;
+			if ( FS_dir_all_connections_cached( d ) ) {
+				continue ;	// answered from the cache, no need to wait behind bus jobs
+			}
+			d->job.run = FS_dir_all_connections_job ;
+			d->job.arg = d ;
+			BusJobSubmit( &group, &(d->job), cin ) ;
 		}
-		if (dacs_next.ret >= 0) {
-			dacs->ret = dacs_next.ret;	/* is it an error return? Then return this one */
-		} else {
-			dacs->flags |= dacs_next.flags ;
-		}		
 	}
-	return VOID_RETURN;
-}
+	BusJobGroupWait( &group ) ;
 
-static ZERO_OR_ERROR
-FS_dir_all_connections(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn_directory, uint32_t * flags)
-{
-	struct dir_all_connections_struct dacs ;
-		
-	// set up structure
-	dacs.pin = Inbound_Control.head_port ; 
-	dacs.dirfunc = dirfunc ;
-	memcpy( &(dacs.pn_directory), pn_directory, sizeof(struct parsedname));	// shallow copy
-	dacs.v = v ;
-	dacs.flags = 0 ;
-	dacs.ret = 0 ;
-	
-	// Start iterating through buses
-	FS_dir_all_connections_callback_port(  (void *) (& dacs) ) ;
-	
-	*flags = dacs.flags ;	
-	return dacs.ret ;
+	for ( i = 0 ; i < connections ; ++i ) {
+		*flags |= dacs[i].flags ;
+		if ( dacs[i].ret >= 0 ) {
+			ret = 0 ;
+			break ;
+		}
+		if ( ret == 0 ) {
+			ret = dacs[i].ret ;	// first error
+		}
+	}
+	for ( ; i < connections ; ++i ) {
+		*flags |= dacs[i].flags ;
+	}
+
+	owfree( dacs ) ;
+	return ret ;
 }
 
 #else							/* OW_MT */
@@ -719,9 +703,7 @@ static ZERO_OR_ERROR FS_realdir(void (*dirfunc) (void *, const struct parsedname
 		ret = PossiblyLockedBusCall( BUS_next, &ds, pn_whole_directory) ;
 	} 
 
-	STATLOCK;
-	dir_main.entries += devices;
-	STATUNLOCK;
+	STAT_ADD(dir_main.entries, devices);
 
 	switch ( ret ) {
 		case search_done:
@@ -770,20 +752,30 @@ void FS_LoadDirectoryOnly(struct parsedname *pn_directory, const struct parsedna
 /* Cache2Real try the cache first, else get directory from bus (and add to cache) */
 static ZERO_OR_ERROR FS_cache2real(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn_real_directory, uint32_t * flags)
 {
-	size_t dindex;
-	struct dirblob db;
-	BYTE sn[8];
-
 	/* Special handling for External directory -- just walk tree */
 	if ( get_busmode(pn_real_directory->selected_connection) == bus_external ) {
 		return FS_externaldir(dirfunc, v, pn_real_directory) ;
 	}
 	
+	if ( BAD( FS_cachedir(dirfunc, v, pn_real_directory, flags) ) ) {
+		//printf("FS_cache2real: didn't find anything at bus %d\n", pn_real_directory->selected_connection->index);
+		return FS_realdir(dirfunc, v, pn_real_directory, flags);
+	}
+	return 0;
+}
+
+/* The directory from the cache only -- gbBAD if it has to come from the bus */
+/* No bus access, so safe to call outside the bus worker */
+static GOOD_OR_BAD FS_cachedir(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn_real_directory, uint32_t * flags)
+{
+	size_t dindex;
+	struct dirblob db;
+	BYTE sn[8];
+
 	/* Test to see whether we should get the directory "directly" */
 	if (SpecifiedBus(pn_real_directory) || IsUncachedDir(pn_real_directory)
 		|| BAD( Cache_Get_Dir(&db, pn_real_directory)) ) {
-		//printf("FS_cache2real: didn't find anything at bus %d\n", pn_real_directory->selected_connection->index);
-		return FS_realdir(dirfunc, v, pn_real_directory, flags);
+		return gbBAD;
 	}
 	//printf("Post test cache for dir, snlist=%p, devices=%lu\n",snlist,devices) ;
 	/* We have a cached list in snlist. Note that we have to free this memory */
@@ -800,12 +792,8 @@ static ZERO_OR_ERROR FS_cache2real(void (*dirfunc) (void *, const struct parsedn
 	}
 	DirblobClear(&db);			/* allocated in Cache_Get_Dir */
 
-	STATLOCK;
-
-	dir_main.entries += dindex;
-
-	STATUNLOCK;
-	return 0;
+	STAT_ADD(dir_main.entries, dindex);
+	return gbGOOD;
 }
 
 // must lock a global struct for walking through tree -- limitation of "twalk"
@@ -59,6 +59,9 @@ static GOOD_OR_BAD DS2482_detect_single(int lowindex, int highindex, char * i2c_
 static enum search_status DS2482_next_both(struct device_search *ds, const struct parsedname *pn);
 static GOOD_OR_BAD DS2482_triple(BYTE * bits, int direction, FILE_DESCRIPTOR_OR_ERROR file_descriptor);
 static GOOD_OR_BAD DS2482_send_and_get(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const BYTE wr, BYTE * rd);
+static GOOD_OR_BAD DS2482_send_and_get_block(const BYTE * data, BYTE * resp, const size_t len, struct connection_in * in);
+static GOOD_OR_BAD DS2482_rdwr(struct i2c_msg * msgs, int nmsgs, FILE_DESCRIPTOR_OR_ERROR file_descriptor);
+static int DS2482_rdwr_capable(FILE_DESCRIPTOR_OR_ERROR file_descriptor);
 static RESET_TYPE DS2482_reset(const struct parsedname *pn);
 static GOOD_OR_BAD DS2482_sendback_data(const BYTE * data, BYTE * resp, const size_t len, const struct parsedname *pn);
 static void DS2482_setroutines(struct connection_in *in);
@@ -142,7 +145,7 @@ static void DS2482_setroutines(struct connection_in *in)
 	in->iroutines.reconnect = DS2482_redetect;
 	in->iroutines.close = DS2482_close;
 	in->iroutines.flags = ADAP_FLAG_overdrive;
-	in->bundling_length = I2C_FIFO_SIZE;
+	in->iroutines.bundling_length = I2C_FIFO_SIZE;
 }
 
 /* All the rest of the program sees is the DS2482_detect and the entry in iroutines */
@@ -402,6 +405,7 @@ static GOOD_OR_BAD DS2482_detect_single(int lowindex, int highindex, char * i2c_
 			in->master.i2c.channels = 1;
 			in->master.i2c.current = 0;
 			in->master.i2c.head = in;
+			in->master.i2c.rdwr = DS2482_rdwr_capable(file_descriptor);
 			in->adapter_name = "DS2482-100";
 			in->master.i2c.configreg = 0x00 ;	// default configuration setting desired
 			if ( Globals.i2c_APU ) {
@@ -477,6 +481,7 @@ static GOOD_OR_BAD DS2482_redetect(const struct parsedname *pn)
 			head->pown->state = cs_deflowered ;
 			head->pown->type = ct_i2c ;
 			head->master.i2c.configchip = 0x00;	// default configuration register after RESET	
+			head->master.i2c.rdwr = DS2482_rdwr_capable(file_descriptor);
 			LEVEL_CONNECT("i2c device at %s address %d reset successfully", DEVICENAME(head), address);
 			for ( next = head->pown->first; next; next = next->next ) {
 				/* loop through devices, matching those that have the same "head" */
@@ -627,13 +632,84 @@ static GOOD_OR_BAD DS2482_sendback_data(const BYTE * data, BYTE * resp, const si
 	RETURN_BAD_IF_BAD(DS2482_channel_select(in)) ;
 
 	TrafficOut( "write", data, len, in ) ;
-	for (i = 0; i < len; ++i) {
-		RETURN_BAD_IF_BAD(DS2482_send_and_get(file_descriptor, data[i], &resp[i])) ;
+	if ( in->master.i2c.head->master.i2c.rdwr && len > 1 ) {
+		RETURN_BAD_IF_BAD(DS2482_send_and_get_block(data, resp, len, in)) ;
+	} else {
+		for (i = 0; i < len; ++i) {
+			RETURN_BAD_IF_BAD(DS2482_send_and_get(file_descriptor, data[i], &resp[i])) ;
+		}
 	}
 	TrafficOut( "response", resp, len, in ) ;
 	return gbGOOD;
 }
 
+/* Block of bytes using combined i2c transfers -- assumes channel selection already done
+   Per byte the smbus path costs 4 transfers: write byte, status, set read pointer, read data.
+   Here the data readback of one byte and the write of the next go out in a single
+   I2C_RDWR call (repeated start, one stop), so each byte costs a status poll plus one call.
+   A 1-Wire Write Byte leaves the read pointer at the status register, so polling needs no setup.
+*/
+static GOOD_OR_BAD DS2482_send_and_get_block(const BYTE * data, BYTE * resp, const size_t len, struct connection_in * in)
+{
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor = in->pown->file_descriptor;
+	__u16 address = in->master.i2c.head->master.i2c.i2c_address ;
+	BYTE set_pointer[2] = { DS2482_CMD_SET_READ_PTR, DS2482_PTR_CODE_DATA, } ;
+	BYTE write_byte[2] = { DS2482_CMD_1WIRE_WRITE_BYTE, 0x00, } ;
+	struct i2c_msg msgs[3] = {
+		{ address, 0, 2, (char *) set_pointer, },
+		{ address, I2C_M_RD, 1, NULL, },
+		{ address, 0, 2, (char *) write_byte, },
+	} ;
+	size_t i;
+
+	/* First byte starts the chain */
+	if (i2c_smbus_write_byte_data(file_descriptor, DS2482_CMD_1WIRE_WRITE_BYTE, data[0]) < 0) {
+		return gbBAD;
+	}
+
+	for (i = 0; i < len; ++i) {
+		BYTE c;
+
+		/* read status for done */
+		RETURN_BAD_IF_BAD( DS2482_readstatus(&c, file_descriptor, DS2482_1wire_write_usec) ) ;
+
+		/* fetch this byte's response and (unless the last) send the next */
+		msgs[1].buf = (char *) &resp[i] ;
+		if ( i + 1 < len ) {
+			write_byte[1] = data[i + 1] ;
+			RETURN_BAD_IF_BAD( DS2482_rdwr(msgs, 3, file_descriptor) ) ;
+		} else {
+			RETURN_BAD_IF_BAD( DS2482_rdwr(msgs, 2, file_descriptor) ) ;
+		}
+	}
+
+	return gbGOOD;
+}
+
+/* One combined i2c transfer */
+static GOOD_OR_BAD DS2482_rdwr(struct i2c_msg * msgs, int nmsgs, FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	struct i2c_rdwr_ioctl_data rdwr = { msgs, nmsgs, } ;
+
+	if ( ioctl(file_descriptor, I2C_RDWR, &rdwr) != nmsgs ) {
+		ERROR_DEBUG("Combined i2c transfer of %d messages failed", nmsgs);
+		return gbBAD;
+	}
+	return gbGOOD;
+}
+
+/* Does the i2c adapter driver handle plain (non-smbus) combined transfers? */
+static int DS2482_rdwr_capable(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	unsigned long funcs = 0 ;
+
+	if ( ioctl(file_descriptor, I2C_FUNCS, &funcs) < 0 ) {
+		return 0 ;
+	}
+	LEVEL_DEBUG("i2c adapter functionality %.8lX, combined transfers %s", funcs, (funcs & I2C_FUNC_I2C) ? "yes" : "no");
+	return (funcs & I2C_FUNC_I2C) != 0 ;
+}
+
 /* Single byte -- assumes channel selection already done */
 static GOOD_OR_BAD DS2482_send_and_get(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const BYTE wr, BYTE * rd)
 {
@@ -48,7 +48,7 @@ static void DS9097_setroutines(struct connection_in *in)
 	in->iroutines.reconnect = NO_RECONNECT_ROUTINE;
 	in->iroutines.close = COM_close;
 	in->iroutines.flags = ADAP_FLAG_default;
-	in->bundling_length = UART_FIFO_SIZE / 10;
+	in->iroutines.bundling_length = UART_FIFO_SIZE / 10;
 }
 
 /* _detect is a bit of a misnomer, no detection is actually done */
@@ -75,8 +75,8 @@ static void DS2480_setroutines(struct connection_in *in)
 	in->iroutines.select_and_sendback = NO_SELECTANDSENDBACK_ROUTINE;
 	in->iroutines.reconnect = DS2480_reconnect ;
 	in->iroutines.close = DS2480_close;
-	in->iroutines.flags = ADAP_FLAG_default;
-	in->bundling_length = UART_FIFO_SIZE;
+	in->iroutines.flags = ADAP_FLAG_default | ADAP_FLAG_bundle;
+	in->iroutines.bundling_length = UART_FIFO_SIZE;
 }
 
 // Number of times to try init (from digitemp code))
@@ -64,6 +64,9 @@ static GOOD_OR_BAD DS9490_setup_adapter(struct connection_in * in) ;
 
 static enum search_status DS9490_next_both(struct device_search *ds, const struct parsedname *pn);
 static GOOD_OR_BAD DS9490_sendback_data(const BYTE * data, BYTE * resp, size_t len, const struct parsedname *pn);
+static GOOD_OR_BAD DS9490_sendback_serial(const BYTE * data, BYTE * resp, size_t len, const struct parsedname *pn);
+static GOOD_OR_BAD DS9490_sendback_pipelined(const BYTE * data, BYTE * resp, size_t len, const struct parsedname *pn);
+static GOOD_OR_BAD DS9490_sendback_abort(int pending, const struct parsedname *pn);
 static GOOD_OR_BAD DS9490_HaltPulse(const struct parsedname *pn);
 static GOOD_OR_BAD DS9490_PowerByte(BYTE byte, BYTE * resp, UINT delay, const struct parsedname *pn);
 static GOOD_OR_BAD DS9490_ProgramPulse(const struct parsedname *pn);
@@ -90,9 +93,9 @@ static void DS9490_setroutines(struct connection_in *in)
 	in->iroutines.select_and_sendback = NO_SELECTANDSENDBACK_ROUTINE;
 	in->iroutines.reconnect = DS9490_reconnect;
 	in->iroutines.close = DS9490_close;
-	in->iroutines.flags = ADAP_FLAG_default;
+	in->iroutines.flags = ADAP_FLAG_default | ADAP_FLAG_bundle;
 
-	in->bundling_length = USB_FIFO_SIZE;
+	in->iroutines.bundling_length = USB_FIFO_SIZE;
 }
 
 #define DS2490_BULK_BUFFER_SIZE     64
@@ -786,6 +789,15 @@ static GOOD_OR_BAD DS9490_open_and_name(struct usb_list *ul, struct connection_i
 /* --- USB read and write --------------------------------------*/
 
 static GOOD_OR_BAD DS9490_sendback_data(const BYTE * data, BYTE * resp, size_t len, const struct parsedname *pn)
+{
+	if ( Globals.usb_pipeline ) {
+		return DS9490_sendback_pipelined( data, resp, len, pn ) ;
+	}
+	return DS9490_sendback_serial( data, resp, len, pn ) ;
+}
+
+/* One 64-byte chunk at a time: write, BLOCK_IO, wait for idle, read */
+static GOOD_OR_BAD DS9490_sendback_serial(const BYTE * data, BYTE * resp, size_t len, const struct parsedname *pn)
 {
 	size_t location = 0 ;
 
@@ -823,6 +835,87 @@ static GOOD_OR_BAD DS9490_sendback_data(const BYTE * data, BYTE * resp, size_t l
 	return gbGOOD;
 }
 
+/* --usb_pipeline (off by default, not yet validated on hardware)
+   Block transfers are pipelined through the DS2490 FIFOs:
+   EP2 (data out) and EP3 (data in) each hold USB_FIFO_SIZE bytes and BLOCK_IO commands queue.
+   So the next chunk is written and its BLOCK_IO issued while the previous one is on the 1-wire bus,
+   and the status poll for a finished chunk overlaps the next chunk's execution.
+   At most USB_FIFO_SIZE bytes are outstanding (sent but not yet read back) */
+static GOOD_OR_BAD DS9490_sendback_pipelined(const BYTE * data, BYTE * resp, size_t len, const struct parsedname *pn)
+{
+	size_t queued = 0 ;			// bytes handed to the adapter
+	size_t received = 0 ;		// bytes read back
+
+	while ( received < len ) {
+		BYTE buffer[ DS9490_getstatus_BUFFER_LENGTH ];
+		int readlen ;
+		size_t block ;
+
+		// keep the adapter fed
+		while ( queued < len ) {
+			block = len - queued ;
+			if ( block > USB_FIFO_EACH ) {
+				block = USB_FIFO_EACH ;
+			}
+			if ( queued + block - received > USB_FIFO_SIZE ) {
+				break ; // FIFO full -- collect a result first
+			}
+
+			if ( DS9490_write( &data[queued], block, pn) < (int) block) {
+				LEVEL_DATA("USBsendback bulk write problem");
+				return DS9490_sendback_abort( queued > received, pn ) ;
+			}
+
+			// COMM_BLOCK_IO | COMM_IM | COMM_F == 0x0075
+			if ( BAD( USB_Control_Msg(COMM_CMD, COMM_BLOCK_IO | COMM_IM | COMM_F, block, pn)) ) {
+				LEVEL_DATA("USBsendback control error");
+				STAT_ADD1_BUS(e_bus_errors, pn->selected_connection);
+				return DS9490_sendback_abort( queued > received, pn ) ;
+			}
+			queued += block ;
+		}
+
+		// oldest outstanding chunk
+		block = queued - received ;
+		if ( block > USB_FIFO_EACH ) {
+			block = USB_FIFO_EACH ;
+		}
+
+		readlen = block ;
+		if ( queued < len || block < queued - received ) {
+			// more still executing -- don't wait for idle
+			if ( DS9490_getstatus_datain(buffer, &readlen, pn)  != BUS_RESET_OK ) {
+				LEVEL_DATA("USBsendback status error");
+				STAT_ADD1_BUS(e_bus_errors, pn->selected_connection);
+				return DS9490_sendback_abort( 1, pn ) ;
+			}
+		} else if ( DS9490_getstatus(buffer, &readlen, pn)  != BUS_RESET_OK ) {	// wait for len bytes
+			LEVEL_DATA("USBsendback control error");
+			STAT_ADD1_BUS(e_bus_errors, pn->selected_connection);
+			return gbBAD;
+		}
+
+		if ( DS9490_read( &resp[received], block, pn) < 0) {
+			LEVEL_DATA("USBsendback bulk read error");
+			return DS9490_sendback_abort( queued > received + block, pn ) ;
+		}
+
+		received += block ;
+	}
+	return gbGOOD;
+}
+
+/* A pipelined transfer failed -- discard whatever the adapter still has queued */
+static GOOD_OR_BAD DS9490_sendback_abort(int pending, const struct parsedname *pn)
+{
+	if ( pending ) {
+		LEVEL_DEBUG("Clearing queued USB block transfers");
+		USB_Control_Msg(CONTROL_CMD, CTL_RESET_DEVICE, 0x0000, pn) ;
+		BUS_ERROR_fix(pn) ;
+	}
+	return gbBAD ;
+}
+
 
 /* ------------------------------------------------------------ */
 /* --- USB Power byte for temperature conversion ---------------*/
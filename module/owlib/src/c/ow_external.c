@@ -33,7 +33,7 @@ static void External_setroutines(struct connection_in *in)
 	in->iroutines.reconnect = NO_RECONNECT_ROUTINE;
 	in->iroutines.close = NO_CLOSE_ROUTINE;
 	in->iroutines.flags = 0 ;
-	in->bundling_length = 1;
+	in->iroutines.bundling_length = 1;
 }
 
 GOOD_OR_BAD External_detect(struct port_in *pin)
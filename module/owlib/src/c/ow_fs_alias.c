@@ -20,16 +20,14 @@ $Id$
 ZERO_OR_ERROR FS_r_alias(struct one_wire_query *owq)
 {
 	BYTE * sn = OWQ_pn(owq).sn ;
-	ASCII * alias_name = Cache_Get_Alias( sn ) ;
+	ASCII alias_name[PROPERTY_LENGTH_ALIAS+1] ;
 
-	if ( alias_name != NULL ) {
-		ZERO_OR_ERROR zoe = OWQ_format_output_offset_and_size_z(alias_name, owq);
+	if ( GOOD( Cache_Get_Alias( alias_name, PROPERTY_LENGTH_ALIAS+1, sn ) ) ) {
 		LEVEL_DEBUG("Found alias %s for "SNformat"\n",alias_name,SNvar(sn));
-		owfree( alias_name ) ;
-		return zoe;
+		return OWQ_format_output_offset_and_size_z(alias_name, owq);
 	}
 
-	LEVEL_DEBUG("Didn't find alias %s for "SNformat"\n",alias_name,SNvar(sn));
+	LEVEL_DEBUG("Didn't find alias for "SNformat"\n",SNvar(sn));
 	return OWQ_format_output_offset_and_size_z("", owq);
 }
 
@@ -65,7 +65,7 @@ static void HA5_setroutines(struct connection_in *in)
 	in->iroutines.reconnect = HA5_reconnect;
 	in->iroutines.close = HA5_close;
 	in->iroutines.flags = ADAP_FLAG_dirgulp | ADAP_FLAG_bundle | ADAP_FLAG_dir_auto_reset | ADAP_FLAG_no2404delay | ADAP_FLAG_presence_from_dirblob ;
-	in->bundling_length = HA5_FIFO_SIZE;
+	in->iroutines.bundling_length = HA5_FIFO_SIZE;
 }
 
 GOOD_OR_BAD HA5_detect(struct port_in *pin)
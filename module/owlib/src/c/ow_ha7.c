@@ -17,6 +17,10 @@ $Id$
 #include "ow_codes.h"
 
 #if OW_HA7
+
+// HA7 only allows WriteBlock of 32 bytes
+#define HA7_CONSERVATIVE_LENGTH 32
+
 struct toHA7 {
 	ASCII *command;
 	ASCII lock[10];
@@ -27,11 +31,15 @@ struct toHA7 {
 };
 
 //static void byteprint( const BYTE * b, int size ) ;
-static GOOD_OR_BAD HA7_write(const ASCII * msg, size_t size, struct connection_in *in);
 static void toHA7init(struct toHA7 *ha7);
 static void setHA7address(struct toHA7 *ha7, const BYTE * sn);
-static GOOD_OR_BAD HA7_toHA7( const struct toHA7 *ha7, struct connection_in *in);
-static GOOD_OR_BAD HA7_read( struct memblob *mb, struct connection_in * in );
+static GOOD_OR_BAD HA7_transaction( const struct toHA7 *ha7, ASCII ** body, struct connection_in *in);
+static GOOD_OR_BAD HA7_toHA7( const struct toHA7 *ha7, int reuse, struct connection_in *in);
+static GOOD_OR_BAD HA7_add_parameter( ASCII * request, size_t * length, int * first, const ASCII * name, const ASCII * value, size_t value_length );
+static GOOD_OR_BAD HA7_read( ASCII ** body, struct connection_in * in );
+static SIZE_OR_ERROR HA7_read_some( ASCII * buffer, size_t length, struct connection_in * in );
+static GOOD_OR_BAD HA7_response_room( size_t size, struct connection_in * in );
+static void HA7_parse_header( const ASCII * header, int * keepalive, size_t * content_length );
 static RESET_TYPE HA7_reset(const struct parsedname *pn);
 static enum search_status HA7_next_both(struct device_search *ds, const struct parsedname *pn);
 static GOOD_OR_BAD HA7_sendback_data(const BYTE * data, BYTE * resp, const size_t len, const struct parsedname *pn);
@@ -53,11 +61,10 @@ static void HA7_setroutines(struct connection_in *in)
 	in->iroutines.sendback_data = HA7_sendback_data;
 	in->iroutines.sendback_bits = NO_SENDBACKBITS_ROUTINE;
 	in->iroutines.select = HA7_select;
-	in->iroutines.select_and_sendback = NO_SELECTANDSENDBACK_ROUTINE;
 	in->iroutines.reconnect = NO_RECONNECT_ROUTINE;
 	in->iroutines.close = HA7_close;
 	in->iroutines.flags = ADAP_FLAG_dirgulp | ADAP_FLAG_bundle | ADAP_FLAG_dir_auto_reset | ADAP_FLAG_no2404delay ;
-	in->bundling_length = HA7_FIFO_SIZE;	// arbitrary number
+	in->iroutines.bundling_length = HA7_FIFO_SIZE;	// arbitrary number
 }
 
 GOOD_OR_BAD HA7_detect(struct port_in *pin)
@@ -73,6 +80,9 @@ GOOD_OR_BAD HA7_detect(struct port_in *pin)
 	HA7_setroutines(in);
 
 	in->master.ha7.locked = 0;
+	in->master.ha7.keepalive = 0;
+	in->master.ha7.response = NULL;
+	in->master.ha7.response_size = 0;
 
 	if (pin->init_data == NULL) {
 		return gbBAD;
@@ -87,15 +97,11 @@ GOOD_OR_BAD HA7_detect(struct port_in *pin)
 
 	toHA7init(&ha7);
 	ha7.command = "ReleaseLock";
-	if (GOOD( HA7_toHA7( &ha7, in)) ) {
-		struct memblob mb;
-		if ( GOOD( HA7_read( &mb, in )) ) {
-			in->adapter_name = "HA7Net";
-			pin->busmode = bus_ha7net;
-			in->AnyDevices = anydevices_yes;
-			MemblobClear(&mb);
-			return gbGOOD;
-		}
+	if ( GOOD( HA7_transaction( &ha7, NULL, in)) ) {
+		in->adapter_name = "HA7Net";
+		pin->busmode = bus_ha7net;
+		in->AnyDevices = anydevices_yes;
+		return gbGOOD;
 	}
 	COM_close(in) ;
 	return gbBAD;
@@ -103,29 +109,23 @@ GOOD_OR_BAD HA7_detect(struct port_in *pin)
 
 static RESET_TYPE HA7_reset(const struct parsedname *pn)
 {
-	struct memblob mb;
-	RESET_TYPE ret = BUS_RESET_OK;
 	struct toHA7 ha7;
 	struct connection_in * in = pn->selected_connection ;
 
 	toHA7init(&ha7);
 	ha7.command = "Reset";
-	if ( BAD(HA7_toHA7( &ha7, in)) ) {
-		LEVEL_DEBUG("Trouble sending reset command");
-		ret = BUS_RESET_ERROR;
-	} else if ( BAD(HA7_read( &mb, in )) ) {
-		LEVEL_DEBUG("Trouble with reset command response");
-		ret = BUS_RESET_ERROR;
-	}
-	MemblobClear(&mb);
-	return ret;
+	if ( BAD(HA7_transaction( &ha7, NULL, in)) ) {
+		LEVEL_DEBUG("Trouble with reset command");
+		return BUS_RESET_ERROR;
+	}
+	return BUS_RESET_OK;
 }
 
 static GOOD_OR_BAD HA7_directory( struct device_search *ds, const struct parsedname *pn)
 {
 	GOOD_OR_BAD ret = gbGOOD;
 	struct toHA7 ha7;
-	struct memblob mb;
+	ASCII *p;
 	struct connection_in * in = pn->selected_connection ;
 
 	DirblobClear(&(ds->gulp));
@@ -136,14 +136,11 @@ static GOOD_OR_BAD HA7_directory( struct device_search *ds, const struct parsedn
 		ha7.conditional[0] = '1';
 	}
 
-	if ( BAD(HA7_toHA7( &ha7, in)) ) {
-		ret = gbBAD;
-	} else if ( BAD(HA7_read( &mb, in )) ) {
+	if ( BAD(HA7_transaction( &ha7, &p, in)) ) {
 		STAT_ADD1_BUS(e_bus_read_errors, in);
 		ret = gbBAD;
 	} else {
 		BYTE sn[SERIAL_NUMBER_SIZE];
-		ASCII *p = (ASCII *) MemblobData(&mb);
 		while ((p = strstr(p, "<INPUT CLASS=\"HA7Value\" NAME=\"Address_"))
 			   && (p = strstr(p, "VALUE=\""))) {
 			p += 7;
@@ -165,7 +162,6 @@ static GOOD_OR_BAD HA7_directory( struct device_search *ds, const struct parsedn
 			}
 			DirblobAdd(sn, &(ds->gulp));
 		}
-		MemblobClear(&mb);
 	}
 	return ret;
 }
@@ -193,82 +189,244 @@ static enum search_status HA7_next_both(struct device_search *ds, const struct p
 	}
 }
 
-#define HA7_READ_BUFFER_LENGTH 2000
+/* HA7Net HTTP transport
+ * Requests are HTTP/1.1 GETs asking to keep the connection open.
+ * If the HA7 answers with a Content-Length and doesn't close, the socket is reused
+ * for the next request instead of a new TCP connection per reset, select or block.
+ * Otherwise (HTTP/1.0 style) the response runs to end-of-file and the socket is closed.
+ * The response is read into a buffer kept with the connection and parsed in place.
+ */
+
+#define HA7_READ_CHUNK 512
+#define HA7_HEADER_MAX 4000
+#define HA7_REQUEST_LENGTH 512
+
+/* Send a command and get the <body> of the response (body may be NULL if not needed) */
+/* body points into the connection's response buffer, valid until the next transaction */
+static GOOD_OR_BAD HA7_transaction( const struct toHA7 *ha7, ASCII ** body, struct connection_in *in)
+{
+	ASCII * response_body ;
+	int reuse = in->master.ha7.keepalive && FILE_DESCRIPTOR_VALID( in->pown->file_descriptor ) ;
+
+	if ( BAD( HA7_toHA7( ha7, reuse, in ) ) || BAD( HA7_read( &response_body, in ) ) ) {
+		if ( ! reuse ) {
+			return gbBAD ;
+		}
+		// The HA7 may have dropped an idle kept-alive connection -- once more on a fresh one
+		LEVEL_DEBUG("Kept-alive HA7 connection failed, retry on a new connection");
+		in->master.ha7.keepalive = 0 ;
+		COM_close(in) ;
+		RETURN_BAD_IF_BAD( HA7_toHA7( ha7, 0, in ) ) ;
+		RETURN_BAD_IF_BAD( HA7_read( &response_body, in ) ) ;
+	}
+	if ( body != NULL ) {
+		body[0] = response_body ;
+	}
+	return gbGOOD ;
+}
 
-static GOOD_OR_BAD HA7_read( struct memblob *mb, struct connection_in * in )
+/* Read the response, header and body, into the connection's response buffer */
+static GOOD_OR_BAD HA7_read( ASCII ** body, struct connection_in * in )
 {
 	struct port_in * pin = in->pown ;
-	
-	ASCII readin_area[HA7_READ_BUFFER_LENGTH + 1];
-	ASCII *start;
-	size_t read_size;
+	struct master_ha7 * master = &(in->master.ha7) ;
+	ASCII * header_end = NULL ;
+	size_t used = 0 ;
+	size_t content_length = 0 ;
+	int keepalive ;
 
-	MemblobInit(mb, HA7_READ_BUFFER_LENGTH);
 	pin->timeout.tv_sec = 2 ;
 	pin->timeout.tv_usec = 0 ;
 
-	// Read first block of data from HA7
-	read_size = COM_read_with_timeout( (BYTE*) readin_area, HA7_READ_BUFFER_LENGTH, in) ;
-	if ( read_size <= 0 ) {
-		LEVEL_CONNECT("Read error");
-		return gbBAD;
+	// Header -- read whatever arrives until the blank line
+	while ( header_end == NULL ) {
+		SIZE_OR_ERROR read_size ;
+		if ( used > HA7_HEADER_MAX || BAD( HA7_response_room( used + HA7_READ_CHUNK, in ) ) ) {
+			LEVEL_DATA("HA7 response header too long");
+			COM_close(in) ;
+			return gbBAD ;
+		}
+		read_size = HA7_read_some( &(master->response[used]), HA7_READ_CHUNK, in ) ;
+		if ( read_size <= 0 ) {
+			LEVEL_CONNECT("Read error");
+			COM_close(in) ;
+			return gbBAD ;
+		}
+		used += read_size ;
+		master->response[used] = '\0' ;
+		if ( (header_end = strstr( master->response, "\r\n\r\n" )) != NULL ) {
+			header_end += 4 ;
+		} else if ( (header_end = strstr( master->response, "\n\n" )) != NULL ) {
+			header_end += 2 ;
+		}
 	}
-	// make sure null terminated (allocated extra byte in readin_area to always have room)
-	readin_area[read_size] = '\0';
 
 	// Look for happy response
-	if (strncmp("HTTP/1.1 200 OK", readin_area, 15)) {	//Bad HTTP return code
-		ASCII *p = strchr(&readin_area[15], '\n');
-		if (p == NULL) {
-			p = &readin_area[15 + 32];
-		}
-		LEVEL_DATA("response problem:%.*s", p - readin_area - 15, &readin_area[15]);
+	if ( strncmp( "HTTP/1.", master->response, 7 ) != 0 || strncmp( " 200", &(master->response[8]), 4 ) != 0 ) {
+		ASCII *p = strchr( master->response, '\n' ) ;
+		LEVEL_DATA("response problem:%.*s", p ? (int) (p - master->response) : 32, master->response);
+		COM_close(in) ;
 		return gbBAD;
 	}
+	keepalive = ( master->response[7] == '1' ) ;	// HTTP/1.1 persists unless told otherwise
+	HA7_parse_header( master->response, &keepalive, &content_length ) ;
+
+	if ( keepalive && content_length > 0 ) {
+		// Body -- exactly content_length bytes, the socket stays open
+		size_t total = (header_end - master->response) + content_length ;
+
+		if ( used < total ) {
+			SIZE_OR_ERROR read_size ;
+			size_t header_offset = header_end - master->response ;
+
+			if ( BAD( HA7_response_room( total, in ) ) ) {
+				COM_close(in) ;
+				return gbBAD ;
+			}
+			header_end = &(master->response[header_offset]) ;	// buffer may have moved
+			read_size = COM_read_with_timeout( (BYTE *) &(master->response[used]), total - used, in ) ;
+			if ( read_size != (SIZE_OR_ERROR) (total - used) ) {
+				LEVEL_DATA("Couldn't get rest of HA7 data (%d of %d bytes)", (int) read_size, (int) (total - used));
+				COM_close(in) ;
+				return gbBAD;
+			}
+		}
+		used = total ;
+	} else {
+		// Body -- until the HA7 closes the connection
+		SIZE_OR_ERROR read_size ;
+		size_t header_offset = header_end - master->response ;
+
+		keepalive = 0 ;
+		do {
+			if ( BAD( HA7_response_room( used + HA7_READ_CHUNK, in ) ) ) {
+				COM_close(in) ;
+				return gbBAD ;
+			}
+			read_size = HA7_read_some( &(master->response[used]), HA7_READ_CHUNK, in ) ;
+			if ( read_size < 0 ) {
+				// timeout or error before end-of-file -- the body may be cut short
+				LEVEL_CONNECT("Read error before end of HA7 response");
+				COM_close(in) ;
+				return gbBAD ;
+			}
+			used += read_size ;
+		} while ( read_size > 0 ) ;
+		header_end = &(master->response[header_offset]) ;
+		COM_close(in) ;
+	}
+	master->response[used] = '\0' ;
+	master->keepalive = keepalive ;
+
 	// Look for "<body>"
-	if ((start = strstr(readin_area, "<body>")) == NULL) {
+	if ( (body[0] = strstr( header_end, "<body>" )) == NULL ) {
 		LEVEL_DATA("response: No HTTP body to parse");
-		MemblobClear(mb);
 		return gbBAD;
 	}
-	// HTML body found, dump header
-	if (MemblobAdd((BYTE *) start, read_size - (start - readin_area), mb)) {
-		MemblobClear(mb);
-		return gbBAD;
+	LEVEL_DEBUG("Successful read of data (%d bytes, %s)", (int) used, keepalive ? "keep-alive" : "closed");
+	return gbGOOD;
+}
+
+/* Connection and Content-Length headers */
+static void HA7_parse_header( const ASCII * header, int * keepalive, size_t * content_length )
+{
+	const ASCII * line = strchr( header, '\n' ) ;
+
+	while ( line != NULL && line[1] != '\r' && line[1] != '\n' && line[1] != '\0' ) {
+		++line ;
+		if ( strncasecmp( line, "Content-Length:", 15 ) == 0 ) {
+			content_length[0] = strtoul( &line[15], NULL, 10 ) ;
+		} else if ( strncasecmp( line, "Connection:", 11 ) == 0 ) {
+			const ASCII * value = &line[11] ;
+			while ( *value == ' ' ) {
+				++value ;
+			}
+			if ( strncasecmp( value, "close", 5 ) == 0 ) {
+				keepalive[0] = 0 ;
+			} else if ( strncasecmp( value, "keep-alive", 10 ) == 0 ) {
+				keepalive[0] = 1 ;
+			}
+		}
+		line = strchr( line, '\n' ) ;
+	}
+}
+
+/* Whatever has arrived, waiting up to the timeout for at least 1 byte */
+/* returns bytes read, 0 for end-of-file */
+static SIZE_OR_ERROR HA7_read_some( ASCII * buffer, size_t length, struct connection_in * in )
+{
+	struct port_in * pin = in->pown ;
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor = pin->file_descriptor ;
+
+	if ( FILE_DESCRIPTOR_NOT_VALID( file_descriptor ) ) {
+		return -EBADF ;
 	}
-	// loop through reading in HA7_READ_BUFFER_LENGTH blocks
-	while (read_size == HA7_READ_BUFFER_LENGTH) {	// full read, so presume more waiting
-		read_size = COM_read_with_timeout( (BYTE*) readin_area, HA7_READ_BUFFER_LENGTH, in) ;
-		if (read_size <= 0) {
-			LEVEL_DATA("Couldn't get rest of HA7 data (err=%d)", read_size);
-			MemblobClear(mb);
-			return gbBAD;
-		} else if (MemblobAdd((BYTE *) readin_area, read_size, mb)) {
-			MemblobClear(mb);
-			return gbBAD;
+
+	while (1) {
+		ssize_t read_result ;
+
+		if ( BAD( tcp_wait( file_descriptor, &(pin->timeout) ) ) ) {
+			LEVEL_CONNECT("HA7 read timeout");
+			return -EAGAIN ;
+		}
+		read_result = read( file_descriptor, buffer, length ) ;
+		if ( read_result < 0 ) {
+			if ( errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK ) {
+				continue ;
+			}
+			STAT_ADD1(NET_read_errors);
+			return -EIO ;
 		}
+		TrafficInFD("NETREAD", (BYTE *) buffer, read_result, file_descriptor ) ;
+		return read_result ;
 	}
+}
 
-	// Add trailing null
-	if (MemblobAdd((BYTE *) "", 1, mb)) {
-		MemblobClear(mb);
-		return gbBAD;
+/* Grow the response buffer to hold size bytes plus a trailing null */
+static GOOD_OR_BAD HA7_response_room( size_t size, struct connection_in * in )
+{
+	struct master_ha7 * master = &(in->master.ha7) ;
+	ASCII * new_response ;
+
+	if ( size < master->response_size ) {
+		return gbGOOD ;
 	}
-	LEVEL_DEBUG("Successful read of data");
-	//printf("READ FROM HA7:\n%s\n",MemblobData(mb));
-	return gbGOOD;
+	new_response = owrealloc( master->response, size + HA7_READ_CHUNK ) ;
+	if ( new_response == NULL ) {
+		return gbBAD ;
+	}
+	master->response = new_response ;
+	master->response_size = size + HA7_READ_CHUNK ;
+	return gbGOOD ;
 }
 
-static GOOD_OR_BAD HA7_write( const ASCII * msg, size_t length, struct connection_in *in )
+/* Append ?name=value or &name=value */
+static GOOD_OR_BAD HA7_add_parameter( ASCII * request, size_t * length, int * first, const ASCII * name, const ASCII * value, size_t value_length )
 {
-	return COM_write( (const BYTE *) msg, length, in) ;
+	size_t name_length = strlen(name) ;
+
+	if ( length[0] + 1 + name_length + 1 + value_length >= HA7_REQUEST_LENGTH ) {
+		return gbBAD ;
+	}
+	request[length[0]++] = first[0] ? '?' : '&' ;
+	memcpy( &request[length[0]], name, name_length ) ;
+	length[0] += name_length ;
+	request[length[0]++] = '=' ;
+	memcpy( &request[length[0]], value, value_length ) ;
+	length[0] += value_length ;
+	first[0] = 0 ;
+	return gbGOOD ;
 }
 
-static GOOD_OR_BAD HA7_toHA7( const struct toHA7 *ha7, struct connection_in *in)
+/* Build the request in place and send it, on the open socket if reuse is set */
+static GOOD_OR_BAD HA7_toHA7( const struct toHA7 *ha7, int reuse, struct connection_in *in)
 {
+	ASCII request[HA7_REQUEST_LENGTH];
+	ASCII hex_data[2 * HA7_CONSERVATIVE_LENGTH];
+	size_t length ;
+	int trailer ;
 	int first = 1;
-	int probable_length;
-	char *full_command;
+
 	LEVEL_DEBUG
 		("To HA7 command=%s address=%.16s conditional=%.1s lock=%.10s",
 		 SAFESTRING(ha7->command), SAFESTRING(ha7->address), SAFESTRING(ha7->conditional), SAFESTRING(ha7->lock));
@@ -277,81 +435,68 @@ static GOOD_OR_BAD HA7_toHA7( const struct toHA7 *ha7, struct connection_in *in)
 		return gbBAD;
 	}
 
-	probable_length = 11 + strlen(ha7->command) + 5 + ((ha7->address[0]) ? 1 + 8 + 16 : 0)
-		+ ((ha7->conditional[0]) ? 1 + 12 + 1 : 0)
-		+ ((ha7->data) ? 1 + 5 + ha7->length * 2 : 0)
-		+ ((ha7->lock[0]) ? 1 + 7 + 10 : 0)
-		+ 11 + 1;
-
-	full_command = owmalloc(probable_length);
-	if (full_command == NULL) {
-		return gbBAD;
+	length = snprintf( request, HA7_REQUEST_LENGTH, "GET /1Wire/%s.html", ha7->command ) ;
+	if ( length >= HA7_REQUEST_LENGTH ) {
+		return gbBAD ;
 	}
-	memset(full_command, 0, probable_length);
-
-	strcpy(full_command, "GET /1Wire/");
-	strcat(full_command, ha7->command);
-	strcat(full_command, ".html");
 
 	if (ha7->address[0]) {
-		strcat(full_command, first ? "?" : "&");
-		strcat(full_command, "Address=");
-		strcat(full_command, ha7->address);
-		first = 0;
+		RETURN_BAD_IF_BAD( HA7_add_parameter( request, &length, &first, "Address", ha7->address, 16 ) ) ;
 	}
 
 	if (ha7->conditional[0]) {
-		strcat(full_command, first ? "?" : "&");
-		strcat(full_command, "Conditional=");
-		strcat(full_command, ha7->conditional);
-		first = 0;
+		RETURN_BAD_IF_BAD( HA7_add_parameter( request, &length, &first, "Conditional", ha7->conditional, 1 ) ) ;
 	}
 
 	if (ha7->data) {
-		strcat(full_command, first ? "?" : "&");
-		strcat(full_command, "Data=");
-		bytes2string(&full_command[strlen(full_command)], ha7->data, ha7->length);
+		if ( ha7->length > HA7_CONSERVATIVE_LENGTH ) {
+			return gbBAD ;
+		}
+		bytes2string( hex_data, ha7->data, ha7->length ) ;
+		RETURN_BAD_IF_BAD( HA7_add_parameter( request, &length, &first, "Data", hex_data, 2 * ha7->length ) ) ;
 	}
 
 	if (ha7->lock[0]) {
-		strcat(full_command, first ? "?" : "&");
-		strcat(full_command, "LockID=");
-		strcat(full_command, ha7->lock);
-		first = 0;
+		RETURN_BAD_IF_BAD( HA7_add_parameter( request, &length, &first, "LockID", ha7->lock, 10 ) ) ;
 	}
 
-	strcat(full_command, " HTTP/1.0\n\n");
-
-	LEVEL_DEBUG("To HA7 %s", full_command);
-
-	if ( BAD( COM_open(in) ) ) {
-		// force reopen
-		owfree(full_command);
+	trailer = snprintf( &request[length], HA7_REQUEST_LENGTH - length, " HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n", SAFESTRING(DEVICENAME(in)) ) ;
+	if ( trailer < 0 || length + trailer >= HA7_REQUEST_LENGTH ) {
 		return gbBAD ;
 	}
+	length += trailer ;
 
-	if ( BAD( HA7_write( full_command, probable_length, in) ) ) {
-		owfree(full_command);
-		return gbBAD ;
+	LEVEL_DEBUG("To HA7 %.*s", (int) length, request);
+
+	if ( ! reuse ) {
+		// new connection for this request
+		RETURN_BAD_IF_BAD( COM_open(in) ) ;
 	}
-		
-	owfree(full_command);
-	return gbGOOD;
+
+	return COM_write( (const BYTE *) request, length, in) ;
 }
 
 // Reset, select, and read/write data
 /* return 0=good
    sendout_data, readin
  */
+/* The first block carries the address -- WriteBlock selects the device itself,
+   so select and data go in one request */
 static GOOD_OR_BAD HA7_select_and_sendback(const BYTE * data, BYTE * resp, const size_t size, const struct parsedname *pn)
 {
 	size_t location = 0;
 	int also_address = 1;
 
+	if ( pn->selected_device == NO_DEVICE ) {
+		// no address to bundle
+		RETURN_BAD_IF_BAD( HA7_select(pn) ) ;
+		return HA7_sendback_data( data, resp, size, pn ) ;
+	}
+
 	while (location < size) {
 		size_t block = size - location;
-		if (block > 32) {
-			block = 32;
+		if (block > HA7_CONSERVATIVE_LENGTH) {
+			block = HA7_CONSERVATIVE_LENGTH;
 		}
 		// Don't add address (that's the "0")
 		RETURN_BAD_IF_BAD(HA7_sendback_block(&data[location], &resp[location], block, also_address, pn)) ;
@@ -365,7 +510,6 @@ static GOOD_OR_BAD HA7_select_and_sendback(const BYTE * data, BYTE * resp, const
 /* return 0=good
    sendout_data, readin
  */
-#define HA7_CONSERVATIVE_LENGTH 32
 static GOOD_OR_BAD HA7_sendback_data(const BYTE * data, BYTE * resp, const size_t size, const struct parsedname *pn)
 {
 	size_t location = 0;
@@ -382,13 +526,11 @@ static GOOD_OR_BAD HA7_sendback_data(const BYTE * data, BYTE * resp, const size_
 	return gbGOOD;
 }
 
-// HA7 only allows WriteBlock of 32 bytes
 // This routine assumes that larger writes have already been broken up
 static GOOD_OR_BAD HA7_sendback_block(const BYTE * data, BYTE * resp, const size_t size, int also_address, const struct parsedname *pn)
 {
-	struct memblob mb;
 	struct toHA7 ha7;
-	GOOD_OR_BAD ret = gbBAD;
+	ASCII *p;
 	struct connection_in * in =  pn->selected_connection ;
 
 	toHA7init(&ha7);
@@ -399,25 +541,20 @@ static GOOD_OR_BAD HA7_sendback_block(const BYTE * data, BYTE * resp, const size
 		setHA7address(&ha7, pn->sn);
 	}
 
-	if ( GOOD( HA7_toHA7( &ha7, in)) ) {
-		if ( GOOD( HA7_read( &mb, in )) ) {
-			ASCII *p = (ASCII *) MemblobData(&mb);
-			if ((p = strstr(p, "<INPUT TYPE=\"TEXT\" NAME=\"ResultData_0\""))
-				&& (p = strstr(p, "VALUE=\""))) {
-				p += 7;
-				LEVEL_DEBUG("HA7_sendback_data received(%d): %.*s", size * 2, size * 2, p);
-				if (strspn(p, "0123456789ABCDEF") >= size << 1) {
-					string2bytes(p, resp, size);
-					ret = gbGOOD;
-				}
-			}
-			MemblobClear(&mb);
-		} else {
-			STAT_ADD1_BUS(e_bus_read_errors, in);
+	if ( BAD( HA7_transaction( &ha7, &p, in)) ) {
+		STAT_ADD1_BUS(e_bus_read_errors, in);
+		return gbBAD ;
+	}
+	if ((p = strstr(p, "<INPUT TYPE=\"TEXT\" NAME=\"ResultData_0\""))
+		&& (p = strstr(p, "VALUE=\""))) {
+		p += 7;
+		LEVEL_DEBUG("HA7_sendback_data received(%d): %.*s", size * 2, size * 2, p);
+		if (strspn(p, "0123456789ABCDEF") >= size << 1) {
+			string2bytes(p, resp, size);
+			return gbGOOD;
 		}
-		return ret ;
 	}
-	return gbGOOD;
+	return gbBAD ;
 }
 
 static void setHA7address(struct toHA7 *ha7, const BYTE * sn)
@@ -434,7 +571,6 @@ static void setHA7address(struct toHA7 *ha7, const BYTE * sn)
 
 static GOOD_OR_BAD HA7_select(const struct parsedname *pn)
 {
-	GOOD_OR_BAD ret = gbBAD;
 	struct connection_in * in =  pn->selected_connection ;
 
 	if (pn->selected_device) {
@@ -442,23 +578,20 @@ static GOOD_OR_BAD HA7_select(const struct parsedname *pn)
 		toHA7init(&ha7);
 		ha7.command = "AddressDevice";
 		setHA7address(&ha7, pn->sn);
-		if ( GOOD( HA7_toHA7( &ha7, in)) ) {
-			struct memblob mb;
-			if ( GOOD( HA7_read( &mb, in )) ) {
-				MemblobClear(&mb);
-				ret = gbGOOD;
-			}
-		}
-	} else {
-		return HA7_reset(pn)==BUS_RESET_OK ? gbGOOD : gbBAD ;
+		return HA7_transaction( &ha7, NULL, in) ;
 	}
-	return ret;
+	return HA7_reset(pn)==BUS_RESET_OK ? gbGOOD : gbBAD ;
 }
 
 static void HA7_close(struct connection_in *in)
 {
 	// that standard COM_free cleans up the connection
-	(void) in ;
+	if ( in->master.ha7.response != NULL ) {
+		owfree( in->master.ha7.response ) ;
+		in->master.ha7.response = NULL ;
+	}
+	in->master.ha7.response_size = 0 ;
+	in->master.ha7.keepalive = 0 ;
 }
 
 static void toHA7init(struct toHA7 *ha7)
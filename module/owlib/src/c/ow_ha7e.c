@@ -42,7 +42,7 @@ static void HA7E_setroutines(struct connection_in *in)
 	in->iroutines.reconnect = NO_RECONNECT_ROUTINE;
 	in->iroutines.close = HA7E_close;
 	in->iroutines.flags = ADAP_FLAG_dirgulp | ADAP_FLAG_bundle | ADAP_FLAG_dir_auto_reset | ADAP_FLAG_no2404delay ;
-	in->bundling_length = HA7E_FIFO_SIZE;
+	in->iroutines.bundling_length = HA7E_FIFO_SIZE;
 }
 
 GOOD_OR_BAD HA7E_detect(struct port_in *pin)
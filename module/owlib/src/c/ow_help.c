@@ -71,6 +71,8 @@ void ow_help_job(void)
 	" Alias\n"
 	"  -a --alias filename\n"
 	"                   file containing device to friendly_name pairs\n"
+	"                   reread on SIGHUP (owserver, owhttpd, owftpd -- not owfs,\n"
+	"                   where SIGHUP unmounts) or a write to /settings/alias/reload\n"
 	"  --unaliased      No substitution of alias names in return data\n"
 	"  --aliased        Substitute alias names in return (Default action)\n"
 	"\n"
@@ -116,6 +118,11 @@ void ow_help_cache(void)
 	"  --timeout_stable    [%3d] Expiration time for stable data (e.g. temperature limit)\n"
 	"  --timeout_directory [%3d] Expiration of directory lists\n"
 	"  --timeout_presence  [%3d] Expiration of known 1-wire device location\n"
+	"  --stale_volatile    [%3d] Serve expired changing data this much longer, refreshing in the background\n"
+	"  --stale_stable      [%3d] Same for stable data\n"
+	"\n"
+	" Background polling (keeps cached values fresh, may be repeated)\n"
+	"  --poll family[/property,...][:seconds][@bus]  e.g. --poll=28/temperature\n"
 	" \n"
 	" Communication timing [default] (in seconds)\n"
 	"  --timeout_serial    [%3d] Timeout for serial port\n"
@@ -125,10 +132,15 @@ void ow_help_cache(void)
 	"  --timeout_ftp       [%3d] Timeout for FTP session\n"
 	"  --timeout_ha7       [%3d] Timeout for HA7Net bus master\n"
 	"  --timeout_w1        [%3d] Timeout for w1 kernel netlink\n"
+	"  --timeout_pool      [%3d] Idle time before a pooled owserver connection is closed\n"
+	"  --timeout_pool_check[%3d] Idle time before a pooled connection is checked before use\n"
+	"  --connections_pool  [%3d] Idle connections kept for each remote owserver\n"
 	, Globals.timeout_volatile
 	, Globals.timeout_stable
 	, Globals.timeout_directory
 	, Globals.timeout_presence
+	, Globals.stale_volatile
+	, Globals.stale_stable
 	, Globals.timeout_serial
 	, Globals.timeout_usb
 	, Globals.timeout_network
@@ -136,6 +148,9 @@ void ow_help_cache(void)
 	, Globals.timeout_ftp
 	, Globals.timeout_ha7
 	, Globals.timeout_w1
+	, Globals.timeout_pool
+	, Globals.timeout_pool_check
+	, Globals.connections_pool
 		   );
 }
 
@@ -171,8 +186,9 @@ void ow_help_program(void)
 	" Development tests (owserver only)\n"
 	"  --pingcrazy      Add lots of keep-alive messages to the owserver protocol\n"
 	"  --no_dirall      DIRALL fails, drops back to older DIR (individual entries)\n"
-	"  --no_get         GET fails, drops back to DIRALL and READ\n"
+	"  --no_get         GET and MULTIGET fail, drops back to DIRALL and READ\n"
 	"  --no_persistence persistent connections refused, drops back to non-persistent\n"
+	"  --no_pipeline    pipelined protocol refused, drops back to protocol 0\n"
 	"\n"
 	" owftpd (ftp server)\n"
 	"  -p --port [ip:]port   TCP address and port number for access\n"
@@ -220,6 +236,7 @@ void ow_help_device(void)
 	"  -d /dev/ttyUSB0 ECLO USB bus master\n"
 	"  --altUSB        Change some settings for DS9490 bus master (especially for AAG and DS2423)\n"
 	"  --usb_flextime | --usb_regulartime     Needed for Louis Swart's LCD module\n"
+	"  --usb_pipeline  Overlap DS9490 block transfers (experimental)\n"
 	"\n"
 	" Network (address is form [ip:]port, ip DNS name or n.n.n.n, port is port number)\n"
 	"  -s address      owserver\n"
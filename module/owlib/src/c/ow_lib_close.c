@@ -14,12 +14,17 @@ $Id$
 #include "ow.h"
 #include "ow_devices.h"
 #include "ow_pid.h"
+#include "ow_external.h"
 
 /* All ow library closeup */
 void LibClose(void)
 {
 	LEVEL_CALL("Starting Library cleanup");
+	PollerStop();
+	RefreshStop();
 	LibStop();
+	Coprocess_close_all();
+	AliasClose();
 	PIDstop();
 	DeviceDestroy();
 
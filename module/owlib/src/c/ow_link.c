@@ -109,14 +109,14 @@ static void LINK_setroutines(struct connection_in *in)
 	in->iroutines.select_and_sendback = NO_SELECTANDSENDBACK_ROUTINE;
 	in->iroutines.reconnect = NO_RECONNECT_ROUTINE;
 	in->iroutines.close = LINK_close;
-	in->iroutines.flags = ADAP_FLAG_no2409path | ADAP_FLAG_no2404delay ;
-	in->bundling_length = LINK_FIFO_SIZE;
+	in->iroutines.flags = ADAP_FLAG_no2409path | ADAP_FLAG_no2404delay | ADAP_FLAG_bundle ;
+	in->iroutines.bundling_length = LINK_FIFO_SIZE;
 }
 
 static void LINKE_setroutines(struct connection_in *in)
 {
 	LINK_setroutines(in) ;
-	in->bundling_length = LINKE_FIFO_SIZE;
+	in->iroutines.bundling_length = LINKE_FIFO_SIZE;
 }
 
 #define LINK_string(x)  ((BYTE *)(x))
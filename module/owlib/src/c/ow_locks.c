@@ -36,6 +36,8 @@ struct mutexes Mutex ;
 void LockSetup(void)
 {
 #if OW_MT
+	int shard ;
+
 	/* global mutex attribute */
 	_MUTEX_ATTR_INIT(Mutex.mattr);
   #ifdef __UCLIBC__
@@ -68,10 +70,18 @@ void LockSetup(void)
 	_MUTEX_INIT(Mutex.namefind_mutex);
 	_MUTEX_INIT(Mutex.aliasfind_mutex);
 	_MUTEX_INIT(Mutex.externalcount_mutex);
+	_MUTEX_INIT(Mutex.busworker_mutex);
+	_MUTEX_INIT(Mutex.coprocess_mutex);
+	_MUTEX_INIT(Mutex.refresh_mutex);
+	_MUTEX_INIT(Mutex.aliastable_mutex);
 
 	RWLOCK_INIT(Mutex.lib);
-	RWLOCK_INIT(Mutex.cache);
-	RWLOCK_INIT(Mutex.persistent_cache);
+	RWLOCK_INIT_WRITER(Mutex.cache);
+	for ( shard = 0 ; shard < CACHE_SHARDS ; ++shard ) {
+		RWLOCK_INIT_WRITER(Mutex.cache_shard[shard]);
+	}
+	RWLOCK_INIT_WRITER(Mutex.persistent_cache);
+	RWLOCK_INIT_WRITER(Mutex.parse_cache);
 	RWLOCK_INIT(Inbound_Control.lock);
 	RWLOCK_INIT(Inbound_Control.monitor_lock);
   #if OW_USB
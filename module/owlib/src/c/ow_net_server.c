@@ -34,8 +34,6 @@ static GOOD_OR_BAD ServerAddr(const char * default_port, struct connection_out *
 static FILE_DESCRIPTOR_OR_ERROR ServerListen(struct connection_out *out);
 
 static FILE_DESCRIPTOR_OR_ERROR SetupListenSet( fd_set * listenset ) ;
-static GOOD_OR_BAD SetupListenSockets( void (*HandlerRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descriptor) ) ;
-static void CloseListenSockets( void ) ;
 static void ProcessListenSocket( struct connection_out * out ) ;
 static void *ProcessAcceptSocket(void *arg) ;
 static void ProcessListenSet( fd_set * listenset ) ;
@@ -169,7 +167,8 @@ static FILE_DESCRIPTOR_OR_ERROR SetupListenSet( fd_set * listenset )
 	return maxfd ;
 }
 
-static GOOD_OR_BAD SetupListenSockets( void (*HandlerRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descriptor) )
+/* Open (and announce) every outbound listening socket. Also used by owserver's event loop */
+GOOD_OR_BAD SetupListenSockets( void (*HandlerRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descriptor) )
 {
 	struct connection_out * out ;
 	GOOD_OR_BAD any_sockets = gbBAD ;
@@ -184,7 +183,7 @@ static GOOD_OR_BAD SetupListenSockets( void (*HandlerRoutine) (FILE_DESCRIPTOR_O
 	return any_sockets ;
 }
 
-static void CloseListenSockets( void )
+void CloseListenSockets( void )
 {
 	struct connection_out * out ;
 
@@ -191,6 +191,8 @@ const struct option owopts_long[] = {
 	{"USB_flextime", no_argument, &Globals.usb_flextime, 1},
 	{"usb_regulartime", no_argument, &Globals.usb_flextime, 0},
 	{"USB_regulartime", no_argument, &Globals.usb_flextime, 0},
+	{"usb_pipeline", no_argument, &Globals.usb_pipeline, 1},	/* overlap block transfers -- experimental */
+	{"USB_pipeline", no_argument, &Globals.usb_pipeline, 1},
 	{"usb_scan", optional_argument, NO_LINKED_VAR, e_usb_monitor,},
 	{"USB_scan", optional_argument, NO_LINKED_VAR, e_usb_monitor,},
 	{"serial_flex", no_argument, &Globals.serial_flextime, 1},
@@ -234,6 +236,12 @@ const struct option owopts_long[] = {
 	{"timeout_persistent_high", required_argument, NO_LINKED_VAR, e_timeout_persistent_high,},
 	{"clients_persistent_low", required_argument, NO_LINKED_VAR, e_clients_persistent_low,},
 	{"clients_persistent_high", required_argument, NO_LINKED_VAR, e_clients_persistent_high,},
+	{"timeout_pool", required_argument, NO_LINKED_VAR, e_timeout_pool,},	// timeout -- idle pooled owserver connection
+	{"timeout_pool_check", required_argument, NO_LINKED_VAR, e_timeout_pool_check,},	// timeout -- idle before a pooled connection is checked
+	{"connections_pool", required_argument, NO_LINKED_VAR, e_connections_pool,},
+	{"stale_volatile", required_argument, NO_LINKED_VAR, e_stale_volatile,},	// grace -- expired changing values served while refreshed
+	{"stale_stable", required_argument, NO_LINKED_VAR, e_stale_stable,},	// grace -- expired unchanging values served while refreshed
+	{"poll", required_argument, NO_LINKED_VAR, e_poll,},	// background refresh of cached values
 
 	{"temperature_low", required_argument, NO_LINKED_VAR, e_templow,},
 	{"low_temperature", required_argument, NO_LINKED_VAR, e_templow,},
@@ -253,6 +261,7 @@ const struct option owopts_long[] = {
 	{"no_dirall", no_argument, &Globals.no_dirall, 1},
 	{"no_get", no_argument, &Globals.no_get, 1},
 	{"no_persistence", no_argument, &Globals.no_persistence, 1},
+	{"no_pipeline", no_argument, &Globals.no_pipeline, 1},
 	{"8bit", no_argument, &Globals.eightbit_serial, 1},
 	{"6bit", no_argument, &Globals.eightbit_serial, 0},
 	{"ActivePullUp", no_argument, &Globals.i2c_APU, 1},
@@ -434,6 +443,12 @@ static void ParseTheLine(struct lineparse *lp)
 					lp->prog = NULL ;
 					AddSensor(current_char+1) ;
 					return ;
+				} else if (strstr(lp->prog, "coprocess") != NULL) {
+					// property line for external device, long-running program
+					LEVEL_DEBUG("COPROCESS entry found <%s>", current_char+1);
+					lp->prog = NULL ;
+					AddProperty(current_char+1,et_coprocess) ;
+					return ;
 				} else if (strstr(lp->prog, "script") != NULL) {
 					// property line for external device
 					LEVEL_DEBUG("SCRIPT entry found <%s>", current_char+1);
@@ -811,10 +826,17 @@ GOOD_OR_BAD owopt(const int option_char, const char *arg)
 	case e_timeout_persistent_high:
 	case e_clients_persistent_low:
 	case e_clients_persistent_high:
+	case e_timeout_pool:
+	case e_timeout_pool_check:
+	case e_connections_pool:
+	case e_stale_volatile:
+	case e_stale_stable:
 		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
 		// Using the character as a numeric value -- convenient but risky
 		(&Globals.timeout_volatile)[option_char - e_timeout_volatile] = (int) arg_to_integer;
 		break;
+	case e_poll:
+		return PollerAdd(arg) ;
 	case e_baud:
 		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
 		Globals.baud = COM_MakeBaud( arg_to_integer ) ;
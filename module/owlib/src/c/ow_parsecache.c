@@ -0,0 +1,186 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: palfille@earthlink.net
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Parse cache -- path string to a finished parsedname
+ * Clients ask for the same paths over and over, and each FS_ParsedName splits
+ * the path, checks serial numbers, looks up aliases and searches the property
+ * tables all over again.
+ * A fixed table of PARSECACHE_SLOTS entries, direct mapped on a hash of the path,
+ * keeps successful parses. A new path replaces whatever shared its slot,
+ * so the table never grows.
+ * Key is the path, the parse pass (local or back from a remote owserver) and the
+ * starting state (--uncached, --unaliased).
+ * ow_parsename.c decides what may be kept, and whether the device has to be
+ * found again on each hit.
+ * Any alias or bus list change flushes the whole table (ParseCache_Flush).
+ */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_counters.h"
+
+#define PARSECACHE_SLOTS	4096		// power of 2
+
+struct parse_cache_entry {
+	UINT hash ;
+	int back_from_remote ;
+	enum ePS_state start_state ;
+	int check_presence ;		// device location is looked up again on each hit
+	int device_name_offset ;	// into path, -1 for none
+	struct parsedname pn ;		// result -- path, path_to_server, sparse_name and bp are stored below
+	char * path ;
+	char * path_to_server ;
+	char * sparse_name ;
+	struct ds2409_hubs * bp ;
+} ;
+
+/* protected by PARSECACHE lock */
+static struct parse_cache_entry * parse_cache[PARSECACHE_SLOTS] ;
+static UINT parse_cache_generation = 0 ;	// bumped by each flush
+
+/* Fill pn (already set up by FS_ParsedName_setup for this path) from a previous parse */
+/* gbBAD if not cached -- generation is set for ParseCache_Add in either case */
+GOOD_OR_BAD ParseCache_Get( int back_from_remote, struct parsedname * pn, int * check_presence, UINT * generation )
+{
+	UINT hash = FNV1a_string( pn->path, 0 ) ;
+	struct parse_cache_entry * pce ;
+	char * path = pn->path ;
+	char * path_to_server = pn->path_to_server ;
+	uint32_t control_flags = pn->control_flags ;
+	struct ds2409_hubs * bp = NULL ;
+	char * sparse_name = NULL ;
+
+	PARSECACHE_RLOCK ;
+	generation[0] = parse_cache_generation ;
+	pce = parse_cache[ hash & (PARSECACHE_SLOTS - 1) ] ;
+	if ( pce == NULL || pce->hash != hash || pce->back_from_remote != back_from_remote
+		|| pce->start_state != pn->state || strcmp( pce->path, path ) != 0 ) {
+		PARSECACHE_RUNLOCK ;
+		STAT_ADD1( parse_cache_misses ) ;
+		return gbBAD ;
+	}
+
+	if ( pce->bp != NULL ) {
+		bp = owmalloc( pce->pn.ds2409_depth * sizeof(struct ds2409_hubs) ) ;
+		if ( bp == NULL ) {
+			PARSECACHE_RUNLOCK ;
+			return gbBAD ;
+		}
+		memcpy( bp, pce->bp, pce->pn.ds2409_depth * sizeof(struct ds2409_hubs) ) ;
+	}
+	if ( pce->sparse_name != NULL ) {
+		sparse_name = owstrdup( pce->sparse_name ) ;
+		if ( sparse_name == NULL ) {
+			PARSECACHE_RUNLOCK ;
+			SAFEFREE( bp ) ;
+			return gbBAD ;
+		}
+	}
+
+	memcpy( pn, &(pce->pn), sizeof(struct parsedname) ) ;
+	strcpy( path_to_server, pce->path_to_server ) ;	// same path, so same room as when it was parsed
+	pn->device_name = ( pce->device_name_offset < 0 ) ? NULL : path + pce->device_name_offset ;
+	check_presence[0] = pce->check_presence ;
+	PARSECACHE_RUNLOCK ;
+
+	pn->path = path ;
+	pn->path_to_server = path_to_server ;
+	pn->bp = bp ;
+	pn->sparse_name = sparse_name ;
+	// temperature scale etc. are current, only the bus-list choice comes from the parse
+	if ( (pn->control_flags & SHOULD_RETURN_BUS_LIST) == 0 ) {
+		control_flags &= ~SHOULD_RETURN_BUS_LIST ;
+	}
+	pn->control_flags = control_flags ;
+
+	STAT_ADD1( parse_cache_hits ) ;
+	return gbGOOD ;
+}
+
+/* Keep a successful parse (unless the table was flushed since the lookup at generation) */
+void ParseCache_Add( int back_from_remote, enum ePS_state start_state, int check_presence, UINT generation, const struct parsedname * pn )
+{
+	UINT hash = FNV1a_string( pn->path, 0 ) ;
+	size_t bp_size = pn->ds2409_depth * sizeof(struct ds2409_hubs) ;
+	size_t path_size = strlen( pn->path ) + 1 ;
+	size_t server_size = strlen( pn->path_to_server ) + 1 ;
+	size_t sparse_size = ( pn->sparse_name == NULL ) ? 0 : strlen( pn->sparse_name ) + 1 ;
+	struct parse_cache_entry * pce ;
+	struct parse_cache_entry * old_pce ;
+	char * store ;
+
+	pce = owmalloc( sizeof(struct parse_cache_entry) + bp_size + path_size + server_size + sparse_size ) ;
+	if ( pce == NULL ) {
+		return ;
+	}
+	pce->hash = hash ;
+	pce->back_from_remote = back_from_remote ;
+	pce->start_state = start_state ;
+	pce->check_presence = check_presence ;
+	pce->device_name_offset = ( pn->device_name == NULL ) ? -1 : pn->device_name - pn->path ;
+	memcpy( &(pce->pn), pn, sizeof(struct parsedname) ) ;
+
+	// bp first, it's the only part needing alignment
+	store = (char *) &pce[1] ;
+	pce->bp = NULL ;
+	if ( bp_size > 0 ) {
+		pce->bp = (struct ds2409_hubs *) store ;
+		memcpy( pce->bp, pn->bp, bp_size ) ;
+		store += bp_size ;
+	}
+	pce->path = store ;
+	memcpy( pce->path, pn->path, path_size ) ;
+	store += path_size ;
+	pce->path_to_server = store ;
+	memcpy( pce->path_to_server, pn->path_to_server, server_size ) ;
+	store += server_size ;
+	pce->sparse_name = NULL ;
+	if ( sparse_size > 0 ) {
+		pce->sparse_name = store ;
+		memcpy( pce->sparse_name, pn->sparse_name, sparse_size ) ;
+	}
+
+	// these belong to the caller's pn only
+	pce->pn.path = pce->pn.path_to_server = pce->pn.device_name = pce->pn.sparse_name = NULL ;
+	pce->pn.bp = NULL ;
+	pce->pn.lock = NULL ;
+	if ( check_presence ) {
+		UnsetKnownBus( &(pce->pn) ) ;
+	}
+
+	PARSECACHE_WLOCK ;
+	if ( generation != parse_cache_generation ) {
+		// aliases or buses changed while this was parsed
+		PARSECACHE_WUNLOCK ;
+		owfree( pce ) ;
+		return ;
+	}
+	old_pce = parse_cache[ hash & (PARSECACHE_SLOTS - 1) ] ;
+	parse_cache[ hash & (PARSECACHE_SLOTS - 1) ] = pce ;
+	PARSECACHE_WUNLOCK ;
+
+	SAFEFREE( old_pce ) ;
+}
+
+/* Forget every parse -- aliases or the bus list changed */
+void ParseCache_Flush( void )
+{
+	int slot ;
+
+	PARSECACHE_WLOCK ;
+	++parse_cache_generation ;
+	for ( slot = 0 ; slot < PARSECACHE_SLOTS ; ++slot ) {
+		SAFEFREE( parse_cache[slot] ) ;
+	}
+	PARSECACHE_WUNLOCK ;
+	STAT_ADD1( parse_cache_flushes ) ;
+}
@@ -45,12 +45,19 @@ static enum parse_enum Parse_Alias(char *filename, enum parse_pass remote_status
 static enum parse_enum Parse_Alias_Known( char *filename, enum parse_pass remote_status, struct parsedname *pn);
 static void ReplaceAliasInPath( char * filename, struct parsedname * pn);
 
-static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass remote_status, struct parsedname *pn);
+static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass remote_status, INDEX_OR_ERROR located_bus, struct parsedname *pn);
 static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const char *path, struct parsedname *pn);
+static void FS_ParsedName_keep(enum parse_pass remote_status, enum ePS_state start_state, UINT generation, struct parsedname *pn);
 static char * find_segment_in_path( char * segment, char * path ) ;
 
 #define BRANCH_INCR (9)
 
+/* path and path_to_server for a pn with no path (bus master setup) -- never written or freed */
+static char no_path[] = "" ;
+
+/* Room for path_to_server to grow as aliases are replaced with serial numbers (ReplaceAliasInPath) */
+#define ALIAS_GROWTH (14-1)
+
 /* ---------------------------------------------- */
 /* Filename (path) parsing functions              */
 /* ---------------------------------------------- */
@@ -63,6 +70,10 @@ void FS_ParsedName_destroy(struct parsedname *pn)
 	CONNIN_RUNLOCK ;
 	SAFEFREE(pn->sparse_name);
 	SAFEFREE(pn->bp) ;
+	if ( pn->path != no_path ) {
+		SAFEFREE(pn->path) ; // path_to_server is in the same allocation
+		pn->path = pn->path_to_server = no_path ;
+	}
 }
 
 // Path is either NULL (in which case a minimal structure is created that doesn't need Destroy -- used for Bus Master setups)
@@ -70,26 +81,36 @@ void FS_ParsedName_destroy(struct parsedname *pn)
 // The Path passed in isn't altered, but 2 copies are made -- one with the full path, the other (to_server) has the first bus.n removed.
 // An initial / is added to the path, and the full length has to be less than MAX_PATH (2048)
 // For efficiency, the two path copies are allocated in the same call, and so can be removed together.
+// Only pointers to them are in the parsedname, so shallow copies are small -- and must not outlive the original.
 
 /* Parse a path to check it's validity and attach to the propery data structures */
 ZERO_OR_ERROR FS_ParsedName(const char *path, struct parsedname *pn)
 {
-	return FS_ParsedName_anywhere(path, parse_pass_pre_remote, pn);
+	return FS_ParsedName_anywhere(path, parse_pass_pre_remote, INDEX_BAD, pn);
 }
 
 /* Parse a path from a remote source back -- so don't check presence */
 ZERO_OR_ERROR FS_ParsedName_BackFromRemote(const char *path, struct parsedname *pn)
 {
-	return FS_ParsedName_anywhere(path, parse_pass_post_remote, pn);
+	return FS_ParsedName_anywhere(path, parse_pass_post_remote, INDEX_BAD, pn);
+}
+
+/* Parse a path whose device the caller just found on bus_nr (another property of it) -- so don't search again */
+ZERO_OR_ERROR FS_ParsedName_OnBus(const char *path, INDEX_OR_ERROR bus_nr, struct parsedname *pn)
+{
+	return FS_ParsedName_anywhere(path, parse_pass_pre_remote, bus_nr, pn);
 }
 
 /* Parse off starting "mode" directory (uncached, alarm...) */
-static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass remote_status, struct parsedname *pn)
+static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass remote_status, INDEX_OR_ERROR located_bus, struct parsedname *pn)
 {
 	struct parsedname_pointers s_pp;
 	struct parsedname_pointers *pp = &s_pp;
 	ZERO_OR_ERROR parse_error_status = 0;
 	enum parse_enum pe = parse_first;
+	enum ePS_state start_state ;
+	UINT generation ;
+	int check_presence ;
 
 	// To make the debug output useful it's cleared here.
 	// Even on normal glibc, errno isn't cleared on good system calls
@@ -97,12 +118,37 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 
 	LEVEL_CALL("path=[%s]", SAFESTRING(path));
 
+	// SIGHUP asked for the alias files to be reread?
+	AliasReloadCheck() ;
+
 	RETURN_CODE_ERROR_RETURN( FS_ParsedName_setup(pp, path, pn) );
 
 	if (path == NO_PATH) {
 		RETURN_CODE_RETURN( 0 ) ; // success (by default)
 	}
 
+	/* Parsed this path before? */
+	start_state = pn->state ;
+	if ( GOOD( ParseCache_Get( remote_status == parse_pass_post_remote, pn, &check_presence, &generation ) ) ) {
+		// only the device location can have changed
+		if ( check_presence ) {
+			if ( INDEX_VALID(located_bus) && SetKnownBus( located_bus, pn ) == 0 ) {
+				return 0 ;
+			}
+			if ( INDEX_NOT_VALID( CheckPresence(pn) ) ) {
+				RETURN_CODE_SET_SCALAR( parse_error_status, 27 ) ; // bad path syntax
+				FS_ParsedName_destroy(pn);
+				return parse_error_status ;
+			}
+		}
+		return 0 ;
+	}
+
+	if ( INDEX_VALID(located_bus) ) {
+		// CheckPresence will take the known bus
+		SetKnownBus( located_bus, pn ) ;
+	}
+
 	while (1) {
 		// Check for extreme conditions (done, error)
 		switch (pe) {
@@ -149,6 +195,7 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 					break ;
 			}
 			//printf("%s: Parse %s after  corrections: %.4X -- state = %d\n\n",(back_from_remote)?"BACK":"FORE",pn->path,pn->state,pn->type) ;
+			FS_ParsedName_keep( remote_status, start_state, generation, pn ) ;
 			return 0;
 
 		case parse_error:
@@ -214,14 +261,43 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 	}
 }
 
+/* Put a successful parse in the parse cache, if it can be reused */
+static void FS_ParsedName_keep(enum parse_pass remote_status, enum ePS_state start_state, UINT generation, struct parsedname *pn)
+{
+	int check_presence = 0 ;
+
+	if ( pn->selected_device == &RemoteDevice ) {
+		// alias found by asking the remote owservers -- the temporary alias list handles it
+		return ;
+	}
+	if ( pn->selected_device == NO_DEVICE && ! RootNotBranch(pn) ) {
+		// DS2409 branch directory -- presence of the hub was checked without the branch
+		return ;
+	}
+
+	// A bus not given in the path (nor --one_device nor external) was found by CheckPresence
+	if ( remote_status == parse_pass_pre_remote && ! Globals.one_device
+		&& KnownBus(pn) && ! SpecifiedBus(pn)
+		&& pn->selected_connection != Inbound_Control.external ) {
+		check_presence = 1 ;
+	}
+
+	ParseCache_Add( remote_status == parse_pass_post_remote, start_state, check_presence, generation, pn ) ;
+}
+
 /* Initial memory allocation and pn setup */
 static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const char *path, struct parsedname *pn)
 {
+	size_t path_length ;
+	size_t server_size ;
+	const char * segment ;
+
 	if (pn == NO_PARSEDNAME) {
 		RETURN_CODE_RETURN( 78 ); // unexpected null pointer
 	}
 
 	memset(pn, 0, sizeof(struct parsedname));
+	pn->path = pn->path_to_server = no_path ;
 	pn->known_bus = NULL;		/* all buses */
 	pn->sparse_name = NULL ;
 	RETURN_CODE_INIT(pn);
@@ -267,20 +343,39 @@ static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const c
 		return 0; // success
 	}
 
-	if (strlen(path) > PATH_MAX) {
+	path_length = strlen(path) ;
+	if (path_length > PATH_MAX) {
 		RETURN_CODE_RETURN( 26 ) ; // path too long
 	}
 
+	/* path_to_server starts as a copy of path, and may grow by ALIAS_GROWTH per segment */
+	server_size = path_length + 2 ;
+	for ( segment = path ; *segment != '\0' ; ++segment ) {
+		if ( *segment == '/' ) {
+			server_size += ALIAS_GROWTH ;
+		}
+	}
+	server_size += ALIAS_GROWTH ;
+	if ( server_size > PATH_MAX + 2 ) {
+		server_size = PATH_MAX + 2 ;
+	}
+	pn->path = owmalloc( path_length + 2 + server_size ) ;
+	if ( pn->path == NULL ) {
+		pn->path = no_path ;
+		RETURN_CODE_RETURN( 79 ) ; // unable to allocate memory
+	}
+	pn->path_to_server = pn->path + path_length + 2 ;
+
 	/* Have to save pn->path at once */
 	strcpy(pn->path, "/"); // initial slash
 	strcpy(pn->path+1, path[0]=='/'?path+1:path);
-	strcpy(pn->path_to_server, pn->path);
+	pn->dirlength = strlen(pn->path) ;
+	memcpy(pn->path_to_server, pn->path, pn->dirlength + 1);
 
 	/* make a copy for destructive parsing  without initial '/'*/
 	strcpy(pp->pathcpy,&pn->path[1]);
 	/* pointer to rest of path after current token peeled off */
 	pp->pathnext = pp->pathcpy;
-	pn->dirlength = strlen(pn->path) ;
 	
 	/* device name */
 	pn->device_name = NULL ;
@@ -673,10 +768,8 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 	//printf("FP name=%s, dot=%s\n", filename, dot);
 
 	/* Match to known filetypes for this device */
-	pn->selected_filetype =
-		 bsearch(filename, pn->selected_device->filetype_array,
-				 (size_t) pn->selected_device->count_of_filetypes, sizeof(struct filetype), filetype_cmp) ;
-				 
+	pn->selected_filetype = FS_filetype_find( filename, pn->selected_device ) ;
+
 	if ( pn->selected_filetype == NO_FILETYPE ) {
 		LEVEL_DEBUG("Unknown property for this device %s",SAFESTRING(filename) ) ;
 		return parse_error;			/* filetype not found */
@@ -756,11 +849,7 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 			return parse_error;
 		}
 		/* STATISTICS */
-		STATLOCK;
-		if (pn->ds2409_depth > dir_depth) {
-			dir_depth = pn->ds2409_depth;
-		}
-		STATUNLOCK;
+		STAT_MAX(dir_depth, (UINT) pn->ds2409_depth);
 		return parse_branch;
 	case ft_subdir:
 		//printf("PN %s is a subdirectory\n", filename);
@@ -17,12 +17,19 @@ $Id$
 
 static GOOD_OR_BAD OWQ_allocate_array( struct one_wire_query * owq ) ;
 static GOOD_OR_BAD OWQ_parsename(const char *path, struct one_wire_query *owq);
+static GOOD_OR_BAD OWQ_parsename_on_bus(const char *path, INDEX_OR_ERROR bus_nr, struct one_wire_query *owq);
 static GOOD_OR_BAD OWQ_parsename_plus(const char *path, const char * file, struct one_wire_query *owq);
 
 #define OWQ_DEFAULT_READ_BUFFER_SIZE  1
 
 /* Create the Parsename structure and create the buffer */
 struct one_wire_query * OWQ_create_from_path(const char *path)
+{
+	return OWQ_create_from_path_on_bus( path, INDEX_BAD ) ;
+}
+
+/* As OWQ_create_from_path, for a device the caller already found on bus_nr */
+struct one_wire_query * OWQ_create_from_path_on_bus(const char *path, INDEX_OR_ERROR bus_nr)
 {
 	int sz = sizeof( struct one_wire_query ) + OWQ_DEFAULT_READ_BUFFER_SIZE;
 	struct one_wire_query * owq = owmalloc( sz );
@@ -37,7 +44,7 @@ struct one_wire_query * OWQ_create_from_path(const char *path)
 	memset(owq, 0, sz);
 	OWQ_cleanup(owq) = owq_cleanup_owq ;
 	
-	if ( GOOD( OWQ_parsename(path,owq) ) ) {
+	if ( GOOD( OWQ_parsename_on_bus(path,bus_nr,owq) ) ) {
 		if ( GOOD( OWQ_allocate_array(owq)) ) {
 			/*   Add a 1 byte buffer by default. This distinguishes from filesystem calls at end of buffer */
 			/*   Read bufer is provided by OWQ_assign_read_buffer or OWQ_allocate_read_buffer */
@@ -69,8 +76,7 @@ struct one_wire_query * OWQ_create_sibling(const char *sibling, struct one_wire_
 	// Add extension only if original property is aggregate
 	} else if ( pn_original->selected_filetype->ag != NON_AGGREGATE ) {
 		// search for sibling in the filetype array
-		struct filetype * sib_filetype = bsearch(sibling, pn_original->selected_device->filetype_array,
-				 (size_t) pn_original->selected_device->count_of_filetypes, sizeof(struct filetype), filetype_cmp) ;
+		struct filetype * sib_filetype = FS_filetype_find( sibling, pn_original->selected_device ) ;
 		// see if sibling is also an aggregate property
 		LEVEL_DEBUG("Path %s is an agggregate",SAFESTRING(pn_original->path));
 		if ( sib_filetype != NO_FILETYPE && sib_filetype->ag != NON_AGGREGATE ) {
@@ -200,6 +206,17 @@ static GOOD_OR_BAD OWQ_parsename(const char *path, struct one_wire_query *owq)
 	return gbGOOD ;
 }
 
+static GOOD_OR_BAD OWQ_parsename_on_bus(const char *path, INDEX_OR_ERROR bus_nr, struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+
+	if ( FS_ParsedName_OnBus(path, bus_nr, pn) != 0 ) {
+		return gbBAD ;
+	}
+	OWQ_cleanup(owq) |= owq_cleanup_pn ;
+	return gbGOOD ;
+}
+
 static GOOD_OR_BAD OWQ_parsename_plus(const char *path, const char * file, struct one_wire_query *owq)
 {
 	struct parsedname *pn = PN(owq);
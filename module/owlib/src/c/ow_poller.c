@@ -0,0 +1,541 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: palfille@earthlink.net
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Background poller
+ * The cache is filled on demand, so the first client after an entry expires
+ * waits for the bus (750 msec for a DS18B20 conversion).
+ * The poller reads chosen properties on a schedule, just before their cache entries
+ * expire, so clients find fresh values in the cache instead.
+ *
+ * --poll=family[/property,property...][:seconds][@bus]   (may be repeated)
+ *   family    hex family code, e.g. 28 for DS18B20
+ *   property  default "temperature"
+ *   seconds   default: a second less than the property's cache timeout
+ *   bus       bus number (as in /bus.n), default every bus
+ *
+ * A round runs each bus on its bus worker (ow_busworker.c):
+ *   simultaneous/temperature once if any due schedule reads temperature,
+ *   a fresh directory listing, then an uncached read of each property of each
+ *   matching device, which puts the new value in the cache.
+ * Each device is a separate job on the worker, so a client's directory listing or
+ * presence search queued meanwhile waits for one device, not the whole round.
+ * Statistics are in /statistics/poller. Lag is how late (msec) a round started
+ * compared with the expiry of the values the previous round cached.
+ */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_counters.h"
+#include "ow_connection.h"
+
+#define POLLER_DEFAULT_PROPERTY	"temperature"
+#define POLLER_ALL_BUSES	-1
+
+struct poll_schedule {
+	struct poll_schedule * next ;
+	BYTE family ;				// family code
+	char * properties ;			// comma separated
+	int interval ;				// seconds, 0 for "just before the cache entries expire"
+	INDEX_OR_ERROR bus ;		// bus index or POLLER_ALL_BUSES
+	int timeout ;				// shortest cache timeout of its properties (learned, 0 if unknown)
+	struct timeval due ;		// next round
+	struct timeval last ;		// start of the previous round
+	int polled ;				// a round has run
+	int temperature ;			// reads "temperature" (simultaneous conversion first)
+} ;
+
+static struct poll_schedule * poll_schedules = NULL ;
+
+#if OW_MT
+
+// One bus's share of a round
+struct poll_bus {
+	struct bus_job job ;
+	struct connection_in * in ;
+	struct poll_schedule ** due ;	// the due schedules
+	int due_count ;
+	int * timeout ;				// per due schedule, shortest cache timeout seen this round
+	struct dirblob db ;			// devices on the bus
+	int device ;				// next one to read
+} ;
+
+static pthread_t poller_thread ;
+static pthread_mutex_t poller_mutex ;
+static pthread_cond_t poller_cond ;	// stop was requested
+static int poller_running = 0 ;
+static int poller_stop = 0 ;
+
+static void * Poller_loop( void * v ) ;
+static void Poller_round( struct poll_schedule ** due, int due_count ) ;
+static void Poller_bus( void * v ) ;
+static void Poller_bus_device( void * v ) ;
+static void Poller_device( struct poll_bus * pb, const BYTE * sn ) ;
+static void Poller_read( struct poll_bus * pb, int schedule, const BYTE * sn, const char * property ) ;
+static void Poller_next( struct poll_schedule * ps, const struct timeval * start ) ;
+static void Poller_dir_callback( void * v, const struct parsedname * pn_entry ) ;
+#endif /* OW_MT */
+
+/* Parse one --poll specification */
+GOOD_OR_BAD PollerAdd( const char * spec )
+{
+	struct poll_schedule * ps ;
+	char * copy ;
+	char * rest ;
+	char * field ;
+	char * end ;
+	unsigned long family ;
+
+	if ( spec == NULL ) {
+		return gbBAD ;
+	}
+	copy = owstrdup( spec ) ;
+	ps = owcalloc( 1, sizeof(struct poll_schedule) ) ;
+	if ( copy == NULL || ps == NULL ) {
+		SAFEFREE( copy ) ;
+		SAFEFREE( ps ) ;
+		return gbBAD ;
+	}
+	ps->bus = POLLER_ALL_BUSES ;
+
+	// from the end: @bus, then :seconds, then /properties
+	rest = copy ;
+	field = strchr( rest, '@' ) ;
+	if ( field != NULL ) {
+		*field++ = '\0' ;
+		ps->bus = (INDEX_OR_ERROR) strtol( field, &end, 10 ) ;
+		if ( end == field || *end != '\0' || ps->bus < 0 ) {
+			LEVEL_DEFAULT("Poll <%s>: bad bus number",spec) ;
+			goto bad ;
+		}
+	}
+	field = strchr( rest, ':' ) ;
+	if ( field != NULL ) {
+		*field++ = '\0' ;
+		ps->interval = (int) strtol( field, &end, 10 ) ;
+		if ( end == field || *end != '\0' || ps->interval < 1 ) {
+			LEVEL_DEFAULT("Poll <%s>: bad interval",spec) ;
+			goto bad ;
+		}
+	}
+	field = strchr( rest, '/' ) ;
+	if ( field != NULL ) {
+		*field++ = '\0' ;
+	}
+	ps->properties = owstrdup( ( field == NULL || field[0] == '\0' ) ? POLLER_DEFAULT_PROPERTY : field ) ;
+	if ( ps->properties == NULL ) {
+		goto bad ;
+	}
+	family = strtoul( rest, &end, 16 ) ;
+	if ( end == rest || *end != '\0' || family > 0xFF ) {
+		LEVEL_DEFAULT("Poll <%s>: bad family code (hex, e.g. 28)",spec) ;
+		goto bad ;
+	}
+	ps->family = (BYTE) family ;
+
+	// temperature among the properties?
+	for ( field = ps->properties ; field != NULL ; field = strchr( field, ',' ) ) {
+		if ( field[0] == ',' ) {
+			++field ;
+		}
+		if ( strncmp( field, POLLER_DEFAULT_PROPERTY, strlen(POLLER_DEFAULT_PROPERTY) ) == 0 ) {
+			char after = field[strlen(POLLER_DEFAULT_PROPERTY)] ;
+			if ( after == '\0' || after == ',' ) {
+				ps->temperature = 1 ;
+			}
+		}
+	}
+
+	LEVEL_DEBUG("Poll family %.2X properties <%s> every %d seconds on bus %d",(int) ps->family,ps->properties,ps->interval,(int) ps->bus) ;
+	owfree( copy ) ;
+	ps->next = poll_schedules ;
+	poll_schedules = ps ;
+	return gbGOOD ;
+
+bad:
+	owfree( copy ) ;
+	SAFEFREE( ps->properties ) ;
+	owfree( ps ) ;
+	return gbBAD ;
+}
+
+#if OW_MT
+
+/* Start the poller thread, if anything is to be polled */
+void PollerStart( void )
+{
+	struct poll_schedule * ps ;
+	struct timeval now ;
+
+	if ( poll_schedules == NULL || poller_running ) {
+		return ;
+	}
+
+	// first round right away
+	timernow( &now ) ;
+	for ( ps = poll_schedules ; ps != NULL ; ps = ps->next ) {
+		timercpy( &(ps->due), &now ) ;
+	}
+
+	_MUTEX_INIT( poller_mutex ) ;
+	my_pthread_cond_init( &poller_cond, NULL ) ;
+	poller_stop = 0 ;
+	if ( pthread_create( &poller_thread, DEFAULT_THREAD_ATTR, Poller_loop, NULL ) != 0 ) {
+		ERROR_DEBUG("Cannot start the background poller") ;
+		my_pthread_cond_destroy( &poller_cond ) ;
+		_MUTEX_DESTROY( poller_mutex ) ;
+		return ;
+	}
+	poller_running = 1 ;
+}
+
+/* Stop the poller (after its current round) and forget the schedules */
+void PollerStop( void )
+{
+	if ( poller_running ) {
+		_MUTEX_LOCK( poller_mutex ) ;
+		poller_stop = 1 ;
+		pthread_cond_signal( &poller_cond ) ;
+		_MUTEX_UNLOCK( poller_mutex ) ;
+		pthread_join( poller_thread, NULL ) ;
+		my_pthread_cond_destroy( &poller_cond ) ;
+		_MUTEX_DESTROY( poller_mutex ) ;
+		poller_running = 0 ;
+	}
+
+	while ( poll_schedules != NULL ) {
+		struct poll_schedule * ps = poll_schedules ;
+		poll_schedules = ps->next ;
+		owfree( ps->properties ) ;
+		owfree( ps ) ;
+	}
+}
+
+/* Sleep until the earliest schedule is due, run every due schedule as one round */
+static void * Poller_loop( void * v )
+{
+	struct poll_schedule * ps ;
+	struct poll_schedule ** due ;
+	int schedules = 0 ;
+
+	(void) v ;
+	for ( ps = poll_schedules ; ps != NULL ; ps = ps->next ) {
+		++schedules ;
+	}
+	due = owmalloc( schedules * sizeof(struct poll_schedule *) ) ;
+	if ( due == NULL ) {
+		return VOID_RETURN ;
+	}
+
+	LEVEL_DEBUG("Background poller started with %d schedules",schedules) ;
+	while (1) {
+		struct timeval now ;
+		struct timeval earliest ;
+		struct timespec wake ;
+		int due_count = 0 ;
+
+		timernow( &now ) ;
+		timercpy( &earliest, &(poll_schedules->due) ) ;
+		for ( ps = poll_schedules ; ps != NULL ; ps = ps->next ) {
+			if ( ! timercmp( &now, &(ps->due), < ) ) {
+				due[due_count++] = ps ;
+			} else if ( timercmp( &(ps->due), &earliest, < ) ) {
+				timercpy( &earliest, &(ps->due) ) ;
+			}
+		}
+
+		if ( due_count > 0 ) {
+			Poller_round( due, due_count ) ;
+		}
+
+		_MUTEX_LOCK( poller_mutex ) ;
+		if ( due_count == 0 && ! poller_stop ) {
+			wake.tv_sec = earliest.tv_sec ;
+			wake.tv_nsec = earliest.tv_usec * 1000 ;
+			pthread_cond_timedwait( &poller_cond, &poller_mutex, &wake ) ;
+		}
+		if ( poller_stop ) {
+			_MUTEX_UNLOCK( poller_mutex ) ;
+			break ;
+		}
+		_MUTEX_UNLOCK( poller_mutex ) ;
+	}
+
+	owfree( due ) ;
+	LEVEL_DEBUG("Background poller stopped") ;
+	return VOID_RETURN ;
+}
+
+/* Run the due schedules on every bus they name, buses in parallel */
+static void Poller_round( struct poll_schedule ** due, int due_count )
+{
+	struct port_in * pin ;
+	struct connection_in * cin ;
+	struct poll_bus * buses ;
+	struct bus_job_group group ;
+	struct timeval start ;
+	int bus_count = 0 ;
+	int b ;
+	int d ;
+
+	timernow( &start ) ;
+	STAT_ADD1( poller_rounds ) ;
+
+	// Buses can't be removed while the round's jobs still point at them
+	CONNIN_RLOCK ;
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+			++bus_count ;
+		}
+	}
+	buses = owcalloc( bus_count, sizeof(struct poll_bus) ) ;
+	if ( bus_count == 0 || buses == NULL ) {
+		CONNIN_RUNLOCK ;
+		SAFEFREE( buses ) ;
+		for ( d = 0 ; d < due_count ; ++d ) {
+			Poller_next( due[d], &start ) ;
+		}
+		return ;
+	}
+
+	BusJobGroupInit( &group ) ;
+	b = 0 ;
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+			struct poll_bus * pb = &buses[b++] ;
+
+			DirblobInit( &(pb->db) ) ;
+			pb->in = cin ;
+			pb->due = owcalloc( due_count, sizeof(struct poll_schedule *) ) ;
+			pb->timeout = owcalloc( due_count, sizeof(int) ) ;
+			if ( pb->due == NULL || pb->timeout == NULL ) {
+				continue ;
+			}
+			for ( d = 0 ; d < due_count ; ++d ) {
+				if ( due[d]->bus == POLLER_ALL_BUSES || due[d]->bus == cin->index ) {
+					pb->due[pb->due_count++] = due[d] ;
+				}
+			}
+			if ( pb->due_count == 0 ) {
+				continue ;
+			}
+			pb->job.run = Poller_bus ;
+			pb->job.arg = pb ;
+			BusJobSubmit( &group, &(pb->job), cin ) ;
+		}
+	}
+	BusJobGroupWait( &group ) ;
+
+	// then a device per bus at a time, behind any jobs queued meanwhile
+	while (1) {
+		int submitted = 0 ;
+
+		BusJobGroupInit( &group ) ;
+		for ( b = 0 ; b < bus_count ; ++b ) {
+			struct poll_bus * pb = &buses[b] ;
+			if ( pb->due_count > 0 && pb->device < DirblobElements( &(pb->db) ) ) {
+				pb->job.run = Poller_bus_device ;
+				BusJobSubmit( &group, &(pb->job), pb->in ) ;
+				++submitted ;
+			}
+		}
+		BusJobGroupWait( &group ) ;
+		if ( submitted == 0 ) {
+			break ;
+		}
+	}
+	CONNIN_RUNLOCK ;
+
+	// fold in the cache timeouts learned, then reschedule
+	for ( b = 0 ; b < bus_count ; ++b ) {
+		struct poll_bus * pb = &buses[b] ;
+		for ( d = 0 ; d < pb->due_count ; ++d ) {
+			struct poll_schedule * ps = pb->due[d] ;
+			if ( pb->timeout[d] > 0 && ( ps->timeout == 0 || pb->timeout[d] < ps->timeout ) ) {
+				ps->timeout = pb->timeout[d] ;
+			}
+		}
+		DirblobClear( &(pb->db) ) ;
+		SAFEFREE( pb->due ) ;
+		SAFEFREE( pb->timeout ) ;
+	}
+	owfree( buses ) ;
+
+	for ( d = 0 ; d < due_count ; ++d ) {
+		Poller_next( due[d], &start ) ;
+	}
+}
+
+/* Lag statistics and the next due time for a schedule whose round started at start */
+static void Poller_next( struct poll_schedule * ps, const struct timeval * start )
+{
+	int interval = ps->interval ;
+
+	if ( ps->polled && ps->timeout > 0 ) {
+		// the previous round's values expired at last + timeout
+		struct timeval expiry = { ps->last.tv_sec + ps->timeout, ps->last.tv_usec, } ;
+		if ( timercmp( start, &expiry, > ) ) {
+			struct timeval late ;
+			UINT lag ;
+			timersub( start, &expiry, &late ) ;
+			lag = late.tv_sec * 1000 + late.tv_usec / 1000 ;
+			STAT_ADD1( poller_late ) ;
+			poller_lag_last = lag ;
+			if ( lag > poller_lag_max ) {
+				poller_lag_max = lag ;
+			}
+		} else {
+			poller_lag_last = 0 ;
+		}
+	}
+	timercpy( &(ps->last), start ) ;
+	ps->polled = 1 ;
+
+	if ( interval == 0 ) {
+		// refresh a second before this round's values expire
+		int timeout = ( ps->timeout > 0 ) ? ps->timeout : Globals.timeout_volatile ;
+		interval = ( timeout > 1 ) ? timeout - 1 : 1 ;
+	}
+	ps->due.tv_sec = start->tv_sec + interval ;
+	ps->due.tv_usec = start->tv_usec ;
+}
+
+/* One bus: simultaneous conversion and a fresh listing (on the bus worker) */
+static void Poller_bus( void * v )
+{
+	struct poll_bus * pb = v ;
+	struct parsedname pn_bus ;
+	char path[PATH_MAX+1] ;
+	int temperature = 0 ;
+	int d ;
+
+	for ( d = 0 ; d < pb->due_count ; ++d ) {
+		temperature |= pb->due[d]->temperature ;
+	}
+	if ( temperature ) {
+		UCLIBCLOCK ;
+		snprintf( path, PATH_MAX, "/uncached/bus.%d/simultaneous/temperature", (int) pb->in->index ) ;
+		UCLIBCUNLOCK ;
+		if ( FS_write( path, "1", 1, 0 ) < 0 ) {
+			LEVEL_DEBUG("Poller: no simultaneous conversion on bus %d",(int) pb->in->index) ;
+		}
+	}
+
+	UCLIBCLOCK ;
+	snprintf( path, PATH_MAX, "/uncached/bus.%d", (int) pb->in->index ) ;
+	UCLIBCUNLOCK ;
+	if ( FS_ParsedName( path, &pn_bus ) != 0 ) {
+		STAT_ADD1( poller_errors ) ;
+		return ;
+	}
+	FS_dir( Poller_dir_callback, &(pb->db), &pn_bus ) ;
+	FS_ParsedName_destroy( &pn_bus ) ;
+}
+
+/* The next device's reads (on the bus worker) */
+static void Poller_bus_device( void * v )
+{
+	struct poll_bus * pb = v ;
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+
+	if ( DirblobGet( pb->device++, sn, &(pb->db) ) == 0 ) {
+		Poller_device( pb, sn ) ;
+	}
+}
+
+static void Poller_dir_callback( void * v, const struct parsedname * pn_entry )
+{
+	struct dirblob * db = v ;
+
+	if ( pn_entry->sn[0] != '\0' ) {
+		DirblobAdd( pn_entry->sn, db ) ;
+	}
+}
+
+/* Each property of each schedule for this device's family */
+static void Poller_device( struct poll_bus * pb, const BYTE * sn )
+{
+	int d ;
+
+	for ( d = 0 ; d < pb->due_count ; ++d ) {
+		struct poll_schedule * ps = pb->due[d] ;
+		char * properties ;
+		char * property ;
+		char * rest ;
+
+		if ( ps->family != sn[0] ) {
+			continue ;
+		}
+		properties = owstrdup( ps->properties ) ;
+		if ( properties == NULL ) {
+			STAT_ADD1( poller_errors ) ;
+			continue ;
+		}
+		rest = properties ;
+		while ( ( property = strsep( &rest, "," ) ) != NULL ) {
+			if ( property[0] != '\0' ) {
+				Poller_read( pb, d, sn, property ) ;
+			}
+		}
+		owfree( properties ) ;
+	}
+}
+
+/* Uncached read, so the fresh value lands in the cache */
+static void Poller_read( struct poll_bus * pb, int schedule, const BYTE * sn, const char * property )
+{
+	char path[PATH_MAX+1] ;
+	struct one_wire_query * owq ;
+	int timeout ;
+
+	UCLIBCLOCK ;
+	snprintf( path, PATH_MAX, "/uncached/bus.%d/%.2X%.2X%.2X%.2X%.2X%.2X%.2X%.2X/%s", (int) pb->in->index, SNvar(sn), property ) ;
+	UCLIBCUNLOCK ;
+
+	owq = OWQ_create_from_path( path ) ;
+	if ( owq == NO_ONE_WIRE_QUERY ) {
+		LEVEL_DEBUG("Poller: cannot read %s",path) ;
+		STAT_ADD1( poller_errors ) ;
+		return ;
+	}
+	if ( FS_read_postparse( owq ) < 0 ) {
+		LEVEL_DEBUG("Poller: read of %s failed",path) ;
+		STAT_ADD1( poller_errors ) ;
+	} else {
+		STAT_ADD1( poller_reads ) ;
+	}
+	timeout = Cache_Timeout( PN(owq)->selected_filetype->change ) ;
+	if ( timeout > 0 && ( pb->timeout[schedule] == 0 || timeout < pb->timeout[schedule] ) ) {
+		pb->timeout[schedule] = timeout ;
+	}
+	OWQ_destroy( owq ) ;
+}
+
+#else /* OW_MT */
+
+void PollerStart( void )
+{
+	if ( poll_schedules != NULL ) {
+		LEVEL_DEFAULT("Background polling needs a multithreaded build -- ignored") ;
+	}
+}
+
+void PollerStop( void )
+{
+	while ( poll_schedules != NULL ) {
+		struct poll_schedule * ps = poll_schedules ;
+		poll_schedules = ps->next ;
+		owfree( ps->properties ) ;
+		owfree( ps ) ;
+	}
+}
+
+#endif /* OW_MT */
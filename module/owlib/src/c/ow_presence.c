@@ -128,81 +128,69 @@ INDEX_OR_ERROR ReCheckPresence(struct parsedname *pn)
 #if OW_MT
 
 struct checkpresence_struct {
-	struct port_in * pin;
+	struct bus_job job;
 	struct connection_in * cin;
 	struct parsedname *pn;
 	INDEX_OR_ERROR bus_nr;
 };
 
-static void * CheckPresence_callback_conn(void * v)
+/* Run by the bus worker for one connection */
+static void CheckPresence_job(void * v)
 {
 	struct checkpresence_struct * cps = (struct checkpresence_struct *) v ;
-	struct checkpresence_struct cps_next ;
-	pthread_t thread;
-	int threadbad = 0 ;
-	
-	cps_next.cin = cps->cin->next ;
-	if ( cps_next.cin == NO_CONNECTION ) {
-		threadbad = 1 ;
-	} else {
-		cps_next.pin = cps->pin ;
-		cps_next.pn = cps->pn ;
-		cps_next.bus_nr = INDEX_BAD ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, CheckPresence_callback_conn, (void *) (&cps_next)) ;
-	}
-	
+
 	cps->bus_nr = CheckThisConnection( cps->cin->index, cps->pn ) ;
-	
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)==0) {
-			if ( INDEX_VALID(cps_next.bus_nr) ) {
-				cps->bus_nr = cps_next.bus_nr ;
-			}
-		}
-	}
-	return VOID_RETURN ;
 }
 
-static void * CheckPresence_callback_port(void * v)
+/* Each connection is searched on that bus's worker thread (ow_busworker.c) */
+static INDEX_OR_ERROR CheckPresence_low(struct parsedname *pn)
 {
-	struct checkpresence_struct * cps = (struct checkpresence_struct *) v ;
-	struct checkpresence_struct cps_next ;
-	pthread_t thread;
-	int threadbad = 0 ;
-	
-	cps_next.pin = cps->pin->next ;
-	if ( cps_next.pin == NULL ) {
-		threadbad = 1 ;
-	} else {
-		cps_next.pn = cps->pn ;
-		cps_next.bus_nr = INDEX_BAD ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, CheckPresence_callback_port, (void *) (&cps_next)) ;
+	struct port_in * pin ;
+	struct connection_in * cin ;
+	struct checkpresence_struct * cps ;
+	struct bus_job_group group ;
+	int connections = 0 ;
+	int i ;
+	INDEX_OR_ERROR bus_nr = INDEX_BAD ;
+
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+			++connections ;
+		}
 	}
-	
-	cps->cin = cps->pin->first ;
-	if ( cps->cin != NO_CONNECTION ) {
-		CheckPresence_callback_conn(v) ;
+	if ( connections == 0 ) {
+		return INDEX_BAD ;
 	}
-			
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)==0) {
-			if ( INDEX_VALID(cps_next.bus_nr) ) {
-				cps->bus_nr = cps_next.bus_nr ;
-			}
+
+	cps = owmalloc( connections * sizeof(struct checkpresence_struct) ) ;
+	if ( cps == NULL ) {
+		return INDEX_BAD ;
+	}
+
+	BusJobGroupInit( &group ) ;
+	i = 0 ;
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+			struct checkpresence_struct * c = &cps[i++] ;
+
+			c->cin = cin ;
+			c->pn = pn ;
+			c->bus_nr = INDEX_BAD ;
+			c->job.run = CheckPresence_job ;
+			c->job.arg = c ;
+			BusJobSubmit( &group, &(c->job), cin ) ;
 		}
 	}
-	return VOID_RETURN ;
-}
+	BusJobGroupWait( &group ) ;
 
-static INDEX_OR_ERROR CheckPresence_low(struct parsedname *pn)
-{
-	struct checkpresence_struct cps = { Inbound_Control.head_port, NULL, pn, INDEX_BAD };
-		
-	if ( cps.pin != NULL ) {
-		CheckPresence_callback_port( (void *) (&cps) ) ;
+	for ( i = 0 ; i < connections ; ++i ) {
+		if ( INDEX_VALID(cps[i].bus_nr) ) {
+			bus_nr = cps[i].bus_nr ;	// last bus found wins, as before
+		}
 	}
 
-	return cps.bus_nr;
+	owfree( cps ) ;
+	return bus_nr;
 }
 
 #else							/* OW_MT */
@@ -269,6 +257,9 @@ static INDEX_OR_ERROR CheckThisConnection(int bus_nr, struct parsedname *pn)
 		}
 	} else if ( in->iroutines.flags & ADAP_FLAG_sham ) {
 		return INDEX_BAD ;
+	} else if ( get_busmode(in) == bus_external ) {
+		// external sensors only -- no 1-wire devices and no bus routines
+		return INDEX_BAD ;
 	} else if ( in->iroutines.flags & ADAP_FLAG_presence_from_dirblob ) {
 		// local connection with a dirblob (like fake, mock, ...)
 		if ( GOOD( PresenceFromDirblob( pn_copy ) ) ) {
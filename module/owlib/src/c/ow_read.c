@@ -31,6 +31,52 @@ static SIZE_OR_ERROR FS_read_distribute(struct one_wire_query *owq) ;
 static ZERO_OR_ERROR FS_read_all( struct one_wire_query *owq_all ); 
 static ZERO_OR_ERROR FS_read_a_part( struct one_wire_query *owq_part );
 static ZERO_OR_ERROR FS_read_in_parts( struct one_wire_query *owq_all );
+static int FS_read_batch_compare( const void * a, const void * b ) ;
+
+// one query of a batch, remembering its place in the caller's list
+struct batch_entry {
+	struct one_wire_query * owq ;
+	int index ;
+} ;
+
+static int FS_read_batch_same_device( struct parsedname * pn_a, struct parsedname * pn_b ) ;
+static SIZE_OR_ERROR FS_r_device_locked(struct one_wire_query *owq);
+static SIZE_OR_ERROR FS_r_single_flight(struct one_wire_query *owq);
+
+#if OW_MT
+/* A local read in progress
+ * Identical requests arriving meanwhile wait for it instead of queueing on the device lock
+ * to repeat the bus traffic (e.g. many clients polling one temperature).
+ * Kept in a short list per connection, guarded by the connection's dev_mutex.
+ * Freed by whoever leaves last -- the reader or the final waiter.
+ */
+struct read_flight {
+	struct read_flight *next;
+	// key -- same request, same answer
+	BYTE sn[SERIAL_NUMBER_SIZE];
+	struct filetype *ft;
+	int extension;
+	char *sparse_name;			// text-keyed sparse properties all have extension 0
+	size_t size;
+	off_t offset;
+	uint32_t control_flags;		// output format (temperature scale, ...)
+	enum ePS_state state;		// uncached, ...
+	// result
+	pthread_cond_t cond;
+	int done;
+	int waiters;
+	SIZE_OR_ERROR ret;
+	union value_object val;		// native value (not for .ALL)
+	union value_object *array;	// native values of a .ALL read, ag->elements of them
+	char *buffer;				// formatted output, ret bytes
+};
+
+#define READFLIGHTLOCK(in)		_MUTEX_LOCK(   (in)->dev_mutex )
+#define READFLIGHTUNLOCK(in)	_MUTEX_UNLOCK( (in)->dev_mutex )
+
+static struct read_flight *FS_read_flight_find(struct one_wire_query *owq);
+static void FS_read_flight_free(struct read_flight *flight);
+#endif							/* OW_MT */
 
 /*
 Change in strategy 6/2006:
@@ -77,24 +123,20 @@ SIZE_OR_ERROR FS_read_postparse(struct one_wire_query *owq)
 
 	/* Normal read. Try three times */
 	LEVEL_DEBUG("%s", pn->path);
-	STATLOCK;
-	AVERAGE_IN(&read_avg);
-	AVERAGE_IN(&all_avg);
-	STATUNLOCK;
+	STAT_AVERAGE_IN(&read_avg);
+	STAT_AVERAGE_IN(&all_avg);
 
 	/* First try */
 	STAT_ADD1(read_tries[0]);
 
 	read_or_error = (pn->type == ePN_real) ? FS_read_real(owq) : FS_r_virtual(owq);
 
-	STATLOCK;
 	if (read_or_error >= 0) {
-		++read_success;			/* statistics */
-		read_bytes += read_or_error;	/* statistics */
+		STAT_ADD1(read_success);	/* statistics */
+		STAT_ADD(read_bytes, read_or_error);	/* statistics */
 	}
-	AVERAGE_OUT(&read_avg);
-	AVERAGE_OUT(&all_avg);
-	STATUNLOCK;
+	STAT_AVERAGE_OUT(&read_avg);
+	STAT_AVERAGE_OUT(&all_avg);
 	LEVEL_DEBUG("%s return %d", pn->path, read_or_error);
 	return read_or_error;
 }
@@ -109,6 +151,11 @@ static SIZE_OR_ERROR FS_read_real(struct one_wire_query *owq)
 	/* in and bus_nr already set */
 	read_or_error = FS_read_distribute(owq);
 
+	/* External sensors answer for themselves -- no bus to recheck */
+	if ( get_busmode(pn->selected_connection) == bus_external ) {
+		return read_or_error ;
+	}
+
 	/* Second Try */
 	/* if not a specified bus, relook for chip location */
 	if (read_or_error < 0) {	//error
@@ -197,10 +244,8 @@ static SIZE_OR_ERROR FS_read_distribute(struct one_wire_query *owq)
 	SIZE_OR_ERROR read_or_error = 0;
 
 	LEVEL_DEBUG("%s", PN(owq)->path);
-	STATLOCK;
-	AVERAGE_IN(&read_avg);
-	AVERAGE_IN(&all_avg);
-	STATUNLOCK;
+	STAT_AVERAGE_IN(&read_avg);
+	STAT_AVERAGE_IN(&all_avg);
 
 	/* handle DeviceSimultaneous */
 	if (PN(owq)->selected_device == DeviceSimultaneous) {
@@ -209,14 +254,12 @@ static SIZE_OR_ERROR FS_read_distribute(struct one_wire_query *owq)
 		read_or_error = FS_r_given_bus(owq);
 	}
 
-	STATLOCK;
 	if (read_or_error >= 0) {
-		++read_success;			/* statistics */
-		read_bytes += read_or_error;		/* statistics */
+		STAT_ADD1(read_success);	/* statistics */
+		STAT_ADD(read_bytes, read_or_error);	/* statistics */
 	}
-	AVERAGE_OUT(&read_avg);
-	AVERAGE_OUT(&all_avg);
-	STATUNLOCK;
+	STAT_AVERAGE_OUT(&read_avg);
+	STAT_AVERAGE_OUT(&all_avg);
 
 	LEVEL_DEBUG("%s returns %d", PN(owq)->path, read_or_error);
 	//printf("FS_read_distribute: pid=%ld return %d\n", pthread_self(), read_or_error);
@@ -243,17 +286,21 @@ static SIZE_OR_ERROR FS_r_given_bus(struct one_wire_query *owq)
 		//printf("FS_r_given_bus pid=%ld r=%d\n",pthread_self(), read_or_error);
 	} else {
 		STAT_ADD1(read_calls);	/* statistics */
-		if (DeviceLockGet(pn) == 0) {
-			read_or_error = FS_r_local(owq);	// this returns status
-			DeviceLockRelease(pn);
+		if ( pn->lock != NULL ) {
+			// device already locked by FS_read_batch for a group of reads
+			read_or_error = FS_r_local(owq);
 			LEVEL_DEBUG("return=%d", read_or_error);
 			if (read_or_error >= 0) {
-				// local success -- now format in buffer
-				read_or_error = OWQ_parse_output(owq);	// this returns nr. bytes
+				read_or_error = OWQ_parse_output(owq);
 			}
+		} else if ( GOOD( OWQ_Cache_Get_Stale(owq) ) ) {
+			// expired but within its stale grace -- answer now, the bus read happens in the background
+			LEVEL_DEBUG("Stale value from cache, refresh queued");
+			pn->control_flags |= STALE_VALUE;
+			RefreshQueue(pn);
+			read_or_error = OWQ_parse_output(owq);
 		} else {
-			LEVEL_DEBUG("Cannot lock bus to perform read") ;
-			read_or_error = -EADDRINUSE;
+			read_or_error = FS_r_single_flight(owq);
 		}
 	}
 	LEVEL_DEBUG("After read is performed (bytes or error %d)", read_or_error);
@@ -261,6 +308,185 @@ static SIZE_OR_ERROR FS_r_given_bus(struct one_wire_query *owq)
 	return read_or_error;
 }
 
+/* Lock the device, read, and format in buffer */
+static SIZE_OR_ERROR FS_r_device_locked(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	SIZE_OR_ERROR read_or_error ;
+
+	if (DeviceLockGet(pn) != 0) {
+		LEVEL_DEBUG("Cannot lock bus to perform read") ;
+		return -EADDRINUSE;
+	}
+	read_or_error = FS_r_local(owq);	// this returns status
+	DeviceLockRelease(pn);
+	LEVEL_DEBUG("return=%d", read_or_error);
+	if (read_or_error >= 0) {
+		// local success -- now format in buffer
+		read_or_error = OWQ_parse_output(owq);	// this returns nr. bytes
+	}
+	return read_or_error;
+}
+
+#if OW_MT
+/* Matching read in progress on this connection, or NULL */
+/* called with READFLIGHTLOCK */
+static struct read_flight *FS_read_flight_find(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	struct read_flight *flight;
+
+	for (flight = pn->selected_connection->read_flights; flight != NULL; flight = flight->next) {
+		if (flight->ft == pn->selected_filetype
+			&& flight->extension == pn->extension
+			&& flight->size == OWQ_size(owq)
+			&& flight->offset == OWQ_offset(owq)
+			&& flight->control_flags == pn->control_flags
+			&& flight->state == pn->state
+			&& memcmp(flight->sn, pn->sn, SERIAL_NUMBER_SIZE) == 0) {
+			if (flight->sparse_name == NULL && pn->sparse_name == NULL) {
+				return flight;
+			}
+			if (flight->sparse_name != NULL && pn->sparse_name != NULL && strcmp(flight->sparse_name, pn->sparse_name) == 0) {
+				return flight;
+			}
+		}
+	}
+	return NULL;
+}
+
+/* called with READFLIGHTLOCK by whoever leaves last */
+static void FS_read_flight_free(struct read_flight *flight)
+{
+	my_pthread_cond_destroy(&(flight->cond));
+	SAFEFREE(flight->sparse_name);
+	SAFEFREE(flight->array);
+	SAFEFREE(flight->buffer);
+	owfree(flight);
+}
+
+/* Join an identical read in progress, or perform it on behalf of later arrivals */
+static SIZE_OR_ERROR FS_r_single_flight(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	struct connection_in *in = pn->selected_connection;
+	struct read_flight *flight;
+	struct read_flight **prior;
+	SIZE_OR_ERROR read_or_error;
+	int shared;
+
+	if (pn->selected_filetype->change == fc_uncached) {
+		// reading has side effects or must be fresh
+		return FS_r_device_locked(owq);
+	}
+
+	READFLIGHTLOCK(in);
+	flight = FS_read_flight_find(owq);
+	if (flight != NULL) {
+		// Someone else is already reading this -- wait for the answer
+		++flight->waiters;
+		STAT_ADD1(read_coalesced);
+		while (!flight->done) {
+			my_pthread_cond_wait(&(flight->cond), &(in->dev_mutex));
+		}
+		read_or_error = flight->ret;
+		shared = (read_or_error <= 0 || flight->buffer != NULL);	// else reader couldn't copy its result
+		if (shared && read_or_error >= 0 && pn->extension == EXTENSION_ALL) {
+			shared = (flight->array != NULL && OWQ_array(owq) != NULL);
+		}
+		if (shared && read_or_error > 0) {
+			memcpy(OWQ_buffer(owq), flight->buffer, read_or_error);
+		}
+		if (shared && read_or_error >= 0) {
+			if (pn->extension == EXTENSION_ALL) {
+				memcpy(OWQ_array(owq), flight->array, pn->selected_filetype->ag->elements * sizeof(union value_object));
+			} else {
+				OWQ_val(owq) = flight->val;
+			}
+		}
+		if (--flight->waiters == 0) {
+			FS_read_flight_free(flight);
+		}
+		READFLIGHTUNLOCK(in);
+		if (!shared) {
+			return FS_r_device_locked(owq);
+		}
+		LEVEL_DEBUG("Shared result of a concurrent read (bytes or error %d)", read_or_error);
+		return read_or_error;
+	}
+
+	// First one -- register the read so later arrivals can wait for it
+	flight = owmalloc(sizeof(struct read_flight));
+	if (flight == NULL) {
+		READFLIGHTUNLOCK(in);
+		return FS_r_device_locked(owq);
+	}
+	memset(flight, 0, sizeof(struct read_flight));
+	memcpy(flight->sn, pn->sn, SERIAL_NUMBER_SIZE);
+	flight->ft = pn->selected_filetype;
+	flight->extension = pn->extension;
+	if (pn->sparse_name != NULL) {
+		flight->sparse_name = owstrdup(pn->sparse_name);
+		if (flight->sparse_name == NULL) {
+			owfree(flight);
+			READFLIGHTUNLOCK(in);
+			return FS_r_device_locked(owq);
+		}
+	}
+	flight->size = OWQ_size(owq);
+	flight->offset = OWQ_offset(owq);
+	flight->control_flags = pn->control_flags;
+	flight->state = pn->state;
+	my_pthread_cond_init(&(flight->cond), NULL);
+	flight->next = in->read_flights;
+	in->read_flights = flight;
+	READFLIGHTUNLOCK(in);
+
+	read_or_error = FS_r_device_locked(owq);
+
+	READFLIGHTLOCK(in);
+	// unlink -- requests from now on start a fresh read
+	for (prior = &(in->read_flights); *prior != flight; prior = &((*prior)->next)) {
+	}
+	*prior = flight->next;
+	flight->ret = read_or_error;
+	flight->done = 1;
+	if (flight->waiters == 0) {
+		FS_read_flight_free(flight);
+	} else {
+		if (read_or_error > 0) {
+			flight->buffer = owmalloc(read_or_error);
+			if (flight->buffer != NULL) {
+				memcpy(flight->buffer, OWQ_buffer(owq), read_or_error);
+			}
+		}
+		if (pn->extension == EXTENSION_ALL) {
+			// internal callers use the values as well as the text
+			size_t array_size = pn->selected_filetype->ag->elements * sizeof(union value_object);
+			if (read_or_error >= 0 && OWQ_array(owq) != NULL) {
+				flight->array = owmalloc(array_size);
+				if (flight->array != NULL) {
+					memcpy(flight->array, OWQ_array(owq), array_size);
+				}
+			}
+		} else {
+			flight->val = OWQ_val(owq);
+		}
+		pthread_cond_broadcast(&(flight->cond));
+	}
+	READFLIGHTUNLOCK(in);
+	return read_or_error;
+}
+
+#else							/* OW_MT */
+
+static SIZE_OR_ERROR FS_r_single_flight(struct one_wire_query *owq)
+{
+	return FS_r_device_locked(owq);
+}
+
+#endif							/* OW_MT */
+
 // This function should return number of bytes read... not status.
 // Works for all the virtual directories, like statistics, interface, ...
 // Doesn't need three-peat and bus was already set or not needed.
@@ -802,6 +1028,112 @@ static ZERO_OR_ERROR FS_read_a_part( struct one_wire_query *owq_part )
 	return 0 ;
 }
 
+/* Read a list of already parsed queries (owserver multiget, owcapi OW_multiget)
+   Queries for the same device on the same bus are read back to back
+   while the device is locked once for the whole group.
+   read_or_error[i] gets the result for owq[i] */
+void FS_read_batch( struct one_wire_query ** owq, SIZE_OR_ERROR * read_or_error, int count )
+{
+	struct batch_entry * order ;
+	int start = 0 ;
+	int index ;
+
+	if ( count < 1 ) {
+		return ;
+	}
+
+	order = owmalloc( count * sizeof(struct batch_entry) ) ;
+	if ( order == NULL ) {
+		// no room to sort -- plain reads in the order given
+		for ( index = 0 ; index < count ; ++index ) {
+			read_or_error[index] = FS_read_postparse( owq[index] ) ;
+		}
+		return ;
+	}
+
+	for ( index = 0 ; index < count ; ++index ) {
+		order[index].owq = owq[index] ;
+		order[index].index = index ;
+	}
+	qsort( order, count, sizeof(struct batch_entry), FS_read_batch_compare ) ;
+
+	while ( start < count ) {
+		struct parsedname * pn_holder = NO_PARSEDNAME ; // query owning the group's device lock
+		struct connection_in * in_holder = NO_CONNECTION ; // bus whose device tree holds that lock
+		int end = start + 1 ;
+
+		while ( end < count && FS_read_batch_same_device( PN(order[start].owq), PN(order[end].owq) ) ) {
+			++end ;
+		}
+
+		for ( index = start ; index < end ; ++index ) {
+			struct parsedname * pn = PN(order[index].owq) ;
+
+			if ( end - start > 1 ) {
+				if ( pn_holder != NO_PARSEDNAME ) {
+					// borrow the group lock -- FS_r_given_bus will not lock again
+					pn->lock = pn_holder->lock ;
+				} else if ( DeviceLockGet(pn) == 0 && pn->lock != NULL ) {
+					pn_holder = pn ;
+					in_holder = pn->selected_connection ;
+				}
+			}
+			read_or_error[order[index].index] = FS_read_postparse( order[index].owq ) ;
+			if ( pn != pn_holder ) {
+				pn->lock = NULL ;
+			}
+		}
+
+		if ( pn_holder != NO_PARSEDNAME ) {
+			// a retry may have found the device on another bus -- release on the one that was locked
+			struct connection_in * in_now = pn_holder->selected_connection ;
+			pn_holder->selected_connection = in_holder ;
+			DeviceLockRelease( pn_holder ) ;
+			pn_holder->selected_connection = in_now ;
+		}
+		start = end ;
+	}
+
+	owfree( order ) ;
+}
+
+/* Sort order for FS_read_batch: real devices grouped by bus, then serial number */
+static int FS_read_batch_compare( const void * a, const void * b )
+{
+	const struct parsedname * pn_a = PN( ((const struct batch_entry *) a)->owq ) ;
+	const struct parsedname * pn_b = PN( ((const struct batch_entry *) b)->owq ) ;
+	int bus_a = (pn_a->type == ePN_real && pn_a->selected_connection != NO_CONNECTION) ? pn_a->selected_connection->index : -1 ;
+	int bus_b = (pn_b->type == ePN_real && pn_b->selected_connection != NO_CONNECTION) ? pn_b->selected_connection->index : -1 ;
+
+	if ( bus_a != bus_b ) {
+		return bus_a < bus_b ? -1 : 1 ;
+	}
+	if ( bus_a < 0 ) {
+		// keep the original order for everything else
+		return ((const struct batch_entry *) a)->index - ((const struct batch_entry *) b)->index ;
+	}
+	return memcmp( pn_a->sn, pn_b->sn, SERIAL_NUMBER_SIZE ) ;
+}
+
+/* Can these two queries share one device lock? */
+static int FS_read_batch_same_device( struct parsedname * pn_a, struct parsedname * pn_b )
+{
+	if ( pn_a->type != ePN_real || pn_b->type != ePN_real ) {
+		return 0 ;
+	}
+	if ( pn_a->selected_device == DeviceSimultaneous || pn_b->selected_device == DeviceSimultaneous ) {
+		return 0 ;
+	}
+	if ( pn_a->selected_connection == NO_CONNECTION || pn_a->selected_connection != pn_b->selected_connection ) {
+		return 0 ;
+	}
+	if ( BusIsServer( pn_a->selected_connection ) ) {
+		// remote device -- the other owserver does the locking
+		return 0 ;
+	}
+	return memcmp( pn_a->sn, pn_b->sn, SERIAL_NUMBER_SIZE ) == 0 ;
+}
+
 /* Used in sibling reads
    Reads locally without locking the bus (since it's already locked)
 */
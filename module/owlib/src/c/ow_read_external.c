@@ -71,6 +71,8 @@ static ZERO_OR_ERROR OW_trees_for_read( char * device, char * property, struct o
 					return -ENOTSUP ;
 				case et_script:
 					return OW_read_external_script( sense_n, property_n, owq ) ;
+				case et_coprocess:
+					return OW_read_external_coprocess( sense_n, property_n, owq ) ;
 				default:
 					return -ENOTSUP ;
 			}
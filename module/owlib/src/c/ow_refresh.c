@@ -0,0 +1,211 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: palfille@earthlink.net
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Background refresh for stale-while-revalidate (--stale_volatile, --stale_stable)
+ * A read answered from an expired cache entry (still within its stale grace)
+ * queues its path here instead of waiting for the bus.
+ * One refresher thread, started on first use, re-reads each queued path uncached,
+ * which puts the new value in the cache.
+ * A path already queued or being read isn't queued again, so a busy sensor costs
+ * one bus read per expiry however many clients ask for it.
+ */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_counters.h"
+
+#if OW_MT
+
+/* Longest queue -- more stale hits just wait for a later one */
+#define REFRESH_QUEUE_MAX	64
+
+struct refresh_entry {
+	struct refresh_entry * next ;
+	char * path ;
+} ;
+
+/* protected by REFRESHLOCK */
+static struct refresh_entry * refresh_head = NULL ;
+static struct refresh_entry * refresh_tail = NULL ;
+static int refresh_queued = 0 ;
+static char * refresh_current = NULL ;	// path being read now
+static int refresh_running = 0 ;
+static int refresh_stop = 0 ;
+static pthread_t refresh_thread ;
+static pthread_cond_t refresh_cond ;	// entry queued, or stop requested
+
+static void * Refresh_loop( void * v ) ;
+static void Refresh_read( const char * path ) ;
+static int Refresh_pending( const char * path ) ;
+
+/* Queue a background read of pn's path (the value in the cache is stale) */
+void RefreshQueue( const struct parsedname * pn )
+{
+	struct refresh_entry * re ;
+
+	REFRESHLOCK ;
+	if ( refresh_stop || Refresh_pending( pn->path ) ) {
+		REFRESHUNLOCK ;
+		return ;
+	}
+	if ( refresh_queued >= REFRESH_QUEUE_MAX ) {
+		REFRESHUNLOCK ;
+		STAT_ADD1( cache_stale_dropped ) ;
+		return ;
+	}
+	if ( ! refresh_running ) {
+		my_pthread_cond_init( &refresh_cond, NULL ) ;
+		if ( pthread_create( &refresh_thread, DEFAULT_THREAD_ATTR, Refresh_loop, NULL ) != 0 ) {
+			ERROR_DEBUG("Cannot start the background refresh thread") ;
+			my_pthread_cond_destroy( &refresh_cond ) ;
+			REFRESHUNLOCK ;
+			STAT_ADD1( cache_stale_dropped ) ;
+			return ;
+		}
+		refresh_running = 1 ;
+	}
+
+	re = owmalloc( sizeof(struct refresh_entry) ) ;
+	if ( re == NULL ) {
+		REFRESHUNLOCK ;
+		return ;
+	}
+	re->path = owstrdup( pn->path ) ;
+	if ( re->path == NULL ) {
+		owfree( re ) ;
+		REFRESHUNLOCK ;
+		return ;
+	}
+	re->next = NULL ;
+	if ( refresh_tail == NULL ) {
+		refresh_head = re ;
+	} else {
+		refresh_tail->next = re ;
+	}
+	refresh_tail = re ;
+	++refresh_queued ;
+	my_pthread_cond_signal( &refresh_cond ) ;
+	REFRESHUNLOCK ;
+	LEVEL_DEBUG("Background refresh of %s queued",pn->path) ;
+}
+
+/* Already queued or being read? */
+/* called with REFRESHLOCK */
+static int Refresh_pending( const char * path )
+{
+	struct refresh_entry * re ;
+
+	if ( refresh_current != NULL && strcmp( refresh_current, path ) == 0 ) {
+		return 1 ;
+	}
+	for ( re = refresh_head ; re != NULL ; re = re->next ) {
+		if ( strcmp( re->path, path ) == 0 ) {
+			return 1 ;
+		}
+	}
+	return 0 ;
+}
+
+static void * Refresh_loop( void * v )
+{
+	(void) v ;
+
+	REFRESHLOCK ;
+	while (1) {
+		struct refresh_entry * re = refresh_head ;
+
+		if ( refresh_stop ) {
+			break ;
+		}
+		if ( re == NULL ) {
+			my_pthread_cond_wait( &refresh_cond, &Mutex.refresh_mutex ) ;
+			continue ;
+		}
+		refresh_head = re->next ;
+		if ( refresh_head == NULL ) {
+			refresh_tail = NULL ;
+		}
+		--refresh_queued ;
+		refresh_current = re->path ;
+		REFRESHUNLOCK ;
+
+		Refresh_read( re->path ) ;
+
+		REFRESHLOCK ;
+		refresh_current = NULL ;
+		owfree( re->path ) ;
+		owfree( re ) ;
+	}
+	REFRESHUNLOCK ;
+	return VOID_RETURN ;
+}
+
+/* Uncached read, so the fresh value replaces the stale one in the cache */
+static void Refresh_read( const char * path )
+{
+	struct one_wire_query * owq = OWQ_create_from_path( path ) ;
+
+	if ( owq == NO_ONE_WIRE_QUERY ) {
+		LEVEL_DEBUG("Background refresh: cannot parse %s",path) ;
+		return ;
+	}
+	PN(owq)->state |= ePS_uncached ;
+	if ( FS_read_postparse( owq ) < 0 ) {
+		LEVEL_DEBUG("Background refresh of %s failed",path) ;
+	} else {
+		STAT_ADD1( cache_stale_refreshes ) ;
+	}
+	OWQ_destroy( owq ) ;
+}
+
+/* Stop the refresher (after its current read) and drop the queue */
+void RefreshStop( void )
+{
+	int running ;
+
+	REFRESHLOCK ;
+	refresh_stop = 1 ;
+	running = refresh_running ;
+	if ( running ) {
+		my_pthread_cond_signal( &refresh_cond ) ;
+	}
+	REFRESHUNLOCK ;
+
+	if ( running ) {
+		pthread_join( refresh_thread, NULL ) ;
+		my_pthread_cond_destroy( &refresh_cond ) ;
+		refresh_running = 0 ;
+	}
+
+	while ( refresh_head != NULL ) {
+		struct refresh_entry * re = refresh_head ;
+		refresh_head = re->next ;
+		owfree( re->path ) ;
+		owfree( re ) ;
+	}
+	refresh_tail = NULL ;
+	refresh_queued = 0 ;
+}
+
+#else /* OW_MT */
+
+/* Without threads there is no refresher, and no stale grace (see StaleGrace in ow_cache.c) */
+void RefreshQueue( const struct parsedname * pn )
+{
+	(void) pn ;
+}
+
+void RefreshStop( void )
+{
+}
+
+#endif /* OW_MT */
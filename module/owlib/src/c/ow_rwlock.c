@@ -12,6 +12,10 @@ $Id$
 /* locks are to handle multithreading */
 
 #include <config.h>
+#if HAVE_RWLOCK_PREFER_WRITER
+#define _GNU_SOURCE				// for pthread_rwlockattr_setkind_np
+#endif							/* HAVE_RWLOCK_PREFER_WRITER */
+
 #include "owfs_config.h"
 #include "ow.h"
 
@@ -19,52 +23,53 @@ $Id$
 
 void my_rwlock_init(my_rwlock_t * my_rwlock)
 {
-	_MUTEX_INIT(my_rwlock->protect_reader_count);
-	sem_init(&(my_rwlock->allow_readers), 0, 1);
-	sem_init(&(my_rwlock->no_processes), 0, 1);
-	my_rwlock->reader_count = 1;
+	my_pthread_rwlock_init(my_rwlock);
 }
 
-inline void my_rwlock_write_lock(my_rwlock_t * my_rwlock)
+/* Writers go ahead of new readers -- only for locks never read-locked recursively */
+/* Falls back to the default lock if the C library has no way to ask */
+void my_rwlock_init_writer(my_rwlock_t * my_rwlock)
 {
-	sem_wait(&(my_rwlock->allow_readers));
+#if HAVE_RWLOCK_PREFER_WRITER
+	pthread_rwlockattr_t attr ;
 
-	sem_wait(&(my_rwlock->no_processes));
+	if ( pthread_rwlockattr_init( &attr ) == 0 ) {
+		int mrc ;
+		pthread_rwlockattr_setkind_np( &attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP ) ;
+		mrc = pthread_rwlock_init( my_rwlock, &attr ) ;
+		pthread_rwlockattr_destroy( &attr ) ;
+		if ( mrc != 0 ) {
+			FATAL_ERROR( rwlock_init_failed, mrc, strerror(mrc) ) ;
+		}
+		return ;
+	}
+#endif							/* HAVE_RWLOCK_PREFER_WRITER */
+	my_pthread_rwlock_init(my_rwlock);
 }
 
-inline void my_rwlock_write_unlock(my_rwlock_t * my_rwlock)
+void my_rwlock_write_lock(my_rwlock_t * my_rwlock)
 {
-	sem_post(&(my_rwlock->allow_readers));
-
-	sem_post(&(my_rwlock->no_processes));
+	my_pthread_rwlock_wrlock(my_rwlock);
 }
 
-inline void my_rwlock_read_lock(my_rwlock_t * my_rwlock)
+void my_rwlock_write_unlock(my_rwlock_t * my_rwlock)
 {
-	sem_wait(&(my_rwlock->allow_readers));
-	sem_post(&(my_rwlock->allow_readers));
+	my_pthread_rwlock_unlock(my_rwlock);
+}
 
-	_MUTEX_LOCK(my_rwlock->protect_reader_count);
-	if (++my_rwlock->reader_count == 1) {
-		sem_wait(&(my_rwlock->no_processes));
-	}
-	_MUTEX_UNLOCK(my_rwlock->protect_reader_count);
+void my_rwlock_read_lock(my_rwlock_t * my_rwlock)
+{
+	my_pthread_rwlock_rdlock(my_rwlock);
 }
 
-inline void my_rwlock_read_unlock(my_rwlock_t * my_rwlock)
+void my_rwlock_read_unlock(my_rwlock_t * my_rwlock)
 {
-	_MUTEX_LOCK(my_rwlock->protect_reader_count);
-	if (--my_rwlock->reader_count == 0) {
-		sem_post(&(my_rwlock->no_processes));
-	}
-	_MUTEX_UNLOCK(my_rwlock->protect_reader_count);
+	my_pthread_rwlock_unlock(my_rwlock);
 }
 
 void my_rwlock_destroy(my_rwlock_t * my_rwlock)
 {
-	_MUTEX_DESTROY(my_rwlock->protect_reader_count);
-	sem_destroy(&(my_rwlock->allow_readers));
-	sem_destroy(&(my_rwlock->no_processes));
+	my_pthread_rwlock_destroy(my_rwlock);
 }
 
 #endif							/* OW_MT */
@@ -20,6 +20,7 @@ $Id$
 static void Server_setroutines(struct interface_routines *f);
 static void Zero_setroutines(struct interface_routines *f);
 static void Server_close(struct connection_in *in);
+static void Server_pool_setup(struct connection_in *in);
 
 static void Server_setroutines(struct interface_routines *f)
 {
@@ -73,6 +74,7 @@ GOOD_OR_BAD Zero_detect(struct port_in *pin)
 	in->Adapter = adapter_tcp;
 	in->adapter_name = "tcp";
 	Zero_setroutines(&(in->iroutines));
+	Server_pool_setup(in);
 	return gbGOOD;
 }
 
@@ -93,6 +95,7 @@ GOOD_OR_BAD Server_detect(struct port_in *pin)
 	in->adapter_name = "tcp";
 	pin->busmode = bus_server;
 	Server_setroutines(&(in->iroutines));
+	Server_pool_setup(in);
 	return gbGOOD;
 }
 
@@ -100,7 +103,160 @@ GOOD_OR_BAD Server_detect(struct port_in *pin)
 // actual connections opened and closed independently
 static void Server_close(struct connection_in *in)
 {
+	struct master_server * ms = &(in->master.server) ;
+
+	Server_pipeline_close(in) ;
+	while ( ms->pool_count > 0 ) {
+		--ms->pool_count ;
+		Test_and_Close( &(ms->pool[ms->pool_count].file_descriptor) ) ;
+	}
+	SAFEFREE(ms->pool) ;
+	ms->pool_size = 0 ;
 	SAFEFREE(in->master.server.type) ;
 	SAFEFREE(in->master.server.domain) ;
 	SAFEFREE(in->master.server.name) ;
 }
+
+/* Pool of idle persistent connections to the owserver
+ * Kept oldest first, so expired entries are always at the front
+ * and the most recently used (warmest) connection is handed out next.
+ * Protected by the bus lock of the connection_in
+ * */
+static void Server_pool_setup(struct connection_in *in)
+{
+	struct port_in * pin = in->pown ;
+	struct master_server * ms = &(in->master.server) ;
+
+	ms->pool = NULL ;
+	ms->pool_size = 0 ;
+	ms->pool_count = 0 ;
+	if ( Globals.connections_pool > 0 ) {
+		ms->pool = owmalloc( Globals.connections_pool * sizeof(struct server_pool_entry) ) ;
+		if ( ms->pool != NULL ) {
+			ms->pool_size = Globals.connections_pool ;
+		}
+	}
+
+	// tcp_open already made a first connection -- park it
+	if ( FILE_DESCRIPTOR_VALID( pin->file_descriptor ) ) {
+		Server_pool_put( in, pin->file_descriptor ) ;
+		pin->file_descriptor = FILE_DESCRIPTOR_BAD ;
+	}
+}
+
+// Take an idle connection from the pool
+// Returns FILE_DESCRIPTOR_BAD if none is available, caller should make a new connection
+FILE_DESCRIPTOR_OR_ERROR Server_pool_get(struct connection_in *in)
+{
+	struct master_server * ms = &(in->master.server) ;
+
+	while (1) {
+		FILE_DESCRIPTOR_OR_ERROR file_descriptor = FILE_DESCRIPTOR_BAD ;
+		time_t now = NOW_TIME ;
+		time_t oldest = now - Globals.timeout_pool ;
+		int expired = 0 ;
+		int recent = 0 ;
+
+		BUSLOCKIN(in) ;
+		while ( expired < ms->pool_count && ms->pool[expired].idle_since < oldest ) {
+			Test_and_Close( &(ms->pool[expired].file_descriptor) ) ;
+			++expired ;
+		}
+		if ( expired > 0 ) {
+			ms->pool_count -= expired ;
+			memmove( ms->pool, &(ms->pool[expired]), ms->pool_count * sizeof(struct server_pool_entry) ) ;
+		}
+		if ( ms->pool_count > 0 ) {
+			--ms->pool_count ;
+			file_descriptor = ms->pool[ms->pool_count].file_descriptor ;
+			// parked less than timeout_pool_check ago -- too soon for the server to have timed it out,
+			// so skip the check (only a server restart in that window costs a failed request)
+			recent = ( now - ms->pool[ms->pool_count].idle_since < Globals.timeout_pool_check ) ;
+		}
+		BUSUNLOCKIN(in) ;
+
+		if ( expired > 0 ) {
+			STAT_ADD( server_pool_expired, expired ) ;
+		}
+		if ( FILE_DESCRIPTOR_NOT_VALID( file_descriptor ) ) {
+			STAT_ADD1( server_pool_misses ) ;
+			return FILE_DESCRIPTOR_BAD ;
+		}
+		if ( recent || GOOD( Server_pool_alive( file_descriptor ) ) ) {
+			STAT_ADD1( server_pool_hits ) ;
+			return file_descriptor ;
+		}
+
+		// Server closed it while idle, try the next one
+		LEVEL_DEBUG("Pooled server connection was closed.");
+		STAT_ADD1( server_pool_stale ) ;
+		Test_and_Close( &file_descriptor ) ;
+	}
+}
+
+// Return a connection to the pool, closing it if the pool is full
+void Server_pool_put(struct connection_in *in, FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	struct master_server * ms = &(in->master.server) ;
+
+	BUSLOCKIN(in) ;
+	if ( ms->pool_count < ms->pool_size ) {
+		ms->pool[ms->pool_count].file_descriptor = file_descriptor ;
+		ms->pool[ms->pool_count].idle_since = NOW_TIME ;
+		++ms->pool_count ;
+		file_descriptor = FILE_DESCRIPTOR_BAD ;
+	}
+	BUSUNLOCKIN(in) ;
+
+	if ( FILE_DESCRIPTOR_VALID( file_descriptor ) ) {
+		STAT_ADD1( server_pool_full ) ;
+		Test_and_Close( &file_descriptor ) ;
+	}
+}
+
+// Check if the server closed the connection
+// This is contributed by Jacob Joseph to fix a timeout problem.
+// http://permalink.gmane.org/gmane.comp.file-systems.owfs.devel/7306
+GOOD_OR_BAD Server_pool_alive(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	BYTE test_read[1] ;
+	ssize_t rcv_value ;
+	int saved_errno = 0 ;
+
+#ifdef MSG_DONTWAIT
+	// non-blocking for this call only -- one system call, socket flags untouched
+	rcv_value = recv( file_descriptor, test_read, 1, MSG_PEEK | MSG_DONTWAIT ) ; // test read the socket to see if closed
+	saved_errno = errno ;
+#else /* MSG_DONTWAIT */
+	int old_flags ;
+
+	old_flags = fcntl( file_descriptor, F_GETFL, 0 ) ; // save socket flags
+	if ( old_flags == -1 ) {
+		return gbBAD ;
+	}
+	if ( fcntl( file_descriptor, F_SETFL, old_flags | O_NONBLOCK ) == -1 ) { // set non-blocking
+		return gbBAD ;
+	}
+	rcv_value = recv( file_descriptor, test_read, 1, MSG_PEEK ) ; // test read the socket to see if closed
+	saved_errno = errno ;
+	if ( fcntl( file_descriptor, F_SETFL, old_flags ) == -1 ) { // restore  socket flags
+		return gbBAD ;
+	}
+#endif /* MSG_DONTWAIT */
+
+	switch ( rcv_value ) {
+		case -1:
+			if ( saved_errno==EAGAIN || saved_errno==EWOULDBLOCK ) {
+				// No data to be read -- so connection healthy
+				return gbGOOD ;
+			}
+			// real error
+			return gbBAD ;
+		case 0:
+			// orderly shutdown by the server
+			return gbBAD ;
+		default:
+			// data to be read, so a good connection
+			return gbGOOD ;
+	}
+}
@@ -55,7 +55,7 @@ static void OWServer_Enet_setroutines(struct connection_in *in)
 	in->iroutines.reconnect = NO_RECONNECT_ROUTINE;
 	in->iroutines.close = OWServer_Enet_close;
 	in->iroutines.flags = ADAP_FLAG_dirgulp | ADAP_FLAG_no2409path | ADAP_FLAG_overdrive | ADAP_FLAG_bundle | ADAP_FLAG_no2404delay ;
-	in->bundling_length = ENET_FIFO_SIZE;
+	in->iroutines.bundling_length = ENET_FIFO_SIZE;
 }
 
 GOOD_OR_BAD OWServer_Enet_detect(struct port_in *pin)
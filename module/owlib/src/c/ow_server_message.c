@@ -18,11 +18,46 @@ $Id$
 #include "ow_connection.h"
 #include "ow_standard.h" // for FS_?_alias
 
+/* A request sent on the bus's pipelined connection, waiting for its reply */
+struct server_pipeline_request {
+	struct server_pipeline * pipeline ;
+	int32_t tag ;
+	int done ; // reply arrived (and the request is off the waiting list)
+	struct client_msg cm ; // the reply
+	BYTE * payload ; // reply payload (null terminated) or NULL
+	struct server_pipeline_request * next ; // waiting list
+} ;
+
 struct server_connection_state {
 	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
 	enum persistent_state { persistent_yes, persistent_no, } persistence ;
 	struct connection_in * in ;
+	int pipeline_offer ; // this request offers the pipelined protocol
+	int pipeline_reply ; // and the server answered in kind
+	struct server_pipeline_request * pipelined ; // sent on the pipelined connection instead
+	struct server_pipeline_request request ;
+} ;
+
+#if OW_MT
+/* Pipelined connection to an owserver (protocol in ow_message.h)
+ * One socket per remote bus shared by all threads.
+ * Requests are written whole under write_mutex and wait on the list for their tag.
+ * Whichever waiting thread finds no reader becomes the reader, and hands each
+ * reply to the matching request until its own has arrived.
+ */
+struct server_pipeline {
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
+	pthread_mutex_t write_mutex ; // whole requests on the socket
+	pthread_mutex_t mutex ; // protects the rest
+	pthread_cond_t cond ; // a reply was handed over or the reader is done
+	int references ; // the bus plus each request in progress
+	int reading ; // a thread is reading replies
+	int broken ; // read or write failed, no use any more
+	UINT next_tag ;
+	struct server_pipeline_request * requests ; // waiting for a reply
+	time_t last_reply ; // when the server last answered (skip the idle check right after)
 } ;
+#endif /* OW_MT */
 
 struct directory_element_structure {
 	const struct parsedname * pn_whole_directory ;
@@ -44,7 +79,13 @@ static void Close_Persistent( struct server_connection_state * scs) ;
 static void Release_Persistent( struct server_connection_state * scs, int granted ) ;
 
 static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp) ;
-static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp);
+static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp, int protocol, const int32_t * tag);
+
+static int Pipeline_Wanted( struct connection_in * in ) ;
+static GOOD_OR_BAD Pipeline_Send( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp) ;
+static GOOD_OR_BAD Pipeline_Wait( struct server_connection_state * scs, struct client_msg *cm ) ;
+static void Pipeline_Finish( struct server_connection_state * scs ) ;
+static void Pipeline_Create( struct connection_in * in, FILE_DESCRIPTOR_OR_ERROR file_descriptor ) ;
 
 static SIZE_OR_ERROR From_Server( struct server_connection_state * scs, struct client_msg *cm, char *msg, size_t size) ;
 static void *From_ServerAlloc(struct server_connection_state * scs, struct client_msg *cm) ;
@@ -89,6 +130,10 @@ SIZE_OR_ERROR ServerRead(struct one_wire_query *owq)
 		Release_Persistent( &scs, 0);
 		return -EIO ;
 	}
+	if ( cm.ret >= 0 && (cm.control_flags & STALE_VALUE) ) {
+		// remote answered from its stale cache -- pass that on
+		pn_file_entry->control_flags |= STALE_VALUE ;
+	}
 	Release_Persistent( &scs, cm.control_flags & PERSISTENT_MASK);
 	return cm.ret;
 }
@@ -170,7 +215,7 @@ ZERO_OR_ERROR ServerWrite(struct one_wire_query *owq)
 		return -EIO ;
 	}
 	{
-		int32_t control_flags = cm.control_flags & ~(SHOULD_RETURN_BUS_LIST | PERSISTENT_MASK | SAFEMODE);
+		int32_t control_flags = cm.control_flags & ~(SHOULD_RETURN_BUS_LIST | PERSISTENT_MASK | SAFEMODE | STALE_VALUE);
 		// keep current safemode
 		control_flags |=  LocalControlFlags & SAFEMODE ;
 		CONTROLFLAGSLOCK;
@@ -432,6 +477,19 @@ static void *From_ServerAlloc(struct server_connection_state * scs, struct clien
 	struct timeval tv = { Globals.timeout_network + 1, 0, };
 	size_t actual_size ;
 
+	if ( scs->pipelined != NULL ) {
+		// reply already read in full by the pipeline
+		if ( BAD( Pipeline_Wait( scs, cm ) ) ) {
+			return NO_PATH ;
+		}
+		if ( cm->payload <= 0 || cm->ret < 0 ) {
+			return NO_PATH ;
+		}
+		msg = scs->pipelined->payload ;
+		scs->pipelined->payload = NULL ;
+		return msg ;
+	}
+
 	do {						/* loop until non delay message (payload>=0) */
 		tcp_read(scs->file_descriptor, (BYTE *) cm, sizeof(struct client_msg), &tv, &actual_size);
 		if (actual_size != sizeof(struct client_msg)) {
@@ -439,12 +497,14 @@ static void *From_ServerAlloc(struct server_connection_state * scs, struct clien
 			cm->ret = -EIO;
 			return NO_PATH;
 		}
+		cm->version = ntohl(cm->version);
 		cm->payload = ntohl(cm->payload);
 		cm->size = ntohl(cm->size);
 		cm->ret = ntohl(cm->ret);
 		cm->control_flags = ntohl(cm->control_flags);
 		cm->offset = ntohl(cm->offset);
 	} while (cm->payload < 0);
+	scs->pipeline_reply = ( Serverprotocol(cm->version) >= OWSERVER_PROTOCOL_PIPELINE ) ;
 
 	if (cm->payload == 0) {
 		return NO_PATH;
@@ -481,6 +541,21 @@ static SIZE_OR_ERROR From_Server( struct server_connection_state * scs, struct c
 	size_t actual_read ;
 	struct timeval tv = { Globals.timeout_network + 1, 0, };
 
+	if ( scs->pipelined != NULL ) {
+		// reply already read in full by the pipeline, so an oversized one is just cut short
+		if ( BAD( Pipeline_Wait( scs, cm ) ) ) {
+			return -EIO ;
+		}
+		if ( cm->payload <= 0 ) {
+			return 0 ;
+		}
+		rtry = cm->payload < (ssize_t) size ? (size_t) cm->payload : size;
+		if ( rtry > 0 ) {
+			memcpy( msg, scs->pipelined->payload, rtry ) ;
+		}
+		return rtry ;
+	}
+
 	do {						// read regular header, or delay (delay when payload<0)
 		tcp_read(scs->file_descriptor, (BYTE *) cm, sizeof(struct client_msg), &tv, &actual_read);
 		if (actual_read != sizeof(struct client_msg)) {
@@ -489,12 +564,14 @@ static SIZE_OR_ERROR From_Server( struct server_connection_state * scs, struct c
 			return -EIO;
 		}
 
+		cm->version = ntohl(cm->version);
 		cm->payload = ntohl(cm->payload);
 		cm->size = ntohl(cm->size);
 		cm->ret = ntohl(cm->ret);
 		cm->control_flags = ntohl(cm->control_flags);
 		cm->offset = ntohl(cm->offset);
 	} while (cm->payload < 0);	// flag to show a delay message
+	scs->pipeline_reply = ( Serverprotocol(cm->version) >= OWSERVER_PROTOCOL_PIPELINE ) ;
 
 	if (cm->payload == 0) {
 		return 0;				// No payload, done.
@@ -516,83 +593,35 @@ static SIZE_OR_ERROR From_Server( struct server_connection_state * scs, struct c
 static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp)
 {
 	struct connection_in * in = scs->in ; // for convenience
-	struct port_in * pin = in->pown ;
-	BYTE test_read[1] ;
-	int old_flags ;
-	ssize_t rcv_value ;
-	int saved_errno ;
+	
+	int protocol = OWSERVER_PROTOCOL_VERSION ;
 	
 	// initialize the variables
 	scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
-	scs->persistence = Globals.no_persistence ? persistent_no : persistent_yes ;
-
-	// First set up the file descriptor based on persistent state
-	if (scs->persistence == persistent_no) {		
-		// no persistence wanted
-		scs->file_descriptor = ClientConnect(in);
-	} else {
-		// Persistence desired
-		BUSLOCKIN(in);
-		switch ( pin->file_descriptor ) {
-			case FILE_DESCRIPTOR_PERSISTENT_IN_USE:
-				// Currently in use, so make new non-persistent connection
-				scs->file_descriptor = ClientConnect(in);
-				scs->persistence = persistent_no ;
-				break ;
-			case FILE_DESCRIPTOR_BAD:
-				// no conection currently, so make a new one
-				scs->file_descriptor = ClientConnect(in);
-				if ( FILE_DESCRIPTOR_VALID( scs->file_descriptor ) ) {
-					pin->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE ;
-				}	
-				break ;
-			default:
-				// persistent connection idle and waiting for use
-				// connection_in is locked so this is safe
-				scs->file_descriptor = pin->file_descriptor;
-				pin->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE;
-			break ;
+	scs->persistence = ( Globals.no_persistence || in->master.server.pool_size == 0 ) ? persistent_no : persistent_yes ;
+	scs->pipeline_offer = 0 ;
+	scs->pipeline_reply = 0 ;
+	scs->pipelined = NULL ;
+
+	// DIR answers in pieces, so it always gets a connection to itself
+	if ( scs->persistence == persistent_yes && sm->type != msg_dir ) {
+		if ( GOOD( Pipeline_Send( scs, sm, sp ) ) ) {
+			return gbGOOD ;
 		}
-		BUSUNLOCKIN(in);
-	}
-	
-	// Check if the server closed the connection
-	// This is contributed by Jacob Joseph to fix a timeout problem.
-	// http://permalink.gmane.org/gmane.comp.file-systems.owfs.devel/7306
-	//rcv_value = recv(scs->file_descriptor, test_read, 1, MSG_DONTWAIT | MSG_PEEK) ;
-	old_flags = fcntl( scs->file_descriptor, F_GETFL, 0 ) ; // save socket flags
-	if ( old_flags == -1 ) {
-		rcv_value = -2 ;
-	} else if ( fcntl( scs->file_descriptor, F_SETFL, old_flags | O_NONBLOCK ) == -1 ) { // set non-blocking
-		rcv_value = -2 ;
-	} else {
-		rcv_value = recv(scs->file_descriptor, test_read, 1, MSG_PEEK) ; // test read the socket to see if closed
-		saved_errno = errno ;
-		if ( fcntl( scs->file_descriptor, F_SETFL, old_flags ) == -1 ) { // restore  socket flags
-			rcv_value = -2 ;
+		// no pipelined connection yet -- ask for one with this request
+		scs->pipeline_offer = Pipeline_Wanted( in ) ;
+		if ( scs->pipeline_offer ) {
+			protocol = OWSERVER_PROTOCOL_PIPELINE ;
 		}
 	}
 
-	switch ( rcv_value ) {
-		case -1:
-			if ( saved_errno==EAGAIN || saved_errno==EWOULDBLOCK ) {
-				// No data to be read -- so connection healthy
-				break ;
-			}
-			// real error, fall through to close connection case
-		case -2:
-			// fnctl error, fall through again
-		case 0:
-			LEVEL_DEBUG("Server connection was closed.  Reconnecting.");
-			Close_Persistent( scs);
-			scs->file_descriptor = ClientConnect(in);
-			if ( FILE_DESCRIPTOR_VALID( scs->file_descriptor ) ) {
-				in->pown->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE ;
-			}
-			break ;
-		default:
-			// data to be read, so a good connection
-			break ;
+	// First set up the file descriptor based on persistent state
+	if (scs->persistence == persistent_yes) {
+		// Persistence desired -- reuse a healthy idle connection if the pool has one
+		scs->file_descriptor = Server_pool_get(in);
+	}
+	if ( FILE_DESCRIPTOR_NOT_VALID( scs->file_descriptor ) ) {
+		scs->file_descriptor = ClientConnect(in);
 	}
 
 	// Now test
@@ -603,7 +632,7 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 	}
 
 	// Do the real work
-	if (WriteToServer(scs->file_descriptor, sm, sp) >= 0) {
+	if (WriteToServer(scs->file_descriptor, sm, sp, protocol, NULL) >= 0) {
 		// successful message
 		return gbGOOD;
 	}
@@ -617,6 +646,7 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 	
 	// perhaps the persistent connection is stale?
 	// Make a new one
+	Test_and_Close( &(scs->file_descriptor) ) ;
 	scs->file_descriptor = ClientConnect(in) ;
 
 	// Now retest
@@ -627,10 +657,8 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 		return gbBAD ;
 	}
 	
-	// Leave in->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE
-
 	// Second attempt at the write, now with new connection
-	if (WriteToServer(scs->file_descriptor, sm, sp) >= 0) {
+	if (WriteToServer(scs->file_descriptor, sm, sp, protocol, NULL) >= 0) {
 		// successful message
 		return gbGOOD;
 	}
@@ -640,36 +668,39 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 	return gbBAD ;
 }
 
+// Drop the connection rather than returning it to the pool
 static void Close_Persistent( struct server_connection_state * scs)
 {
-	// First set up the file descriptor based on persistent state
-	if (scs->persistence == persistent_yes) {
-		// no persistence wanted
-		BUSLOCKIN(scs->in);
-			scs->in->pown->file_descriptor = FILE_DESCRIPTOR_BAD ;
-		BUSUNLOCKIN(scs->in);
-	}
-	
 	scs->persistence = persistent_no ;
 	Test_and_Close( &(scs->file_descriptor) ) ;
 }
 
 // should be const char * data but iovec has problems with const arguments
-static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp)
+// tag is sent after the header on a pipelined connection (NULL otherwise)
+static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp, int protocol, const int32_t * tag)
 {
 	int payload = 0;
 	int tokens = 0;
 	int nio = 0;
 	int traffic_counter ;
 	int server_type = Globals.program_type==program_type_server || Globals.program_type==program_type_external ;
-	struct iovec io[5] = { {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, };
+	struct iovec io[6] = { {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, };
 	struct server_msg net_sm ;
+	int32_t net_tag ;
 
 	// First block to send, the header
 	io[nio].iov_base = &net_sm;
 	io[nio].iov_len = sizeof(struct server_msg);
 	nio++;
 
+	// pipelined request tag
+	if ( tag != NULL ) {
+		net_tag = htonl( tag[0] ) ;
+		io[nio].iov_base = &net_tag;
+		io[nio].iov_len = sizeof(int32_t);
+		nio++;
+	}
+
 	// Next block, the path
 	if (sp->path != 0) {	// send path (if not null)
 #pragma GCC diagnostic push
@@ -689,7 +720,7 @@ static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, s
 		nio++;
 	}
 
-	sm->version = MakeServerprotocol(OWSERVER_PROTOCOL_VERSION);
+	sm->version = MakeServerprotocol(protocol);
 	if ( server_type ) {
 		tokens = sp->tokens;
 		sm->version |= MakeServermessage;
@@ -719,6 +750,10 @@ static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, s
 
 	traffic_counter = 0 ;
 	TrafficOutFD("write header" ,io[traffic_counter].iov_base,io[traffic_counter].iov_len,file_descriptor);
+	if ( tag != NULL ) {
+		++traffic_counter;
+		TrafficOutFD("write tag" ,io[traffic_counter].iov_base,io[traffic_counter].iov_len,file_descriptor);
+	}
 	++traffic_counter;
 	TrafficOutFD("write path"  ,io[traffic_counter].iov_base,io[traffic_counter].iov_len,file_descriptor);
 	if ((sp->datasize>0) && (sp->data!=NULL)) {	// send data only for writes (if datasize not zero)
@@ -734,7 +769,10 @@ static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, s
 		TrafficOutFD("write new tokens" ,io[traffic_counter].iov_base,io[traffic_counter].iov_len,file_descriptor);
 	}
 
-	return writev(file_descriptor, io, nio) != (ssize_t) (payload + sizeof(struct server_msg) + tokens * sizeof(union antiloop));
+	if ( writev(file_descriptor, io, nio) != (ssize_t) (payload + sizeof(struct server_msg) + (tag ? sizeof(int32_t) : 0) + tokens * sizeof(union antiloop)) ) {
+		return -EIO ;
+	}
+	return 0 ;
 }
 
 /* flag the sg for "virtual root" -- the remote bus was specifically requested */
@@ -750,6 +788,9 @@ static uint32_t SetupControlFlags(const struct parsedname *pn)
 	/* from owlib to owserver never wants alias */
 	control_flags &= ~ALIAS_REQUEST ;
 
+	/* reply-only flag */
+	control_flags &= ~STALE_VALUE ;
+
 	control_flags &= ~SHOULD_RETURN_BUS_LIST;
 	if (SpecifiedBus(pn)) {
 		control_flags |= SHOULD_RETURN_BUS_LIST;
@@ -764,6 +805,12 @@ static uint32_t SetupControlFlags(const struct parsedname *pn)
 */
 static void Release_Persistent( struct server_connection_state * scs, int granted )
 {
+	if ( scs->pipelined != NULL ) {
+		// the pipelined connection stays with the bus
+		Pipeline_Finish( scs ) ;
+		return ;
+	}
+
 	if ( granted == 0 ) {
 		Close_Persistent( scs ) ;
 		return ;
@@ -780,10 +827,349 @@ static void Release_Persistent( struct server_connection_state * scs, int grante
 		return ;
 	}
 
+	if ( scs->pipeline_offer ) {
+		if ( scs->pipeline_reply ) {
+			// server switched this connection to the pipelined protocol
+			Pipeline_Create( scs->in, scs->file_descriptor ) ;
+			scs->persistence = persistent_no ; // we no longer own this connection
+			scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
+			return ;
+		}
+		LEVEL_DEBUG("Server doesn't support the pipelined protocol") ;
+		scs->in->master.server.no_pipeline = 1 ;
+	}
+
 	// mark as available
-	BUSLOCKIN(scs->in);
-	scs->in->pown->file_descriptor = scs->file_descriptor;
-	BUSUNLOCKIN(scs->in);
+	Server_pool_put( scs->in, scs->file_descriptor ) ;
 	scs->persistence = persistent_no ; // we no longer own this connection
 	scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
 }
+
+#if OW_MT
+
+static void Pipeline_Release( struct server_pipeline * pipeline ) ;
+static void Pipeline_Drop( struct connection_in * in, struct server_pipeline * pipeline ) ;
+static GOOD_OR_BAD Pipeline_Read( struct server_pipeline * pipeline ) ;
+
+// Worth offering the pipelined protocol on this request?
+static int Pipeline_Wanted( struct connection_in * in )
+{
+	if ( Globals.no_pipeline || in->master.server.no_pipeline ) {
+		return 0 ;
+	}
+	// unlocked peek -- a second offer is harmless (see Pipeline_Create)
+	return in->master.server.pipeline == NULL ;
+}
+
+// Take over a connection the server has switched to the pipelined protocol
+// The connection is used or closed, never returned to the pool
+static void Pipeline_Create( struct connection_in * in, FILE_DESCRIPTOR_OR_ERROR file_descriptor )
+{
+	struct server_pipeline * pipeline = owcalloc( 1, sizeof(struct server_pipeline) ) ;
+
+	if ( pipeline == NULL ) {
+		Test_and_Close( &file_descriptor ) ;
+		return ;
+	}
+	pipeline->file_descriptor = file_descriptor ;
+	pipeline->references = 1 ; // the bus
+	pipeline->last_reply = NOW_TIME ;
+	_MUTEX_INIT( pipeline->write_mutex ) ;
+	_MUTEX_INIT( pipeline->mutex ) ;
+	my_pthread_cond_init( &(pipeline->cond), NULL ) ;
+
+	BUSLOCKIN(in) ;
+	if ( in->master.server.pipeline == NULL ) {
+		in->master.server.pipeline = pipeline ;
+		pipeline = NULL ;
+	}
+	BUSUNLOCKIN(in) ;
+
+	if ( pipeline == NULL ) {
+		LEVEL_DEBUG("Pipelined connection to server established") ;
+		STAT_ADD1( server_pipeline_connections ) ;
+	} else {
+		// lost the race to another offer
+		Pipeline_Release( pipeline ) ;
+	}
+}
+
+// Send the request on the bus's pipelined connection, if there is one
+static GOOD_OR_BAD Pipeline_Send( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp)
+{
+	struct connection_in * in = scs->in ;
+	struct server_pipeline_request * spr = &(scs->request) ;
+	struct server_pipeline * pipeline ;
+	SIZE_OR_ERROR write_result ;
+	int stale = 0 ;
+
+	memset( spr, 0, sizeof(struct server_pipeline_request) ) ;
+
+	BUSLOCKIN(in) ;
+	pipeline = in->master.server.pipeline ;
+	if ( pipeline != NULL ) {
+		_MUTEX_LOCK( pipeline->mutex ) ;
+		if ( pipeline->requests == NULL && NOW_TIME - pipeline->last_reply >= Globals.timeout_pool_check && BAD( Server_pool_alive( pipeline->file_descriptor ) ) ) {
+			// idle (for timeout_pool_check or longer), and the server has closed it meanwhile
+			// (no requests in progress, so nobody else is using the socket)
+			pipeline->broken = 1 ;
+			stale = 1 ;
+		} else {
+			++pipeline->references ;
+			spr->pipeline = pipeline ;
+			spr->tag = (int32_t) pipeline->next_tag++ ;
+			spr->next = pipeline->requests ; // waiting before the reply can possibly arrive
+			pipeline->requests = spr ;
+		}
+		_MUTEX_UNLOCK( pipeline->mutex ) ;
+	}
+	BUSUNLOCKIN(in) ;
+
+	if ( stale ) {
+		LEVEL_DEBUG("Pipelined connection was closed by the server.") ;
+		STAT_ADD1( server_pool_stale ) ;
+		Pipeline_Drop( in, pipeline ) ;
+		return gbBAD ;
+	}
+	if ( pipeline == NULL ) {
+		return gbBAD ;
+	}
+	scs->pipelined = spr ;
+
+	_MUTEX_LOCK( pipeline->write_mutex ) ;
+	write_result = WriteToServer( pipeline->file_descriptor, sm, sp, OWSERVER_PROTOCOL_PIPELINE, &(spr->tag) ) ;
+	_MUTEX_UNLOCK( pipeline->write_mutex ) ;
+
+	if ( write_result < 0 ) {
+		// connection lost -- let the caller fall back to an ordinary one
+		LEVEL_DEBUG("Pipelined connection to server failed on write") ;
+		_MUTEX_LOCK( pipeline->mutex ) ;
+		pipeline->broken = 1 ;
+		pthread_cond_broadcast( &(pipeline->cond) ) ;
+		_MUTEX_UNLOCK( pipeline->mutex ) ;
+		Pipeline_Drop( in, pipeline ) ;
+		Pipeline_Finish( scs ) ;
+		return gbBAD ;
+	}
+
+	STAT_ADD1( server_pipeline_requests ) ;
+	return gbGOOD ;
+}
+
+// Wait for the reply to a pipelined request, reading replies for other requests meanwhile
+static GOOD_OR_BAD Pipeline_Wait( struct server_connection_state * scs, struct client_msg *cm )
+{
+	struct server_pipeline_request * spr = scs->pipelined ;
+	struct server_pipeline * pipeline = spr->pipeline ;
+	int done ;
+
+	_MUTEX_LOCK( pipeline->mutex ) ;
+	while ( ! spr->done && ! pipeline->broken ) {
+		GOOD_OR_BAD read_result ;
+
+		if ( pipeline->reading ) {
+			my_pthread_cond_wait( &(pipeline->cond), &(pipeline->mutex) ) ;
+			continue ;
+		}
+
+		// become the reader
+		pipeline->reading = 1 ;
+		_MUTEX_UNLOCK( pipeline->mutex ) ;
+		read_result = Pipeline_Read( pipeline ) ;
+		_MUTEX_LOCK( pipeline->mutex ) ;
+		pipeline->reading = 0 ;
+		if ( BAD( read_result ) ) {
+			pipeline->broken = 1 ;
+		}
+		pthread_cond_broadcast( &(pipeline->cond) ) ;
+	}
+	done = spr->done ;
+	_MUTEX_UNLOCK( pipeline->mutex ) ;
+
+	if ( ! done ) {
+		LEVEL_DEBUG("Pipelined connection to server failed on read") ;
+		Pipeline_Drop( scs->in, pipeline ) ;
+		memset( cm, 0, sizeof(struct client_msg) ) ;
+		cm->ret = -EIO ;
+		return gbBAD ;
+	}
+	memcpy( cm, &(spr->cm), sizeof(struct client_msg) ) ;
+	return gbGOOD ;
+}
+
+// Read one reply and hand it to its request. Caller is the reader.
+static GOOD_OR_BAD Pipeline_Read( struct server_pipeline * pipeline )
+{
+	BYTE header[sizeof(struct client_msg)+sizeof(int32_t)] ;
+	struct client_msg cm ;
+	int32_t tag ;
+	BYTE * payload = NULL ;
+	struct server_pipeline_request ** waiting ;
+	struct timeval tv = { Globals.timeout_network + 1, 0, };
+	size_t actual_read ;
+
+	tcp_read( pipeline->file_descriptor, header, sizeof(header), &tv, &actual_read ) ;
+	if ( actual_read != sizeof(header) ) {
+		return gbBAD ;
+	}
+	memcpy( &cm, header, sizeof(struct client_msg) ) ;
+	memcpy( &tag, &header[sizeof(struct client_msg)], sizeof(int32_t) ) ;
+	cm.version = ntohl(cm.version);
+	cm.payload = ntohl(cm.payload);
+	cm.size = ntohl(cm.size);
+	cm.ret = ntohl(cm.ret);
+	cm.control_flags = ntohl(cm.control_flags);
+	cm.offset = ntohl(cm.offset);
+	tag = ntohl(tag) ;
+
+	if ( cm.payload < 0 ) {
+		// keep-alive for a slow request
+		return gbGOOD ;
+	}
+	if ( cm.payload > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) {
+		return gbBAD ;
+	}
+	if ( cm.payload > 0 ) {
+		payload = owmalloc( (size_t) cm.payload + 1 ) ;
+		if ( payload == NULL ) {
+			return gbBAD ;
+		}
+		tcp_read( pipeline->file_descriptor, payload, (size_t) cm.payload, &tv, &actual_read ) ;
+		if ( (ssize_t) actual_read != cm.payload ) {
+			owfree( payload ) ;
+			return gbBAD ;
+		}
+		payload[cm.payload] = '\0' ; // safety NULL
+	}
+
+	_MUTEX_LOCK( pipeline->mutex ) ;
+	pipeline->last_reply = NOW_TIME ;
+	for ( waiting = &(pipeline->requests) ; waiting[0] != NULL ; waiting = &(waiting[0]->next) ) {
+		struct server_pipeline_request * spr = waiting[0] ;
+		if ( spr->tag == tag ) {
+			waiting[0] = spr->next ;
+			spr->next = NULL ;
+			memcpy( &(spr->cm), &cm, sizeof(struct client_msg) ) ;
+			spr->payload = payload ;
+			payload = NULL ;
+			spr->done = 1 ;
+			break ;
+		}
+	}
+	_MUTEX_UNLOCK( pipeline->mutex ) ;
+
+	if ( payload != NULL ) {
+		LEVEL_DEBUG("Reply for unknown pipelined request %d",(int) tag) ;
+		owfree( payload ) ;
+	}
+	return gbGOOD ;
+}
+
+// Done with a pipelined request (whether or not a reply came)
+static void Pipeline_Finish( struct server_connection_state * scs )
+{
+	struct server_pipeline_request * spr = scs->pipelined ;
+	struct server_pipeline * pipeline = spr->pipeline ;
+
+	_MUTEX_LOCK( pipeline->mutex ) ;
+	if ( ! spr->done ) {
+		struct server_pipeline_request ** waiting ;
+		for ( waiting = &(pipeline->requests) ; waiting[0] != NULL ; waiting = &(waiting[0]->next) ) {
+			if ( waiting[0] == spr ) {
+				waiting[0] = spr->next ;
+				break ;
+			}
+		}
+	}
+	_MUTEX_UNLOCK( pipeline->mutex ) ;
+
+	SAFEFREE( spr->payload ) ;
+	scs->pipelined = NULL ;
+	Pipeline_Release( pipeline ) ;
+}
+
+// Take a failed pipelined connection away from the bus
+static void Pipeline_Drop( struct connection_in * in, struct server_pipeline * pipeline )
+{
+	int drop = 0 ;
+
+	BUSLOCKIN(in) ;
+	if ( in->master.server.pipeline == pipeline ) {
+		in->master.server.pipeline = NULL ;
+		drop = 1 ;
+	}
+	BUSUNLOCKIN(in) ;
+
+	if ( drop ) {
+		Pipeline_Release( pipeline ) ;
+	}
+}
+
+static void Pipeline_Release( struct server_pipeline * pipeline )
+{
+	int last ;
+
+	_MUTEX_LOCK( pipeline->mutex ) ;
+	last = ( --pipeline->references == 0 ) ;
+	_MUTEX_UNLOCK( pipeline->mutex ) ;
+
+	if ( last ) {
+		Test_and_Close( &(pipeline->file_descriptor) ) ;
+		my_pthread_cond_destroy( &(pipeline->cond) ) ;
+		_MUTEX_DESTROY( pipeline->mutex ) ;
+		_MUTEX_DESTROY( pipeline->write_mutex ) ;
+		owfree( pipeline ) ;
+	}
+}
+
+// Bus closing
+void Server_pipeline_close( struct connection_in * in )
+{
+	struct server_pipeline * pipeline = in->master.server.pipeline ;
+
+	if ( pipeline != NULL ) {
+		Pipeline_Drop( in, pipeline ) ;
+	}
+}
+
+#else /* OW_MT */
+
+// Without threads nothing could share the connection
+static int Pipeline_Wanted( struct connection_in * in )
+{
+	(void) in ;
+	return 0 ;
+}
+
+static void Pipeline_Create( struct connection_in * in, FILE_DESCRIPTOR_OR_ERROR file_descriptor )
+{
+	(void) in ;
+	Test_and_Close( &file_descriptor ) ;
+}
+
+static GOOD_OR_BAD Pipeline_Send( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp)
+{
+	(void) scs ;
+	(void) sm ;
+	(void) sp ;
+	return gbBAD ;
+}
+
+static GOOD_OR_BAD Pipeline_Wait( struct server_connection_state * scs, struct client_msg *cm )
+{
+	(void) scs ;
+	cm->ret = -EIO ;
+	return gbBAD ;
+}
+
+static void Pipeline_Finish( struct server_connection_state * scs )
+{
+	scs->pipelined = NULL ;
+}
+
+void Server_pipeline_close( struct connection_in * in )
+{
+	(void) in ;
+}
+
+#endif /* OW_MT */
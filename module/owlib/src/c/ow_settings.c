@@ -29,6 +29,7 @@ WRITE_FUNCTION(FS_w_TS);
 READ_FUNCTION(FS_r_PS);
 WRITE_FUNCTION(FS_w_PS);
 READ_FUNCTION(FS_aliaslist);
+WRITE_FUNCTION(FS_w_aliasreload);
 READ_FUNCTION(FS_return_code);
 
 /* -------- Structures ---------- */
@@ -45,6 +46,10 @@ static struct filetype set_timeout[] = {
 	{"ftp", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {v:&Globals.timeout_ftp}, },
 	{"ha7", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {v:&Globals.timeout_ha7}, },
 	{"w1", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {v:&Globals.timeout_w1}, },
+	{"pool", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {v:&Globals.timeout_pool}, },
+	{"pool_check", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {v:&Globals.timeout_pool_check}, },
+	{"stale_volatile", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {v:&Globals.stale_volatile}, },
+	{"stale_stable", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {v:&Globals.stale_stable}, },
 	{"uncached", PROPERTY_LENGTH_YESNO, NON_AGGREGATE, ft_yesno, fc_static, FS_r_yesno, FS_w_yesno, VISIBLE, {v:&Globals.uncached}, },
 };
 struct device d_set_timeout = { "timeout", "timeout", ePN_settings, COUNT_OF_FILETYPES(set_timeout),
@@ -61,6 +66,7 @@ struct device d_set_units = { "units", "units", ePN_settings, COUNT_OF_FILETYPES
 
 static struct filetype set_alias[] = {
  	{"list", MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE, NON_AGGREGATE, ft_ascii, fc_static, FS_aliaslist, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"reload", PROPERTY_LENGTH_YESNO, NON_AGGREGATE, ft_yesno, fc_static, NO_READ_FUNCTION, FS_w_aliasreload, VISIBLE, NO_FILETYPE_DATA, },
 	{"unaliased", PROPERTY_LENGTH_YESNO, NON_AGGREGATE, ft_yesno, fc_static, FS_r_yesno, FS_w_yesno, VISIBLE, {v:&Globals.unaliased}, },
 };
 struct device d_set_alias = { "alias", "alias", ePN_settings, COUNT_OF_FILETYPES(set_alias),
@@ -190,6 +196,15 @@ static ZERO_OR_ERROR FS_aliaslist( struct one_wire_query * owq )
 	return zoe ;
 }
 
+/* Reread the alias files (as SIGHUP does) */
+static ZERO_OR_ERROR FS_w_aliasreload( struct one_wire_query * owq )
+{
+	if ( OWQ_Y(owq) == 0 ) {
+		return 0 ;
+	}
+	return GOOD( AliasReload() ) ? 0 : -EINVAL ;
+}
+
 static ZERO_OR_ERROR FS_return_code(struct one_wire_query *owq)
 {
 	return OWQ_format_output_offset_and_size_z(return_code_strings[PN(owq)->extension], owq);
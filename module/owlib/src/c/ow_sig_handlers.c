@@ -16,6 +16,10 @@ $Id$
 static void DefaultSignalHandler(int signo, siginfo_t * info, void *context)
 {
 	(void) context;
+	if (signo == SIGHUP) {
+		// reread the alias files (done on the next request, not in the handler)
+		AliasReloadRequest();
+	}
 #if OW_MT
 	if (info) {
 		LEVEL_DEBUG
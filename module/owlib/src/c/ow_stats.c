@@ -52,6 +52,16 @@ $Id$
 /* ----------------- */
 UINT cache_flips = 0;
 UINT cache_adds = 0;
+UINT cache_bytes = 0;
+UINT cache_evictions = 0;
+UINT cache_stale_hits = 0;
+UINT cache_stale_misses = 0;
+UINT cache_stale_refreshes = 0;
+UINT cache_stale_dropped = 0;
+UINT parse_cache_hits = 0;
+UINT parse_cache_misses = 0;
+UINT parse_cache_flushes = 0;
+UINT cache_occupancy[fc_subdir + 1] ;
 struct average old_avg = { 0L, 0L, 0L, 0L, };
 struct average new_avg = { 0L, 0L, 0L, 0L, };
 struct average store_avg = { 0L, 0L, 0L, 0L, };
@@ -68,8 +78,27 @@ UINT read_cachebytes = 0;
 UINT read_array = 0;
 UINT read_tries[3] = { 0, 0, 0, };
 UINT read_success = 0;
+UINT read_coalesced = 0;
 struct average read_avg = { 0L, 0L, 0L, 0L, };
 
+UINT bundle_ships = 0;
+UINT bundle_saved = 0;
+UINT bundle_items[BUNDLE_HISTOGRAM_BUCKETS] = { 0, 0, 0, 0, 0, 0, };
+UINT bundle_bytes[BUNDLE_HISTOGRAM_BUCKETS] = { 0, 0, 0, 0, 0, 0, };
+
+UINT poller_rounds = 0;
+UINT poller_reads = 0;
+UINT poller_errors = 0;
+UINT poller_late = 0;
+UINT poller_lag_last = 0;
+UINT poller_lag_max = 0;
+
+UINT http_pages = 0;
+UINT http_page_reads = 0;
+UINT http_page_msec_last = 0;
+UINT http_page_msec_max = 0;
+UINT http_page_msec_total = 0;
+
 UINT write_calls = 0;
 UINT write_bytes = 0;
 UINT write_array = 0;
@@ -100,6 +129,17 @@ UINT NET_accept_errors = 0;
 UINT NET_connection_errors = 0;
 UINT NET_read_errors = 0;
 
+// ow_server.c
+UINT server_pool_hits = 0;
+UINT server_pool_misses = 0;
+UINT server_pool_expired = 0;
+UINT server_pool_stale = 0;
+UINT server_pool_full = 0;
+
+// ow_server_message.c
+UINT server_pipeline_connections = 0;
+UINT server_pipeline_requests = 0;
+
 // ow_bus.c
 UINT BUS_send_data_errors = 0;
 UINT BUS_send_data_memcmp_errors = 0;
@@ -133,6 +173,29 @@ READ_FUNCTION(FS_return_code);
 static struct filetype stats_cache[] = {
 	{"flips", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_flips}, },
 	{"additions", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_adds}, },
+	{"bytes", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_bytes}, },
+	{"evictions", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_evictions}, },
+
+	{"stale", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"stale/hits", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_stale_hits}, },
+	{"stale/misses", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_stale_misses}, },
+	{"stale/refreshes", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_stale_refreshes}, },
+	{"stale/dropped", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_stale_dropped}, },
+
+	{"parse", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"parse/hits", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&parse_cache_hits}, },
+	{"parse/misses", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&parse_cache_misses}, },
+	{"parse/flushes", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&parse_cache_flushes}, },
+
+	{"occupancy", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"occupancy/stable", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_occupancy[fc_stable]}, },
+	{"occupancy/read_stable", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_occupancy[fc_read_stable]}, },
+	{"occupancy/volatile", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_occupancy[fc_volatile]}, },
+	{"occupancy/simultaneous_temperature", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_occupancy[fc_simultaneous_temperature]}, },
+	{"occupancy/simultaneous_voltage", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_occupancy[fc_simultaneous_voltage]}, },
+	{"occupancy/second", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_occupancy[fc_second]}, },
+	{"occupancy/directory", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_occupancy[fc_directory]}, },
+	{"occupancy/presence", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&cache_occupancy[fc_presence]}, },
 
 	{"primary", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
 	{"primary/now", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&new_avg.current}, },
@@ -188,6 +251,7 @@ struct device d_stats_cache = { "cache", "cache", 0, COUNT_OF_FILETYPES(stats_ca
 static struct aggregate Aread = { 3, ag_numbers, ag_separate, };
 static struct filetype stats_read[] = {
 	{"calls", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&read_calls}, },
+	{"coalesced", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&read_coalesced}, },
 	{"cachesuccess", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&read_cache}, },
 	{"cachebytes", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&read_cachebytes}, },
 	{"success", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&read_success}, },
@@ -197,6 +261,41 @@ static struct filetype stats_read[] = {
 
 struct device d_stats_read = { "read", "read", 0, COUNT_OF_FILETYPES(stats_read), stats_read, NO_GENERIC_READ, NO_GENERIC_WRITE };
 
+/* Bundled bus transactions: the histograms bucket by powers of two
+   items: 1, 2, 3-4, 5-8, 9-16, 17+      bytes: 1-8, 9-16, 17-32, 33-64, 65-128, 129+ */
+static struct aggregate Abundle = { BUNDLE_HISTOGRAM_BUCKETS, ag_numbers, ag_separate, };
+static struct filetype stats_bundle[] = {
+	{"frames", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&bundle_ships}, },
+	{"saved", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&bundle_saved}, },
+	{"items", PROPERTY_LENGTH_UNSIGNED, &Abundle, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&bundle_items}, },
+	{"bytes", PROPERTY_LENGTH_UNSIGNED, &Abundle, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&bundle_bytes}, },
+};
+
+struct device d_stats_bundle = { "bundle", "bundle", 0, COUNT_OF_FILETYPES(stats_bundle), stats_bundle, NO_GENERIC_READ, NO_GENERIC_WRITE };
+
+/* Background poller: lag is msec a round started after the previous round's values expired */
+static struct filetype stats_poller[] = {
+	{"errors", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&poller_errors}, },
+	{"lag_last", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&poller_lag_last}, },
+	{"lag_max", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&poller_lag_max}, },
+	{"late", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&poller_late}, },
+	{"reads", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&poller_reads}, },
+	{"rounds", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&poller_rounds}, },
+};
+
+struct device d_stats_poller = { "poller", "poller", 0, COUNT_OF_FILETYPES(stats_poller), stats_poller, NO_GENERIC_READ, NO_GENERIC_WRITE };
+
+/* owhttpd device pages: time from request to last row, in msec */
+static struct filetype stats_http[] = {
+	{"msec_last", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&http_page_msec_last}, },
+	{"msec_max", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&http_page_msec_max}, },
+	{"msec_total", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&http_page_msec_total}, },
+	{"pages", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&http_pages}, },
+	{"reads", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&http_page_reads}, },
+};
+
+struct device d_stats_http = { "http", "http", 0, COUNT_OF_FILETYPES(stats_http), stats_http, NO_GENERIC_READ, NO_GENERIC_WRITE };
+
 static struct filetype stats_write[] = {
 	{"calls", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&write_calls}, },
 	{"success", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&write_success}, },
@@ -223,6 +322,20 @@ struct device d_stats_directory = { "directory", "directory", 0, COUNT_OF_FILETY
 	stats_directory, NO_GENERIC_READ, NO_GENERIC_WRITE
 };
 
+static struct filetype stats_server[] = {
+	{"pool", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"pool/hits", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&server_pool_hits}, },
+	{"pool/misses", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&server_pool_misses}, },
+	{"pool/expired", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&server_pool_expired}, },
+	{"pool/stale", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&server_pool_stale}, },
+	{"pool/full", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&server_pool_full}, },
+	{"pipeline", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"pipeline/connections", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&server_pipeline_connections}, },
+	{"pipeline/requests", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&server_pipeline_requests}, },
+};
+
+struct device d_stats_server = { "server", "server", 0, COUNT_OF_FILETYPES(stats_server), stats_server, NO_GENERIC_READ, NO_GENERIC_WRITE };
+
 static struct filetype stats_thread[] = {
 	{"directory", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
 	{"directory/now", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {v:&dir_avg.current}, },
@@ -312,6 +425,35 @@ struct device d_stats_errors = {
 
 /* ------- Functions ------------ */
 
+#if OW_MT && defined(HAVE_SYNC_FETCH_AND_ADD)
+/* Lock-free versions of the AVERAGE_* macros (see ow_counters.h) */
+/* Each field is updated atomically, the set of fields is not -- fine for statistics */
+void StatMax( UINT * max, UINT value )
+{
+	UINT old = *max ;
+	while ( value > old ) {
+		if ( __sync_bool_compare_and_swap( max, old, value ) ) {
+			break ;
+		}
+		old = *max ;
+	}
+}
+
+void StatAverageIn( struct average * a )
+{
+	UINT current = __sync_add_and_fetch( &(a->current), 1 ) ;
+	STAT_ADD( a->count, 1 ) ;
+	STAT_ADD( a->sum, current ) ;
+	StatMax( &(a->max), current ) ;
+}
+
+void StatAverageMark( struct average * a )
+{
+	STAT_ADD( a->count, 1 ) ;
+	STAT_ADD( a->sum, a->current ) ;
+}
+#endif /* OW_MT && HAVE_SYNC_FETCH_AND_ADD */
+
 static ZERO_OR_ERROR FS_stat(struct one_wire_query *owq)
 {
 	struct parsedname *pn = PN(owq);
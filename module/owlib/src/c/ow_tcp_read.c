@@ -17,37 +17,72 @@ $Id$
 #include "owfs_config.h"
 #include "ow.h"
 #include "ow_counters.h"
+#include <poll.h>
 
-/* Wait for something to be readable or timeout */
-GOOD_OR_BAD tcp_wait(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const struct timeval *ptv)
+/* Reads wait with poll() rather than select():
+   the pollfd is set up once per call and reused for every wait in the loop,
+   there is no FD_SETSIZE limit on the descriptor number (a busy owserver can exceed it),
+   and the timeout is an absolute deadline for the whole call, so a peer that trickles
+   data a byte at a time can't stretch it indefinitely. */
+
+/* Milliseconds left before the deadline (0 if already passed) */
+static int tcp_remaining_ms( const struct timeval * deadline )
 {
-	int select_result;
-	fd_set readset;
-	struct timeval tv ;
+	struct timeval now ;
+	struct timeval left ;
 
-	/* Initialize readset */
-	FD_ZERO(&readset);
-	FD_SET(file_descriptor, &readset);
+	timernow( &now ) ;
+	if ( ! timercmp( &now, deadline, < ) ) {
+		return 0 ;
+	}
+	timersub( deadline, &now, &left ) ;
+	if ( left.tv_sec > 86400 ) {
+		return 86400 * 1000 ; // a day -- keeps the int from overflowing
+	}
+	return left.tv_sec * 1000 + ( left.tv_usec + 999 ) / 1000 ;
+}
 
+/* Wait until readable, or the deadline */
+/* return 0 if readable (or at end of stream), -EAGAIN on timeout, -EBADF on error */
+static ZERO_OR_ERROR tcp_poll( struct pollfd * pfd, const struct timeval * deadline )
+{
 	while (1) {
-		// Read if it doesn't timeout first
-		timercpy( &tv, ptv ) ;
-		select_result = select(file_descriptor + 1, &readset, NULL, NULL, &tv);
-		if (select_result < 0) {
-			if (errno == EINTR) {
-				continue;		/* interrupted */
-			}
-			return gbBAD;		/* error */
-		} else if (select_result == 0) {
-			return gbBAD;		/* timeout */
-		} else {
-			// Is there something to read?
-			if (FD_ISSET(file_descriptor, &readset)) {
-				break;
+		int poll_result = poll( pfd, 1, tcp_remaining_ms( deadline ) ) ;
+		if ( poll_result > 0 ) {
+			if ( pfd->revents & ( POLLIN | POLLHUP ) ) {
+				return 0 ; // data, or a hangup that read() will report as end of stream
 			}
+			LEVEL_DEBUG("tcp_error -- poll flags 0x%X", pfd->revents );
+			return -EBADF ;
+		} else if ( poll_result == 0 ) {
+			return -EAGAIN ; // timeout
+		} else if ( errno != EINTR ) {
+			ERROR_DATA("Poll error");
+			return -EBADF ;
 		}
+		// interrupted, try again
 	}
-	return gbGOOD;
+}
+
+/* Deadline ptv from now */
+static void tcp_deadline( struct timeval * deadline, const struct timeval * ptv )
+{
+	timernow( deadline ) ;
+	timeradd( deadline, ptv, deadline ) ;
+}
+
+/* Wait for something to be readable or timeout */
+GOOD_OR_BAD tcp_wait(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const struct timeval *ptv)
+{
+	struct pollfd pfd = { file_descriptor, POLLIN, 0, } ;
+	struct timeval deadline ;
+
+	if ( FILE_DESCRIPTOR_NOT_VALID( file_descriptor ) ) {
+		return gbBAD ;
+	}
+
+	tcp_deadline( &deadline, ptv ) ;
+	return tcp_poll( &pfd, &deadline ) == 0 ? gbGOOD : gbBAD ;
 }
 
 /* Read "n" bytes from a descriptor. */
@@ -56,60 +91,42 @@ GOOD_OR_BAD tcp_wait(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const struct time
 ZERO_OR_ERROR tcp_read(FILE_DESCRIPTOR_OR_ERROR file_descriptor, BYTE * buffer, size_t requested_size, const struct timeval * ptv, size_t * chars_in)
 {
 	size_t to_be_read = requested_size ;
+	struct pollfd pfd = { file_descriptor, POLLIN, 0, } ;
+	struct timeval deadline ;
 
 	if ( FILE_DESCRIPTOR_NOT_VALID( file_descriptor ) ) {
 		return -EBADF ;
 	}
 
 	LEVEL_DEBUG("attempt %d bytes Time: "TVformat,(int)requested_size, TVvar(ptv) ) ;
+	tcp_deadline( &deadline, ptv ) ;
 	*chars_in = 0 ;
 	while (to_be_read > 0) {
-		int select_result;
-		fd_set readset;
-		struct timeval tv ;
-
-		/* Initialize readset */
-		FD_ZERO(&readset);
-		FD_SET(file_descriptor, &readset);
-
-		/* Read if it doesn't timeout first */
-		timercpy( &tv, ptv ) ;
-		select_result = select(file_descriptor + 1, &readset, NULL, NULL, &tv);
-		if (select_result > 0) {
-			ssize_t read_result;
-
-			/* Is there something to read? */
-			if (FD_ISSET(file_descriptor, &readset) == 0) {
-				LEVEL_DEBUG("tcp_error -- nothing avialable to read");
-				return -EBADF ;	/* error */
-			}
-			errno = 0 ;
-			read_result = read(file_descriptor, &buffer[*chars_in], to_be_read) ;
-			if ( read_result < 0 ) {
-				if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
-					read_result = 0;	/* and call read() again */
-				} else {
-					LEVEL_DATA("Network data read error errno=%d %s", errno, strerror(errno));
-					STAT_ADD1(NET_read_errors);
-					return -EBADF ;
-				}
-			} else if (read_result == 0) {
-				break;			/* EOF */
-			}
-			TrafficInFD("NETREAD", &buffer[*chars_in], read_result, file_descriptor ) ;
-			to_be_read -= read_result;
-			*chars_in += read_result ;
-		} else if (select_result < 0) {	/* select error */
-			if (errno == EINTR) {
-				/* select() was interrupted, try again */
-				continue;
-			}
-			ERROR_DATA("Select error");
-			return -EBADF;
-		} else {				/* timed out */
+		ssize_t read_result;
+		ZERO_OR_ERROR poll_result = tcp_poll( &pfd, &deadline ) ;
+
+		if ( poll_result == -EAGAIN ) {
 			LEVEL_CONNECT("TIMEOUT after %d bytes", requested_size - to_be_read);
 			return -EAGAIN;
+		} else if ( poll_result < 0 ) {
+			return -EBADF ;
+		}
+
+		errno = 0 ;
+		read_result = read(file_descriptor, &buffer[*chars_in], to_be_read) ;
+		if ( read_result < 0 ) {
+			if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+				continue ;	/* and call read() again */
+			}
+			LEVEL_DATA("Network data read error errno=%d %s", errno, strerror(errno));
+			STAT_ADD1(NET_read_errors);
+			return -EBADF ;
+		} else if (read_result == 0) {
+			break;			/* EOF */
 		}
+		TrafficInFD("NETREAD", &buffer[*chars_in], read_result, file_descriptor ) ;
+		to_be_read -= read_result;
+		*chars_in += read_result ;
 	}
 	LEVEL_DEBUG("read: %d - %d = %d",(int)requested_size, (int) to_be_read, (int) (requested_size-to_be_read) ) ;
 	return 0;
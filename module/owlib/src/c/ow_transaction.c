@@ -22,6 +22,8 @@ struct transaction_bundle {
 	size_t max_size;
 	struct memblob mb;
 	int select_first;
+	int bus_items;				// items that put bytes on the wire (round trips if unbundled)
+	int native_power;			// adapter has its own strong pullup -- power bytes can't be bundled
 };
 
 // static int BUS_transaction_length( const struct transaction_log * tl, const struct parsedname * pn ) ;
@@ -34,6 +36,8 @@ static GOOD_OR_BAD Bundle_enroute(struct transaction_bundle *tb, const struct pa
 static GOOD_OR_BAD Bundle_unpack(struct transaction_bundle *tb);
 
 static void Bundle_init(struct transaction_bundle *tb, const struct parsedname *pn);
+static void Bundle_clear(struct transaction_bundle *tb);
+static void Bundle_stats(struct transaction_bundle *tb);
 
 #define TRANSACTION_INCREMENT 1000
 
@@ -225,9 +229,21 @@ static GOOD_OR_BAD BUS_transaction_single(const struct transaction_log *t, const
 // initialize the bundle
 static void Bundle_init(struct transaction_bundle *tb, const struct parsedname *pn)
 {
+	struct connection_in * in = pn->selected_connection ;
+
 	memset(tb, 0, sizeof(struct transaction_bundle));
 	MemblobInit(&tb->mb, TRANSACTION_INCREMENT);
-	tb->max_size = pn->selected_connection->bundling_length;
+	tb->max_size = in->iroutines.bundling_length;
+	tb->native_power = (in->iroutines.PowerByte != NO_POWERBYTE_ROUTINE) ;
+}
+
+// empty the bundle for reuse
+static void Bundle_clear(struct transaction_bundle *tb)
+{
+	MemblobClear(&tb->mb);
+	tb->packets = 0;
+	tb->bus_items = 0;
+	tb->select_first = 0;
 }
 
 static GOOD_OR_BAD Bundle_pack(const struct transaction_log *tl, const struct parsedname *pn)
@@ -242,6 +258,16 @@ static GOOD_OR_BAD Bundle_pack(const struct transaction_log *tl, const struct pa
 		switch (Pack_item(t_index, tb)) {
 		case gbGOOD:
 			LEVEL_DEBUG("Item added");
+			switch (t_index->type) {
+			case trxn_delay:
+			case trxn_udelay:
+			case trxn_power:
+				// the delay is taken at unpack -- later bytes must not go out before it
+				RETURN_BAD_IF_BAD(Bundle_ship(tb, pn)) ;
+				break ;
+			default:
+				break ;
+			}
 			break;
 		case gbBAD:
 			LEVEL_DEBUG("Item cannot be bundled");
@@ -270,19 +296,21 @@ static GOOD_OR_BAD Bundle_ship(struct transaction_bundle *tb, const struct parse
 	}
 
 	if ( BAD( Bundle_enroute(tb, pn) ) ) {
-		// clear the bundle
-		MemblobClear(&tb->mb);
-		tb->packets = 0;
-		tb->select_first = 0;
+		Bundle_clear(tb);
 		return gbBAD;
 	}
 
+	Bundle_stats(tb);
 	return Bundle_unpack(tb);
 }
 
 // Execute a bundle transaction (actual bytes on 1-wire bus)
 static GOOD_OR_BAD Bundle_enroute(struct transaction_bundle *tb, const struct parsedname *pn)
 {
+	if (MemblobLength(&(tb->mb)) == 0) {
+		// nothing for the wire (e.g. select followed by a delay)
+		return tb->select_first ? BUS_select(pn) : gbGOOD ;
+	}
 	if (tb->select_first) {
 		return BUS_select_and_sendback(MemblobData(&(tb->mb)), MemblobData(&(tb->mb)), MemblobLength(&(tb->mb)), pn);
 	} else {
@@ -306,13 +334,21 @@ static GOOD_OR_BAD Pack_item(const struct transaction_log *tl, struct transactio
 			return gbOTHER;		// select must be first
 		}
 		tb->select_first = 1;
+		++tb->bus_items ;
 		break;
 	case trxn_compare:			// match two strings -- no actual 1-wire
 	case trxn_bitcompare:			// match two strings -- no actual 1-wire
 		LEVEL_DEBUG("pack=COMPARE");
 		break;
-	case trxn_read:
 	case trxn_bitread:
+	case trxn_bitmatch:
+	case trxn_bitmodify:
+	case trxn_bitpower:
+	case trxn_program:
+		// bit-level and programming items have no byte image in the frame
+		LEVEL_DEBUG("pack=BIT or PROGRAM");
+		return gbBAD;
+	case trxn_read:
 		LEVEL_DEBUG(" pack=READ");
 		if (tl->size > tb->max_size) {
 			return gbBAD;		// too big for any bundle
@@ -323,11 +359,10 @@ static GOOD_OR_BAD Pack_item(const struct transaction_log *tl, struct transactio
 		if (MemblobAddChar(0xFF, tl->size, &tb->mb)) {
 			return gbBAD;
 		}
+		++tb->bus_items ;
 		break;
 	case trxn_match:			// write data and match response
-	case trxn_bitmatch:			// write data and match response
 	case trxn_modify:			// write data and read response. No match needed
-	case trxn_bitmodify:			// write data and read response. No match needed
 	case trxn_blind:			// write data and ignore response
 		LEVEL_DEBUG("pack=MATCH MODIFY BLIND");
 		if (tl->size > tb->max_size) {
@@ -339,11 +374,13 @@ static GOOD_OR_BAD Pack_item(const struct transaction_log *tl, struct transactio
 		if (MemblobAdd(tl->out, tl->size, &tb->mb)) {
 			return gbBAD;
 		}
+		++tb->bus_items ;
 		break;
 	case trxn_power:
-	case trxn_bitpower:
-	case trxn_program:
-		LEVEL_DEBUG("pack=POWER PROGRAM");
+		LEVEL_DEBUG("pack=POWER");
+		if (tb->native_power) {
+			return gbBAD;		// adapter's own strong pullup must be used
+		}
 		if (1 > tb->max_size) {
 			return gbBAD;		// too big for any bundle
 		}
@@ -353,6 +390,7 @@ static GOOD_OR_BAD Pack_item(const struct transaction_log *tl, struct transactio
 		if (MemblobAdd(tl->out, 1, &tb->mb)) {
 			return gbBAD;
 		}
+		++tb->bus_items ;
 		ret = gbGOOD;			// needs delay
 		break;
 	case trxn_crc8:
@@ -424,8 +462,7 @@ static GOOD_OR_BAD Bundle_unpack(struct transaction_bundle *tb)
 			data += tl->size;
 			break;
 		case trxn_power:
-		case trxn_program:
-			LEVEL_DEBUG("unpacking #%d POWER PROGRAM", packet_index);
+			LEVEL_DEBUG("unpacking #%d POWER", packet_index);
 			memmove(tl->in, data, 1);
 			data += 1;
 			UT_delay(tl->size);
@@ -473,17 +510,14 @@ static GOOD_OR_BAD Bundle_unpack(struct transaction_bundle *tb)
 		case trxn_select:
 			LEVEL_DEBUG("unpacking #%d NOP or SELECT", packet_index);
 			break;
+		case trxn_program:
 		case trxn_bitmatch:
-			LEVEL_DEBUG("Unsupported transaction request trxn_bitmatch");
-			break ;
 		case trxn_bitmodify:
-			LEVEL_DEBUG("Unsupported transaction request trxn_bitmodify");
-			break ;
 		case trxn_bitread:
-			LEVEL_DEBUG("Unsupported transaction request trxn_bitread");
-			break ;
 		case trxn_bitpower:
-			LEVEL_DEBUG("Unsupported transaction request trxn_bitpower");
+			// never packed
+			LEVEL_DEBUG("unpacking #%d unbundled type %d", packet_index, tl->type);
+			ret = gbBAD;
 			break ;
 		}
 		if ( BAD(ret) ) {
@@ -491,10 +525,33 @@ static GOOD_OR_BAD Bundle_unpack(struct transaction_bundle *tb)
 		}
 	}
 
-	// clear the bundle
-	MemblobClear(&tb->mb);
-	tb->packets = 0;
-	tb->select_first = 0;
-
+	Bundle_clear(tb);
 	return ret;
 }
+
+/* Histogram bucket for a count, doubling from the first bucket's top
+   items (top=1): 1, 2, 3-4, 5-8, 9-16, 17+
+   bytes (top=8): 1-8, 9-16, 17-32, 33-64, 65-128, 129+ */
+static int Bundle_bucket(size_t count, size_t top)
+{
+	int bucket = 0 ;
+
+	while (bucket < BUNDLE_HISTOGRAM_BUCKETS - 1 && count > top) {
+		++bucket ;
+		top *= 2 ;
+	}
+	return bucket ;
+}
+
+// Tally a shipped bundle -- one round trip instead of bus_items
+static void Bundle_stats(struct transaction_bundle *tb)
+{
+	size_t length = MemblobLength(&(tb->mb)) ;
+
+	STAT_ADD1(bundle_ships);
+	STAT_ADD1(bundle_items[Bundle_bucket(tb->bus_items, 1)]);
+	STAT_ADD1(bundle_bytes[Bundle_bucket(length, 8)]);
+	if (tb->bus_items > 1) {
+		STAT_ADD(bundle_saved, tb->bus_items - 1);
+	}
+}
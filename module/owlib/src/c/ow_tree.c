@@ -19,10 +19,31 @@ static int device_compare(const void *a, const void *b);
 static int file_compare(const void *a, const void *b);
 static void Device2Tree(const struct device *d, enum ePN_type type);
 static void External_Process(void);
+static struct device * FS_devicefindhex_tree(BYTE f, enum ePN_type type);
+static void FamilyIndexBuild(void);
+static UINT PropertyHash(const struct filetype *filetype_array, const char *name);
+static void PropertyIndexAdd(const struct device *d);
+static void PropertyIndex_action(const void *nodep, const VISIT which, const int depth);
+static void PropertyIndexBuild(void);
 
 struct device *DeviceSimultaneous;
 struct device *DeviceThermostat;
 
+/* Flat lookup indexes, built once the trees are complete (DeviceSort)
+ * The device tables don't change after that, so parsing needs no tree walk
+ * or string-compare chain:
+ *   family_index   -- real device for each family code byte (the byte is the hash)
+ *   property_index -- open-addressed table of every property of every device,
+ *                     hashed on the device's filetype_array and the property name
+ * Lookups that miss fall back to tfind / bsearch, so a device added any other way still works.
+ */
+static struct device * family_index[256];
+static int family_index_built = 0;
+
+static struct filetype ** property_index = NULL;
+static UINT property_index_mask = 0;
+static int property_count = 0;		// properties added by Device2Tree, to size property_index
+
 static int device_compare(const void *a, const void *b)
 {
 	return strcmp(((const struct device *) a)->family_code, ((const struct device *) b)->family_code);
@@ -56,6 +77,7 @@ static void Device2Tree(const struct device *d, enum ePN_type type)
 	// Sort all the file types alphabetically for search and listing
 	if (d_copy->filetype_array != NULL) {
 		qsort(d_copy->filetype_array, (size_t) d_copy->count_of_filetypes, sizeof(struct filetype), file_compare);
+		property_count += d_copy->count_of_filetypes ;
 	}
 }
 #else    /* not FreeBSD */
@@ -66,6 +88,7 @@ static void Device2Tree(const struct device *d, enum ePN_type type)
 	// Sort all the file types alphabetically for search and listing
 	if (d->filetype_array != NULL) {
 		qsort(d->filetype_array, (size_t) d->count_of_filetypes, sizeof(struct filetype), file_compare);
+		property_count += d->count_of_filetypes ;
 	}
 }
 #endif							/* __FreeBSD__ */
@@ -81,6 +104,12 @@ void DeviceDestroy(void)
 {
 	UINT i;
 
+	// flat indexes point into the trees
+	family_index_built = 0 ;
+	SAFEFREE( property_index ) ;
+	property_index_mask = 0 ;
+	property_count = 0 ;
+
 	// clear external trees
 	tdestroy( sensor_tree, owfree_func ) ;
 	tdestroy( family_tree, owfree_func ) ;
@@ -101,6 +130,7 @@ void DeviceDestroy(void)
 void DeviceSort(void)
 {
 	memset(Tree, 0, sizeof(void *) * ePN_max_type);
+	property_count = 0 ;
 
 	/* Sort the filetypes for the unrecognized device */
 	qsort(UnknownDevice.filetype_array, (size_t) UnknownDevice.count_of_filetypes, sizeof(struct filetype), file_compare);
@@ -166,10 +196,14 @@ void DeviceSort(void)
 	Device2Tree( & d_LCD,            ePN_real);
 	Device2Tree( & d_simultaneous,   ePN_real);
 	
+	Device2Tree( & d_stats_bundle,         ePN_statistics);
+	Device2Tree( & d_stats_poller,         ePN_statistics);
+	Device2Tree( & d_stats_http,           ePN_statistics);
 	Device2Tree( & d_stats_cache,          ePN_statistics);
 	Device2Tree( & d_stats_directory,      ePN_statistics);
 	Device2Tree( & d_stats_errors,         ePN_statistics);
 	Device2Tree( & d_stats_read,           ePN_statistics);
+	Device2Tree( & d_stats_server,         ePN_statistics);
 	Device2Tree( & d_stats_thread,         ePN_statistics);
 	Device2Tree( & d_stats_write,          ePN_statistics);
 	Device2Tree( & d_stats_return_code,    ePN_statistics);
@@ -206,26 +240,136 @@ void DeviceSort(void)
 
 	/* structure uses same tree as real */
 	Tree[ePN_structure] = Tree[ePN_real];
+
+	/* Trees are complete -- make the flat indexes */
+	FamilyIndexBuild() ;
+	PropertyIndexBuild() ;
 }
 
 struct device * FS_devicefindhex(BYTE f, struct parsedname *pn)
+{
+	if ( family_index_built && ( pn->type == ePN_real || pn->type == ePN_structure ) ) {
+		return family_index[f] ;
+	}
+	return FS_devicefindhex_tree( f, pn->type ) ;
+}
+
+static struct device * FS_devicefindhex_tree(BYTE f, enum ePN_type type)
 {
 	char ID[] = "XX";
 	const struct device d = { ID, NULL, 0, 0, NULL, NO_GENERIC_READ, NO_GENERIC_WRITE };
 	struct device_opaque *p;
 
 	num2string(ID, f);
-	if ((p = tfind(&d, &Tree[pn->type], device_compare))) {
+	if ((p = tfind(&d, &Tree[type], device_compare))) {
 		return p->key;
 	} else {
 		num2string(ID, f ^ 0x80);
-		if ((p = tfind(&d, &Tree[pn->type], device_compare))) {
+		if ((p = tfind(&d, &Tree[type], device_compare))) {
 			return p->key;
 		}
 	}
 	return &UnknownDevice ;
 }
 
+/* Same answer as the tree search, for every family byte */
+static void FamilyIndexBuild(void)
+{
+	UINT f ;
+
+	for ( f = 0 ; f < 256 ; ++f ) {
+		family_index[f] = FS_devicefindhex_tree( (BYTE) f, ePN_real ) ;
+	}
+	family_index_built = 1 ;
+}
+
+/* FNV-1a over the property name, seeded with the device's filetype_array */
+/* (the array rather than the device, since a FreeBSD tree holds copies of the device) */
+static UINT PropertyHash(const struct filetype *filetype_array, const char *name)
+{
+	return FNV1a_string( name, (UINT) ( ((uintptr_t) filetype_array) >> 4 ) ) ;
+}
+
+static void PropertyIndexAdd(const struct device *d)
+{
+	int i ;
+
+	for ( i = 0 ; i < d->count_of_filetypes ; ++i ) {
+		struct filetype * ft = &(d->filetype_array[i]) ;
+		UINT slot = PropertyHash( d->filetype_array, ft->name ) ;
+
+		while ( property_index[slot & property_index_mask] != NULL ) {
+			if ( property_index[slot & property_index_mask] == ft ) {
+				// device in more than one tree
+				break ;
+			}
+			++slot ;
+		}
+		property_index[slot & property_index_mask] = ft ;
+	}
+}
+
+static void PropertyIndex_action(const void *nodep, const VISIT which, const int depth)
+{
+	const struct device *d = *(struct device * const *) nodep;
+	(void) depth;
+
+	switch (which) {
+	case leaf:
+	case postorder:
+		PropertyIndexAdd( d ) ;
+		break ;
+	case preorder:
+	case endorder:
+		break;
+	}
+}
+
+/* Sized for at most half full, so probe chains stay short */
+static void PropertyIndexBuild(void)
+{
+	UINT slots = 64 ;
+	UINT i ;
+
+	property_count += UnknownDevice.count_of_filetypes ;
+	while ( slots < 2 * (UINT) property_count ) {
+		slots <<= 1 ;
+	}
+	property_index = owcalloc( slots, sizeof(struct filetype *) ) ;
+	if ( property_index == NULL ) {
+		LEVEL_DEBUG("No memory for the property index -- properties will be searched") ;
+		return ;
+	}
+	property_index_mask = slots - 1 ;
+
+	PropertyIndexAdd( &UnknownDevice ) ;
+	for (i = 0; i < ePN_max_type; i++) {
+		/* ePN_structure is just a duplicate of ePN_real */
+		if (i != ePN_structure) {
+			twalk( Tree[i], PropertyIndex_action ) ;
+		}
+	}
+}
+
+/* Property of this device with this name, or NO_FILETYPE */
+struct filetype * FS_filetype_find(const char *name, const struct device *d)
+{
+	if ( property_index != NULL && d->filetype_array != NULL ) {
+		UINT slot = PropertyHash( d->filetype_array, name ) ;
+		struct filetype * ft ;
+
+		while ( (ft = property_index[slot & property_index_mask]) != NULL ) {
+			if ( ft >= d->filetype_array && ft < d->filetype_array + d->count_of_filetypes
+				&& strcmp( ft->name, name ) == 0 ) {
+				return ft ;
+			}
+			++slot ;
+		}
+	}
+	// not indexed, or not a property of this device
+	return bsearch(name, d->filetype_array, (size_t) d->count_of_filetypes, sizeof(struct filetype), filetype_cmp) ;
+}
+
 void FS_devicefind(const char *code, struct parsedname *pn)
 {
 	const struct device d = { code, NULL, 0, 0, NULL, NO_GENERIC_READ, NO_GENERIC_WRITE };
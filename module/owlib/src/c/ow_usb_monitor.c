@@ -165,7 +165,7 @@ static void USB_scan_for_adapters(void)
 		struct port_in * pin = AllocPort(NULL) ;
 		struct connection_in * in ;
 		if ( pin == NULL ) {
-			return ;
+			break ;
 		}
 		in = pin->first ;
 		DEVICENAME(in) = DS9490_device_name(&ul) ;
@@ -103,7 +103,26 @@ int BSD_usb_clear_halt(usb_dev_handle * dev, unsigned int ep)
 #endif /* __FreeBSD__ < 8 */
 #endif							/* __FreeBSD__ */
 
+static RESET_TYPE DS9490_status_wait(BYTE * buffer, int * readlen, int wait_idle, const struct parsedname *pn);
+
+/* Read the status packet, waiting for the adapter to go idle
+   readlen <0 -- don't wait for idle
+   readlen 0 -- wait for idle
+   readlen >0 -- wait for idle and that many bytes in the data-in buffer
+   */
 RESET_TYPE DS9490_getstatus(BYTE * buffer, int * readlen, const struct parsedname *pn)
+{
+	return DS9490_status_wait(buffer, readlen, 1, pn) ;
+}
+
+/* Read the status packet until readlen bytes are in the data-in buffer
+   The adapter may still be busy with later queued commands */
+RESET_TYPE DS9490_getstatus_datain(BYTE * buffer, int * readlen, const struct parsedname *pn)
+{
+	return DS9490_status_wait(buffer, readlen, 0, pn) ;
+}
+
+static RESET_TYPE DS9490_status_wait(BYTE * buffer, int * readlen, int wait_idle, const struct parsedname *pn)
 {
 	int ret, loops = 0;
 	int i;
@@ -184,6 +203,10 @@ RESET_TYPE DS9490_getstatus(BYTE * buffer, int * readlen, const struct parsednam
 			break;				/* Don't wait for STATUSFLAGS_IDLE if length==-1 */
 		}
 
+		if ( !wait_idle && *readlen > 0 && buffer[13] >= *readlen ) {
+			break;				/* enough data even though still busy */
+		}
+
 		if (buffer[8] & STATUSFLAGS_IDLE) {
 #if OW_SHOW_TRAFFIC
 			// See note below for register info
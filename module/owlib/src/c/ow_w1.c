@@ -59,7 +59,7 @@ static void W1_setroutines(struct connection_in *in)
 	// Bundle transactions
 	//
 	in->iroutines.flags = ADAP_FLAG_dirgulp | ADAP_FLAG_bundle | ADAP_FLAG_dir_auto_reset | ADAP_FLAG_no2404delay ;
-	in->bundling_length = W1_FIFO_SIZE;	// arbitrary number
+	in->iroutines.bundling_length = W1_FIFO_SIZE;	// arbitrary number
 }
 
 GOOD_OR_BAD W1_detect(struct port_in *pin)
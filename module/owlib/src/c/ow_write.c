@@ -97,15 +97,12 @@ SIZE_OR_ERROR FS_write_postparse(struct one_wire_query *owq)
 		return -EISDIR;			// not a file
 	}
 
-	STATLOCK;
-	AVERAGE_IN(&write_avg);
-	AVERAGE_IN(&all_avg);
-	++write_calls;				/* statistics */
-	STATUNLOCK;
+	STAT_AVERAGE_IN(&write_avg);
+	STAT_AVERAGE_IN(&all_avg);
+	STAT_ADD1(write_calls);		/* statistics */
 
 	write_or_error = FS_write_post_stats( owq ) ;
 
-	STATLOCK;
 	// write_or_error is still ZERO_OR_ERROR mode
 	if ( write_or_error == 0 ) {
 		LEVEL_DEBUG("Successful write to %s",pn->path) ;
@@ -113,14 +110,13 @@ SIZE_OR_ERROR FS_write_postparse(struct one_wire_query *owq)
 		LEVEL_DEBUG("Error writing to %s",pn->path) ;
 	}
 	if (write_or_error == 0) {
-		++write_success;		/* statistics */
-		write_bytes += OWQ_size(owq);	/* statistics */
+		STAT_ADD1(write_success);	/* statistics */
+		STAT_ADD(write_bytes, OWQ_size(owq));	/* statistics */
 		// write_or_error now SIZE_OR_ERROR mode
 		write_or_error = OWQ_size(owq);	/* here's where the size is used! */
 	}
-	AVERAGE_OUT(&write_avg);
-	AVERAGE_OUT(&all_avg);
-	STATUNLOCK;
+	STAT_AVERAGE_OUT(&write_avg);
+	STAT_AVERAGE_OUT(&all_avg);
 
 	return write_or_error;
 }
@@ -211,6 +207,9 @@ static ZERO_OR_ERROR FS_write_real(int depth, struct one_wire_query *owq)
 		case bus_fake:
 		case bus_tester:
 			return ( ft->write == NO_WRITE_FUNCTION ) ? -ENOTSUP : 0 ;
+		case bus_external:
+			// scripts and co-processes answer for themselves -- no bus to recheck
+			return FS_w_given_bus(owq);
 		default:
 			// non-virtual devices get handled below
 			break ;
@@ -151,6 +151,10 @@ $Id$
 #include <sys/uio.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif							/* HAVE_SYS_EPOLL_H */
+
 /* Include gettimeofday and all the timerX macros */
 #include "ow_timer.h"
 #define NOW_TIME 	time(NULL)
@@ -292,6 +296,8 @@ ssize_t getline (char **lineptr, size_t *n, FILE *stream) ;
 /* predeclare connection_in/out */
 struct connection_in;
 struct connection_out;
+struct bus_job;
+struct bus_job_group;
 
 /* Maximum length of a file or directory name, and extension */
 #define OW_NAME_MAX      (32)
@@ -75,6 +75,8 @@ struct interface_routines {
 	void (*close) (struct connection_in * in);
 	/* capabilities flags */
 	UINT flags;
+	/* largest frame (bytes) moved in one exchange -- bundled transactions (ADAP_FLAG_bundle) are packed up to this */
+	size_t bundling_length;
 };
 
 #define NO_DETECT_ROUTINE				NULL
@@ -60,6 +60,7 @@ extern struct internal_prop ipSimul[] ;
 void Cache_Open(void);
 void Cache_Close(void);
 void Cache_Clear(void);
+time_t Cache_Timeout(const enum fc_change change);
 
 GOOD_OR_BAD OWQ_Cache_Add(const struct one_wire_query *owq);
 GOOD_OR_BAD Cache_Add_Dir(const struct dirblob *db, const struct parsedname *pn);
@@ -72,9 +73,10 @@ void Cache_Add_Alias_Bus(const ASCII * alias_name, INDEX_OR_ERROR bus);
 GOOD_OR_BAD OWQ_Cache_Get(struct one_wire_query *owq);
 GOOD_OR_BAD Cache_Get(void *data, size_t * dsize, const struct parsedname *pn);
 GOOD_OR_BAD Cache_Get_Dir(struct dirblob *db, const struct parsedname *pn);
+GOOD_OR_BAD OWQ_Cache_Get_Stale(struct one_wire_query *owq);
 GOOD_OR_BAD Cache_Get_Device(void *bus_nr, const struct parsedname *pn);
 GOOD_OR_BAD Cache_Get_SlaveSpecific(void *data, size_t dsize, const struct internal_prop *ip, const struct parsedname *pn);
-ASCII * Cache_Get_Alias(const BYTE * sn) ;
+GOOD_OR_BAD Cache_Get_Alias(ASCII * alias_name, size_t length, const BYTE * sn) ;
 GOOD_OR_BAD Cache_Get_Simul_Time(enum simul_type type, time_t * dwell_time, const struct parsedname * pn);
 INDEX_OR_ERROR Cache_Get_Alias_Bus(const ASCII * alias_name) ;
 GOOD_OR_BAD Cache_Get_Alias_SN(const ASCII * alias_name, BYTE * sn );
@@ -94,6 +96,8 @@ void Cache_Del_Alias_Bus(const ASCII * alias_name);
 void Cache_Del_Alias(const BYTE * sn);
 
 void Aliaslist( struct memblob * mb  ) ;
+GOOD_OR_BAD Cache_Load_Aliases(struct memblob * mb, int replace) ;
+void Cache_Close_Aliases(void) ;
 
 #else							/* OW_CACHE */
 
@@ -103,6 +107,7 @@ void Aliaslist( struct memblob * mb  ) ;
 #define Cache_Open( void )
 #define Cache_Close( void )
 #define Cache_Clear( void )
+#define Cache_Timeout( change )             (0)
 
 #define Cache_Add_Dir(db,pn )               (gbBAD)
 #define Cache_Add_Device(bus_nr,sn )        (gbBAD)
@@ -115,10 +120,11 @@ void Aliaslist( struct memblob * mb  ) ;
 #define Cache_Get(data,dsize,pn )           (gbBAD)
 #define Cache_Get_Dir(db,pn )               (gbBAD)
 #define OWQ_Cache_Get( owq )                (gbBAD)
+#define OWQ_Cache_Get_Stale( owq )          (gbBAD)
 
 #define Cache_Get_Device(bus_nr,pn )        (gbBAD)
 #define Cache_Get_SlaveSpecific(data,dsize,ip,pn )       (gbBAD)
-#define Cache_Get_Alias(sn)				   (gbBAD)
+#define Cache_Get_Alias(name,length,sn)     (gbBAD)
 #define Cache_Get_SerialNumber(name, sn)    (gbBAD)
 #define Cache_Get_Simul_Time(type,time,pn)  (1)
 #define Cache_Get_Alias_Bus(name)	 		(INDEX_BAD)
@@ -142,6 +148,8 @@ void Aliaslist( struct memblob * mb  ) ;
 #define Cache_Del_Alias(sn)                 (1)
 
 #define Aliaslist(mb)     
+#define Cache_Load_Aliases(mb,replace)      (gbBAD)
+#define Cache_Close_Aliases()
 
 #endif							/* OW_CACHE */
 
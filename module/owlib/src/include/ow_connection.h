@@ -216,6 +216,6 @@ GOOD_OR_BAD TestConnection(const struct parsedname *pn);
 void ZeroAdd(const char * name, const char * type, const char * domain, const char * host, const char * service) ;
 void ZeroDel(const char * name, const char * type, const char * domain ) ;
 
-#define STAT_ADD1_BUS( err, in )     STATLOCK; ++((in)->bus_stat[err]) ; STATUNLOCK
+#define STAT_ADD1_BUS( err, in )     STAT_ADD1( (in)->bus_stat[err] )
 
 #endif							/* OW_CONNECTION_H */
@@ -116,6 +116,24 @@ enum e_bus_stat {
 // Add serial/tcp/telnet abstraction
 #include "ow_communication.h"
 
+#if OW_MT
+// Work handed to a bus's persistent worker thread (ow_busworker.c)
+// Usually embedded in the caller's per-bus argument struct
+struct bus_job {
+	void (*run) (void *);
+	void *arg;
+	struct bus_job *next;		// worker queue
+	struct bus_job_group *group;
+};
+
+// A fan-out: the caller waits until all its jobs are done
+struct bus_job_group {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int pending;
+};
+#endif							/* OW_MT */
+
 struct connection_in {
 	struct connection_in *next;
 	struct port_in * pown ; // pointer to port_in that owns us.
@@ -128,7 +146,9 @@ struct connection_in {
 
 	pthread_mutex_t bus_mutex;
 	pthread_mutex_t dev_mutex;
-	void *dev_db;				// dev-lock tree
+	struct devlock *dev_table;	// device lock table (ow_devicelock.c)
+	struct bus_worker *worker;	// fan-out job thread (ow_busworker.c)
+	struct read_flight *read_flights;	// reads in progress, shared by identical requests (ow_read.c)
 	enum e_reconnect reconnect_state;
 	struct timeval last_lock;	/* statistics */
 
@@ -152,8 +172,6 @@ struct connection_in {
 	int CRLF_size ; 
 
 	unsigned char remembered_sn[SERIAL_NUMBER_SIZE] ;       /* last address */
-	
-	size_t bundling_length;
 
 	struct { // Channel info for bus masters that share a common comminucation channel */
 		char channel ;
@@ -83,6 +83,16 @@ struct directory {
 
 extern UINT cache_flips;
 extern UINT cache_adds;
+extern UINT cache_bytes;
+extern UINT cache_evictions;
+extern UINT cache_stale_hits;		// expired values answered within their stale grace
+extern UINT cache_stale_misses;		// stale-eligible reads that waited for the bus
+extern UINT cache_stale_refreshes;	// background refreshes completed
+extern UINT cache_stale_dropped;	// refreshes not queued (queue full)
+extern UINT parse_cache_hits;		// paths found already parsed
+extern UINT parse_cache_misses;		// paths parsed in full
+extern UINT parse_cache_flushes;	// parse cache emptied (alias or bus change)
+extern UINT cache_occupancy[fc_subdir + 1];	// volatile cache entries by enum fc_change
 extern struct average new_avg;
 extern struct average old_avg;
 extern struct average store_avg;
@@ -99,6 +109,7 @@ extern UINT read_bytes;
 extern UINT read_array;
 extern UINT read_tries[3];
 extern UINT read_success;
+extern UINT read_coalesced;
 extern struct average read_avg;
 
 extern UINT write_calls;
@@ -132,6 +143,39 @@ extern UINT NET_accept_errors;
 extern UINT NET_connection_errors;
 extern UINT NET_read_errors;
 
+// ow_server.c
+extern UINT server_pool_hits;	// request served by an idle pooled connection
+extern UINT server_pool_misses;	// no idle connection, new one made
+extern UINT server_pool_expired;	// idle too long, closed
+extern UINT server_pool_stale;	// closed by the server while idle
+extern UINT server_pool_full;	// pool full, connection closed instead of parked
+
+// ow_server_message.c
+extern UINT server_pipeline_connections;	// connections switched to the pipelined protocol
+extern UINT server_pipeline_requests;	// requests sent pipelined
+
+// ow_transaction.c
+#define BUNDLE_HISTOGRAM_BUCKETS 6
+extern UINT bundle_ships;	// bundled frames sent
+extern UINT bundle_saved;	// round trips avoided by bundling
+extern UINT bundle_items[BUNDLE_HISTOGRAM_BUCKETS];	// bus items per frame: 1, 2, 3-4, 5-8, 9-16, 17+
+extern UINT bundle_bytes[BUNDLE_HISTOGRAM_BUCKETS];	// bytes per frame: 1-8, 9-16, 17-32, 33-64, 65-128, 129+
+
+// ow_poller.c
+extern UINT poller_rounds;	// background polling rounds
+extern UINT poller_reads;	// properties refreshed
+extern UINT poller_errors;	// reads that failed
+extern UINT poller_late;	// rounds started after the previous values expired
+extern UINT poller_lag_last;	// msec late, last round
+extern UINT poller_lag_max;	// msec late, worst round
+
+// owhttpd_read.c
+extern UINT http_pages;	// device pages shown
+extern UINT http_page_reads;	// property values read for them
+extern UINT http_page_msec_last;	// msec to show the last page
+extern UINT http_page_msec_max;	// msec, slowest page
+extern UINT http_page_msec_total;	// msec, all pages (with pages, gives the average)
+
 // ow_bus.c
 extern UINT BUS_readin_data_errors;
 extern UINT BUS_level_errors;
@@ -151,6 +195,29 @@ extern UINT DS2480_read_read;
 extern UINT DS2480_level_docheck_errors;
 extern UINT DS2480_databit_errors;
 
-#define STAT_ADD1(x)    STATLOCK ; ++x ; STATUNLOCK
+/* Statistics updates
+   Lock-free (__sync atomics) where the compiler allows, so counting never
+   serializes bus or cache work. Otherwise fall back to STATLOCK */
+#if OW_MT && defined(HAVE_SYNC_FETCH_AND_ADD)
+#define STAT_ADD(x,n)         do { (void) __sync_fetch_and_add( &(x), (n) ) ; } while (0)
+#define STAT_SUB(x,n)         do { (void) __sync_fetch_and_sub( &(x), (n) ) ; } while (0)
+#define STAT_MAX(x,n)         StatMax( &(x), (n) )
+#define STAT_AVERAGE_IN(pA)   StatAverageIn(pA)
+#define STAT_AVERAGE_OUT(pA)  STAT_SUB( (pA)->current, 1 )
+#define STAT_AVERAGE_MARK(pA) StatAverageMark(pA)
+
+void StatMax( UINT * max, UINT value ) ;
+void StatAverageIn( struct average * a ) ;
+void StatAverageMark( struct average * a ) ;
+#else /* no atomics */
+#define STAT_ADD(x,n)         do { STATLOCK ; (x) += (n) ; STATUNLOCK ; } while (0)
+#define STAT_SUB(x,n)         do { STATLOCK ; (x) -= (n) ; STATUNLOCK ; } while (0)
+#define STAT_MAX(x,n)         do { STATLOCK ; if ( (n) > (x) ) { (x) = (n) ; } ; STATUNLOCK ; } while (0)
+#define STAT_AVERAGE_IN(pA)   do { STATLOCK ; AVERAGE_IN(pA) ; STATUNLOCK ; } while (0)
+#define STAT_AVERAGE_OUT(pA)  do { STATLOCK ; AVERAGE_OUT(pA) ; STATUNLOCK ; } while (0)
+#define STAT_AVERAGE_MARK(pA) do { STATLOCK ; AVERAGE_MARK(pA) ; STATUNLOCK ; } while (0)
+#endif /* OW_MT && HAVE_SYNC_FETCH_AND_ADD */
+
+#define STAT_ADD1(x)          STAT_ADD(x,1)
 
 #endif							/* OW_COUNTERS_H */
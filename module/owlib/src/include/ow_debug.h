@@ -167,9 +167,30 @@ extern const char  cond_destroy_failed[];
 	int mrc = pthread_cond_destroy(cond);	                \
 	if(mrc != 0) { FATAL_ERROR( cond_destroy_failed,      mrc, strerror(mrc)); }} while (0)
 
-//extern const char rwlock_init_failed[];
-//extern const char rwlock_read_lock_failed[];
-//extern const char rwlock_read_unlock_failed[];
+extern const char rwlock_init_failed[];
+#define my_pthread_rwlock_init(rwlock)                  do {\
+	int mrc = pthread_rwlock_init(rwlock, NULL);            \
+	if(mrc != 0) { FATAL_ERROR( rwlock_init_failed,       mrc, strerror(mrc)); }} while(0)
+
+extern const char rwlock_destroy_failed[];
+#define my_pthread_rwlock_destroy(rwlock)               do {\
+	int mrc = pthread_rwlock_destroy(rwlock);               \
+	if(mrc != 0) { FATAL_ERROR( rwlock_destroy_failed,    mrc, strerror(mrc)); }} while(0)
+
+extern const char rwlock_read_lock_failed[];
+#define my_pthread_rwlock_rdlock(rwlock)                do {\
+	int mrc = pthread_rwlock_rdlock(rwlock);                \
+	if(mrc != 0) { FATAL_ERROR( rwlock_read_lock_failed,  mrc, strerror(mrc)); }} while (0)
+
+extern const char rwlock_write_lock_failed[];
+#define my_pthread_rwlock_wrlock(rwlock)                do {\
+	int mrc = pthread_rwlock_wrlock(rwlock);                \
+	if(mrc != 0) { FATAL_ERROR( rwlock_write_lock_failed, mrc, strerror(mrc)); }} while (0)
+
+extern const char rwlock_unlock_failed[];
+#define my_pthread_rwlock_unlock(rwlock)                do {\
+	int mrc = pthread_rwlock_unlock(rwlock);                \
+	if(mrc != 0) { FATAL_ERROR( rwlock_unlock_failed,     mrc, strerror(mrc)); }} while (0)
 
 #else /* not OW_MT */
 
@@ -185,6 +206,11 @@ extern const char  cond_destroy_failed[];
 #define my_pthread_cond_signal(cond)	                do {} while (0)
 #define my_pthread_cond_init(cond, attr)                do {} while (0)
 #define my_pthread_cond_destroy(cond)	                do {} while (0)
+#define my_pthread_rwlock_init(rwlock)                  do {} while (0)
+#define my_pthread_rwlock_destroy(rwlock)               do {} while (0)
+#define my_pthread_rwlock_rdlock(rwlock)                do {} while (0)
+#define my_pthread_rwlock_wrlock(rwlock)                do {} while (0)
+#define my_pthread_rwlock_unlock(rwlock)                do {} while (0)
 
 #endif /* OW_MT */
 
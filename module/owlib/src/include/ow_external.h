@@ -41,6 +41,7 @@ enum external_type {
 	et_none,
 	et_internal,
 	et_script,
+	et_coprocess,
 	et_tcp,
 	et_udp,
 } ;
@@ -83,6 +84,10 @@ struct sensor_node * Find_External_Sensor( char * sensor ) ;
 struct family_node * Find_External_Family( char * family ) ;
 struct property_node * Find_External_Property( char * family, char * property ) ;
 
+ZERO_OR_ERROR OW_read_external_coprocess( struct sensor_node * sensor_n, struct property_node * property_n, struct one_wire_query * owq ) ;
+ZERO_OR_ERROR OW_write_external_coprocess( struct sensor_node * sensor_n, struct property_node * property_n, struct one_wire_query * owq ) ;
+void Coprocess_close_all( void ) ;
+
 int sensor_compare( const void * a , const void * b ) ;
 int family_compare( const void * a , const void * b ) ;
 int property_compare( const void * a , const void * b ) ;
@@ -62,13 +62,18 @@ void DeviceSort(void);
 void DeviceDestroy(void);
 /* Pasename processing -- URL/path comprehension */
 int filetype_cmp(const void *name, const void *ex);
+struct filetype * FS_filetype_find(const char *name, const struct device *d);
 ZERO_OR_ERROR FS_ParsedNamePlus(const char *path, const char *file, struct parsedname *pn);
 ZERO_OR_ERROR FS_ParsedNamePlusExt(const char *path, const char *file, int extension, enum ag_index alphanumeric, struct parsedname *pn);
 ZERO_OR_ERROR FS_ParsedNamePlusText(const char *path, const char *file, const char *extension, struct parsedname *pn);
 ZERO_OR_ERROR FS_ParsedName(const char *fn, struct parsedname *pn);
 ZERO_OR_ERROR FS_ParsedName_BackFromRemote(const char *fn, struct parsedname *pn);
+ZERO_OR_ERROR FS_ParsedName_OnBus(const char *fn, INDEX_OR_ERROR bus_nr, struct parsedname *pn);
 void FS_ParsedName_destroy(struct parsedname *pn);
 void FS_ParsedName_Placeholder( struct parsedname * pn ) ;
+GOOD_OR_BAD ParseCache_Get( int back_from_remote, struct parsedname * pn, int * check_presence, UINT * generation ) ;
+void ParseCache_Add( int back_from_remote, enum ePS_state start_state, int check_presence, UINT generation, const struct parsedname * pn ) ;
+void ParseCache_Flush( void ) ;
 
 size_t FileLength(const struct parsedname *pn);
 size_t FullFileLength(const struct parsedname *pn);
@@ -87,6 +92,8 @@ BYTE CRC8seeded(const BYTE * bytes, const size_t length, const UINT seed);
 BYTE CRC8compute(const BYTE * bytes, const size_t length, const UINT seed);
 int CRC16(const BYTE * bytes, const size_t length);
 int CRC16seeded(const BYTE * bytes, const size_t length, const UINT seed);
+UINT FNV1a(const BYTE * bytes, const size_t length, const UINT seed);
+UINT FNV1a_string(const ASCII * string, const UINT seed);
 BYTE char2num(const char *s);
 BYTE string2num(const char *s);
 char num2char(const BYTE n);
@@ -115,6 +122,24 @@ GOOD_OR_BAD FS_poll_convert(const struct parsedname *pn);
 void LockSetup(void);
 ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn);
 void DeviceLockRelease(struct parsedname *pn);
+GOOD_OR_BAD DeviceLockTableCreate(struct connection_in *in);
+void DeviceLockTableDestroy(struct connection_in *in);
+
+// ow_busworker.c
+#if OW_MT
+void BusJobGroupInit(struct bus_job_group *group);
+void BusJobSubmit(struct bus_job_group *group, struct bus_job *job, struct connection_in *in);
+void BusJobGroupWait(struct bus_job_group *group);
+#endif							/* OW_MT */
+void BusWorkerStop(struct connection_in *in);
+
+// ow_poller.c
+GOOD_OR_BAD PollerAdd(const char *spec);
+void PollerStart(void);
+void PollerStop(void);
+
+void RefreshQueue(const struct parsedname *pn);
+void RefreshStop(void);
 
 /* 1-wire lowlevel */
 void UT_delay(const UINT len);
@@ -128,12 +153,22 @@ ssize_t udp_read(FILE_DESCRIPTOR_OR_ERROR file_descriptor, void *vptr, size_t n,
 GOOD_OR_BAD ClientAddr(char *sname, char * default_port, struct connection_in *in);
 FILE_DESCRIPTOR_OR_ERROR ClientConnect(struct connection_in *in);
 void FreeClientAddr(struct connection_in *in);
+FILE_DESCRIPTOR_OR_ERROR Server_pool_get(struct connection_in *in);
+void Server_pool_put(struct connection_in *in, FILE_DESCRIPTOR_OR_ERROR file_descriptor);
+GOOD_OR_BAD Server_pool_alive(FILE_DESCRIPTOR_OR_ERROR file_descriptor);
+void Server_pipeline_close(struct connection_in *in);
 
 void ServerProcess(void (*HandlerRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descriptor));
 GOOD_OR_BAD ServerOutSetup(struct connection_out *out);
+GOOD_OR_BAD SetupListenSockets( void (*HandlerRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descriptor) ) ;
+void CloseListenSockets( void ) ;
 
 GOOD_OR_BAD ReadAliasFile(const ASCII * file) ;
 GOOD_OR_BAD Test_and_Add_Alias( char * name, BYTE * sn ) ;
+GOOD_OR_BAD AliasReload(void) ;
+void AliasReloadRequest(void) ;
+void AliasReloadCheck(void) ;
+void AliasClose(void) ;
 
 speed_t COM_MakeBaud( int raw_baud ) ;
 int COM_BaudRate( speed_t B_baud ) ;
@@ -163,6 +198,7 @@ ZERO_OR_ERROR FS_read_fake(struct one_wire_query *owq);
 ZERO_OR_ERROR FS_read_tester(struct one_wire_query *owq);
 ZERO_OR_ERROR FS_r_aggregate_all(struct one_wire_query *owq);
 SIZE_OR_ERROR FS_read_local( struct one_wire_query *owq);
+void FS_read_batch( struct one_wire_query ** owq, SIZE_OR_ERROR * read_or_error, int count ) ;
 
 size_t FileLength_vascii(struct one_wire_query *owq);
 
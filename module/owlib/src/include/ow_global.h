@@ -94,6 +94,7 @@ struct global {
 	/* Special parameter to trigger William Robison <ibutton@n952.dyndns.ws> timings */
 	int altUSB;
 	int usb_flextime;
+	int usb_pipeline;			// overlap DS9490 block transfers (experimental)
 	int serial_flextime;
 	int serial_reverse; // reverse polarity ?
 	int serial_hardflow ; // hardware flow control
@@ -113,12 +114,18 @@ struct global {
 	int timeout_persistent_high;
 	int clients_persistent_low;
 	int clients_persistent_high;
+	int timeout_pool;
+	int timeout_pool_check;		// idle before a pooled connection is probed for a server close
+	int connections_pool;
+	int stale_volatile;			// grace after expiry when a cached value is still served
+	int stale_stable;
 	int usb_scan_interval ;
 	int enet_scan_interval ;
 	int pingcrazy;
 	int no_dirall;
 	int no_get;
 	int no_persistence;
+	int no_pipeline;
 	int eightbit_serial;
 	enum zero_support zero ;
 	int i2c_APU ;
@@ -26,11 +26,25 @@ $Id$
 
 /* included in ow_connection.h as the bus-master specific portion of the connection_in structure */
 
+/* shared connection using the pipelined owserver protocol (ow_server_message.c) */
+struct server_pipeline ;
+
+/* idle persistent connection parked in the owserver connection pool */
+struct server_pool_entry {
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
+	time_t idle_since ;
+} ;
+
 struct master_server {
 	char *type;					// for zeroconf
 	char *domain;				// for zeroconf
 	char *name;					// zeroconf name
 	int no_dirall;				// flag that server doesn't support DIRALL
+	struct server_pool_entry * pool ; // idle connections, oldest first (protected by BUSLOCKIN)
+	int pool_size ;				// slots allocated in pool
+	int pool_count ;			// slots in use
+	struct server_pipeline * pipeline ; // pipelined connection, if any (protected by BUSLOCKIN)
+	int no_pipeline ;			// flag that server doesn't support the pipelined protocol
 } ;
 
 struct master_serial {
@@ -75,6 +89,7 @@ struct master_i2c {
 	int index;
 	int i2c_address;
 	int i2c_index ;
+	int rdwr;					// i2c adapter does combined transfers (I2C_RDWR)
 	BYTE configreg;
 	BYTE configchip;
 	/* only one per chip, the bus entries for the other 7 channels point to the first one */
@@ -87,6 +102,9 @@ struct master_ha7 {
 	ASCII lock[10];
 	int locked;
 	int found;
+	int keepalive;				// last response allows reuse of the socket (HTTP/1.1 with Content-Length)
+	ASCII *response;			// reusable response buffer
+	size_t response_size;
 };
 
 struct master_enet {
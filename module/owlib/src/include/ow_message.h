@@ -45,7 +45,16 @@ enum msg_classification {
 	msg_get,
 	msg_dirallslash,
 	msg_getslash,
+	msg_multiget,
 };
+
+/* msg_multiget
+ * Request payload is a list of paths, each null terminated, read with the same control flags.
+ * size is the largest value wanted per path (as for msg_read).
+ * Reply ret is the number of paths, or <0 if the whole request failed.
+ * Reply payload has, for each path in order, a 32-bit length or error (network order)
+ * followed by that many bytes of value.
+ */
 /* message to owserver */
 struct server_msg {
 	int32_t version;
@@ -82,6 +91,18 @@ struct serverpackage {
 // Current version of the protocol
 #define OWSERVER_PROTOCOL_VERSION   0
 
+/* Pipelined protocol
+ * A client offers it by sending an ordinary (protocol 0) persistent request
+ * with Serverprotocol(version) set to OWSERVER_PROTOCOL_PIPELINE.
+ * An owserver that understands answers with the same protocol in its reply version.
+ * If persistence was granted too, every later message on that connection
+ * (both directions) carries a 32-bit request tag (network order) right after the header.
+ * Requests can then be sent back to back and replies come back in any order,
+ * matched by tag. Keep-alive pings carry the tag of the request they stand for.
+ * Older owservers ignore the protocol bits and reply with protocol 0.
+ */
+#define OWSERVER_PROTOCOL_PIPELINE  1
+
 // lower 16 bits is token size (only FROM owserver of course)
 #define Servertokens(tokens)		((tokens)&0xFFFF)
 #define MakeServertokens(tokens)	(tokens)
@@ -57,6 +57,9 @@ $Id$
 #define DEFAULT_THREAD_ATTR	NULL
 #endif							/* OW_MT */
 
+/* Volatile cache entries are spread over this many independently locked trees */
+#define CACHE_SHARDS	16
+
 extern struct mutexes {
 	pthread_mutex_t stat_mutex;
 	pthread_mutex_t controlflags_mutex;
@@ -70,11 +73,17 @@ extern struct mutexes {
 	pthread_mutex_t aliasfind_mutex;
 	pthread_mutex_t aliaslist_mutex;
 	pthread_mutex_t externalcount_mutex;
+	pthread_mutex_t busworker_mutex;
+	pthread_mutex_t coprocess_mutex;
+	pthread_mutex_t refresh_mutex;
+	pthread_mutex_t aliastable_mutex;
 	
 	pthread_mutexattr_t mattr; // mutex attribute -- used for all mutexes
 	my_rwlock_t lib;
 	my_rwlock_t cache;
+	my_rwlock_t cache_shard[CACHE_SHARDS];
 	my_rwlock_t persistent_cache;
+	my_rwlock_t parse_cache;
   #ifdef __UCLIBC__
 	pthread_mutex_t uclibc_mutex;
   #endif							/* __UCLIBC__ */
@@ -94,6 +103,7 @@ extern struct mutexes {
 #define _MUTEX_UNLOCK(mut)	my_pthread_mutex_unlock( &(mut) )
 
 #define RWLOCK_INIT(rw)		my_rwlock_init(    &(rw) )
+#define RWLOCK_INIT_WRITER(rw)	my_rwlock_init_writer( &(rw) )	// never read-locked recursively
 #define RWLOCK_DESTROY(rw)	my_rwlock_destroy( &(rw) )
 
 #define RWLOCK_WLOCK(mut)	my_rwlock_write_lock(   &(mut) )
@@ -112,11 +122,21 @@ extern struct mutexes {
 #define CACHE_RLOCK       	RWLOCK_RLOCK(   Mutex.cache  )
 #define CACHE_RUNLOCK     	RWLOCK_RUNLOCK( Mutex.cache  )
 
+#define SHARD_WLOCK(s)     	RWLOCK_WLOCK(   Mutex.cache_shard[s] )
+#define SHARD_WUNLOCK(s)   	RWLOCK_WUNLOCK( Mutex.cache_shard[s] )
+#define SHARD_RLOCK(s)     	RWLOCK_RLOCK(   Mutex.cache_shard[s] )
+#define SHARD_RUNLOCK(s)   	RWLOCK_RUNLOCK( Mutex.cache_shard[s] )
+
 #define PERSISTENT_WLOCK    RWLOCK_WLOCK(   Mutex.persistent_cache )
 #define PERSISTENT_WUNLOCK  RWLOCK_WUNLOCK( Mutex.persistent_cache )
 #define PERSISTENT_RLOCK    RWLOCK_RLOCK(   Mutex.persistent_cache )
 #define PERSISTENT_RUNLOCK  RWLOCK_RUNLOCK( Mutex.persistent_cache )
 
+#define PARSECACHE_WLOCK    RWLOCK_WLOCK(   Mutex.parse_cache )
+#define PARSECACHE_WUNLOCK  RWLOCK_WUNLOCK( Mutex.parse_cache )
+#define PARSECACHE_RLOCK    RWLOCK_RLOCK(   Mutex.parse_cache )
+#define PARSECACHE_RUNLOCK  RWLOCK_RUNLOCK( Mutex.parse_cache )
+
 #define CONNIN_WLOCK      	RWLOCK_WLOCK(   Inbound_Control.lock )
 #define CONNIN_WUNLOCK    	RWLOCK_WUNLOCK( Inbound_Control.lock )
 #define CONNIN_RLOCK      	RWLOCK_RLOCK(   Inbound_Control.lock )
@@ -163,6 +183,18 @@ extern struct mutexes {
 #define EXTERNALCOUNTLOCK   _MUTEX_LOCK(  Mutex.externalcount_mutex)
 #define EXTERNALCOUNTUNLOCK _MUTEX_UNLOCK(Mutex.externalcount_mutex)
 
+#define BUSWORKERLOCK       _MUTEX_LOCK(  Mutex.busworker_mutex)
+#define BUSWORKERUNLOCK     _MUTEX_UNLOCK(Mutex.busworker_mutex)
+
+#define COPROCESSLOCK       _MUTEX_LOCK(  Mutex.coprocess_mutex)
+#define COPROCESSUNLOCK     _MUTEX_UNLOCK(Mutex.coprocess_mutex)
+
+#define REFRESHLOCK         _MUTEX_LOCK(  Mutex.refresh_mutex)
+#define REFRESHUNLOCK       _MUTEX_UNLOCK(Mutex.refresh_mutex)
+
+#define ALIASTABLELOCK      _MUTEX_LOCK(  Mutex.aliastable_mutex)
+#define ALIASTABLEUNLOCK    _MUTEX_UNLOCK(Mutex.aliastable_mutex)
+
 #define BUSLOCK(pn)       	BUS_lock(pn)
 #define BUSUNLOCK(pn)     	BUS_unlock(pn)
 #define BUSLOCKIN(in)     	BUS_lock_in(in)
@@ -196,11 +228,21 @@ extern struct mutexes {
 #define CACHE_RLOCK			return_ok()
 #define CACHE_RUNLOCK		return_ok()
 
+#define SHARD_WLOCK(s)		return_ok()
+#define SHARD_WUNLOCK(s)	return_ok()
+#define SHARD_RLOCK(s)		return_ok()
+#define SHARD_RUNLOCK(s)	return_ok()
+
 #define PERSISTENT_WLOCK	return_ok()
 #define PERSISTENT_WUNLOCK	return_ok()
 #define PERSISTENT_RLOCK	return_ok()
 #define PERSISTENT_RUNLOCK	return_ok()
 
+#define PARSECACHE_WLOCK	return_ok()
+#define PARSECACHE_WUNLOCK	return_ok()
+#define PARSECACHE_RLOCK	return_ok()
+#define PARSECACHE_RUNLOCK	return_ok()
+
 #define CONNIN_WLOCK		return_ok()
 #define CONNIN_WUNLOCK		return_ok()
 #define CONNIN_RLOCK		return_ok()
@@ -250,6 +292,18 @@ extern struct mutexes {
 #define EXTERNALCOUNTLOCK	return_ok()
 #define EXTERNALCOUNTUNLOCK	return_ok()
 
+#define BUSWORKERLOCK		return_ok()
+#define BUSWORKERUNLOCK		return_ok()
+
+#define COPROCESSLOCK		return_ok()
+#define COPROCESSUNLOCK		return_ok()
+
+#define REFRESHLOCK			return_ok()
+#define REFRESHUNLOCK		return_ok()
+
+#define ALIASTABLELOCK		return_ok()
+#define ALIASTABLEUNLOCK	return_ok()
+
 #define UCLIBCLOCK			return_ok()
 #define UCLIBCUNLOCK		return_ok()
 #define BUSLOCK(pn)			return_ok()
@@ -88,6 +88,7 @@ GOOD_OR_BAD OWQ_create_plus(const char *path, const char *file, struct one_wire_
 void OWQ_destroy(struct one_wire_query *owq);
 
 struct one_wire_query * OWQ_create_from_path(const char *path) ;
+struct one_wire_query * OWQ_create_from_path_on_bus(const char *path, INDEX_OR_ERROR bus_nr) ;
 struct one_wire_query * OWQ_create_sibling(const char *sibling, struct one_wire_query *owq_original) ;
 
 GOOD_OR_BAD OWQ_allocate_read_buffer(struct one_wire_query * owq ) ;
@@ -70,6 +70,9 @@ enum e_long_option { e_error_print = 257, e_error_level, e_debug,
 	e_timeout_volatile, e_timeout_stable, e_timeout_directory, e_timeout_presence,
 	e_timeout_serial, e_timeout_usb, e_timeout_network, e_timeout_server, e_timeout_ftp, e_timeout_ha7, e_timeout_w1,
 	e_timeout_persistent_low, e_timeout_persistent_high, e_clients_persistent_low, e_clients_persistent_high,
+	e_timeout_pool, e_timeout_pool_check, e_connections_pool,
+	e_stale_volatile, e_stale_stable,
+	e_poll,
 	e_concurrent_connections,
 	e_fatal_debug_file,
 	e_baud,
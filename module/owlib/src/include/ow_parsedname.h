@@ -128,8 +128,8 @@ enum ePS_state {
 };
 
 struct parsedname {
-	char path[2*PATH_MAX+2];				// full device name
-	char path_to_server[PATH_MAX+2];			// path without first bus
+	char * path;				// full device name
+	char * path_to_server;			// path without first bus (same allocation as path)
 	char * device_name ;		// for external name
 	struct connection_in *known_bus;	// where this device is located
 	enum ePN_type type;			// real? settings? ...
@@ -158,6 +158,7 @@ struct parsedname {
 #define ALIAS_REQUEST               ( (UINT) 0x00000008 )
 #define SAFEMODE                    ( (UINT) 0x00000010 )
 #define UNCACHED                    ( (UINT) 0x00000020 )
+#define STALE_VALUE                 ( (UINT) 0x00000040 )	// reply: answered from an expired cache entry
 #define OWNET                       ( (UINT) 0x00000100 )
 #define TEMPSCALE_MASK              ( (UINT) 0x00030000 )
 #define TEMPSCALE_BIT      16
@@ -20,8 +20,12 @@ $Id$
 /* -------- Structures ---------- */
 DeviceHeader(stats_cache);
 DeviceHeader(stats_read);
+DeviceHeader(stats_bundle);
+DeviceHeader(stats_poller);
+DeviceHeader(stats_http);
 DeviceHeader(stats_write);
 DeviceHeader(stats_directory);
+DeviceHeader(stats_server);
 DeviceHeader(stats_errors);
 DeviceHeader(stats_thread);
 DeviceHeader(stats_return_code);
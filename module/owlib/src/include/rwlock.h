@@ -1,12 +1,14 @@
 /* From Paul Alfille */
 /* $Id$ */
-/* Implementation of Reader/Writer locks using semaphores and mutexes */
-/* based on "The Little Book of Semaphores" bu Allen B. Downey */
-/* http://www.greenteapress.com */
+/* Reader/Writer locks */
+/* Thin wrapper over pthread_rwlock_t (configure adds -D_XOPEN_SOURCE=500 for it) */
 
-/* Note, these are relatively light-weight rwlocks,
-    only solve writer starvation and no timeout or
-    queued wakeup */
+/* Note, read locks are taken recursively (CONNIN_RLOCK is held for the
+    life of each parsedname, and parsednames nest) so the lock must let a
+    reader in while a writer waits -- the pthread default */
+/* Locks whose read side is never nested (cache, parse cache) use
+    my_rwlock_init_writer instead, so a steady stream of readers can't
+    starve the writer -- where the C library allows it */
 
 #ifndef RWLOCK_H
 #define RWLOCK_H
@@ -16,20 +18,15 @@
 #if OW_MT
 
 #include <pthread.h>
-#include "sem.h"
 
-typedef struct {
-	pthread_mutex_t protect_reader_count;
-	int reader_count;
-	sem_t allow_readers;
-	sem_t no_processes;
-} my_rwlock_t;
+typedef pthread_rwlock_t my_rwlock_t;
 
 void my_rwlock_init(my_rwlock_t * rwlock);
-inline void my_rwlock_write_lock(my_rwlock_t * rwlock);
-inline void my_rwlock_write_unlock(my_rwlock_t * rwlock);
-inline void my_rwlock_read_lock(my_rwlock_t * rwlock);
-inline void my_rwlock_read_unlock(my_rwlock_t * rwlock);
+void my_rwlock_init_writer(my_rwlock_t * rwlock);
+void my_rwlock_write_lock(my_rwlock_t * rwlock);
+void my_rwlock_write_unlock(my_rwlock_t * rwlock);
+void my_rwlock_read_lock(my_rwlock_t * rwlock);
+void my_rwlock_read_unlock(my_rwlock_t * rwlock);
 void my_rwlock_destroy(my_rwlock_t * rwlock);
 
 #else /* not OW_MT */
@@ -129,6 +129,105 @@ int ServerRead(struct request_packet *rp)
 	return ret;
 }
 
+#define MULTI_PATH(paths, index)	(((paths)[index] == NULL) ? "/" : (paths)[index])
+
+// Send to an owserver using the MULTIGET message
+// paths are read together, values[i] gets a malloc-ed, null terminated value and return_values[i] its length or error
+// returns <0 if the owserver can't handle the message at all
+int ServerMultiRead(struct request_packet *rp, const char **paths, int count, char **values, int *return_values)
+{
+	struct server_msg sm;
+	struct client_msg cm;
+	struct serverpackage sp = { NULL, NULL, 0, rp->tokenstring, rp->tokens, };
+	int persistent = 1;
+	int connectfd;
+	int ret;
+	int index;
+	size_t list_length = 0;
+	char *reply;
+
+	for (index = 0; index < count; ++index) {
+		list_length += strlen(MULTI_PATH(paths, index)) + 1;
+	}
+	if (list_length > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE) {
+		return -EMSGSIZE;
+	}
+	sp.data = malloc(list_length);
+	if (sp.data == NULL) {
+		return -ENOMEM;
+	}
+	sp.datasize = 0;
+	for (index = 0; index < count; ++index) {
+		size_t path_length = strlen(MULTI_PATH(paths, index)) + 1;
+		memcpy(&sp.data[sp.datasize], MULTI_PATH(paths, index), path_length);
+		sp.datasize += path_length;
+	}
+
+	memset(&sm, 0, sizeof(struct server_msg));
+	memset(&cm, 0, sizeof(struct client_msg));
+	sm.type = msg_multiget;
+	sm.size = rp->data_length;
+
+	LEVEL_CALL("SERVER MULTIGET count=%d\n", count);
+
+	connectfd = PersistentStart(&persistent, rp->owserver);
+	if (connectfd < 0) {
+		free(sp.data);
+		PersistentEnd(connectfd, persistent, cm.sg & PERSISTENT_MASK, rp->owserver);
+		return -EIO;
+	}
+	sm.sg = SetupSemi(persistent);
+	connectfd = ToServerTwice(connectfd, persistent, &sm, &sp, rp->owserver);
+	free(sp.data);
+	if (connectfd < 0) {
+		PersistentEnd(connectfd, persistent, cm.sg & PERSISTENT_MASK, rp->owserver);
+		return -EIO;
+	}
+
+	reply = FromServerAlloc(connectfd, &cm);
+	ret = cm.ret;
+	if (ret == count && reply != NULL) {
+		// unpack (length-or-error, value) pairs
+		char *reply_pointer = reply;
+		char *reply_end = reply + cm.payload;
+		for (index = 0; index < count; ++index) {
+			int32_t length_or_error;
+			values[index] = NULL;
+			if (reply_pointer + sizeof(int32_t) > reply_end) {
+				return_values[index] = -EIO;
+				continue;
+			}
+			memcpy(&length_or_error, reply_pointer, sizeof(int32_t));
+			reply_pointer += sizeof(int32_t);
+			return_values[index] = length_or_error = ntohl(length_or_error);
+			if (length_or_error <= 0) {
+				continue;
+			}
+			if (reply_pointer + length_or_error > reply_end) {
+				return_values[index] = -EIO;
+				reply_pointer = reply_end;
+				continue;
+			}
+			values[index] = malloc(length_or_error + 1);
+			if (values[index] == NULL) {
+				return_values[index] = -ENOMEM;
+			} else {
+				memcpy(values[index], reply_pointer, length_or_error);
+				values[index][length_or_error] = '\0';
+			}
+			reply_pointer += length_or_error;
+		}
+	} else if (ret >= 0) {
+		ret = -EIO;
+	}
+	if (reply != NULL) {
+		free(reply);
+	}
+
+	PersistentEnd(connectfd, persistent, cm.sg & PERSISTENT_MASK, rp->owserver);
+	return ret;
+}
+
 // Send to an owserver using the PRESENT message
 int ServerPresence(struct request_packet *rp)
 {
@@ -191,7 +290,7 @@ int ServerWrite(struct request_packet *rp)
 		} else if (FromServer(connectfd, &cm, NULL, 0) < 0) {
 			ret = -EIO;
 		} else {
-			uint32_t sg = cm.sg & ~(SHOULD_RETURN_BUS_LIST | PERSISTENT_MASK);
+			uint32_t sg = cm.sg & ~(SHOULD_RETURN_BUS_LIST | PERSISTENT_MASK | STALE_VALUE);
 			ret = cm.ret;
 			if (ow_Global.sg != sg) {
 				//printf("ServerRead: cm.sg changed!  SemiGlobal=%X cm.sg=%X\n", SemiGlobal, cm.sg);
@@ -76,3 +76,51 @@ int OWNET_lread(OWNET_HANDLE h, const char *onewire_path, char *return_string, s
 	CONNIN_RUNLOCK;
 	return return_value;
 }
+
+int OWNET_multiread(OWNET_HANDLE h, const char **onewire_paths, int count, char **return_strings, int *return_values)
+{
+	struct request_packet s_request_packet;
+	struct request_packet *rp = &s_request_packet;
+	int return_value;
+	int index;
+	memset(rp, 0, sizeof(struct request_packet));
+
+	if (count < 1 || onewire_paths == NULL || return_strings == NULL || return_values == NULL) {
+		return -EINVAL;
+	}
+
+	CONNIN_RLOCK;
+	rp->owserver = find_connection_in(h);
+	if (rp->owserver == NULL) {
+		CONNIN_RUNLOCK;
+		return -EBADF;
+	}
+
+	rp->data_length = MAX_READ_BUFFER_SIZE;
+	rp->data_offset = 0;
+
+	return_value = ServerMultiRead(rp, onewire_paths, count, return_strings, return_values);
+	if (return_value < 0) {
+		// older owserver (no MULTIGET) -- one read per path instead
+		unsigned char buffer[MAX_READ_BUFFER_SIZE];
+		rp->read_value = buffer;
+		for (index = 0; index < count; ++index) {
+			rp->path = (onewire_paths[index] == NULL) ? "/" : onewire_paths[index];
+			return_strings[index] = NULL;
+			return_values[index] = ServerRead(rp);
+			if (return_values[index] > 0) {
+				return_strings[index] = malloc(return_values[index] + 1);
+				if (return_strings[index] == NULL) {
+					return_values[index] = -ENOMEM;
+				} else {
+					memcpy(return_strings[index], buffer, return_values[index]);
+					return_strings[index][return_values[index]] = '\0';
+				}
+			}
+		}
+		return_value = count;
+	}
+
+	CONNIN_RUNLOCK;
+	return return_value;
+}
@@ -45,7 +45,16 @@ enum msg_classification {
 	msg_get,
 	msg_dirallslash,
 	msg_getslash,
+	msg_multiget,
 };
+
+/* msg_multiget
+ * Request payload is a list of paths, each null terminated, read with the same control flags.
+ * size is the largest value wanted per path (as for msg_read).
+ * Reply ret is the number of paths, or <0 if the whole request failed.
+ * Reply payload has, for each path in order, a 32-bit length or error (network order)
+ * followed by that many bytes of value.
+ */
 /* message to owserver */
 struct server_msg {
 	int32_t version;
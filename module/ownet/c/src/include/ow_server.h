@@ -50,6 +50,7 @@ extern struct ow_global {
 #define PERSISTENT_MASK    ( (UINT) 0x00000004 )
 #define PERSISTENT_BIT     2
 #define ALIAS_REQUEST      ( (UINT) 0x00000008 )
+#define STALE_VALUE        ( (UINT) 0x00000040 )	// reply: answered from an expired cache entry
 #define TEMPSCALE_MASK ( (UINT) 0x00FF0000 )
 #define TEMPSCALE_BIT  16
 #define DEVFORMAT_MASK ( (UINT) 0xFF000000 )
@@ -63,6 +64,7 @@ extern struct ow_global {
 
 int ServerPresence(struct request_packet *rp);
 int ServerRead(struct request_packet *rp);
+int ServerMultiRead(struct request_packet *rp, const char **paths, int count, char **values, int *return_values);
 int ServerWrite(struct request_packet *rp);
 int ServerDir(void (*dirfunc) (void *, const char *), void *v, struct request_packet *rp);
 
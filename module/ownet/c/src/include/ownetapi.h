@@ -99,6 +99,19 @@ extern "C" {
 */
 	int OWNET_lread(OWNET_HANDLE h, const char *onewire_path, char *return_string, size_t size, off_t offset);
 
+/* int OWNET_multiread( OWNET_HANDLE h, const char ** onewire_paths, int count,
+        char ** return_strings, int * return_values )
+   Read several one-wire device properties in a single owserver message.
+   The owserver reads properties of the same device together (one device lock).
+   return_strings[i] has the result for onewire_paths[i] (or NULL)
+     and must be free-ed by the calling program.
+   return_values[i] is the length of that result or <0 on error
+
+   returns count on success,
+   returns <0 on error
+*/
+	int OWNET_multiread(OWNET_HANDLE h, const char **onewire_paths, int count, char **return_strings, int *return_values);
+
 /* int OWNET_put( OWNET_HANDLE h, const char * onewire_path, 
         const unsigned char * value_string, size_t size)
    Write a value to a one-wire device property,
@@ -59,8 +59,8 @@ void *DataHandler(void *v)
 #endif
 
 	memset(&cm, 0, sizeof(struct client_msg));
-	cm.version = MakeServerprotocol(OWSERVER_PROTOCOL_VERSION);
-	cm.control_flags = hd->sm.control_flags;			// default flag return -- includes persistence state
+	cm.version = MakeServerprotocol(hd->protocol);
+	cm.control_flags = hd->sm.control_flags & ~STALE_VALUE;			// default flag return -- includes persistence state
 
 	/* Pre-handling for special testing mode to exclude certain messages */
 	switch ((enum msg_classification) hd->sm.type) {
@@ -73,6 +73,7 @@ void *DataHandler(void *v)
 		break;
 	case msg_get:
 	case msg_getslash:
+	case msg_multiget:
 		if (Globals.no_get) {
 			LEVEL_DEBUG("GET message rejected.") ;
 			hd->sm.type = msg_error;
@@ -108,22 +109,7 @@ void *DataHandler(void *v)
 				break;
 			}
 
-			/* Use client persistent settings (temp scale, display mode ...) */
-			pn->control_flags = hd->sm.control_flags;
-			/* Override some settings from control flags */
-			if ( (pn->control_flags & UNCACHED) != 0 ) {
-				// client wants uncached
-				pn->state |= ePS_uncached;
-			}
-			if ( (pn->control_flags & ALIAS_REQUEST) == 0 ) {
-				// client wants unaliased
-				pn->state |= ePS_unaliased;
-			}
-			
-
-			/* Antilooping tags */
-			pn->tokens = hd->sp.tokens;
-			pn->tokenstring = hd->sp.tokenstring;
+			ClientSettings(hd, pn);
 			//printf("Handler: sm.sg=%X pn.state=%X\n", sm.sg, pn.state);
 			//printf("Scale=%s\n", TemperatureScaleName(SGTemperatureScale(sm.sg)));
 
@@ -194,6 +180,15 @@ void *DataHandler(void *v)
 			LEVEL_DEBUG("DataHandler: FS_ParsedName_destroy done");
 		}
 		break;
+	case msg_multiget:			// good message
+		if (hd->sm.payload == 0) {	/* Bad query -- no data after header */
+			LEVEL_DEBUG("No payload -- ignore.") ;
+			cm.ret = -EBADMSG;
+		} else {
+			LEVEL_CALL("Multiget message");
+			retbuffer = MultigetHandler(hd, &cm);
+		}
+		break;
 	case msg_nop:				// "bad" message
 		LEVEL_CALL("NOP message");
 		cm.ret = 0;
@@ -209,7 +204,7 @@ void *DataHandler(void *v)
 
 	TOCLIENTLOCK(hd);
 	if (cm.ret != -EIO) {
-		ToClient(hd->file_descriptor, &cm, retbuffer);
+		ToClient(hd, &cm, retbuffer);
 	} else {
 		ErrorToClient(hd, &cm) ;
 	}
@@ -228,3 +223,23 @@ void *DataHandler(void *v)
 	LEVEL_DEBUG("Finished with client request");
 	return VOID_RETURN;
 }
+
+/* Apply the client's settings to a freshly parsed path */
+void ClientSettings(struct handlerdata *hd, struct parsedname *pn)
+{
+	/* Use client persistent settings (temp scale, display mode ...) */
+	pn->control_flags = hd->sm.control_flags & ~STALE_VALUE;
+	/* Override some settings from control flags */
+	if ( (pn->control_flags & UNCACHED) != 0 ) {
+		// client wants uncached
+		pn->state |= ePS_uncached;
+	}
+	if ( (pn->control_flags & ALIAS_REQUEST) == 0 ) {
+		// client wants unaliased
+		pn->state |= ePS_unaliased;
+	}
+
+	/* Antilooping tags */
+	pn->tokens = hd->sp.tokens;
+	pn->tokenstring = hd->sp.tokenstring;
+}
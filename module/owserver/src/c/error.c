@@ -42,6 +42,6 @@ void ErrorToClient(struct handlerdata *hd, struct client_msg * cm )
 		cm->payload = 0 ;
 		cm->size = 0 ;
 		cm->offset = 0 ;
-		ToClient(hd->file_descriptor, cm, NULL);	// send the ping
+		ToClient(hd, cm, NULL);	// send the ping
 }
 
@@ -0,0 +1,664 @@
+/*
+$Id$
+    OW_HTML -- OWFS used for the web
+    OW -- One-Wire filesystem
+
+    Written 2004 Paul H Alfille
+
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* owserver -- responds to requests over a network socket, and processes them on the 1-wire bus/
+         Basic idea: control the 1-wire bus and answer queries over a network socket
+         Clients can be owperl, owfs, owhttpd, etc...
+         Clients can be local or remote
+                 Eventually will also allow bounce servers.
+
+         syntax:
+                 owserver
+                 -u (usb)
+                 -d /dev/ttyS1 (serial)
+                 -p tcp port
+                 e.g. 3001 or 10.183.180.101:3001 or /tmp/1wire
+*/
+
+
+#include "owserver.h"
+
+#if OW_EVENT_SERVER
+
+/* Event-driven front end for owserver
+ *
+ * A single thread waits (epoll) on the listening sockets and every client connection.
+ * Requests are read without blocking -- header first, then payload -- and only a
+ * complete request is handed to the worker pool (worker.c).
+ * Idle persistent connections cost no thread at all.
+ * Keep-alive pings for slow requests are due when a connection's ping deadline
+ * passes. The loop hands them to the worker pool's ping thread (EventPingSend),
+ * instead of a thread per request, and never writes to a client itself.
+ *
+ * Once a client switches to the pipelined protocol (see ow_message.h) each request
+ * gets its own event_connection (with parent set) and goes straight to the workers,
+ * while the loop keeps reading the next one. Replies share the socket under the
+ * parent's to_client mutex, and the socket stays open until the last one is sent.
+ */
+
+#define EVENT_MAX_EVENTS 64
+
+static FILE_DESCRIPTOR_OR_ERROR event_fd = FILE_DESCRIPTOR_BAD ;
+static struct event_connection * event_listeners = NULL ;
+static struct event_connection * event_clients = NULL ; // list of client connections
+static int event_shutdown = 0 ;
+static pthread_mutex_t event_mutex ; // protects event_clients and state changes of busy connections
+
+#define EVENTLOCK    _MUTEX_LOCK(   event_mutex )
+#define EVENTUNLOCK  _MUTEX_UNLOCK( event_mutex )
+
+static struct timeval tv_ping_long  = { 1 , 000000 } ; // 1 second
+static struct timeval tv_ping_short = { 0 , 500000 } ; // 1/2 second
+
+static GOOD_OR_BAD EventSetup( void ) ;
+static GOOD_OR_BAD EventListen( void ) ;
+static void EventCleanup( void ) ;
+static void EventAccept( struct event_connection * listener ) ;
+static void EventRead( struct event_connection * ec ) ;
+static GOOD_OR_BAD EventArm( struct event_connection * ec, int op ) ;
+static void EventStartMessage( struct event_connection * ec, const struct timeval * timeout ) ;
+static void EventDispatch( struct event_connection * ec ) ;
+static void EventDispatchPipelined( struct event_connection * ec ) ;
+static void EventClose( struct event_connection * ec ) ;
+static void EventRelease( struct event_connection * ec ) ;
+static void EventFree( struct event_connection * ec ) ;
+static void EventPing( struct event_connection * ec, const struct timeval * now ) ;
+static int EventTimers( void ) ;
+static void EventLoop( void ) ;
+
+static GOOD_OR_BAD EventArm( struct event_connection * ec, int op )
+{
+	struct epoll_event ev ;
+
+	memset( &ev, 0, sizeof(struct epoll_event) ) ;
+	// client connections are one-shot so only one thread owns a connection at a time
+	ev.events = ( ec->state == event_listen ) ? EPOLLIN : ( EPOLLIN | EPOLLONESHOT ) ;
+	ev.data.ptr = ec ;
+	if ( epoll_ctl( event_fd, op, ec->hd.file_descriptor, &ev ) != 0 ) {
+		ERROR_DEBUG("Cannot add owserver socket %d to the event set",ec->hd.file_descriptor) ;
+		return gbBAD ;
+	}
+	return gbGOOD ;
+}
+
+static GOOD_OR_BAD EventSetup( void )
+{
+	event_fd = epoll_create( EVENT_MAX_EVENTS ) ;
+	if ( FILE_DESCRIPTOR_NOT_VALID( event_fd ) ) {
+		ERROR_DEBUG("Cannot create epoll descriptor") ;
+		return gbBAD ;
+	}
+
+	_MUTEX_INIT( event_mutex ) ;
+	event_clients = NULL ;
+	event_shutdown = 0 ;
+	return gbGOOD ;
+}
+
+/* Add the (already opened) listening sockets to the event set */
+static GOOD_OR_BAD EventListen( void )
+{
+	struct connection_out * out ;
+	int listener_count = 0 ;
+	int index = 0 ;
+
+	for (out = Outbound_Control.head; out; out = out->next) {
+		++listener_count ;
+	}
+	event_listeners = owcalloc( listener_count, sizeof(struct event_connection) ) ;
+	if ( event_listeners == NULL ) {
+		return gbBAD ;
+	}
+
+	for (out = Outbound_Control.head; out; out = out->next) {
+		struct event_connection * listener = &event_listeners[index++] ;
+		listener->state = event_listen ;
+		listener->out = out ;
+		listener->hd.file_descriptor = out->file_descriptor ;
+		if ( FILE_DESCRIPTOR_NOT_VALID( out->file_descriptor ) ) {
+			continue ;
+		}
+		// a connection reset between wakeup and accept must not stall the loop
+		fcntl( out->file_descriptor, F_SETFL, fcntl( out->file_descriptor, F_GETFL, 0 ) | O_NONBLOCK ) ;
+		EventArm( listener, EPOLL_CTL_ADD ) ;
+	}
+	return gbGOOD ;
+}
+
+static void EventCleanup( void )
+{
+	EVENTLOCK ;
+	while ( event_clients != NULL ) {
+		EventClose( event_clients ) ;
+	}
+	EVENTUNLOCK ;
+	_MUTEX_DESTROY( event_mutex ) ;
+
+	SAFEFREE( event_listeners ) ;
+	Test_and_Close( &event_fd ) ;
+}
+
+/* New client connection on a listening socket */
+static void EventAccept( struct event_connection * listener )
+{
+	struct event_connection * ec ;
+	FILE_DESCRIPTOR_OR_ERROR acceptfd = accept( listener->out->file_descriptor, NULL, NULL ) ;
+	struct timeval tv_server = { Globals.timeout_server, 0, } ;
+
+	if ( FILE_DESCRIPTOR_NOT_VALID( acceptfd ) ) {
+		return ;
+	}
+
+	ec = owcalloc( 1, sizeof(struct event_connection) ) ;
+	if ( ec == NULL ) {
+		LEVEL_DEBUG("Could not allocate memory to handle this connection");
+		close( acceptfd ) ;
+		return ;
+	}
+
+	ec->out = listener->out ;
+	ec->hd.file_descriptor = acceptfd ;
+	Init_Pipe( ec->hd.ping_pipe ) ; // completion is seen through hd.toclient, not a pipe
+	_MUTEX_INIT( ec->hd.to_client ) ;
+	EventStartMessage( ec, &tv_server ) ;
+
+	EVENTLOCK ;
+	ec->next = event_clients ;
+	if ( event_clients != NULL ) {
+		event_clients->prev = ec ;
+	}
+	event_clients = ec ;
+	if ( BAD( EventArm( ec, EPOLL_CTL_ADD ) ) ) {
+		EventClose( ec ) ;
+	}
+	EVENTUNLOCK ;
+}
+
+/* Get ready to read the next request on this connection */
+static void EventStartMessage( struct event_connection * ec, const struct timeval * timeout )
+{
+	struct timeval now ;
+
+	ec->state = event_header ;
+	ec->have = 0 ;
+	ec->trueload = 0 ;
+	ec->msg = NULL ;
+	ec->long_wait = 0 ;
+	memset( &ec->hd.sp, 0, sizeof(struct serverpackage) ) ;
+
+	gettimeofday( &now, NULL ) ;
+	timeradd( &now, timeout, &ec->deadline ) ;
+}
+
+/* Data available on a client connection. Read whatever is there without blocking */
+static void EventRead( struct event_connection * ec )
+{
+	struct timeval tv_server = { Globals.timeout_server, 0, } ;
+	// pipelined requests have a tag after the header
+	size_t header_length = sizeof(struct server_msg) + ( ec->pipelined ? sizeof(int32_t) : 0 ) ;
+
+	while (1) {
+		BYTE * buffer ;
+		size_t wanted ;
+		ssize_t read_result ;
+
+		if ( ec->state == event_header ) {
+			buffer = ec->header + ec->have ;
+			wanted = header_length - ec->have ;
+		} else {
+			buffer = ec->msg + ec->have ;
+			wanted = ec->trueload - ec->have ;
+		}
+
+		read_result = recv( ec->hd.file_descriptor, buffer, wanted, MSG_DONTWAIT ) ;
+		if ( read_result < 0 ) {
+			if ( errno == EINTR ) {
+				continue ;
+			}
+			if ( errno == EAGAIN || errno == EWOULDBLOCK ) {
+				// partial message -- wait for more
+				if ( GOOD( EventArm( ec, EPOLL_CTL_MOD ) ) ) {
+					return ;
+				}
+			} else {
+				LEVEL_DATA("Network data read error errno=%d %s", errno, strerror(errno));
+				STAT_ADD1(NET_read_errors);
+			}
+			break ;
+		} else if ( read_result == 0 ) {
+			// EOF -- client is done with this connection
+			break ;
+		}
+
+		TrafficInFD("NETREAD", buffer, read_result, ec->hd.file_descriptor ) ;
+		if ( ec->have == 0 && ec->state == event_header ) {
+			// request under way, so the idle timeout gives way to the read timeout
+			struct timeval now ;
+			gettimeofday( &now, NULL ) ;
+			timeradd( &now, &tv_server, &ec->deadline ) ;
+		}
+		ec->have += read_result ;
+		if ( ec->have < header_length && ec->state == event_header ) {
+			continue ;
+		}
+
+		if ( ec->state == event_header ) {
+			memcpy( &ec->hd.sm, ec->header, sizeof(struct server_msg) ) ;
+			if ( ec->pipelined ) {
+				int32_t network_order_tag ;
+				memcpy( &network_order_tag, &ec->header[sizeof(struct server_msg)], sizeof(int32_t) ) ;
+				ec->hd.tag = ntohl( network_order_tag ) ;
+			}
+			if ( FromClientHeader( &ec->hd, &ec->trueload ) != 0 ) {
+				break ;
+			}
+			if ( ec->trueload == 0 ) {
+				EventDispatch( ec ) ;
+				return ;
+			}
+			if ( (ec->msg = owmalloc( ec->trueload )) == NULL ) {
+				break ;
+			}
+			ec->state = event_payload ;
+			ec->have = 0 ;
+		} else if ( (ssize_t) ec->have == ec->trueload ) {
+			BYTE * msg = ec->msg ;
+			ec->msg = NULL ; // FromClientPayload owns it now
+			if ( FromClientPayload( &ec->hd, msg ) != 0 ) {
+				break ;
+			}
+			EventDispatch( ec ) ;
+			return ;
+		}
+	}
+
+	// Error, EOF or bad message -- drop the connection like the threaded Handler does
+	EVENTLOCK ;
+	EventClose( ec ) ;
+	EVENTUNLOCK ;
+}
+
+/* Complete request -- give it to a worker */
+static void EventDispatch( struct event_connection * ec )
+{
+	struct timeval now ;
+
+	if ( ec->pipelined ) {
+		EventDispatchPipelined( ec ) ;
+		return ;
+	}
+
+	gettimeofday( &now, NULL ) ;
+	EVENTLOCK ;
+	ec->state = event_busy ;
+	ec->hd.toclient = toclient_postping ;
+	timeradd( &now, &tv_ping_long, &ec->deadline ) ;
+	EVENTUNLOCK ;
+
+	WorkerPoolSubmit( ec ) ;
+}
+
+/* Complete request on a pipelined connection -- answer it in its own
+ * event_connection and go straight back to reading the connection */
+static void EventDispatchPipelined( struct event_connection * ec )
+{
+	struct event_connection * request = owcalloc( 1, sizeof(struct event_connection) ) ;
+	struct timeval tv_low = { Globals.timeout_persistent_low, 0, };
+	struct timeval now ;
+
+	if ( request == NULL ) {
+		LEVEL_DEBUG("Could not allocate memory to handle this request");
+		EVENTLOCK ;
+		EventClose( ec ) ;
+		EVENTUNLOCK ;
+		return ;
+	}
+
+	request->parent = ec ;
+	request->out = ec->out ;
+	request->hd.file_descriptor = ec->hd.file_descriptor ;
+	request->hd.sm = ec->hd.sm ;
+	request->hd.sp = ec->hd.sp ; // takes over the path buffer
+	request->hd.tag = ec->hd.tag ;
+	request->hd.protocol = OWSERVER_PROTOCOL_PIPELINE ;
+	request->hd.pipelined = 1 ;
+	request->hd.socket_mutex = &(ec->hd.to_client) ;
+	request->hd.toclient = toclient_postping ;
+	Init_Pipe( request->hd.ping_pipe ) ;
+	_MUTEX_INIT( request->hd.to_client ) ;
+	request->state = event_busy ;
+
+	EventStartMessage( ec, &tv_low ) ;
+
+	gettimeofday( &now, NULL ) ;
+	EVENTLOCK ;
+	timeradd( &now, &tv_ping_long, &request->deadline ) ;
+	request->next = event_clients ;
+	if ( event_clients != NULL ) {
+		event_clients->prev = request ;
+	}
+	event_clients = request ;
+	++ec->outstanding ;
+	if ( BAD( EventArm( ec, EPOLL_CTL_MOD ) ) ) {
+		EventClose( ec ) ;
+	}
+	EVENTUNLOCK ;
+
+	WorkerPoolSubmit( request ) ;
+}
+
+/* Remove a client connection -- EVENTLOCK must be held */
+static void EventClose( struct event_connection * ec )
+{
+	if ( ec->prev != NULL ) {
+		ec->prev->next = ec->next ;
+	} else {
+		event_clients = ec->next ;
+	}
+	if ( ec->next != NULL ) {
+		ec->next->prev = ec->prev ;
+	}
+	ec->prev = ec->next = NULL ;
+
+	if ( ec->parent == NULL ) {
+		epoll_ctl( event_fd, EPOLL_CTL_DEL, ec->hd.file_descriptor, NULL ) ;
+		if ( ec->outstanding > 0 ) {
+			// replies still to be sent, the last one frees the connection
+			ec->closing = 1 ;
+			return ;
+		}
+	}
+	EventRelease( ec ) ;
+}
+
+/* Free a closed connection unless a ping for it is pending -- EVENTLOCK must be held */
+static void EventRelease( struct event_connection * ec )
+{
+	struct event_connection * parent = ec->parent ;
+
+	if ( ec->ping_queued ) {
+		// the ping thread still uses it, and frees it when done
+		ec->ping_closed = 1 ;
+		return ;
+	}
+
+	if ( parent != NULL ) {
+		// pipelined request answered -- the socket belongs to the parent
+		FreeClientPath( &ec->hd ) ;
+		_MUTEX_DESTROY( ec->hd.to_client ) ;
+		owfree( ec ) ;
+		if ( --parent->outstanding == 0 && parent->closing ) {
+			EventRelease( parent ) ;
+		}
+		return ;
+	}
+	EventFree( ec ) ;
+}
+
+/* Release a client connection already taken out of the list and event set */
+static void EventFree( struct event_connection * ec )
+{
+	Test_and_Close( &(ec->hd.file_descriptor) ) ;
+	if ( ec->msg != NULL ) {
+		owfree( ec->msg ) ;
+	}
+	FreeClientPath( &ec->hd ) ;
+	PersistenceRelease( ec->persistent ) ;
+	_MUTEX_DESTROY( ec->hd.to_client ) ;
+	owfree( ec ) ;
+	LEVEL_DEBUG("OWSERVER handler done");
+}
+
+/* Worker thread: answer the request, then either wait for the next one or close */
+void EventRequest( struct event_connection * ec )
+{
+	struct handlerdata * hd = &ec->hd ;
+	int loop_persistent = 0 ;
+	int pipeline_offered = 0 ;
+
+	if ( ec->parent != NULL ) {
+		// pipelined request -- the connection is persistent already
+		hd->persistent = 1 ;
+		hd->sm.control_flags |= PERSISTENT_MASK ;
+	} else {
+		loop_persistent = PersistenceRequest( hd, &ec->persistent ) ;
+		pipeline_offered = ( Serverprotocol(hd->sm.version) >= OWSERVER_PROTOCOL_PIPELINE ) && ! Globals.no_pipeline ;
+		// answering in kind tells the client we understand, persistence decides if it's used
+		hd->protocol = pipeline_offered ? OWSERVER_PROTOCOL_PIPELINE : OWSERVER_PROTOCOL_VERSION ;
+	}
+
+	timerclear(&hd->tv);
+	gettimeofday(&(hd->tv), NULL);
+	LEVEL_DEBUG("START handler %s",hd->sp.path) ;
+
+	if (Globals.pingcrazy) {	// extra pings
+		TOCLIENTLOCK(hd);
+		PingClient(hd);	// send the ping
+		TOCLIENTUNLOCK(hd);
+		LEVEL_DEBUG("Extra ping (pingcrazy mode)");
+	}
+
+	DataHandler( hd ) ;
+	FreeClientPath( hd ) ;
+
+	EVENTLOCK ;
+	if ( ec->parent != NULL ) {
+		EventClose( ec ) ;
+	} else if ( loop_persistent && event_shutdown == 0 ) {
+		struct timeval tv_low = { Globals.timeout_persistent_low, 0, };
+		LEVEL_DEBUG("OWSERVER tcp connection persistence -- waiting for next request.");
+		if ( pipeline_offered && ! ec->pipelined ) {
+			LEVEL_DEBUG("OWSERVER tcp connection switched to pipelined protocol.");
+			ec->pipelined = 1 ;
+		}
+		EventStartMessage( ec, &tv_low ) ;
+		if ( BAD( EventArm( ec, EPOLL_CTL_MOD ) ) ) {
+			EventClose( ec ) ;
+		}
+	} else {
+		EventClose( ec ) ;
+	}
+	EVENTUNLOCK ;
+}
+
+/* Keep-alive for a request still in progress -- EVENTLOCK held
+ * Only queued here, the worker may be writing to this client (under its to_client lock)
+ * and the client may not be reading, neither of which may stall the loop */
+static void EventPing( struct event_connection * ec, const struct timeval * now )
+{
+	if ( ! ec->ping_queued ) {
+		ec->ping_queued = 1 ;
+		WorkerPoolPing( ec ) ;
+	}
+	// looked at again after the short wait, EventPingSend stretches it after a ping
+	timeradd( now, &tv_ping_short, &ec->deadline ) ;
+}
+
+/* Ping thread: send the keep-alive queued by EventPing
+ * Skipped this time round if a reply is being written or the client isn't reading */
+void EventPingSend( struct event_connection * ec )
+{
+	struct handlerdata * hd = &ec->hd ;
+	struct timeval now ;
+	int closed ;
+	int pinged = 0 ;
+
+	EVENTLOCK ;
+	closed = ec->ping_closed ;
+	EVENTUNLOCK ;
+
+	if ( closed ) {
+		// request finished and connection closed meanwhile
+	} else if ( pthread_mutex_trylock( &hd->to_client ) != 0 ) {
+		LEVEL_DEBUG("Ping not needed, reply being sent");
+	} else {
+		switch ( hd->toclient ) {
+			case toclient_complete:
+				// crossed paths, worker will finish up
+				break ;
+			case toclient_postmessage:
+				LEVEL_DEBUG("Ping forestalled by a directory element");
+				hd->toclient = toclient_postping ;
+				break ;
+			case toclient_postping:
+				LEVEL_DEBUG("Taking too long, send a keep-alive pulse");
+				pinged = ( PingClientNoWait(hd) == 0 ) ;	// send the ping
+				break ;
+		}
+		TOCLIENTUNLOCK(hd);
+	}
+
+	gettimeofday( &now, NULL ) ;
+	EVENTLOCK ;
+	ec->ping_queued = 0 ;
+	if ( ec->ping_closed ) {
+		EventRelease( ec ) ;
+	} else if ( pinged && ec->state == event_busy ) {
+		timeradd( &now, &tv_ping_long, &ec->deadline ) ;
+	}
+	EVENTUNLOCK ;
+}
+
+/* Pings and timeouts. Returns milliseconds until the next deadline (or -1 for none) */
+static int EventTimers( void )
+{
+	struct event_connection * ec ;
+	struct event_connection * ec_next ;
+	struct timeval now ;
+	struct timeval next_deadline ;
+	int wait_ms = -1 ;
+
+	gettimeofday( &now, NULL ) ;
+	timerclear( &next_deadline ) ;
+
+	EVENTLOCK ;
+	for ( ec = event_clients ; ec != NULL ; ec = ec_next ) {
+		ec_next = ec->next ;
+		if ( timercmp( &now, &ec->deadline, >= ) ) {
+			switch ( ec->state ) {
+				case event_busy:
+					EventPing( ec, &now ) ;
+					break ;
+				case event_header:
+					if ( ec->have == 0 && ec->outstanding > 0 ) {
+						// not idle, still answering pipelined requests
+						timeradd( &now, &tv_ping_long, &ec->deadline ) ;
+						break ;
+					}
+					if ( ec->have == 0 && ec->persistent && ec->long_wait == 0 && PersistenceLongWait() ) {
+						// idle persistent connection -- allowed the longer wait
+						struct timeval tv_delta = { Globals.timeout_persistent_high - Globals.timeout_persistent_low, 0, } ;
+						ec->long_wait = 1 ;
+						timeradd( &ec->deadline, &tv_delta, &ec->deadline ) ;
+						break ;
+					}
+					// fall through
+				default:
+					LEVEL_DEBUG("Timeout on owserver connection %d",ec->hd.file_descriptor) ;
+					EventClose( ec ) ;
+					continue ;
+			}
+		}
+		if ( !timerisset( &next_deadline ) || timercmp( &ec->deadline, &next_deadline, < ) ) {
+			next_deadline = ec->deadline ;
+		}
+	}
+	EVENTUNLOCK ;
+
+	if ( timerisset( &next_deadline ) ) {
+		struct timeval delta ;
+		if ( timercmp( &next_deadline, &now, > ) ) {
+			timersub( &next_deadline, &now, &delta ) ;
+			wait_ms = delta.tv_sec * 1000 + delta.tv_usec / 1000 + 1 ;
+		} else {
+			wait_ms = 0 ;
+		}
+	}
+	return wait_ms ;
+}
+
+/* Main loop -- runs until shutdown is signalled */
+static void EventLoop( void )
+{
+	while ( StateInfo.shutting_down == 0 ) {
+		struct epoll_event events[EVENT_MAX_EVENTS] ;
+		int nevents = epoll_wait( event_fd, events, EVENT_MAX_EVENTS, EventTimers() ) ;
+		int i ;
+
+		if ( nevents < 0 ) {
+			if ( errno == EINTR ) {
+				continue ;
+			}
+			ERROR_DEBUG("Event wait problem") ;
+			break ;
+		}
+
+		for ( i = 0 ; i < nevents ; ++i ) {
+			struct event_connection * ec = events[i].data.ptr ;
+			if ( ec->state == event_listen ) {
+				EventAccept( ec ) ;
+			} else {
+				EventRead( ec ) ;
+			}
+		}
+	}
+}
+
+void EventServerProcess( void )
+{
+	if ( BAD( EventSetup() ) ) {
+		LEVEL_DEBUG("No event-driven front end. Use a thread per connection.") ;
+		ServerProcess( Handler ) ;
+		return ;
+	}
+
+	if ( BAD( WorkerPoolSetup( Globals.concurrent_connections ) ) ) {
+		LEVEL_DEBUG("No worker threads. Use a thread per connection.") ;
+		EventCleanup() ;
+		ServerProcess( Handler ) ;
+		return ;
+	}
+
+	if ( BAD( SetupListenSockets( Handler ) ) ) {
+		LEVEL_DEFAULT("Isolated from any control -- exit") ;
+		WorkerPoolStop() ;
+		EventCleanup() ;
+		return ;
+	}
+
+	if ( GOOD( EventListen() ) ) {
+		EventLoop() ;
+	} else {
+		LEVEL_DEFAULT("Cannot watch the listening sockets -- exit") ;
+	}
+
+	// Let requests in progress finish, then close everything
+	EVENTLOCK ;
+	event_shutdown = 1 ;
+	EVENTUNLOCK ;
+	WorkerPoolStop() ;
+	EventCleanup() ;
+	CloseListenSockets() ;
+}
+
+#endif /* OW_EVENT_SERVER */
@@ -43,6 +43,7 @@ int FromClient(struct handlerdata *hd)
 	BYTE *msg;
 	ssize_t trueload;
 	size_t actual_read ;
+	int ret ;
 	struct timeval tv = { Globals.timeout_server, 0, };
 	//printf("FromClient\n");
 
@@ -56,6 +57,33 @@ int FromClient(struct handlerdata *hd)
 		return -EIO;
 	}
 
+	ret = FromClientHeader( hd, &trueload ) ;
+	if ( ret != 0 || trueload == 0 ) {
+		return ret ;
+	}
+
+	/* Can allocate space? */
+	if ((msg = owmalloc(trueload)) == NULL) {	/* create a buffer */
+		hd->sm.type = msg_error;
+		return -ENOMEM;
+	}
+
+	/* read in data */
+	tcp_read(hd->file_descriptor, msg, trueload, &tv, &actual_read) ;
+	if ((ssize_t)actual_read != trueload) {	/* read in the expected data */
+		hd->sm.type = msg_error;
+		owfree(msg);
+		return -EIO;
+	}
+
+	return FromClientPayload( hd, msg ) ;
+}
+
+/* Header (struct server_msg) has been read into hd->sm in network order.
+   Translate it and compute the size of the rest of the message.
+   Used by both the blocking reader above and the event-driven front end */
+int FromClientHeader(struct handlerdata *hd, ssize_t * trueload)
+{
 	/* translate endian state */
 	hd->sm.version = ntohl(hd->sm.version);
 	hd->sm.payload = ntohl(hd->sm.payload);
@@ -67,37 +95,30 @@ int FromClient(struct handlerdata *hd)
 	LEVEL_DEBUG("FromClient payload=%d size=%d type=%d sg=0x%X offset=%d", hd->sm.payload, hd->sm.size, hd->sm.type, hd->sm.control_flags, hd->sm.offset);
 
 	/* figure out length of rest of message: payload plus tokens */
-	trueload = hd->sm.payload;
+	trueload[0] = hd->sm.payload;
 	if (isServermessage(hd->sm.version)) {
-		trueload += sizeof(union antiloop) * Servertokens(hd->sm.version);
-		LEVEL_DEBUG("FromClient (servermessage) payload=%d nrtokens=%d trueload=%d size=%d type=%d controlflags=0x%X offset=%d", hd->sm.payload, Servertokens(hd->sm.version), trueload, hd->sm.size, hd->sm.type, hd->sm.control_flags, hd->sm.offset);
+		trueload[0] += sizeof(union antiloop) * Servertokens(hd->sm.version);
+		LEVEL_DEBUG("FromClient (servermessage) payload=%d nrtokens=%d trueload=%d size=%d type=%d controlflags=0x%X offset=%d", hd->sm.payload, Servertokens(hd->sm.version), trueload[0], hd->sm.size, hd->sm.type, hd->sm.control_flags, hd->sm.offset);
 	} else {
 		LEVEL_DEBUG("FromClient (no servermessage) payload=%d size=%d type=%d controlflags=0x%X offset=%d", hd->sm.payload, hd->sm.size, hd->sm.type, hd->sm.control_flags, hd->sm.offset);
 	}
-	if (trueload == 0) {
+	if (trueload[0] == 0) {
 		return 0;
 	}
 
 	/* valid size? */
-	if ((hd->sm.payload < 0) || (trueload > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE)) {
+	if ((hd->sm.payload < 0) || (trueload[0] > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE)) {
 		hd->sm.type = msg_error;
 		return -EMSGSIZE;
 	}
 
-	/* Can allocate space? */
-	if ((msg = owmalloc(trueload)) == NULL) {	/* create a buffer */
-		hd->sm.type = msg_error;
-		return -ENOMEM;
-	}
-
-	/* read in data */
-	tcp_read(hd->file_descriptor, msg, trueload, &tv, &actual_read) ;
-	if ((ssize_t)actual_read != trueload) {	/* read in the expected data */
-		hd->sm.type = msg_error;
-		owfree(msg);
-		return -EIO;
-	}
+	return 0 ;
+}
 
+/* The rest of the message (payload plus antiloop tokens) is in msg
+   msg is owned by hd->sp.path on success, and freed on error */
+int FromClientPayload(struct handlerdata *hd, BYTE * msg)
+{
 	/* path has null termination? */
 	if (hd->sm.payload) {
 		int pathlen;
@@ -131,3 +152,16 @@ int FromClient(struct handlerdata *hd)
 	hd->sp.path = (char *) msg;
 	return 0;
 }
+
+/* Release the path buffer allocated in FromClient */
+void FreeClientPath(struct handlerdata *hd)
+{
+	if (hd->sp.path) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+	// allocated in FromClient with owmalloc, but cast to const
+		owfree( (void *) hd->sp.path);
+#pragma GCC diagnostic pop
+		hd->sp.path = NULL;
+	}
+}
@@ -56,51 +56,15 @@ void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 	struct timeval tv_high = { Globals.timeout_persistent_high, 0, };
 	int persistent = 0;
 
+	memset(&hd, 0, sizeof(struct handlerdata)); // protocol 0, not pipelined
 	hd.file_descriptor = file_descriptor;
 	_MUTEX_INIT(hd.to_client);
 
 	timersub(&tv_high, &tv_low, &tv_high);	// just the delta
 
 	while (FromClient(&hd) == 0) {
-		// Was persistence requested?
-		int loop_persistent = ((hd.sm.control_flags & PERSISTENT_MASK) != 0);
-
-		/* Persistence suppression? */
-		if (Globals.no_persistence) {
-			loop_persistent = 0;
-		}
-
-		/* Persistence logic */
-		if (loop_persistent) {	/* Requested persistence */
-			LEVEL_DEBUG("Persistence requested");
-			if (persistent) {	/* already had persistence granted */
-				hd.persistent = 1;	/* so keep it */
-			} else {			/* See if available */
-
-				PERSISTENCELOCK;
-
-				if (persistent_connections < Globals.clients_persistent_high) {	/* ok */
-					++persistent_connections;	/* global count */
-					persistent = 1;	/* connection toggle */
-					hd.persistent = 1;	/* for responses */
-				} else {
-					loop_persistent = 0;	/* denied! */
-					hd.persistent = 0;	/* for responses */
-				}
-
-				PERSISTENCEUNLOCK;
-
-			}
-		} else {				/* No persistence requested this time */
-			hd.persistent = 0;	/* for responses */
-		}
-
-		/* now set the sg flag because it usually is copied back to the client */
-		if (loop_persistent) {
-			hd.sm.control_flags |= PERSISTENT_MASK;
-		} else {
-			hd.sm.control_flags &= ~PERSISTENT_MASK;
-		}
+		// Was persistence requested (and granted)?
+		int loop_persistent = PersistenceRequest(&hd, &persistent);
 
 		/* Do the real work */
 		SingleHandler(&hd);
@@ -113,15 +77,7 @@ void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 		/* Shorter wait */
 		if ( BAD(tcp_wait(file_descriptor, &tv_low)) ) {	// timed out
 			/* test if below threshold for longer wait */
-
-			PERSISTENCELOCK;
-
-			/* store the test because the mutex locks the variable */
-			loop_persistent = (persistent_connections < Globals.clients_persistent_low);
-
-			PERSISTENCEUNLOCK;
-
-			if (loop_persistent == 0) {
+			if (PersistenceLongWait() == 0) {
 				break;			/* too many connections and we're slow */
 			}
 
@@ -137,6 +93,75 @@ void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 	LEVEL_DEBUG("OWSERVER handler done");
 	_MUTEX_DESTROY(hd.to_client);
 	// restore the persistent count
+	PersistenceRelease(persistent);
+}
+
+/* Grant or refuse persistence for the request in hd
+ * persistent tracks whether this connection already holds a persistent slot
+ * returns non-zero if the connection should stay open after the reply
+ */
+int PersistenceRequest(struct handlerdata *hd, int *persistent)
+{
+	int loop_persistent = ((hd->sm.control_flags & PERSISTENT_MASK) != 0);
+
+	/* Persistence suppression? */
+	if (Globals.no_persistence) {
+		loop_persistent = 0;
+	}
+
+	/* Persistence logic */
+	if (loop_persistent) {	/* Requested persistence */
+		LEVEL_DEBUG("Persistence requested");
+		if (persistent[0]) {	/* already had persistence granted */
+			hd->persistent = 1;	/* so keep it */
+		} else {			/* See if available */
+
+			PERSISTENCELOCK;
+
+			if (persistent_connections < Globals.clients_persistent_high) {	/* ok */
+				++persistent_connections;	/* global count */
+				persistent[0] = 1;	/* connection toggle */
+				hd->persistent = 1;	/* for responses */
+			} else {
+				loop_persistent = 0;	/* denied! */
+				hd->persistent = 0;	/* for responses */
+			}
+
+			PERSISTENCEUNLOCK;
+
+		}
+	} else {				/* No persistence requested this time */
+		hd->persistent = 0;	/* for responses */
+	}
+
+	/* now set the sg flag because it usually is copied back to the client */
+	if (loop_persistent) {
+		hd->sm.control_flags |= PERSISTENT_MASK;
+	} else {
+		hd->sm.control_flags &= ~PERSISTENT_MASK;
+	}
+
+	return loop_persistent ;
+}
+
+/* Few enough persistent connections to allow the longer idle wait? */
+int PersistenceLongWait(void)
+{
+	int long_wait ;
+
+	PERSISTENCELOCK;
+
+	/* store the test because the mutex locks the variable */
+	long_wait = (persistent_connections < Globals.clients_persistent_low);
+
+	PERSISTENCEUNLOCK;
+
+	return long_wait ;
+}
+
+/* Give back a persistent slot when the connection closes */
+void PersistenceRelease(int persistent)
+{
 	if (persistent) {
 
 		PERSISTENCELOCK;
@@ -163,32 +188,19 @@ static void SingleHandler(struct handlerdata *hd)
 
 	PingLoop( hd ) ;
 
-	if (hd->sp.path) {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-	// allocated in From_Client with owmalloc, but cast to const
-		owfree( (void *) hd->sp.path);
-#pragma GCC diagnostic pop
-		hd->sp.path = NULL;
-	}
+	FreeClientPath( hd ) ;
 }
 
 #else							/* no OW_MT */
 void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 {
 	struct handlerdata hd;
+	memset(&hd, 0, sizeof(struct handlerdata)); // protocol 0, not pipelined
 	hd.file_descriptor = file_descriptor;
 	if (FromClient(&hd) == 0) {
 		DataHandler(&hd);
 	}
-	if (hd.sp.path) {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-	// allocated in From_Client with owmalloc, but cast to const
-		owfree(hd.sp.path);
-#pragma GCC diagnostic pop
-		hd.sp.path = NULL;
-	}
+	FreeClientPath( &hd ) ;
 }
 
 #endif							/* OW_MT */
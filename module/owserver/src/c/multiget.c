@@ -0,0 +1,224 @@
+/*
+$Id$
+    OW_HTML -- OWFS used for the web
+    OW -- One-Wire filesystem
+
+    Written 2004 Paul H Alfille
+
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* owserver -- responds to requests over a network socket, and processes them on the 1-wire bus/
+         Basic idea: control the 1-wire bus and answer queries over a network socket
+         Clients can be owperl, owfs, owhttpd, etc...
+         Clients can be local or remote
+                 Eventually will also allow bounce servers.
+
+         syntax:
+                 owserver
+                 -u (usb)
+                 -d /dev/ttyS1 (serial)
+                 -p tcp port
+                 e.g. 3001 or 10.183.180.101:3001 or /tmp/1wire
+*/
+
+#include "owserver.h"
+
+/* One path of the request, sorted so a device's properties are together */
+struct multiget_path {
+	const char * path ;
+	size_t dirlength ;	// up to the last '/' -- the device directory
+	int index ;			// position in the request
+};
+
+static int MultigetCompare( const void * a, const void * b ) ;
+static int MultigetSameDirectory( const struct multiget_path * a, const struct multiget_path * b ) ;
+
+/* Multiget, called from DataHandler with the following caveats: */
+/* hd->sp.path is the whole payload: a list of null terminated paths */
+/* sm has been read, cm has been zeroed */
+/* The paths are grouped by device directory and parsed a group at a time: */
+/* the first path finds the device, the rest reuse that bus without searching again */
+/* All are then read together with FS_read_batch */
+/* so that properties of one device share a single device lock */
+/* Multiget will return: */
+/* cm fully constructed, cm->ret the number of paths or an error <0 */
+/* a malloc'ed buffer of (length-or-error, value) pairs that must be free'd by Handler */
+/* The length of buffer is cm->payload */
+void *MultigetHandler(struct handlerdata *hd, struct client_msg *cm)
+{
+	const char * paths = hd->sp.path ;
+	size_t payload = hd->sm.payload ;
+	struct one_wire_query ** owq ;
+	struct one_wire_query ** batch_owq ;
+	struct multiget_path * order ;
+	SIZE_OR_ERROR * read_or_error ;
+	SIZE_OR_ERROR * batch_read_or_error ;
+	int * batch_slot ;
+	int count = 0 ;
+	int batch_count = 0 ;
+	int index ;
+	int sorted ;
+	INDEX_OR_ERROR located_bus = INDEX_BAD ;
+	size_t position ;
+	size_t reply_size ;
+	BYTE * retbuffer = NULL ;
+	BYTE * reply_pointer ;
+
+	LEVEL_DEBUG("MultigetHandler: From Client sm->payload=%d sm->size=%d", hd->sm.payload, hd->sm.size);
+
+	if ((hd->sm.size <= 0) || (hd->sm.size > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE)) {
+		cm->ret = -EMSGSIZE;
+		return NULL ;
+	}
+	if ( paths[payload-1] != '\0' ) {
+		LEVEL_DEBUG("MultigetHandler: last path not terminated");
+		cm->ret = -EBADMSG;
+		return NULL ;
+	}
+
+	for ( position = 0 ; position < payload ; ++position ) {
+		if ( paths[position] == '\0' ) {
+			++count ;
+		}
+	}
+
+	owq = owmalloc( count * ( 2*sizeof(struct one_wire_query *) + 2*sizeof(SIZE_OR_ERROR) + sizeof(int) ) ) ;
+	if ( owq == NULL ) {
+		cm->ret = -ENOBUFS;
+		return NULL ;
+	}
+	batch_owq = & owq[count] ;
+	read_or_error = (SIZE_OR_ERROR *) & batch_owq[count] ;
+	batch_read_or_error = & read_or_error[count] ;
+	batch_slot = (int *) & batch_read_or_error[count] ;
+
+	order = owmalloc( count * sizeof(struct multiget_path) ) ;
+	if ( order == NULL ) {
+		owfree( owq ) ;
+		cm->ret = -ENOBUFS;
+		return NULL ;
+	}
+	for ( index = 0, position = 0 ; index < count ; ++index ) {
+		const char * path = & paths[position] ;
+		const char * slash = strrchr( path, '/' ) ;
+
+		position += strlen(path) + 1 ;
+		order[index].path = path ;
+		order[index].dirlength = ( slash == NULL ) ? 0 : slash - path ;
+		order[index].index = index ;
+	}
+	qsort( order, count, sizeof(struct multiget_path), MultigetCompare ) ;
+
+	/* Parse every path, only good ones go to the batch */
+	for ( sorted = 0 ; sorted < count ; ++sorted ) {
+		const char * path = order[sorted].path ;
+
+		index = order[sorted].index ;
+		if ( sorted > 0 && ! MultigetSameDirectory( &order[sorted-1], &order[sorted] ) ) {
+			// next device
+			located_bus = INDEX_BAD ;
+		}
+		LEVEL_CALL("MultigetHandler: parse path=%s", path);
+		owq[index] = OWQ_create_from_path_on_bus( path, located_bus ) ;
+		if ( owq[index] == NO_ONE_WIRE_QUERY ) {
+			// OWQ_destroy below passes over these
+			read_or_error[index] = -ENOENT ;
+			continue ;
+		}
+		if ( INDEX_NOT_VALID(located_bus) && KnownBus(PN(owq[index])) && ! SpecifiedBus(PN(owq[index])) ) {
+			// found by searching -- the rest of this directory can use it
+			located_bus = PN(owq[index])->known_bus->index ;
+		}
+		ClientSettings( hd, PN(owq[index]) ) ;
+		if ( BAD( OWQ_allocate_read_buffer(owq[index]) ) ) {
+			read_or_error[index] = -ENOBUFS ;
+			continue ;
+		}
+		if ( OWQ_size(owq[index]) > (size_t) hd->sm.size ) {
+			OWQ_size(owq[index]) = hd->sm.size ;
+		}
+		batch_owq[batch_count] = owq[index] ;
+		batch_slot[batch_count] = index ;
+		++batch_count ;
+	}
+
+	FS_read_batch( batch_owq, batch_read_or_error, batch_count ) ;
+
+	/* Size the reply */
+	reply_size = 0 ;
+	for ( index = 0 ; index < batch_count ; ++index ) {
+		read_or_error[batch_slot[index]] = batch_read_or_error[index] ;
+	}
+	for ( index = 0 ; index < count ; ++index ) {
+		reply_size += sizeof(int32_t) ;
+		if ( read_or_error[index] > 0 ) {
+			reply_size += read_or_error[index] ;
+		}
+	}
+
+	if ( reply_size > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) {
+		cm->ret = -EMSGSIZE ;
+	} else if ( (retbuffer = owmalloc(reply_size)) == NULL ) {
+		cm->ret = -ENOBUFS ;
+	} else {
+		reply_pointer = retbuffer ;
+		for ( index = 0 ; index < count ; ++index ) {
+			int32_t length_or_error = htonl( read_or_error[index] ) ;
+
+			memcpy( reply_pointer, &length_or_error, sizeof(int32_t) ) ;
+			reply_pointer += sizeof(int32_t) ;
+			if ( read_or_error[index] > 0 ) {
+				memcpy( reply_pointer, OWQ_buffer(owq[index]), read_or_error[index] ) ;
+				reply_pointer += read_or_error[index] ;
+			}
+		}
+		cm->payload = reply_size ;
+		cm->size = reply_size ;
+		cm->ret = count ;
+	}
+
+	for ( index = 0 ; index < count ; ++index ) {
+		OWQ_destroy( owq[index] ) ;
+	}
+	owfree( order ) ;
+	owfree( owq ) ;
+
+	LEVEL_DEBUG("MultigetHandler: To Client cm->payload=%d cm->ret=%d", cm->payload, cm->ret);
+	return retbuffer;
+}
+
+/* Same device directory first, then request order */
+static int MultigetCompare( const void * a, const void * b )
+{
+	const struct multiget_path * mp_a = (const struct multiget_path *) a ;
+	const struct multiget_path * mp_b = (const struct multiget_path *) b ;
+	size_t length = ( mp_a->dirlength < mp_b->dirlength ) ? mp_a->dirlength : mp_b->dirlength ;
+	int cmp = memcmp( mp_a->path, mp_b->path, length ) ;
+
+	if ( cmp != 0 ) {
+		return cmp ;
+	}
+	if ( mp_a->dirlength != mp_b->dirlength ) {
+		return ( mp_a->dirlength < mp_b->dirlength ) ? -1 : 1 ;
+	}
+	return mp_a->index - mp_b->index ;
+}
+
+static int MultigetSameDirectory( const struct multiget_path * a, const struct multiget_path * b )
+{
+	return a->dirlength == b->dirlength && memcmp( a->path, b->path, a->dirlength ) == 0 ;
+}
@@ -93,13 +93,20 @@ int main(int argc, char **argv)
 	set_exit_signal_handlers(exit_handler);
 	set_signal_handlers(NULL);
 
+	/* Keep the cache warm for --poll schedules */
+	PollerStart();
+
 #if OW_MT
 	_MUTEX_INIT(persistence_mutex);
 #endif
 
 	/* Set up "Antiloop" -- a unique token */
 	SetupAntiloop();
+#if OW_EVENT_SERVER
+	EventServerProcess();
+#else							/* OW_EVENT_SERVER */
 	ServerProcess( Handler );
+#endif							/* OW_EVENT_SERVER */
 	LEVEL_DEBUG("ServerProcess done");
 #if OW_MT
 	_MUTEX_DESTROY(persistence_mutex);
@@ -54,7 +54,12 @@ struct client_msg ping_cm = {
 
 void PingClient(struct handlerdata *hd)
 {
-		ToClient(hd->file_descriptor, &ping_cm, NULL);	// send the ping
+		ToClient(hd, &ping_cm, NULL);	// send the ping
+}
+
+int PingClientNoWait(struct handlerdata *hd)
+{
+	return ToClientNoWait(hd, &ping_cm, NULL);
 }
 
 #endif							/* OW_MT */
@@ -89,6 +89,10 @@ void *ReadHandler(struct handlerdata *hd, struct client_msg *cm, struct one_wire
 			LEVEL_DEBUG("ReadHandler: FS_read_postparse ok size=%d", read_or_error);
 			// make return size smaller (just large enough)
 			cm->payload = read_or_error;
+			if ( pn->control_flags & STALE_VALUE ) {
+				// answered from an expired cache entry, refresh under way
+				cm->control_flags |= STALE_VALUE;
+			}
 			cm->offset = hd->sm.offset;
 			cm->size = read_or_error;
 			cm->ret = read_or_error;
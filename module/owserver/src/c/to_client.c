@@ -36,25 +36,55 @@ $Id$
 */
 
 #include "owserver.h"
+#include <poll.h>
+
+static int ToClientSend(struct handlerdata *hd, struct client_msg *machine_order_cm, const char *data, int wait);
 
 /* Send fully configured message back to client.
    data is optional and length depends on "payload"
+   On a pipelined connection the request tag follows the header
  */
-int ToClient(int file_descriptor, struct client_msg *machine_order_cm, const char *data)
+int ToClient(struct handlerdata *hd, struct client_msg *machine_order_cm, const char *data)
+{
+	return ToClientSend( hd, machine_order_cm, data, 1 ) ;
+}
+
+/* Same, but give up (return 1) rather than wait for a client that isn't reading,
+   or for another reply on a shared pipelined connection.
+   For keep-alive pings, which can simply be sent next time */
+int ToClientNoWait(struct handlerdata *hd, struct client_msg *machine_order_cm, const char *data)
+{
+	return ToClientSend( hd, machine_order_cm, data, 0 ) ;
+}
+
+static int ToClientSend(struct handlerdata *hd, struct client_msg *machine_order_cm, const char *data, int wait)
 {
 	struct client_msg s_cm;
 	struct client_msg *network_order_cm = &s_cm;
-	
-	int nio = 1;
+	int32_t network_order_tag = htonl( hd->tag ) ;
+	int file_descriptor = hd->file_descriptor ;
+	int write_error ;
+	struct iovec io[3] ;
+	int nio = 0;
+	int data_io ;
+	ssize_t total_length = 0 ;
+	int i ;
 
+	io[nio].iov_base = network_order_cm ;
+	io[nio].iov_len = sizeof(struct client_msg) ;
+	++nio ;
+	if ( hd->pipelined ) {
+		io[nio].iov_base = &network_order_tag ;
+		io[nio].iov_len = sizeof(int32_t) ;
+		++nio ;
+	}
+	data_io = nio ;
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-qual"
 	// note data should be (const char *) but iovec complains about const arguments
-	struct iovec io[] = {
-		{network_order_cm, sizeof(struct client_msg),},
-		{ (char *) data, machine_order_cm->payload,},
-	};
+	io[data_io].iov_base = (char *) data ;
 #pragma GCC diagnostic pop
+	io[data_io].iov_len = machine_order_cm->payload ;
 
 	LEVEL_DEBUG("payload=%d size=%d, ret=%d, sg=0x%X offset=%d ", machine_order_cm->payload, machine_order_cm->size, machine_order_cm->ret,
 		     machine_order_cm->control_flags, machine_order_cm->offset);
@@ -63,13 +93,13 @@ int ToClient(int file_descriptor, struct client_msg *machine_order_cm, const cha
 		If payload <0, flag to show a delay message, again no data
 	*/
 	if(machine_order_cm->payload < 0) {
-		io[1].iov_len = 0;
+		io[data_io].iov_len = 0;
 		LEVEL_DEBUG("Send delay message");
 	} else if ( machine_order_cm->payload == 0 ) {
-		io[1].iov_len = 0;
+		io[data_io].iov_len = 0;
 	} else if ( data == NULL ) {
 		LEVEL_DEBUG("Bad data pointer -- NULL") ;
-		io[1].iov_len = 0;
+		io[data_io].iov_len = 0;
 	} else {
 		++nio;
 	}
@@ -82,8 +112,37 @@ int ToClient(int file_descriptor, struct client_msg *machine_order_cm, const cha
 	network_order_cm->offset        = htonl( machine_order_cm->offset        );
 
 	if(machine_order_cm->payload >= 0) {
-		TrafficOutFD("to server data",io[1].iov_base,io[1].iov_len,file_descriptor);
+		TrafficOutFD("to server data",io[data_io].iov_base,io[data_io].iov_len,file_descriptor);
 	}
 	
-	return writev(file_descriptor, io, nio) != (ssize_t) (io[0].iov_len + io[1].iov_len);
+	for ( i = 0 ; i < nio ; ++i ) {
+		total_length += io[i].iov_len ;
+	}
+
+	// replies to pipelined requests share the socket
+	if ( hd->socket_mutex != NULL ) {
+		if ( wait ) {
+			_MUTEX_LOCK( hd->socket_mutex[0] ) ;
+		} else if ( pthread_mutex_trylock( hd->socket_mutex ) != 0 ) {
+			// another request's reply is going out, the client is hearing from us anyway
+			LEVEL_DEBUG("Connection busy, nothing sent") ;
+			return 1 ;
+		}
+	}
+	if ( ! wait ) {
+		// a writable socket has room for far more than a header
+		struct pollfd pfd = { .fd = file_descriptor, .events = POLLOUT, } ;
+		if ( poll( &pfd, 1, 0 ) != 1 || (pfd.revents & POLLOUT) == 0 ) {
+			if ( hd->socket_mutex != NULL ) {
+				_MUTEX_UNLOCK( hd->socket_mutex[0] ) ;
+			}
+			LEVEL_DEBUG("Client not reading, nothing sent") ;
+			return 1 ;
+		}
+	}
+	write_error = writev(file_descriptor, io, nio) != total_length ;
+	if ( hd->socket_mutex != NULL ) {
+		_MUTEX_UNLOCK( hd->socket_mutex[0] ) ;
+	}
+	return write_error ;
 }
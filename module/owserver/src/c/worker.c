@@ -0,0 +1,255 @@
+/*
+$Id$
+    OW_HTML -- OWFS used for the web
+    OW -- One-Wire filesystem
+
+    Written 2004 Paul H Alfille
+
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* owserver -- responds to requests over a network socket, and processes them on the 1-wire bus/
+         Basic idea: control the 1-wire bus and answer queries over a network socket
+         Clients can be owperl, owfs, owhttpd, etc...
+         Clients can be local or remote
+                 Eventually will also allow bounce servers.
+
+         syntax:
+                 owserver
+                 -u (usb)
+                 -d /dev/ttyS1 (serial)
+                 -p tcp port
+                 e.g. 3001 or 10.183.180.101:3001 or /tmp/1wire
+*/
+
+
+#include "owserver.h"
+
+#if OW_EVENT_SERVER
+
+/* Fixed pool of worker threads for the event-driven front end.
+ * The epoll loop (event.c) queues connections holding a complete request,
+ * and a worker answers it with EventRequest. The number of workers bounds
+ * the number of requests in progress (--max_connections).
+ * One more thread sends the keep-alive pings for requests that take a while
+ * (EventPingSend), so neither the loop nor a busy pool holds them up.
+ */
+
+static pthread_mutex_t worker_mutex ;
+static pthread_cond_t worker_cond ;
+static struct event_connection * worker_queue_head = NULL ;
+static struct event_connection * worker_queue_tail = NULL ;
+static pthread_t * worker_threads = NULL ;
+static int worker_count = 0 ;
+static int worker_stop = 0 ;
+
+static pthread_cond_t ping_cond ;
+static struct event_connection * ping_queue_head = NULL ;
+static struct event_connection * ping_queue_tail = NULL ;
+static pthread_t ping_thread ;
+static int ping_running = 0 ;
+
+#define WORKERLOCK    _MUTEX_LOCK(   worker_mutex )
+#define WORKERUNLOCK  _MUTEX_UNLOCK( worker_mutex )
+
+static void * WorkerThread(void * v) ;
+static void * PingThread(void * v) ;
+
+static void * WorkerThread(void * v)
+{
+	(void) v ;
+
+	while (1) {
+		struct event_connection * ec ;
+
+		WORKERLOCK ;
+		while ( worker_queue_head == NULL && worker_stop == 0 ) {
+			my_pthread_cond_wait( &worker_cond, &worker_mutex ) ;
+		}
+		ec = worker_queue_head ;
+		if ( ec != NULL ) {
+			worker_queue_head = ec->queue_next ;
+			if ( worker_queue_head == NULL ) {
+				worker_queue_tail = NULL ;
+			}
+			ec->queue_next = NULL ;
+		}
+		WORKERUNLOCK ;
+
+		if ( ec == NULL ) {
+			// stop requested and nothing left to do
+			break ;
+		}
+		EventRequest( ec ) ;
+	}
+	LEVEL_DEBUG("Worker thread done") ;
+	return VOID_RETURN ;
+}
+
+static void * PingThread(void * v)
+{
+	(void) v ;
+
+	while (1) {
+		struct event_connection * ec ;
+
+		WORKERLOCK ;
+		while ( ping_queue_head == NULL && worker_stop == 0 ) {
+			my_pthread_cond_wait( &ping_cond, &worker_mutex ) ;
+		}
+		ec = ping_queue_head ;
+		if ( ec != NULL ) {
+			ping_queue_head = ec->ping_next ;
+			if ( ping_queue_head == NULL ) {
+				ping_queue_tail = NULL ;
+			}
+			ec->ping_next = NULL ;
+		}
+		WORKERUNLOCK ;
+
+		if ( ec == NULL ) {
+			break ;
+		}
+		EventPingSend( ec ) ;
+	}
+	LEVEL_DEBUG("Ping thread done") ;
+	return VOID_RETURN ;
+}
+
+GOOD_OR_BAD WorkerPoolSetup(int workers)
+{
+	if ( workers < 1 ) {
+		workers = 1 ;
+	}
+
+	worker_threads = owcalloc( workers, sizeof(pthread_t) ) ;
+	if ( worker_threads == NULL ) {
+		return gbBAD ;
+	}
+
+	_MUTEX_INIT( worker_mutex ) ;
+	my_pthread_cond_init( &worker_cond, NULL ) ;
+	my_pthread_cond_init( &ping_cond, NULL ) ;
+	worker_queue_head = worker_queue_tail = NULL ;
+	ping_queue_head = ping_queue_tail = NULL ;
+	worker_stop = 0 ;
+
+	if ( pthread_create( &ping_thread, DEFAULT_THREAD_ATTR, PingThread, NULL ) != 0 ) {
+		ERROR_DEBUG("Cannot start the owserver ping thread") ;
+		my_pthread_cond_destroy( &ping_cond ) ;
+		my_pthread_cond_destroy( &worker_cond ) ;
+		_MUTEX_DESTROY( worker_mutex ) ;
+		owfree( worker_threads ) ;
+		worker_threads = NULL ;
+		return gbBAD ;
+	}
+	ping_running = 1 ;
+
+	for ( worker_count = 0 ; worker_count < workers ; ++worker_count ) {
+		if ( pthread_create( &worker_threads[worker_count], DEFAULT_THREAD_ATTR, WorkerThread, NULL ) != 0 ) {
+			ERROR_DEBUG("Could only start %d of %d owserver worker threads",worker_count,workers) ;
+			break ;
+		}
+	}
+
+	if ( worker_count == 0 ) {
+		WORKERLOCK ;
+		worker_stop = 1 ;
+		my_pthread_cond_signal( &ping_cond ) ;
+		WORKERUNLOCK ;
+		pthread_join( ping_thread, NULL ) ;
+		ping_running = 0 ;
+		my_pthread_cond_destroy( &ping_cond ) ;
+		my_pthread_cond_destroy( &worker_cond ) ;
+		_MUTEX_DESTROY( worker_mutex ) ;
+		owfree( worker_threads ) ;
+		worker_threads = NULL ;
+		return gbBAD ;
+	}
+
+	LEVEL_DEBUG("%d owserver worker threads started",worker_count) ;
+	return gbGOOD ;
+}
+
+/* Hand a connection with a complete request to the pool */
+void WorkerPoolSubmit(struct event_connection * ec)
+{
+	ec->queue_next = NULL ;
+
+	WORKERLOCK ;
+	if ( worker_queue_tail == NULL ) {
+		worker_queue_head = ec ;
+	} else {
+		worker_queue_tail->queue_next = ec ;
+	}
+	worker_queue_tail = ec ;
+	my_pthread_cond_signal( &worker_cond ) ;
+	WORKERUNLOCK ;
+}
+
+/* Queue a keep-alive ping for a request in progress */
+void WorkerPoolPing(struct event_connection * ec)
+{
+	ec->ping_next = NULL ;
+
+	WORKERLOCK ;
+	if ( ping_queue_tail == NULL ) {
+		ping_queue_head = ec ;
+	} else {
+		ping_queue_tail->ping_next = ec ;
+	}
+	ping_queue_tail = ec ;
+	my_pthread_cond_signal( &ping_cond ) ;
+	WORKERUNLOCK ;
+}
+
+/* Finish all queued requests and pings and join the threads */
+void WorkerPoolStop(void)
+{
+	int i ;
+
+	if ( worker_threads == NULL ) {
+		return ;
+	}
+
+	WORKERLOCK ;
+	worker_stop = 1 ;
+	pthread_cond_broadcast( &worker_cond ) ;
+	my_pthread_cond_signal( &ping_cond ) ;
+	WORKERUNLOCK ;
+
+	for ( i = 0 ; i < worker_count ; ++i ) {
+		if ( pthread_join( worker_threads[i], NULL ) != 0 ) {
+			LEVEL_DEBUG("Error waiting for owserver worker thread %d",i) ;
+		}
+	}
+
+	if ( ping_running ) {
+		if ( pthread_join( ping_thread, NULL ) != 0 ) {
+			LEVEL_DEBUG("Error waiting for owserver ping thread") ;
+		}
+		ping_running = 0 ;
+	}
+
+	my_pthread_cond_destroy( &ping_cond ) ;
+	my_pthread_cond_destroy( &worker_cond ) ;
+	_MUTEX_DESTROY( worker_mutex ) ;
+	owfree( worker_threads ) ;
+	worker_threads = NULL ;
+	worker_count = 0 ;
+}
+
+#endif /* OW_EVENT_SERVER */
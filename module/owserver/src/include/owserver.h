@@ -42,13 +42,18 @@ struct handlerdata {
 	struct timeval tv;
 	struct server_msg sm;
 	struct serverpackage sp;
+	int protocol; // owserver protocol of the replies
+	int pipelined; // replies carry the request tag
+	int32_t tag; // request tag (pipelined protocol)
+	pthread_mutex_t * socket_mutex; // serializes replies sharing a pipelined connection
 };
 
 /* read from client, free return pointer if not Null */
 int FromClient(struct handlerdata *hd);
 
 /* Send fully configured message back to client */
-int ToClient(int file_descriptor, struct client_msg *cm, const char *data);
+int ToClient(struct handlerdata *hd, struct client_msg *cm, const char *data);
+int ToClientNoWait(struct handlerdata *hd, struct client_msg *cm, const char *data);
 
 /* Read from 1-wire bus and return file contents */
 void *ReadHandler(struct handlerdata *hd, struct client_msg *cm, struct one_wire_query *owq);
@@ -65,6 +70,12 @@ void *DirallHandler(struct handlerdata *hd, struct client_msg *cm, const struct
 /* Newer directory-at-once with directory '/' */
 void *DirallslashHandler(struct handlerdata *hd, struct client_msg *cm, const struct parsedname *pn);
 
+/* Several reads in one message, grouped by device */
+void *MultigetHandler(struct handlerdata *hd, struct client_msg *cm);
+
+/* Apply client control flags and antiloop tokens to a parsed path */
+void ClientSettings(struct handlerdata *hd, struct parsedname *pn);
+
 /* Handle the actual request -- pings handled higher up */
 void *DataHandler(void *v);
 
@@ -74,14 +85,87 @@ void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor);
 /* Send a response to client of an error */
 void ErrorToClient(struct handlerdata *hd, struct client_msg * cm ) ;
 
+/* Release the path buffer allocated in FromClient */
+void FreeClientPath(struct handlerdata *hd);
+
+/* Pieces of FromClient shared with the event-driven front end */
+int FromClientHeader(struct handlerdata *hd, ssize_t * trueload);
+int FromClientPayload(struct handlerdata *hd, BYTE * msg);
+
 #if OW_MT
 
+/* Persistent connection bookkeeping (handler.c) */
+int PersistenceRequest(struct handlerdata *hd, int *persistent);
+int PersistenceLongWait(void);
+void PersistenceRelease(int persistent);
+
 /* Send a timeout ping */
 void PingClient(struct handlerdata *hd);
 
+/* Send a timeout ping unless the client isn't reading -- non-zero if not sent */
+int PingClientNoWait(struct handlerdata *hd);
+
 /* Loop waiting for finish sending pings */
 void PingLoop(struct handlerdata *hd) ;
 
 #endif /* OW_MT */
 
+/* Event-driven front end: one epoll loop reads requests, a fixed pool of workers answers them */
+#if OW_MT && defined(HAVE_SYS_EPOLL_H)
+#define OW_EVENT_SERVER 1
+#else
+#define OW_EVENT_SERVER 0
+#endif
+
+#if OW_EVENT_SERVER
+
+enum event_state {
+	event_listen,  // listening socket
+	event_header,  // collecting struct server_msg (also idle persistent connection)
+	event_payload, // collecting path, data and antiloop tokens
+	event_busy,    // queued for or being processed by a worker
+} ;
+
+// One per listening socket or client connection
+// and one per request in progress on a pipelined connection
+struct event_connection {
+	enum event_state state ;
+	struct connection_out * out ; // listening sockets only
+	struct handlerdata hd ;
+	BYTE header[sizeof(struct server_msg)+sizeof(int32_t)] ; // header (and tag) as read
+	size_t have ; // bytes of header or payload read so far
+	ssize_t trueload ; // payload plus antiloop tokens
+	BYTE * msg ; // payload buffer until handed to hd.sp.path
+	int persistent ; // holds a persistent connection slot
+	int long_wait ; // idle wait already extended to timeout_persistent_high
+	int pipelined ; // client switched to the pipelined protocol
+	int outstanding ; // pipelined requests still being answered
+	int closing ; // closed, but waiting for outstanding replies
+	int ping_queued ; // keep-alive ping waiting for or being sent by the ping thread
+	int ping_closed ; // closed while ping_queued, the ping thread frees it
+	struct event_connection * parent ; // connection of a pipelined request
+	struct timeval deadline ; // read or idle timeout, or next keep-alive ping while busy
+	struct event_connection * prev ; // list of client connections
+	struct event_connection * next ;
+	struct event_connection * queue_next ; // worker queue
+	struct event_connection * ping_next ; // ping queue
+} ;
+
+/* Run the owserver front end (falls back to ServerProcess if epoll is unusable) */
+void EventServerProcess(void) ;
+
+/* Answer one complete request -- called from a worker thread */
+void EventRequest(struct event_connection * ec) ;
+
+/* Send a keep-alive ping for a request in progress -- called from the ping thread */
+void EventPingSend(struct event_connection * ec) ;
+
+/* Fixed pool of threads running EventRequest, plus one sending pings */
+GOOD_OR_BAD WorkerPoolSetup(int workers) ;
+void WorkerPoolSubmit(struct event_connection * ec) ;
+void WorkerPoolPing(struct event_connection * ec) ;
+void WorkerPoolStop(void) ;
+
+#endif /* OW_EVENT_SERVER */
+
 #endif							/* OWSERVER_H */
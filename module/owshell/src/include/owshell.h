@@ -219,6 +219,7 @@ enum msg_classification {
 	msg_get,
 	msg_dirallslash,
 	msg_getslash,
+	msg_multiget,
 };
 /* message to owserver */
 struct server_msg {
@@ -292,6 +293,7 @@ int ServerPresence(ASCII * path);
 #define DEVFORMAT_MASK              ( (UINT) 0xFF000000 )
 #define DEVFORMAT_BIT  24
 #define UNCACHED                    ( (UINT) 0x00000020 )
+#define STALE_VALUE                 ( (UINT) 0x00000040 )
 #define OWNET                       ( (UINT) 0x00000100 )
 
 #define PRINT_ERROR(...)		while ( ! Globals.quiet ) { fprintf( stderr, __VA_ARGS__ ) ; break ; }
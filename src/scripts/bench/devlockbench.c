@@ -0,0 +1,177 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+	Released under the GPL
+	See the header file: ow.h for full attribution
+	1wire/iButton system from Dallas Semiconductor
+*/
+
+/* DeviceLockGet / DeviceLockRelease cost with thousands of devices.
+   libow's per-connection lock table against the tsearch tree with a
+   malloc per lock that it replaced (copied here, minus the
+   filetype checks both versions share) */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_connection.h"
+#include "owcapi.h"
+
+#include <search.h>
+#include <time.h>
+
+#define DEVICES 5000
+#define MAX_THREADS 16
+#define MAX_HELD 8
+
+/* ------- the old tree ------- */
+struct tree_devlock {
+	pthread_mutex_t lock;
+	BYTE sn[SERIAL_NUMBER_SIZE];
+	UINT users;
+};
+
+static void *tree_root = NULL;
+static pthread_mutex_t tree_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int tree_compare(const void *a, const void *b)
+{
+	return memcmp(((const struct tree_devlock *) a)->sn, ((const struct tree_devlock *) b)->sn, SERIAL_NUMBER_SIZE);
+}
+
+static struct tree_devlock *Tree_DeviceLockGet(const BYTE * sn)
+{
+	struct tree_devlock *local_devlock = malloc(sizeof(struct tree_devlock));
+	struct tree_devlock *tree_devlock;
+
+	if (local_devlock == NULL) {
+		return NULL;
+	}
+	memcpy(local_devlock->sn, sn, SERIAL_NUMBER_SIZE);
+
+	pthread_mutex_lock(&tree_mutex);
+	tree_devlock = *(struct tree_devlock **) tsearch(local_devlock, &tree_root, tree_compare);
+	if (tree_devlock == local_devlock) {
+		pthread_mutex_init(&tree_devlock->lock, NULL);
+		tree_devlock->users = 0;
+	} else {
+		free(local_devlock);
+	}
+	++tree_devlock->users;
+	pthread_mutex_unlock(&tree_mutex);
+	pthread_mutex_lock(&tree_devlock->lock);
+	return tree_devlock;
+}
+
+static void Tree_DeviceLockRelease(struct tree_devlock *tree_devlock)
+{
+	pthread_mutex_unlock(&tree_devlock->lock);
+	pthread_mutex_lock(&tree_mutex);
+	if (--tree_devlock->users == 0) {
+		tdelete(tree_devlock, &tree_root, tree_compare);
+		pthread_mutex_destroy(&tree_devlock->lock);
+		free(tree_devlock);
+	}
+	pthread_mutex_unlock(&tree_mutex);
+}
+
+/* ------- benchmark ------- */
+static struct parsedname base_pn;
+static int use_tree;
+static int held;
+static long loops;
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* Each thread locks "held" devices at a time, spread over DEVICES serial numbers */
+static void *worker(void *v)
+{
+	long t = (long) v;
+	long i;
+	struct parsedname pn[MAX_HELD];
+	struct tree_devlock *tree_lock[MAX_HELD];
+
+	for (i = 0; i < loops; i += held) {
+		int h;
+		for (h = 0; h < held; ++h) {
+			UINT dev = (UINT) (((i + h) * 7919 + t * 104729) % DEVICES);
+
+			memcpy(&pn[h], &base_pn, sizeof(struct parsedname));
+			pn[h].lock = NULL;
+			pn[h].sn[1] = dev & 0xFF;
+			pn[h].sn[2] = dev >> 8;
+			pn[h].sn[3] = (BYTE) t;
+			if (use_tree) {
+				tree_lock[h] = Tree_DeviceLockGet(pn[h].sn);
+				if (tree_lock[h] == NULL) {
+					abort();
+				}
+			} else if (DeviceLockGet(&pn[h]) != 0) {
+				abort();
+			}
+		}
+		for (h = 0; h < held; ++h) {
+			if (use_tree) {
+				Tree_DeviceLockRelease(tree_lock[h]);
+			} else {
+				DeviceLockRelease(&pn[h]);
+			}
+		}
+	}
+	return NULL;
+}
+
+static double run(int threads)
+{
+	pthread_t th[MAX_THREADS];
+	long t;
+	double t0 = now();
+
+	for (t = 0; t < threads; ++t) {
+		pthread_create(&th[t], NULL, worker, (void *) t);
+	}
+	for (t = 0; t < threads; ++t) {
+		pthread_join(th[t], NULL);
+	}
+	return loops * threads / (now() - t0);
+}
+
+int main(int argc, char **argv)
+{
+	int threads[] = { 1, 4, 16, };
+	int k;
+
+	loops = (argc > 1) ? atol(argv[1]) : 1000000;
+	if (OW_init("--fake=10 --error_level=0") < 0) {
+		fprintf(stderr, "OW_init failed\n");
+		return 1;
+	}
+	/* a lockable property on a real (fake) connection */
+	if (FS_ParsedName("/10.67C6697351FF/temperature", &base_pn) != 0) {
+		fprintf(stderr, "Cannot parse the test path\n");
+		return 1;
+	}
+
+	printf("%d devices, M lock/unlock per second\n", DEVICES);
+	printf("%5s %8s %12s %10s\n", "held", "threads", "tree+malloc", "table");
+	for (held = 1; held <= MAX_HELD; held *= MAX_HELD) {
+		for (k = 0; k < (int) (sizeof(threads) / sizeof(threads[0])); ++k) {
+			double tree, table;
+			use_tree = 1;
+			tree = run(threads[k]);
+			use_tree = 0;
+			table = run(threads[k]);
+			printf("%5d %8d %12.2f %10.2f\n", held, threads[k], tree / 1e6, table / 1e6);
+			fflush(stdout);
+		}
+	}
+
+	FS_ParsedName_destroy(&base_pn);
+	OW_finish();
+	return 0;
+}
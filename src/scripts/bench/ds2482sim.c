@@ -0,0 +1,369 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+	Released under the GPL
+	See the header file: ow.h for full attribution
+	1wire/iButton system from Dallas Semiconductor
+*/
+
+/* LD_PRELOAD simulator: a DS2482-100 at i2c address 0x18 with one DS18S20.
+   Opening DS2482SIM_DEVICE (default /tmp/ds2482sim) gives an i2c "adapter"
+   whose ioctls are answered here, with the DS2482's busy times.
+   Counts of ioctl, I2C_SMBUS and I2C_RDWR calls are written to
+   DS2482SIM_COUNTS (default /tmp/ds2482sim.counts) on every 1-wire reset.
+   Set DS2482SIM_NORDWR to hide I2C_FUNC_I2C, forcing owlib's smbus path.
+
+   owserver --i2c=/tmp/ds2482sim:0 with LD_PRELOAD=./ds2482sim.so */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <unistd.h>
+
+#define DS2482_ADDRESS 0x18
+
+/* DS2482 commands and registers */
+#define DEVICE_RESET     0xF0
+#define SET_READ_POINTER 0xE1
+#define CHANNEL_SELECT   0xC3
+#define WRITE_CONFIG     0xD2
+#define ONEWIRE_RESET    0xB4
+#define ONEWIRE_WRITE    0xA5
+#define ONEWIRE_TRIPLET  0x78
+
+#define REG_STATUS 0xF0
+#define REG_DATA   0xE1
+#define REG_CONFIG 0xC3
+
+#define STATUS_1WB 0x01
+#define STATUS_PPD 0x02
+#define STATUS_RST 0x10
+#define STATUS_SBR 0x20
+#define STATUS_TSB 0x40
+#define STATUS_DIR 0x80
+
+static int sim_fd = -1;
+static unsigned char status = STATUS_RST | 0x08;
+static unsigned char data = 0;
+static unsigned char config = 0;
+static unsigned char read_pointer = REG_STATUS;
+static long long busy_until = 0;
+static unsigned long count_ioctl = 0;
+static unsigned long count_smbus = 0;
+static unsigned long count_rdwr = 0;
+
+/* The DS18S20: serial number and a 25 C scratchpad, CRCs filled in at open */
+static unsigned char sn[8] = { 0x10, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x00, };
+static unsigned char scratchpad[9] = { 0x32, 0x00, 0x4B, 0x46, 0xFF, 0xFF, 0x0C, 0x10, 0x00, };
+
+/* 1-wire slave state since the last reset */
+enum slave_state { slave_rom, slave_match, slave_selected, slave_scratchpad, slave_search, slave_function, slave_idle, };
+static enum slave_state slave = slave_idle;
+static int slave_index = 0;
+
+static const char *sim_device(void)
+{
+	const char *device = getenv("DS2482SIM_DEVICE");
+	return (device != NULL) ? device : "/tmp/ds2482sim";
+}
+
+static unsigned char crc8(const unsigned char *bytes, int length)
+{
+	unsigned char crc = 0;
+	int i, j;
+
+	for (i = 0; i < length; ++i) {
+		unsigned char byte = bytes[i];
+		for (j = 0; j < 8; ++j) {
+			unsigned char mix = (crc ^ byte) & 1;
+			crc >>= 1;
+			if (mix) {
+				crc ^= 0x8C;
+			}
+			byte >>= 1;
+		}
+	}
+	return crc;
+}
+
+static long long now_us(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static void write_counts(void)
+{
+	const char *name = getenv("DS2482SIM_COUNTS");
+	FILE *counts = fopen((name != NULL) ? name : "/tmp/ds2482sim.counts", "w");
+
+	if (counts != NULL) {
+		fprintf(counts, "ioctl=%lu smbus=%lu rdwr=%lu\n", count_ioctl, count_smbus, count_rdwr);
+		fclose(counts);
+	}
+}
+
+static unsigned char read_register(void)
+{
+	switch (read_pointer) {
+	case REG_STATUS:
+		return status | ((now_us() < busy_until) ? STATUS_1WB : 0);
+	case REG_DATA:
+		return data;
+	case REG_CONFIG:
+		return config;
+	default:
+		return 0xFF;
+	}
+}
+
+/* What the DS18S20 puts on the wire while the master writes this byte */
+static unsigned char slave_byte(unsigned char byte)
+{
+	switch (slave) {
+	case slave_rom:
+		if (byte == 0x55) {
+			slave = slave_match;
+			slave_index = 0;
+		} else if (byte == 0xCC) {
+			slave = slave_selected;
+		} else if (byte == 0xF0) {
+			slave = slave_search;
+			slave_index = 0;
+		} else {
+			slave = slave_idle;
+		}
+		return byte;
+	case slave_match:
+		if (byte != sn[slave_index]) {
+			slave = slave_idle;
+		} else if (++slave_index == 8) {
+			slave = slave_selected;
+		}
+		return byte;
+	case slave_selected:
+		if (byte == 0xBE) {
+			slave = slave_scratchpad;
+			slave_index = 0;
+		} else {
+			slave = slave_function;	// convert etc. -- reads give 1s (done)
+		}
+		return byte;
+	case slave_scratchpad:
+		return byte & ((slave_index < 9) ? scratchpad[slave_index++] : 0xFF);
+	default:
+		return byte;
+	}
+}
+
+static void onewire_reset(void)
+{
+	write_counts();
+	slave = slave_rom;
+	status = STATUS_PPD;
+	read_pointer = REG_STATUS;
+	busy_until = now_us() + 1150;
+}
+
+static void onewire_write(unsigned char byte)
+{
+	data = slave_byte(byte);
+	status = 0;
+	read_pointer = REG_STATUS;
+	busy_until = now_us() + 560;
+}
+
+/* A search with one device: the bits of its serial number, no discrepancies */
+static void onewire_triplet(void)
+{
+	if (slave != slave_search) {
+		status = STATUS_SBR | STATUS_TSB | STATUS_DIR;
+	} else {
+		int bit = (sn[slave_index / 8] >> (slave_index % 8)) & 1;
+		status = bit ? (STATUS_SBR | STATUS_DIR) : STATUS_TSB;
+		++slave_index;
+	}
+	read_pointer = REG_STATUS;
+	busy_until = now_us() + 200;
+}
+
+static int ds2482_command(unsigned char command, unsigned char parameter)
+{
+	switch (command) {
+	case DEVICE_RESET:
+		status = STATUS_RST | 0x08;
+		config = 0;
+		read_pointer = REG_STATUS;
+		slave = slave_idle;
+		return 0;
+	case SET_READ_POINTER:
+		read_pointer = parameter;
+		return 0;
+	case CHANNEL_SELECT:
+		return -1;				// a DS2482-100 has no channels
+	case WRITE_CONFIG:
+		if (((parameter >> 4) ^ 0x0F) != (parameter & 0x0F)) {
+			return -1;
+		}
+		config = parameter & 0x0F;
+		read_pointer = REG_CONFIG;
+		return 0;
+	case ONEWIRE_RESET:
+		onewire_reset();
+		return 0;
+	case ONEWIRE_WRITE:
+		if (now_us() < busy_until) {
+			return -1;			// commands are refused while 1WB is set
+		}
+		onewire_write(parameter);
+		return 0;
+	case ONEWIRE_TRIPLET:
+		onewire_triplet();
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+static int sim_open(const char *path)
+{
+	static int (*real_open) (const char *, int, ...) = NULL;
+
+	if (real_open == NULL) {
+		real_open = dlsym(RTLD_NEXT, "open");
+	}
+	sn[7] = crc8(sn, 7);
+	scratchpad[8] = crc8(scratchpad, 8);
+	sim_fd = real_open("/dev/null", O_RDWR);
+	(void) path;
+	return sim_fd;
+}
+
+int open(const char *path, int flags, ...)
+{
+	static int (*real_open) (const char *, int, ...) = NULL;
+	va_list ap;
+	int mode;
+
+	if (real_open == NULL) {
+		real_open = dlsym(RTLD_NEXT, "open");
+	}
+	va_start(ap, flags);
+	mode = va_arg(ap, int);
+	va_end(ap);
+	if (strcmp(path, sim_device()) == 0) {
+		return sim_open(path);
+	}
+	return real_open(path, flags, mode);
+}
+
+int open64(const char *path, int flags, ...)
+{
+	static int (*real_open64) (const char *, int, ...) = NULL;
+	va_list ap;
+	int mode;
+
+	if (real_open64 == NULL) {
+		real_open64 = dlsym(RTLD_NEXT, "open64");
+	}
+	va_start(ap, flags);
+	mode = va_arg(ap, int);
+	va_end(ap);
+	if (strcmp(path, sim_device()) == 0) {
+		return sim_open(path);
+	}
+	return real_open64(path, flags, mode);
+}
+
+int close(int fd)
+{
+	static int (*real_close) (int) = NULL;
+
+	if (real_close == NULL) {
+		real_close = dlsym(RTLD_NEXT, "close");
+	}
+	if (fd == sim_fd && sim_fd >= 0) {
+		write_counts();
+		sim_fd = -1;
+	}
+	return real_close(fd);
+}
+
+int ioctl(int fd, unsigned long request, ...)
+{
+	static int (*real_ioctl) (int, unsigned long, ...) = NULL;
+	va_list ap;
+	void *arg;
+
+	if (real_ioctl == NULL) {
+		real_ioctl = dlsym(RTLD_NEXT, "ioctl");
+	}
+	va_start(ap, request);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+	if (fd != sim_fd || sim_fd < 0) {
+		return real_ioctl(fd, request, arg);
+	}
+
+	++count_ioctl;
+	switch (request) {
+	case I2C_SLAVE:
+		return ((long) arg == DS2482_ADDRESS) ? 0 : -1;
+	case I2C_FUNCS:
+		*(unsigned long *) arg = I2C_FUNC_SMBUS_BYTE | I2C_FUNC_SMBUS_BYTE_DATA;
+		if (getenv("DS2482SIM_NORDWR") == NULL) {
+			*(unsigned long *) arg |= I2C_FUNC_I2C;
+		}
+		return 0;
+	case I2C_SMBUS:{
+			struct i2c_smbus_ioctl_data *smbus = arg;
+			++count_smbus;
+			if (smbus->read_write == I2C_SMBUS_READ && smbus->size == I2C_SMBUS_BYTE) {
+				smbus->data->byte = read_register();
+				return 0;
+			}
+			if (smbus->read_write == I2C_SMBUS_WRITE && smbus->size == I2C_SMBUS_BYTE) {
+				return ds2482_command(smbus->command, 0);
+			}
+			if (smbus->read_write == I2C_SMBUS_WRITE && smbus->size == I2C_SMBUS_BYTE_DATA) {
+				return ds2482_command(smbus->command, smbus->data->byte);
+			}
+			return -1;
+		}
+	case I2C_RDWR:{
+			struct i2c_rdwr_ioctl_data *rdwr = arg;
+			unsigned int i;
+			++count_rdwr;
+			for (i = 0; i < rdwr->nmsgs; ++i) {
+				struct i2c_msg *msg = &rdwr->msgs[i];
+				int j;
+				if (msg->addr != DS2482_ADDRESS) {
+					return -1;
+				}
+				if (msg->flags & I2C_M_RD) {
+					for (j = 0; j < msg->len; ++j) {
+						msg->buf[j] = read_register();
+					}
+				} else if (msg->len == 1 || msg->len == 2) {
+					if (ds2482_command(msg->buf[0], (msg->len == 2) ? msg->buf[1] : 0) < 0) {
+						return -1;
+					}
+				} else {
+					return -1;
+				}
+			}
+			return rdwr->nmsgs;
+		}
+	default:
+		return -1;
+	}
+}
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# $Id$
+# Fake HA7Net for testing the owlib HA7 bus master without hardware.
+#
+# Answers the Search and WriteBlock pages with DS18S20 temperature
+# sensors (scratchpad reads give 25 C), anything else with an empty page.
+# A second port (port+1) reports how many TCP connections and requests
+# it has seen, e.g.
+#     python3 fakeha7.py 4000 keep &
+#     owserver --ha7=127.0.0.1:4000 -p 4304
+#     owread -s 4304 /uncached/10.....
+#     nc 127.0.0.1 4001    -> conn=1 req=12
+#
+# mode: keep   HTTP/1.1 keep-alive, Content-Length on every reply
+#       close  "Connection: close" and no Content-Length (old HA7 firmware)
+#       stall  like close, but WriteBlock replies stop half way for 3 s
+
+import argparse
+import re
+import socket
+import threading
+import time
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        for _ in range(8):
+            mix = (crc ^ byte) & 1
+            crc >>= 1
+            if mix:
+                crc ^= 0x8C
+            byte >>= 1
+    return crc
+
+
+parser = argparse.ArgumentParser(description="Fake HA7Net responder")
+parser.add_argument("port", type=int)
+parser.add_argument("mode", choices=("keep", "close", "stall"))
+parser.add_argument("--devices", type=int, default=1, help="number of DS18S20s on the bus")
+parser.add_argument("--delay", type=float, default=0.0, help="seconds added to each WriteBlock")
+parser.add_argument("--search-delay", type=float, default=0.0, help="seconds added to each Search")
+args = parser.parse_args()
+
+addresses = []
+for n in range(args.devices):
+    sn = bytes([0x10, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 + n])
+    sn += bytes([crc8(sn)])
+    addresses.append("".join("%02X" % b for b in reversed(sn)))
+
+scratchpad = bytes([0x32, 0x00, 0x4B, 0x46, 0xFF, 0xFF, 0x0C, 0x10])
+scratchpad += bytes([crc8(scratchpad)])
+
+stats = {"conn": 0, "req": 0}
+
+
+def page_body(path):
+    command = re.match(r"/1Wire/(\w+)\.html", path).group(1)
+    query = dict(re.findall(r"[?&](\w+)=([0-9A-Fa-f]*)", path))
+    if command == "Search":
+        return "".join('<INPUT CLASS="HA7Value" NAME="Address_%d" TYPE="TEXT" VALUE="%s">' % (i, a)
+                       for i, a in enumerate(addresses))
+    if command == "WriteBlock":
+        data = bytearray(bytes.fromhex(query.get("Data", "")))
+        for i, byte in enumerate(data):
+            if byte == 0xBE:        # read scratchpad
+                for k in range(9):
+                    if i + 1 + k < len(data):
+                        data[i + 1 + k] = scratchpad[k]
+                break
+            if byte == 0xB4:        # read power supply: powered
+                for k in range(i + 1, len(data)):
+                    data[k] = 0xFF
+                break
+        return '<INPUT TYPE="TEXT" NAME="ResultData_0" VALUE="%s">' % data.hex().upper()
+    return ""
+
+
+def serve(conn):
+    stats["conn"] += 1
+    request = conn.makefile("rb")
+    while True:
+        line = request.readline()
+        if not line:
+            break
+        path = line.split()[1].decode()
+        while request.readline() not in (b"\r\n", b"\n", b""):
+            pass
+        stats["req"] += 1
+        if "Search" in path:
+            time.sleep(args.search_delay)
+        if "WriteBlock" in path:
+            time.sleep(args.delay)
+        html = ("<html><body>" + page_body(path) + "</body></html>").encode()
+        if args.mode == "keep":
+            conn.sendall(b"HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: %d\r\n\r\n" % len(html) + html)
+            continue
+        header = b"HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nConnection: close\r\n\r\n"
+        if args.mode == "stall" and "WriteBlock" in path:
+            # half the page, then silence past owlib's read timeout
+            conn.sendall(header + html[:len(html) // 2])
+            time.sleep(3)
+        else:
+            conn.sendall(header + html)
+        break
+    conn.close()
+
+
+def report(listener):
+    while True:
+        conn, _ = listener.accept()
+        conn.sendall(("conn=%d req=%d\n" % (stats["conn"], stats["req"])).encode())
+        conn.close()
+
+
+def listen(port):
+    sock = socket.socket()
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("127.0.0.1", port))
+    sock.listen(16)
+    return sock
+
+
+server = listen(args.port)
+threading.Thread(target=report, args=(listen(args.port + 1),), daemon=True).start()
+while True:
+    client, _ = server.accept()
+    threading.Thread(target=serve, args=(client,), daemon=True).start()
@@ -0,0 +1,172 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+	Released under the GPL
+	See the header file: ow.h for full attribution
+	1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Cost of parsing a path, alone and as part of a read.
+   FS_ParsedName/FS_ParsedName_destroy, then OWQ_create_from_path +
+   FS_read_postparse + OWQ_destroy, then the whole OW_get, on a --fake
+   connection. The same path each time (a parse cache hit), and each of
+   more devices than the parse cache has slots in turn (nearly all misses) */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "owcapi.h"
+
+#include <time.h>
+
+#define MAX_THREADS 4
+#define DEVICES 10000
+
+static char paths[DEVICES][32];
+static int distinct;
+static long loops;
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static const char *next_path(long i)
+{
+	return paths[distinct ? i % DEVICES : 0];
+}
+
+static void *parse_only(void *v)
+{
+	long i;
+	(void) v;
+
+	for (i = 0; i < loops; ++i) {
+		struct parsedname pn;
+		if (FS_ParsedName(next_path(i), &pn) != 0) {
+			abort();
+		}
+		FS_ParsedName_destroy(&pn);
+	}
+	return NULL;
+}
+
+static void *parse_read(void *v)
+{
+	long i;
+	(void) v;
+
+	for (i = 0; i < loops; ++i) {
+		struct one_wire_query *owq = OWQ_create_from_path(next_path(i));
+		if (owq == NO_ONE_WIRE_QUERY || FS_read_postparse(owq) < 0) {
+			abort();
+		}
+		OWQ_destroy(owq);
+	}
+	return NULL;
+}
+
+static void *owcapi_get(void *v)
+{
+	long i;
+	(void) v;
+
+	for (i = 0; i < loops; ++i) {
+		char *buffer;
+		size_t length;
+		if (OW_get(next_path(i), &buffer, &length) < 0) {
+			abort();
+		}
+		free(buffer);
+	}
+	return NULL;
+}
+
+static double run(void *(*test) (void *), int threads)
+{
+	pthread_t th[MAX_THREADS];
+	long t;
+	double t0 = now();
+
+	for (t = 0; t < threads; ++t) {
+		pthread_create(&th[t], NULL, test, NULL);
+	}
+	for (t = 0; t < threads; ++t) {
+		pthread_join(th[t], NULL);
+	}
+	return loops * threads / (now() - t0);
+}
+
+/* The fake devices' paths, from a directory listing */
+static void collect(void *v, const struct parsedname *pn_entry)
+{
+	int *count = v;
+
+	if (pn_entry->sn[0] != 0x10 || *count >= DEVICES) {
+		return;
+	}
+	snprintf(paths[*count], sizeof(paths[0]), "/%.2X.%.2X%.2X%.2X%.2X%.2X%.2X/type", pn_entry->sn[0], pn_entry->sn[1], pn_entry->sn[2],
+			 pn_entry->sn[3], pn_entry->sn[4], pn_entry->sn[5], pn_entry->sn[6]);
+	++*count;
+}
+
+int main(int argc, char **argv)
+{
+	struct {
+		const char *name;
+		void *(*test) (void *);
+	} tests[] = {
+		{"parse", parse_only,},
+		{"parse+read", parse_read,},
+		{"OW_get", owcapi_get,},
+	};
+	struct parsedname pn_root;
+	char *options = malloc(DEVICES * 3 + 32);
+	char *end;
+	int count = 0;
+	int threads;
+	int k;
+
+	loops = (argc > 1) ? atol(argv[1]) : 200000;
+	if (options == NULL) {
+		return 1;
+	}
+	end = options + sprintf(options, "--error_level=0 --fake=10");
+	for (k = 1; k < DEVICES; ++k) {
+		end += sprintf(end, ",10");
+	}
+	if (OW_init(options) < 0) {
+		fprintf(stderr, "OW_init failed\n");
+		return 1;
+	}
+	free(options);
+	if (FS_ParsedName("/", &pn_root) != 0) {
+		fprintf(stderr, "Cannot parse the root directory\n");
+		return 1;
+	}
+	FS_dir(collect, &count, &pn_root);
+	FS_ParsedName_destroy(&pn_root);
+	if (count < DEVICES) {
+		fprintf(stderr, "Only %d fake devices listed\n", count);
+		return 1;
+	}
+
+	printf("%s and %d others, k operations per second\n", paths[0], DEVICES - 1);
+	printf("%12s %8s %12s %12s\n", "", "threads", "same path", "all devices");
+	for (k = 0; k < (int) (sizeof(tests) / sizeof(tests[0])); ++k) {
+		for (threads = 1; threads <= MAX_THREADS; threads *= MAX_THREADS) {
+			double same, many;
+			distinct = 0;
+			same = run(tests[k].test, threads);
+			distinct = 1;
+			many = run(tests[k].test, threads);
+			printf("%12s %8d %12.1f %12.1f\n", tests[k].name, threads, same / 1e3, many / 1e3);
+			fflush(stdout);
+		}
+	}
+
+	OW_finish();
+	return 0;
+}
@@ -0,0 +1,241 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+	Released under the GPL
+	See the header file: ow.h for full attribution
+	1wire/iButton system from Dallas Semiconductor
+*/
+
+/* my_rwlock_t benchmark: read throughput, and how long a writer waits
+   while readers keep the lock busy.
+   The old semaphore-based lock is copied here for comparison;
+   the other two are libow's my_rwlock_init and my_rwlock_init_writer */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "rwlock.h"
+
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define READERS 16
+#define WRITES 100
+
+/* The my_rwlock_t before pthread_rwlock_t */
+struct sem_rwlock {
+	pthread_mutex_t protect_reader_count;
+	int reader_count;
+	sem_t allow_readers;
+	sem_t no_processes;
+};
+
+static void sem_rwlock_init(struct sem_rwlock *l)
+{
+	pthread_mutex_init(&l->protect_reader_count, NULL);
+	sem_init(&l->allow_readers, 0, 1);
+	sem_init(&l->no_processes, 0, 1);
+	l->reader_count = 1;
+}
+
+static void sem_rwlock_read_lock(struct sem_rwlock *l)
+{
+	sem_wait(&l->allow_readers);
+	sem_post(&l->allow_readers);
+	pthread_mutex_lock(&l->protect_reader_count);
+	if (++l->reader_count == 1) {
+		sem_wait(&l->no_processes);
+	}
+	pthread_mutex_unlock(&l->protect_reader_count);
+}
+
+static void sem_rwlock_read_unlock(struct sem_rwlock *l)
+{
+	pthread_mutex_lock(&l->protect_reader_count);
+	if (--l->reader_count == 0) {
+		sem_post(&l->no_processes);
+	}
+	pthread_mutex_unlock(&l->protect_reader_count);
+}
+
+static int sem_rwlock_timed_write_lock(struct sem_rwlock *l, const struct timespec *deadline)
+{
+	if (sem_timedwait(&l->allow_readers, deadline) != 0) {
+		return 1;
+	}
+	if (sem_timedwait(&l->no_processes, deadline) != 0) {
+		sem_post(&l->allow_readers);
+		return 1;
+	}
+	return 0;
+}
+
+static void sem_rwlock_write_unlock(struct sem_rwlock *l)
+{
+	sem_post(&l->allow_readers);
+	sem_post(&l->no_processes);
+}
+
+enum lock_kind { lock_semaphore, lock_default, lock_writer, lock_kinds };
+static const char *lock_name[lock_kinds] = { "semaphore (old)", "my_rwlock_init", "my_rwlock_init_writer" };
+
+static enum lock_kind kind;
+static struct sem_rwlock sem_lock;
+static my_rwlock_t rw_lock;
+static volatile int stop;
+static volatile unsigned int sink;
+static long loops;
+static long busy_reads[READERS];
+
+static void read_lock(void)
+{
+	if (kind == lock_semaphore) {
+		sem_rwlock_read_lock(&sem_lock);
+	} else {
+		my_rwlock_read_lock(&rw_lock);
+	}
+}
+
+static void read_unlock(void)
+{
+	if (kind == lock_semaphore) {
+		sem_rwlock_read_unlock(&sem_lock);
+	} else {
+		my_rwlock_read_unlock(&rw_lock);
+	}
+}
+
+/* Write lock that gives up after 1 second -- the default lock can starve writers forever */
+static int timed_write_lock(void)
+{
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += 1;
+	if (kind == lock_semaphore) {
+		return sem_rwlock_timed_write_lock(&sem_lock, &deadline);
+	}
+	return pthread_rwlock_timedwrlock(&rw_lock, &deadline);
+}
+
+static void write_unlock(void)
+{
+	if (kind == lock_semaphore) {
+		sem_rwlock_write_unlock(&sem_lock);
+	} else {
+		my_rwlock_write_unlock(&rw_lock);
+	}
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void *reader(void *v)
+{
+	long i;
+
+	(void) v;
+	for (i = 0; i < loops; ++i) {
+		read_lock();
+		sink++;
+		read_unlock();
+	}
+	return NULL;
+}
+
+/* Holds the read lock for a short leaf section, over and over */
+static void *busy_reader(void *v)
+{
+	long t = (long) v;
+
+	while (!stop) {
+		int j;
+		read_lock();
+		for (j = 0; j < 50; ++j) {
+			sink++;
+		}
+		read_unlock();
+		++busy_reads[t];
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	loops = (argc > 1) ? atol(argv[1]) : 2000000;
+
+	printf("%-22s %14s %14s %16s %16s %9s\n", "lock", "1 thread", "16 threads", "writer wait avg", "writer wait max", "gave up");
+	for (kind = 0; kind < lock_kinds; ++kind) {
+		pthread_t th[READERS];
+		double t0, one, many;
+		double wait_sum = 0., wait_max = 0.;
+		int gave_up = 0;
+		long t;
+		int n;
+
+		switch (kind) {
+		case lock_semaphore:
+			sem_rwlock_init(&sem_lock);
+			break;
+		case lock_default:
+			my_rwlock_init(&rw_lock);
+			break;
+		default:
+			my_rwlock_init_writer(&rw_lock);
+			break;
+		}
+
+		t0 = now();
+		reader(NULL);
+		one = loops / (now() - t0);
+
+		t0 = now();
+		for (t = 0; t < READERS; ++t) {
+			pthread_create(&th[t], NULL, reader, NULL);
+		}
+		for (t = 0; t < READERS; ++t) {
+			pthread_join(th[t], NULL);
+		}
+		many = READERS * loops / (now() - t0);
+
+		stop = 0;
+		for (t = 0; t < READERS; ++t) {
+			busy_reads[t] = 0;
+			pthread_create(&th[t], NULL, busy_reader, (void *) t);
+		}
+		for (n = 0; n < WRITES; ++n) {
+			struct timespec gap = { 0, 2000000 };
+			double waited;
+
+			nanosleep(&gap, NULL);
+			t0 = now();
+			if (timed_write_lock() != 0) {
+				++gave_up;
+				continue;
+			}
+			waited = now() - t0;
+			write_unlock();
+			wait_sum += waited;
+			if (waited > wait_max) {
+				wait_max = waited;
+			}
+		}
+		stop = 1;
+		for (t = 0; t < READERS; ++t) {
+			pthread_join(th[t], NULL);
+		}
+
+		printf("%-22s %10.2f M/s %10.2f M/s %13.1f us %13.1f us %5d/%d\n", lock_name[kind], one / 1e6, many / 1e6,
+			   (gave_up < WRITES) ? wait_sum / (WRITES - gave_up) * 1e6 : 0., wait_max * 1e6, gave_up, WRITES);
+		fflush(stdout);
+		if (kind != lock_semaphore) {
+			my_rwlock_destroy(&rw_lock);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+$Id$
+    OWFS -- One-Wire filesystem
+	Released under the GPL
+	See the header file: ow.h for full attribution
+	1wire/iButton system from Dallas Semiconductor
+*/
+
+/* LD_PRELOAD call counter for the network syscalls owlib makes.
+   Counts calls through the C library (not the kernel's view) and appends
+   one line of totals to the file named by SYSCOUNT_OUT at exit.
+   See syscount.sh */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+static volatile long count_read, count_recv, count_select, count_poll;
+static volatile long count_write, count_send, count_writev, count_sendmsg, count_fcntl;
+
+#define REAL(name) static __typeof__(name) *real_##name ; if ( real_##name == NULL ) { real_##name = dlsym(RTLD_NEXT, #name) ; }
+#define COUNT(counter) __sync_add_and_fetch( &(counter), 1 )
+
+ssize_t read(int fd, void *buf, size_t count)
+{
+	REAL(read);
+	COUNT(count_read);
+	return real_read(fd, buf, count);
+}
+
+ssize_t recv(int fd, void *buf, size_t len, int flags)
+{
+	REAL(recv);
+	COUNT(count_recv);
+	return real_recv(fd, buf, len, flags);
+}
+
+int select(int nfds, fd_set * readfds, fd_set * writefds, fd_set * exceptfds, struct timeval *timeout)
+{
+	REAL(select);
+	COUNT(count_select);
+	return real_select(nfds, readfds, writefds, exceptfds, timeout);
+}
+
+int poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+	REAL(poll);
+	COUNT(count_poll);
+	return real_poll(fds, nfds, timeout);
+}
+
+ssize_t write(int fd, const void *buf, size_t count)
+{
+	REAL(write);
+	COUNT(count_write);
+	return real_write(fd, buf, count);
+}
+
+ssize_t send(int fd, const void *buf, size_t len, int flags)
+{
+	REAL(send);
+	COUNT(count_send);
+	return real_send(fd, buf, len, flags);
+}
+
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+	REAL(writev);
+	COUNT(count_writev);
+	return real_writev(fd, iov, iovcnt);
+}
+
+ssize_t sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+	REAL(sendmsg);
+	COUNT(count_sendmsg);
+	return real_sendmsg(fd, msg, flags);
+}
+
+/* every fcntl command owlib uses takes an int or a pointer, both fit a long */
+int fcntl(int fd, int cmd, ...)
+{
+	va_list ap;
+	long arg;
+	REAL(fcntl);
+	va_start(ap, cmd);
+	arg = va_arg(ap, long);
+	va_end(ap);
+	COUNT(count_fcntl);
+	return real_fcntl(fd, cmd, arg);
+}
+
+int fcntl64(int fd, int cmd, ...)
+{
+	va_list ap;
+	long arg;
+	REAL(fcntl64);
+	va_start(ap, cmd);
+	arg = va_arg(ap, long);
+	va_end(ap);
+	COUNT(count_fcntl);
+	return real_fcntl64(fd, cmd, arg);
+}
+
+__attribute__ ((destructor))
+static void syscount_report(void)
+{
+	const char *name = getenv("SYSCOUNT_OUT");
+	FILE *out = (name != NULL) ? fopen(name, "a") : NULL;
+
+	if (out == NULL) {
+		return;
+	}
+	fprintf(out, "read=%ld recv=%ld select=%ld poll=%ld write=%ld send=%ld writev=%ld sendmsg=%ld fcntl=%ld\n",
+			count_read, count_recv, count_select, count_poll, count_write, count_send, count_writev, count_sendmsg, count_fcntl);
+	fclose(out);
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+# $Id$
+# Network syscalls made by a relaying owserver (the owserver client path)
+# for N owread requests. A second owserver with --fake=10 is the backend.
+# usage: syscount.sh [port] [N]     (run from src/scripts/bench after
+#        make -f Makefile.example syscount.so)
+
+OWFS=${OWFS:-../../..}
+M=$OWFS/module
+PORT=${1:-4304}
+N=${2:-200}
+BACKEND=$((PORT+1))
+OUT=${TMPDIR:-/tmp}/syscount.$$
+
+# run the real binaries, not the libtool wrappers, so LD_PRELOAD counts owserver alone
+export LD_LIBRARY_PATH=$M/owlib/src/c/.libs
+OWSERVER=$M/owserver/src/c/.libs/owserver
+OWREAD=$M/owshell/src/c/owread
+
+$OWSERVER --fake=10 -p $BACKEND --foreground --error_level=0 &
+BACKEND_PID=$!
+sleep 1
+
+count() {
+	rm -f $OUT
+	SYSCOUNT_OUT=$OUT LD_PRELOAD=./syscount.so $OWSERVER -s $BACKEND -p $PORT --foreground --error_level=0 &
+	RELAY_PID=$!
+	sleep 1
+	i=0
+	while [ $i -lt $1 ]; do
+		$OWREAD -s $PORT /10.67C6697351FF/temperature >/dev/null
+		i=$((i+1))
+	done
+	kill $RELAY_PID
+	wait $RELAY_PID
+	cat $OUT
+}
+
+echo "startup only: $(count 0)"
+echo "$N requests: $(count $N)"
+
+kill $BACKEND_PID
+wait $BACKEND_PID
+rm -f $OUT